@@ -22,6 +22,7 @@
 #import "IGAppDelegate.h"
 
 #import "IGNetworkManager.h"
+#import "IGAutoDownloader.h"
 #import "IGMediaPlayer.h"
 #import "IGAPIKeys.h"
 #import "IGEpisodeImporter.h"
@@ -41,6 +42,8 @@
     [MagicalRecord setupCoreDataStackWithAutoMigratingSqliteStoreNamed:@"SITMOS.sqlite"];
     
     [[AFNetworkActivityIndicatorManager sharedManager] setEnabled:YES];
+    [IGNetworkManager restoreDownloadTasks];
+    [IGNetworkManager startResumingInterruptedDownloads];
     
 #ifdef DEVELOPMENT_MODE
     [IGNetworkManager setDevelopmentModeEnabled:YES];
@@ -50,6 +53,8 @@
     
     [self registerDefaultSettings];
     [self importEpisodesFromMediaLibrary];
+    [IGEpisode startReconcilingDownloadedEpisodes];
+    [IGEpisode applyPlaybackJournalWithCompletion:nil];
     
     [[NSNotificationCenter defaultCenter] addObserver:self
                                              selector:@selector(becomeFirstResponder:)
@@ -140,18 +145,7 @@
 
 - (void)application:(UIApplication *)application performFetchWithCompletionHandler:(void (^)(UIBackgroundFetchResult))completionHandler
 {
-    IGNetworkManager *networkManager = [[IGNetworkManager alloc] init];
-    [networkManager syncPodcastFeedWithCompletion:^(BOOL success, NSArray *feedItems, NSError *error) {
-        if (success && feedItems)
-        {
-            [IGEpisode importPodcastFeedItems:feedItems completion:nil];
-        }
-        
-        if (completionHandler)
-        {
-            completionHandler(feedItems ? UIBackgroundFetchResultNewData : UIBackgroundFetchResultNoData);
-        }
-    }];
+    [[IGAutoDownloader sharedDownloader] performFetchWithCompletionHandler:completionHandler];
 }
 
 - (void)application:(UIApplication *)application handleEventsForBackgroundURLSession:(NSString *)identifier
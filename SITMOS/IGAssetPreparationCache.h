@@ -0,0 +1,77 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class AVURLAsset;
+@class IGMediaAsset;
+
+/**
+ * The IGAssetPreparationCache class warms the AVURLAssets of media the user is likely to play, so playback can begin as soon as it is asked for.
+ *
+ * Preparing an asset creates its AVURLAsset and starts loading the keys the media player needs. The prepared assets are kept in least recently used order up to capacity, and are all dropped when the application receives a memory warning.
+ *
+ * All methods must be called on the main thread.
+ */
+@interface IGAssetPreparationCache : NSObject
+
+/**
+ * Returns the shared preparation cache.
+ */
++ (instancetype)sharedCache;
+
+/**
+ * Initializes a preparation cache holding up to the given number of assets.
+ *
+ * @param The maximum number of prepared assets.
+ */
+- (id)initWithCapacity:(NSUInteger)capacity;
+
+/**
+ * The maximum number of prepared assets, the least recently used asset is dropped when another is prepared. Defaults to 6.
+ */
+@property (nonatomic, assign) NSUInteger capacity;
+
+/**
+ * Creates the AVURLAsset of a media asset and starts loading its keys, unless it is already prepared in which case it becomes the most recently used.
+ *
+ * @param The media asset to prepare.
+ */
+- (void)prepareAsset:(IGMediaAsset *)asset;
+
+/**
+ * Returns the prepared AVURLAsset of a media asset and removes it from the cache, nil if it has not been prepared.
+ *
+ * @param The media asset about to be played.
+ */
+- (AVURLAsset *)takeURLAssetForAsset:(IGMediaAsset *)asset;
+
+/**
+ * Returns the number of prepared assets.
+ */
+- (NSUInteger)count;
+
+/**
+ * Drops every prepared asset, cancelling the loading of their keys.
+ */
+- (void)removeAllAssets;
+
+@end
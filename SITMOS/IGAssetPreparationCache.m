@@ -0,0 +1,147 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGAssetPreparationCache.h"
+
+#import "IGMediaAsset.h"
+
+#import <AVFoundation/AVFoundation.h>
+#import <UIKit/UIKit.h>
+
+static NSUInteger const IGAssetPreparationCacheDefaultCapacity = 6;
+
+@implementation IGAssetPreparationCache
+{
+    NSMutableDictionary *_URLAssets;
+    NSMutableArray *_keys;
+}
+
++ (instancetype)sharedCache
+{
+    static IGAssetPreparationCache *sharedCache = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedCache = [[self alloc] initWithCapacity:IGAssetPreparationCacheDefaultCapacity];
+    });
+    return sharedCache;
+}
+
+- (id)initWithCapacity:(NSUInteger)capacity
+{
+    if (!(self = [super init])) return nil;
+    
+    _capacity = capacity;
+    _URLAssets = [[NSMutableDictionary alloc] initWithCapacity:capacity];
+    _keys = [[NSMutableArray alloc] initWithCapacity:capacity];
+    
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(removeAllAssets)
+                                                 name:UIApplicationDidReceiveMemoryWarningNotification
+                                               object:nil];
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+/**
+ * Returns the key a media asset is prepared under, its content URL.
+ */
+- (NSString *)keyForAsset:(IGMediaAsset *)asset
+{
+    return [[asset contentURL] absoluteString];
+}
+
+#pragma mark - Preparing Assets
+
+- (void)setCapacity:(NSUInteger)capacity
+{
+    _capacity = capacity;
+    [self trimToCapacity];
+}
+
+- (void)prepareAsset:(IGMediaAsset *)asset
+{
+    NSString *key = [self keyForAsset:asset];
+    if (!key || _capacity == 0)
+    {
+        return;
+    }
+    
+    [_keys removeObject:key];
+    [_keys addObject:key];
+    
+    if (![_URLAssets objectForKey:key])
+    {
+        AVURLAsset *URLAsset = [asset URLAsset];
+        [URLAsset loadValuesAsynchronouslyForKeys:@[@"tracks", @"playable"] completionHandler:nil];
+        [_URLAssets setObject:URLAsset forKey:key];
+    }
+    
+    [self trimToCapacity];
+}
+
+- (AVURLAsset *)takeURLAssetForAsset:(IGMediaAsset *)asset
+{
+    NSString *key = [self keyForAsset:asset];
+    AVURLAsset *URLAsset = key ? [_URLAssets objectForKey:key] : nil;
+    if (URLAsset)
+    {
+        [_URLAssets removeObjectForKey:key];
+        [_keys removeObject:key];
+    }
+    
+    return URLAsset;
+}
+
+- (NSUInteger)count
+{
+    return [_keys count];
+}
+
+#pragma mark - Removing Assets
+
+- (void)trimToCapacity
+{
+    while ([_keys count] > _capacity)
+    {
+        NSString *key = [_keys objectAtIndex:0];
+        [[_URLAssets objectForKey:key] cancelLoading];
+        [_URLAssets removeObjectForKey:key];
+        [_keys removeObjectAtIndex:0];
+    }
+}
+
+- (void)removeAllAssets
+{
+    for (AVURLAsset *URLAsset in [_URLAssets allValues])
+    {
+        [URLAsset cancelLoading];
+    }
+    
+    [_URLAssets removeAllObjects];
+    [_keys removeAllObjects];
+}
+
+@end
@@ -22,6 +22,9 @@
 #import "IGAudioPlayerViewController.h"
 
 #import "IGEpisode.h"
+#import "IGEpisodeStorage.h"
+#import "IGPlaybackJournal.h"
+#import "IGPlaybackProgressPublisher.h"
 #import "IGMediaPlayer.h"
 #import "IGMediaAsset.h"
 #import "IGDefines.h"
@@ -32,6 +35,9 @@ NSString * const kPlaybackStateKey = @"playbackState";
 
 static void * IGMediaPlayerPlaybackStateContext = &IGMediaPlayerPlaybackStateContext;
 
+/* The interval between progress updates while the audio player is on screen, one per display frame */
+static NSTimeInterval const IGAudioPlayerProgressInterval = 1.0 / 60.0;
+
 @interface IGAudioPlayerViewController ()
 
 @property (nonatomic, weak) IBOutlet UILabel *currentTime;
@@ -41,7 +47,7 @@ static void * IGMediaPlayerPlaybackStateContext = &IGMediaPlayerPlaybackStateCon
 @property (nonatomic, weak) IBOutlet UIButton *playButton;
 @property (nonatomic, weak) IBOutlet UIButton *seekBackwardButton;
 @property (nonatomic, weak) IBOutlet UIButton *seekForwardButton;
-@property (nonatomic, strong) NSTimer *playbackProgressUpdateTimer;
+@property (nonatomic, strong) IGPlaybackProgressPublisher *progressPublisher;
 @property (nonatomic, strong) IGMediaPlayer *mediaPlayer;
 
 @end
@@ -77,6 +83,11 @@ static void * IGMediaPlayerPlaybackStateContext = &IGMediaPlayerPlaybackStateCon
                                                  name:UIApplicationWillEnterForegroundNotification
                                                object:nil];
     
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(currentAssetDidChange:)
+                                                 name:IGMediaPlayerCurrentAssetDidChangeNotification
+                                               object:nil];
+    
     return self;
 }
 
@@ -87,8 +98,7 @@ static void * IGMediaPlayerPlaybackStateContext = &IGMediaPlayerPlaybackStateCon
     [super encodeRestorableStateWithCoder:coder];
     
     // Save the current playing episodes URIRepresentation, which we can use to look up the episode on restore and call loadAudioPlayerWithEpisode: method.
-    IGEpisode *episode = [IGEpisode MR_findFirstByAttribute:@"title"
-                                                  withValue:[[self.mediaPlayer asset] title]];
+    IGEpisode *episode = [IGEpisode episodeWithMediaAsset:[self.mediaPlayer asset]];
     [coder encodeObject:[[episode objectID] URIRepresentation] forKey:@"episodeURIRepresentation"];
 }
 
@@ -120,20 +130,35 @@ static void * IGMediaPlayerPlaybackStateContext = &IGMediaPlayerPlaybackStateCon
                                                                             action:@selector(hideAudioPlayer:)];
     
     [self.progressSlider setThumbImage:[UIImage imageNamed:@"progress-slider-thumb"] forState:UIControlStateNormal];
+    
+    __weak IGAudioPlayerViewController *weakSelf = self;
+    self.progressPublisher = [[IGPlaybackProgressPublisher alloc] init];
+    [self.progressPublisher setElapsedTimeTextBlock:^(NSString *text) {
+        [weakSelf.currentTime setText:text];
+    }];
+    [self.progressPublisher setRemainingTimeTextBlock:^(NSString *text) {
+        [weakSelf.duration setText:text];
+    }];
+    [self.progressPublisher setDurationBlock:^(Float64 duration) {
+        [weakSelf.progressSlider setMaximumValue:duration];
+    }];
+    [self.progressPublisher setCurrentTimeBlock:^(Float64 currentTime) {
+        [weakSelf.progressSlider setValue:currentTime];
+    }];
 }
 
 - (void)viewWillAppear:(BOOL)animated
 {
     [super viewWillAppear:animated];
     
-    [self startPlaybackProgressUpdateTimer];
+    [self startPublishingPlaybackProgress];
 }
 
 - (void)viewWillDisappear:(BOOL)animated
 {
     [super viewWillDisappear:animated];
     
-    [self stopPlaybackProgressUpdateTimer];
+    [self stopPublishingPlaybackProgress];
 }
 
 #pragma mark - Orientation Support
@@ -161,12 +186,8 @@ static void * IGMediaPlayerPlaybackStateContext = &IGMediaPlayerPlaybackStateCon
 
 - (void)updatePlaybackProgress
 {
-    if (isnan([self.mediaPlayer duration])) return;
-    
-    [self.currentTime setText:[self currentTimeString]];
-    [self.duration setText:[self durationString]];
-    [self.progressSlider setMaximumValue:[self.mediaPlayer duration]];
-    [self.progressSlider setValue:[self.mediaPlayer currentTime]];
+    [self.progressPublisher publishCurrentTime:[self.mediaPlayer currentTime]
+                                      duration:[self.mediaPlayer duration]];
 }
 
 - (void)showBufferingIndicator
@@ -197,12 +218,16 @@ static void * IGMediaPlayerPlaybackStateContext = &IGMediaPlayerPlaybackStateCon
     self.title = episode.title;
     
     NSURL *contentURL = ([episode isDownloaded]) ? [episode fileURL] : [NSURL URLWithString:[episode downloadURL]];
+    NSString *fileName = [episode isDownloaded] ? [[episode fileURL] lastPathComponent] : nil;
+    [[IGEpisodeStorage sharedStorage] setFileNameInUse:fileName];
+    [[IGEpisodeStorage sharedStorage] recordAccessToFileWithName:fileName];
     IGMediaAsset *asset = [[IGMediaAsset alloc] initWithTitle:[episode title]
+                                                   identifier:[episode identifier]
                                                    contentURL:contentURL
                                                       isAudio:[episode isAudio]];
     
     IGMediaPlayer *mediaPlayer = [IGMediaPlayer sharedInstance];
-    if ([[mediaPlayer.asset title] isEqualToString:asset.title] && mediaPlayer.playbackState == IGMediaPlayerPlaybackStatePlaying)
+    if ([[IGEpisode episodeWithMediaAsset:mediaPlayer.asset] isEqual:episode] && mediaPlayer.playbackState == IGMediaPlayerPlaybackStatePlaying)
     {
         // No need to reload the media that is already playing
         return;
@@ -211,27 +236,43 @@ static void * IGMediaPlayerPlaybackStateContext = &IGMediaPlayerPlaybackStateCon
     // Stop any media playing before loading new media so the current media's position gets saved
     [mediaPlayer stop];
     
-    [mediaPlayer setStartFromTime:[[episode progress] floatValue]];
+    [mediaPlayer setStartFromTime:[[episode playbackPosition] floatValue]];
     [mediaPlayer startWithAsset:asset];
     
+    // Positions go to the playback journal, which is folded into the episode in the background. The blocks look up the asset playing when they run, as playback carries on into the up next queue.
+    __weak IGMediaPlayer *weakMediaPlayer = mediaPlayer;
+    [mediaPlayer setPositionBlock:^(Float64 currentTime) {
+        [IGEpisode recordPlaybackPosition:currentTime forMediaAsset:[weakMediaPlayer asset]];
+    }];
+    
     [mediaPlayer setPausedBlock:^(Float64 currentTime) {
-        NSManagedObjectContext *localContext = [NSManagedObjectContext MR_defaultContext];
-        IGEpisode *localEpisode = [episode MR_inContext:localContext];
-        [localEpisode setProgress:@(currentTime)];
-        [localContext MR_saveToPersistentStoreAndWait];
+        [IGEpisode recordPlaybackPosition:currentTime forMediaAsset:[weakMediaPlayer asset]];
+        [[IGPlaybackJournal sharedJournal] synchronize];
+        [IGEpisode applyPlaybackJournalWithCompletion:nil];
     }];
     
     [mediaPlayer setStoppedBlock:^(Float64 currentTime, BOOL playbackEnded) {
-        NSManagedObjectContext *localContext = [NSManagedObjectContext MR_defaultContext];
-        IGEpisode *localEpisode = [episode MR_inContext:localContext];
-        NSNumber *progress = @(currentTime);
+        IGMediaAsset *playingAsset = [weakMediaPlayer asset];
+        [IGEpisode recordPlaybackPosition:(playbackEnded ? 0 : currentTime) forMediaAsset:playingAsset];
+        [[IGPlaybackJournal sharedJournal] synchronize];
         if (playbackEnded)
         {
-            progress = @(0);
+            NSManagedObjectContext *localContext = [NSManagedObjectContext MR_defaultContext];
+            IGEpisode *localEpisode = [IGEpisode episodeWithMediaAsset:playingAsset];
             [localEpisode markAsPlayed:playbackEnded];
+            [localEpisode setProgress:@(0)];
+            [localContext MR_saveToPersistentStoreWithCompletion:nil];
         }
-        [localEpisode setProgress:progress];
-        [localContext MR_saveToPersistentStoreAndWait];
+        [IGEpisode applyPlaybackJournalWithCompletion:nil];
+    }];
+    
+    [mediaPlayer setUpNextBlock:^Float64(IGMediaAsset *upNextAsset) {
+        IGEpisode *upNextEpisode = [IGEpisode episodeWithMediaAsset:upNextAsset];
+        NSString *upNextFileName = [upNextEpisode isDownloaded] ? [[upNextEpisode fileURL] lastPathComponent] : nil;
+        [[IGEpisodeStorage sharedStorage] setFileNameInUse:upNextFileName];
+        [[IGEpisodeStorage sharedStorage] recordAccessToFileWithName:upNextFileName];
+        
+        return [[upNextEpisode playbackPosition] doubleValue];
     }];
     
     NSString *from = ([episode isDownloaded]) ? @"download" : @"stream";
@@ -252,13 +293,11 @@ static void * IGMediaPlayerPlaybackStateContext = &IGMediaPlayerPlaybackStateCon
 
 - (void)play
 {
-    [self startPlaybackProgressUpdateTimer];
     [self.mediaPlayer play];
 }
 
 - (void)pause
 {
-    [self stopPlaybackProgressUpdateTimer];
     [self.mediaPlayer pause];
 }
 
@@ -318,10 +357,10 @@ static void * IGMediaPlayerPlaybackStateContext = &IGMediaPlayerPlaybackStateCon
 - (IBAction)seekToTime:(UISlider *)slider
 {
     Float64 newSeekTime = [slider value];
-    [self.mediaPlayer seekToTime:newSeekTime];
+    [self.mediaPlayer scrubToTime:newSeekTime];
     
-    [self.currentTime setText:[self currentTimeString]];
-    [self.duration setText:[self durationString]];
+    [self.progressPublisher publishCurrentTime:newSeekTime
+                                      duration:[self.mediaPlayer duration]];
 }
 
 /**
@@ -331,7 +370,7 @@ static void * IGMediaPlayerPlaybackStateContext = &IGMediaPlayerPlaybackStateCon
  */
 - (IBAction)seekToTimeStart:(UISlider *)slider
 {
-    [self stopPlaybackProgressUpdateTimer];
+    [self stopPublishingPlaybackProgress];
 }
 
 /**
@@ -341,51 +380,32 @@ static void * IGMediaPlayerPlaybackStateContext = &IGMediaPlayerPlaybackStateCon
  */
 - (IBAction)seekToTimeStop:(UISlider *)slider
 {
-    [self startPlaybackProgressUpdateTimer];
+    [self.mediaPlayer endScrubbingAtTime:[slider value]];
+    [self startPublishingPlaybackProgress];
     [self play];
 }
 
-- (NSString *)currentTimeString
-{
-    Float64 currentTime = [self.mediaPlayer currentTime];
-    
-    NSInteger secondsPlayed = (NSInteger)currentTime % 60;
-    NSInteger minutesPlayed = (NSInteger)currentTime / 60 % 60;
-    NSInteger hoursPlayed = ((NSInteger)currentTime / 60) / 60;
-    
-    return [NSString stringWithFormat:@"%2d:%02d:%02d", hoursPlayed, minutesPlayed, secondsPlayed];
-}
-
-- (NSString *)durationString
-{
-    Float64 currentTime = [self.mediaPlayer currentTime];
-    Float64 duration = [self.mediaPlayer duration];
-    
-    NSInteger secondsLeft = ((NSInteger)duration - (NSInteger)currentTime) % 60;
-    NSInteger minutesLeft = ((NSInteger)duration - (NSInteger)currentTime) / 60 % 60;
-    NSInteger hoursLeft = (((NSInteger)duration - (NSInteger)currentTime) / 60) / 60;
-    
-    return [NSString stringWithFormat:@"-%1d:%02d:%02d", hoursLeft, minutesLeft, secondsLeft];
-}
-
 #pragma mark - Playback Progress
 
-- (void)startPlaybackProgressUpdateTimer
+/**
+ * Has the media player drive the progress UI at display cadence. The player only reports while playback runs or the time jumps, so nothing is done while paused.
+ */
+- (void)startPublishingPlaybackProgress
 {
-    if ([self.playbackProgressUpdateTimer isValid]) return;
+    __weak IGAudioPlayerViewController *weakSelf = self;
+    [self.mediaPlayer setProgressBlock:^(Float64 currentTime, Float64 duration) {
+        [weakSelf.progressPublisher publishCurrentTime:currentTime duration:duration];
+    }];
+    [self.mediaPlayer setProgressInterval:IGAudioPlayerProgressInterval];
     
-    self.playbackProgressUpdateTimer = [NSTimer scheduledTimerWithTimeInterval:0.2
-                                                                        target:self
-                                                                      selector:@selector(updatePlaybackProgress)
-                                                                      userInfo:nil
-                                                                       repeats:YES];
+    [self.progressPublisher reset];
+    [self updatePlaybackProgress];
 }
 
-- (void)stopPlaybackProgressUpdateTimer
+- (void)stopPublishingPlaybackProgress
 {
-    if (![self.playbackProgressUpdateTimer isValid]) return;
-    
-    [self.playbackProgressUpdateTimer invalidate];
+    [self.mediaPlayer setProgressInterval:0];
+    [self.mediaPlayer setProgressBlock:nil];
 }
 
 #pragma mark - Media Player Notification Observer Methods
@@ -408,16 +428,25 @@ static void * IGMediaPlayerPlaybackStateContext = &IGMediaPlayerPlaybackStateCon
     [self dismissViewControllerAnimated:YES completion:nil];
 }
 
+- (void)currentAssetDidChange:(NSNotification *)notification
+{
+    self.title = [[self.mediaPlayer asset] title];
+    [self updatePlaybackProgress];
+}
+
 #pragma mark - UIApplication Notification Observer Methods 
 
 - (void)applicationDidEnterBackground:(NSNotification *)notification
 {
-    [self stopPlaybackProgressUpdateTimer];
+    [self stopPublishingPlaybackProgress];
 }
 
 - (void)applicationDidEnterForeground:(NSNotification *)notification
 {
-    [self startPlaybackProgressUpdateTimer];
+    if ([self isViewLoaded] && [self.view window])
+    {
+        [self startPublishingPlaybackProgress];
+    }
 }
 
 #pragma mark - KVO
@@ -0,0 +1,108 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <UIKit/UIKit.h>
+
+@class IGEpisodeStorage;
+
+extern NSString * const IGBackgroundFetchHistoryKey;
+
+/**
+ * The IGAutoDownloader class downloads new episodes during background fetches.
+ *
+ * A background fetch syncs the podcast feed, imports the new episodes and queues the unplayed ones with automatic priority on the background download session, which carries on with the transfers after the app is suspended. Episodes wait for Wi-Fi unless downloading with cellular data is allowed, and only as many as fit in the storage budget are queued. The fetch completes before the time the system allows for it runs out, even if the feed has not been synced by then, and how much of that time was used is recorded so the fetch interval can be tuned.
+ */
+@interface IGAutoDownloader : NSObject
+
+/**
+ * Returns the shared auto downloader, which records its fetches in the standard user defaults under IGBackgroundFetchHistoryKey.
+ */
++ (instancetype)sharedDownloader;
+
+/**
+ * Initializes an auto downloader that keeps downloads within the budget of the given episode storage.
+ *
+ * @param The episode storage whose budget downloads must fit in.
+ * @param The user defaults key to record fetches under.
+ */
+- (id)initWithEpisodeStorage:(IGEpisodeStorage *)episodeStorage historyKey:(NSString *)historyKey;
+
+/**
+ * The maximum number of episodes queued by one fetch. Defaults to 3.
+ */
+@property (nonatomic, assign) NSUInteger maximumDownloadsPerFetch;
+
+/**
+ * The number of seconds a fetch may take before it completes. Defaults to 25 seconds, leaving a margin on the 30 seconds the system allows.
+ */
+@property (nonatomic, assign) NSTimeInterval fetchTimeBudget;
+
+#pragma mark - Background Fetching
+
+/**
+ * @name Background Fetching
+ */
+
+/**
+ * Syncs the podcast feed, imports the new episodes and queues the unplayed ones to be downloaded. The completion handler is executed on the main queue within fetchTimeBudget seconds.
+ *
+ * @param The completion handler block to execute.
+ */
+- (void)performFetchWithCompletionHandler:(void (^)(UIBackgroundFetchResult result))completionHandler;
+
+/**
+ * Returns the download URLs, in order, of the episodes to queue. Episodes are taken in the order given until maximumDownloadsPerFetch is reached, an episode that does not fit in what is left of the storage budget is skipped.
+ *
+ * @param The download URLs of the candidate episodes, newest first.
+ * @param The file size in bytes of each candidate episode, 0 when it is not known.
+ */
+- (NSArray *)downloadURLsToQueueFromURLs:(NSArray *)downloadURLs fileSizes:(NSArray *)fileSizes;
+
+#pragma mark - Fetch History
+
+/**
+ * @name Fetch History
+ */
+
+/**
+ * Records a fetch, keeping the most recent 50.
+ *
+ * @param The number of seconds the fetch took.
+ * @param The result the fetch completed with.
+ */
+- (void)recordFetchWithDuration:(NSTimeInterval)duration result:(UIBackgroundFetchResult)result;
+
+/**
+ * Returns the number of fetches recorded.
+ */
+- (NSUInteger)numberOfRecordedFetches;
+
+/**
+ * Returns the average share of fetchTimeBudget the recorded fetches used, between 0 and 1. Returns 0 if no fetches have been recorded.
+ */
+- (double)averageFetchTimeBudgetUsage;
+
+/**
+ * Returns the share of the recorded fetches that found new episodes, between 0 and 1. Returns 0 if no fetches have been recorded.
+ */
+- (double)newDataRate;
+
+@end
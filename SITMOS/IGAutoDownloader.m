@@ -0,0 +1,230 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGAutoDownloader.h"
+
+#import "IGNetworkManager.h"
+#import "IGEpisode.h"
+#import "IGEpisodeStorage.h"
+
+NSString * const IGBackgroundFetchHistoryKey = @"BackgroundFetchHistory";
+
+static NSString * const IGBackgroundFetchDurationKey = @"Duration";
+static NSString * const IGBackgroundFetchResultKey = @"Result";
+static NSUInteger const IGBackgroundFetchHistoryLength = 50;
+
+@implementation IGAutoDownloader
+{
+    IGEpisodeStorage *_episodeStorage;
+    NSString *_historyKey;
+}
+
++ (instancetype)sharedDownloader
+{
+    static IGAutoDownloader *sharedDownloader = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedDownloader = [[self alloc] initWithEpisodeStorage:[IGEpisodeStorage sharedStorage]
+                                                     historyKey:IGBackgroundFetchHistoryKey];
+    });
+    return sharedDownloader;
+}
+
+- (id)initWithEpisodeStorage:(IGEpisodeStorage *)episodeStorage historyKey:(NSString *)historyKey
+{
+    if (!(self = [super init])) return nil;
+    
+    _episodeStorage = episodeStorage;
+    _historyKey = [historyKey copy];
+    _maximumDownloadsPerFetch = 3;
+    _fetchTimeBudget = 25.0;
+    
+    return self;
+}
+
+#pragma mark - Background Fetching
+
+- (void)performFetchWithCompletionHandler:(void (^)(UIBackgroundFetchResult result))completionHandler
+{
+    NSDate *startDate = [NSDate date];
+    __block BOOL finished = NO;
+    void (^finish)(UIBackgroundFetchResult) = ^(UIBackgroundFetchResult result) {
+        if (finished)
+        {
+            return;
+        }
+        finished = YES;
+        
+        [self recordFetchWithDuration:-[startDate timeIntervalSinceNow] result:result];
+        if (completionHandler)
+        {
+            completionHandler(result);
+        }
+    };
+    
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.fetchTimeBudget * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        // Overrunning the time allowed gets the app fetched less often, or not at all, so the fetch is given up on.
+        finish(UIBackgroundFetchResultFailed);
+    });
+    
+    IGNetworkManager *networkManager = [[IGNetworkManager alloc] init];
+    [networkManager syncPodcastFeedNewerThanPubDate:[IGEpisode latestPubDate] completion:^(BOOL success, NSArray *feedItems, NSError *error) {
+        if (!success)
+        {
+            finish(UIBackgroundFetchResultFailed);
+            return;
+        }
+        
+        if ([feedItems count] == 0)
+        {
+            finish(UIBackgroundFetchResultNoData);
+            return;
+        }
+        
+        [IGEpisode importPodcastFeedItems:feedItems completion:^(BOOL success, NSError *error) {
+            if (success)
+            {
+                // The background session carries on with the transfers once the app is suspended, so they are queued even when the fetch has been given up on.
+                [self queueDownloadsForFeedItems:feedItems];
+            }
+            finish(success ? UIBackgroundFetchResultNewData : UIBackgroundFetchResultFailed);
+        }];
+    }];
+}
+
+/**
+ * Queues the unplayed episodes of the feed items that have not been downloaded yet. Off Wi-Fi they are parked by the download scheduler unless downloading with cellular data is allowed.
+ */
+- (void)queueDownloadsForFeedItems:(NSArray *)feedItems
+{
+    NSSet *guids = [NSSet setWithArray:[feedItems valueForKey:@"guid"]];
+    NSMutableArray *downloadURLs = [NSMutableArray array];
+    NSMutableArray *fileSizes = [NSMutableArray array];
+    for (IGEpisode *episode in [IGEpisode latestUnplayedStreamingEpisodesWithLimit:[feedItems count]])
+    {
+        NSURL *downloadURL = [NSURL URLWithString:[episode downloadURL]];
+        if (!downloadURL || ![guids containsObject:[episode guid]] || [episode isDownloading])
+        {
+            continue;
+        }
+        
+        [downloadURLs addObject:downloadURL];
+        [fileSizes addObject:[episode fileSize] ?: @0];
+    }
+    
+    IGNetworkManager *networkManager = [[IGNetworkManager alloc] init];
+    for (NSURL *downloadURL in [self downloadURLsToQueueFromURLs:downloadURLs fileSizes:fileSizes])
+    {
+        [networkManager downloadEpisodeWithDownloadURL:downloadURL
+                                        destinationURL:[IGEpisode fileURLForDownloadURL:downloadURL]
+                                              priority:IGDownloadPriorityAutomatic
+                                            completion:nil];
+    }
+}
+
+- (NSArray *)downloadURLsToQueueFromURLs:(NSArray *)downloadURLs fileSizes:(NSArray *)fileSizes
+{
+    int64_t budget = [_episodeStorage budget];
+    // Played episodes are removed to make room, so only the space taken by unplayed ones counts against the budget.
+    int64_t availableSize = budget - ([_episodeStorage usedSize] - [_episodeStorage playedSize]);
+    
+    NSMutableArray *downloadURLsToQueue = [NSMutableArray array];
+    [downloadURLs enumerateObjectsUsingBlock:^(NSURL *downloadURL, NSUInteger idx, BOOL *stop) {
+        if ([downloadURLsToQueue count] >= self.maximumDownloadsPerFetch)
+        {
+            *stop = YES;
+            return;
+        }
+        
+        int64_t fileSize = [[fileSizes objectAtIndex:idx] longLongValue];
+        if (budget > 0)
+        {
+            if (fileSize <= 0 || fileSize > availableSize)
+            {
+                // An episode of unknown size could push out the ones not yet listened to.
+                return;
+            }
+            availableSize -= fileSize;
+        }
+        
+        [downloadURLsToQueue addObject:downloadURL];
+    }];
+    
+    return downloadURLsToQueue;
+}
+
+#pragma mark - Fetch History
+
+- (void)recordFetchWithDuration:(NSTimeInterval)duration result:(UIBackgroundFetchResult)result
+{
+    NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
+    NSMutableArray *history = [[userDefaults arrayForKey:_historyKey] mutableCopy] ?: [NSMutableArray array];
+    [history addObject:@{ IGBackgroundFetchDurationKey: @(duration), IGBackgroundFetchResultKey: @(result) }];
+    if ([history count] > IGBackgroundFetchHistoryLength)
+    {
+        [history removeObjectsInRange:NSMakeRange(0, [history count] - IGBackgroundFetchHistoryLength)];
+    }
+    
+    [userDefaults setObject:history forKey:_historyKey];
+    [userDefaults synchronize];
+}
+
+- (NSUInteger)numberOfRecordedFetches
+{
+    return [[[NSUserDefaults standardUserDefaults] arrayForKey:_historyKey] count];
+}
+
+- (double)averageFetchTimeBudgetUsage
+{
+    NSArray *history = [[NSUserDefaults standardUserDefaults] arrayForKey:_historyKey];
+    if ([history count] == 0 || self.fetchTimeBudget <= 0)
+    {
+        return 0;
+    }
+    
+    double usage = 0;
+    for (NSDictionary *fetch in history)
+    {
+        usage += MIN([[fetch objectForKey:IGBackgroundFetchDurationKey] doubleValue] / self.fetchTimeBudget, 1.0);
+    }
+    return usage / [history count];
+}
+
+- (double)newDataRate
+{
+    NSArray *history = [[NSUserDefaults standardUserDefaults] arrayForKey:_historyKey];
+    if ([history count] == 0)
+    {
+        return 0;
+    }
+    
+    NSUInteger newDataCount = 0;
+    for (NSDictionary *fetch in history)
+    {
+        if ([[fetch objectForKey:IGBackgroundFetchResultKey] integerValue] == UIBackgroundFetchResultNewData)
+        {
+            newDataCount++;
+        }
+    }
+    return (double)newDataCount / [history count];
+}
+
+@end
@@ -0,0 +1,90 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGDownloadScheduler.h"
+#import <Foundation/Foundation.h>
+
+extern NSString * const IGDataUsageKey;
+
+/**
+ * The IGDataUsageMeter class counts the bytes downloaded on each network class over the calendar month, and keeps track of a monthly limit on cellular data.
+ *
+ * The counts are persisted and start from zero again when a new month begins.
+ *
+ * All methods must be called on the main thread.
+ */
+@interface IGDataUsageMeter : NSObject
+
+/**
+ * Returns the shared data usage meter, its counts are persisted under IGDataUsageKey and its limit is taken from the settings.
+ */
++ (instancetype)sharedMeter;
+
+/**
+ * Initializes a data usage meter that persists its counts in the standard user defaults under the given key.
+ *
+ * @param The user defaults key to persist the counts under.
+ */
+- (id)initWithUsageKey:(NSString *)usageKey;
+
+/**
+ * The number of bytes that may be downloaded with cellular data each month, 0 for no limit.
+ */
+@property (nonatomic, assign) int64_t monthlyCellularLimit;
+
+/**
+ * Records bytes downloaded now.
+ *
+ * @param The number of bytes downloaded.
+ * @param The network class they were downloaded on.
+ */
+- (void)recordBytes:(int64_t)bytes onNetwork:(IGDownloadNetwork)network;
+
+/**
+ * Records bytes downloaded at the given date. Bytes downloaded before the month being counted are dropped.
+ *
+ * @param The number of bytes downloaded.
+ * @param The network class they were downloaded on.
+ * @param The date they were downloaded at.
+ */
+- (void)recordBytes:(int64_t)bytes onNetwork:(IGDownloadNetwork)network date:(NSDate *)date;
+
+/**
+ * Returns the number of bytes downloaded on the network class this month.
+ *
+ * @param The network class.
+ */
+- (int64_t)bytesUsedOnNetwork:(IGDownloadNetwork)network;
+
+/**
+ * Returns the number of bytes downloaded on the network class in the month of the given date.
+ *
+ * @param The network class.
+ * @param A date in the month.
+ */
+- (int64_t)bytesUsedOnNetwork:(IGDownloadNetwork)network inMonthOfDate:(NSDate *)date;
+
+/**
+ * Returns YES if the monthly cellular limit has been reached this month, NO otherwise or when there is no limit.
+ */
+- (BOOL)isMonthlyCellularLimitReached;
+
+@end
@@ -0,0 +1,129 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGDataUsageMeter.h"
+
+#import "IGDefines.h"
+
+NSString * const IGDataUsageKey = @"DataUsage";
+
+static NSString * const IGDataUsageMonthKey = @"Month";
+static NSString * const IGDataUsageWiFiKey = @"WiFi";
+static NSString * const IGDataUsageCellularKey = @"Cellular";
+
+@implementation IGDataUsageMeter
+{
+    NSString *_usageKey;
+}
+
++ (instancetype)sharedMeter
+{
+    static IGDataUsageMeter *sharedMeter = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedMeter = [[self alloc] initWithUsageKey:IGDataUsageKey];
+        sharedMeter.monthlyCellularLimit = [[[NSUserDefaults standardUserDefaults] objectForKey:IGMonthlyCellularDataLimitKey] longLongValue];
+    });
+    return sharedMeter;
+}
+
+- (id)initWithUsageKey:(NSString *)usageKey
+{
+    if (!(self = [super init])) return nil;
+    
+    _usageKey = [usageKey copy];
+    
+    return self;
+}
+
+/**
+ * Returns the month of the date as a number that grows month by month, such as 202610 for October 2026.
+ */
++ (NSInteger)monthOfDate:(NSDate *)date
+{
+    NSDateComponents *components = [[NSCalendar currentCalendar] components:(NSYearCalendarUnit | NSMonthCalendarUnit) fromDate:date];
+    return [components year] * 100 + [components month];
+}
+
++ (NSString *)keyForNetwork:(IGDownloadNetwork)network
+{
+    return (network == IGDownloadNetworkCellular) ? IGDataUsageCellularKey : IGDataUsageWiFiKey;
+}
+
+#pragma mark - Recording Usage
+
+- (void)recordBytes:(int64_t)bytes onNetwork:(IGDownloadNetwork)network
+{
+    [self recordBytes:bytes onNetwork:network date:[NSDate date]];
+}
+
+- (void)recordBytes:(int64_t)bytes onNetwork:(IGDownloadNetwork)network date:(NSDate *)date
+{
+    if (bytes <= 0)
+    {
+        return;
+    }
+    
+    NSInteger month = [IGDataUsageMeter monthOfDate:date];
+    NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
+    NSMutableDictionary *usage = [[userDefaults dictionaryForKey:_usageKey] mutableCopy];
+    NSInteger countedMonth = [[usage objectForKey:IGDataUsageMonthKey] integerValue];
+    if (month < countedMonth)
+    {
+        return;
+    }
+    
+    if (!usage || month > countedMonth)
+    {
+        usage = [NSMutableDictionary dictionaryWithObject:@(month) forKey:IGDataUsageMonthKey];
+    }
+    
+    NSString *networkKey = [IGDataUsageMeter keyForNetwork:network];
+    [usage setObject:@([[usage objectForKey:networkKey] longLongValue] + bytes) forKey:networkKey];
+    
+    // Written often while downloads run, the user defaults are left to save it in their own time.
+    [userDefaults setObject:usage forKey:_usageKey];
+}
+
+#pragma mark - Inspecting Usage
+
+- (int64_t)bytesUsedOnNetwork:(IGDownloadNetwork)network
+{
+    return [self bytesUsedOnNetwork:network inMonthOfDate:[NSDate date]];
+}
+
+- (int64_t)bytesUsedOnNetwork:(IGDownloadNetwork)network inMonthOfDate:(NSDate *)date
+{
+    NSDictionary *usage = [[NSUserDefaults standardUserDefaults] dictionaryForKey:_usageKey];
+    if ([[usage objectForKey:IGDataUsageMonthKey] integerValue] != [IGDataUsageMeter monthOfDate:date])
+    {
+        return 0;
+    }
+    
+    return [[usage objectForKey:[IGDataUsageMeter keyForNetwork:network]] longLongValue];
+}
+
+- (BOOL)isMonthlyCellularLimitReached
+{
+    return self.monthlyCellularLimit > 0 && [self bytesUsedOnNetwork:IGDownloadNetworkCellular] >= self.monthlyCellularLimit;
+}
+
+@end
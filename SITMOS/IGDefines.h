@@ -25,7 +25,9 @@ extern NSString * const IGDateFormatString;
 /* Settings */
 extern NSString * const IGAllowCellularDataStreamingKey;
 extern NSString * const IGAllowCellularDataDownloadingKey;
+extern NSString * const IGMonthlyCellularDataLimitKey;
 extern NSString * const IGAutoDeleteAfterFinishedPlayingKey;
+extern NSString * const IGEpisodesStorageBudgetKey;
 extern NSString * const IGShowApplicationBadgeForUnseenKey;
 extern NSString * const IGPlayerSkipForwardPeriodKey;
 extern NSString * const IGPlayerSkipBackPeriodKey;
@@ -27,7 +27,9 @@ NSString * const IGDateFormatString = @"EEE, dd MMM yyyy HH:mm:ss zzz";
 /* Settings */
 NSString * const IGAllowCellularDataStreamingKey = @"AllowCellularDataStreaming";
 NSString * const IGAllowCellularDataDownloadingKey = @"AllowCellularDataDownloading";
+NSString * const IGMonthlyCellularDataLimitKey = @"MonthlyCellularDataLimit";
 NSString * const IGAutoDeleteAfterFinishedPlayingKey = @"AutoDeleteAfterFinishedPlaying";
+NSString * const IGEpisodesStorageBudgetKey = @"EpisodesStorageBudget";
 NSString * const IGShowApplicationBadgeForUnseenKey = @"ShowApplicationBadgeForUnseen";
 NSString * const IGPlayerSkipForwardPeriodKey = @"PlayerSkipForwardPeriod";
 NSString * const IGPlayerSkipBackPeriodKey = @"PlayerSkipBackPeriod";
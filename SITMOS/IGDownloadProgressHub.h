@@ -0,0 +1,139 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+/* Download Progress States */
+typedef NS_ENUM(NSInteger, IGDownloadProgressState) {
+    IGDownloadProgressStateNone,
+    IGDownloadProgressStateWaiting,
+    IGDownloadProgressStateRunning,
+    IGDownloadProgressStateSuspended
+};
+
+/**
+ * The IGDownloadProgressSnapshot class is an immutable record of the progress of one download at the moment it was sampled.
+ */
+@interface IGDownloadProgressSnapshot : NSObject
+
+/**
+ * Initializes a snapshot. This is the designated initializer.
+ *
+ * @param The URL of the download.
+ * @param The state of the download.
+ * @param The number of bytes received so far.
+ * @param The length of the file in bytes, 0 if it is not known yet.
+ */
+- (id)initWithDownloadURL:(NSURL *)downloadURL
+                    state:(IGDownloadProgressState)state
+     countOfBytesReceived:(int64_t)countOfBytesReceived
+countOfBytesExpectedToReceive:(int64_t)countOfBytesExpectedToReceive;
+
+/**
+ * The URL of the download.
+ */
+@property (nonatomic, strong, readonly) NSURL *downloadURL;
+
+/**
+ * The state of the download, IGDownloadProgressStateNone when there is no download for the URL.
+ */
+@property (nonatomic, assign, readonly) IGDownloadProgressState state;
+
+/**
+ * The number of bytes received so far.
+ */
+@property (nonatomic, assign, readonly) int64_t countOfBytesReceived;
+
+/**
+ * The length of the file in bytes, 0 if it is not known yet.
+ */
+@property (nonatomic, assign, readonly) int64_t countOfBytesExpectedToReceive;
+
+/**
+ * Returns the fraction of the file received, between 0 and 1.
+ */
+- (double)fractionCompleted;
+
+/**
+ * Returns the bytes received out of the length of the file formatted for display, such as "3.2 MB of 24.5 MB".
+ */
+- (NSString *)localizedAdditionalDescription;
+
+/**
+ * Returns YES if both snapshots are of the same download with the same state and byte counts, NO otherwise.
+ */
+- (BOOL)isEqualToSnapshot:(IGDownloadProgressSnapshot *)snapshot;
+
+@end
+
+/**
+ * Objects that display the progress of a download adopt the IGDownloadProgressObserver protocol.
+ */
+@protocol IGDownloadProgressObserver <NSObject>
+
+/**
+ * Called on the main queue with the latest snapshot of a download the observer registered for, only when the snapshot differs from the one delivered before.
+ */
+- (void)downloadProgressDidChange:(IGDownloadProgressSnapshot *)progress;
+
+@end
+
+/**
+ * The IGDownloadProgressHub class samples the progress of downloads and delivers it to the observers registered for them.
+ *
+ * Progress is sampled once per screen refresh and only for URLs that have an observer, and only while one of them is running. Each observer receives a snapshot only when it differs from the previous one, so displaying progress costs one main queue pass per frame however many downloads are running. Observers are held weakly.
+ */
+@interface IGDownloadProgressHub : NSObject
+
+/**
+ * Returns the shared progress hub, which samples the downloads of IGNetworkManager.
+ */
++ (instancetype)sharedHub;
+
+/**
+ * Initializes a progress hub that samples with the given block. This is the designated initializer.
+ *
+ * @param The block returning the current progress of a download, nil if there is no download for the URL. Called on the main queue.
+ */
+- (id)initWithProgressProvider:(IGDownloadProgressSnapshot * (^)(NSURL *downloadURL))progressProvider;
+
+/**
+ * Registers the observer for the progress of the download. The current progress is delivered straight away. Must be called on the main queue.
+ *
+ * @param The observer to deliver the progress to.
+ * @param The URL of the download.
+ */
+- (void)addObserver:(id<IGDownloadProgressObserver>)observer forURL:(NSURL *)downloadURL;
+
+/**
+ * Stops delivering the progress of the download to the observer. Must be called on the main queue.
+ *
+ * @param The observer to stop delivering the progress to.
+ * @param The URL of the download.
+ */
+- (void)removeObserver:(id<IGDownloadProgressObserver>)observer forURL:(NSURL *)downloadURL;
+
+/**
+ * Samples the observed downloads now and delivers what has changed, used when a download has been queued, started or stopped. May be called from any queue.
+ */
+- (void)setNeedsUpdate;
+
+@end
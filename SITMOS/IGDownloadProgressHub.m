@@ -0,0 +1,269 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGDownloadProgressHub.h"
+
+#import "IGNetworkManager.h"
+
+#import <QuartzCore/QuartzCore.h>
+
+@implementation IGDownloadProgressSnapshot
+
+- (id)initWithDownloadURL:(NSURL *)downloadURL
+                    state:(IGDownloadProgressState)state
+     countOfBytesReceived:(int64_t)countOfBytesReceived
+countOfBytesExpectedToReceive:(int64_t)countOfBytesExpectedToReceive
+{
+    if (!(self = [super init])) return nil;
+    
+    _downloadURL = downloadURL;
+    _state = state;
+    _countOfBytesReceived = countOfBytesReceived;
+    _countOfBytesExpectedToReceive = countOfBytesExpectedToReceive;
+    
+    return self;
+}
+
+- (double)fractionCompleted
+{
+    if (self.countOfBytesExpectedToReceive <= 0)
+    {
+        return 0;
+    }
+    
+    return MIN((double)self.countOfBytesReceived / self.countOfBytesExpectedToReceive, 1);
+}
+
+- (NSString *)localizedAdditionalDescription
+{
+    static NSByteCountFormatter *byteCountFormatter = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        byteCountFormatter = [[NSByteCountFormatter alloc] init];
+        byteCountFormatter.countStyle = NSByteCountFormatterCountStyleFile;
+    });
+    
+    return [NSString stringWithFormat:NSLocalizedString(@"DownloadProgress", nil), [byteCountFormatter stringFromByteCount:self.countOfBytesReceived], [byteCountFormatter stringFromByteCount:self.countOfBytesExpectedToReceive]];
+}
+
+- (BOOL)isEqualToSnapshot:(IGDownloadProgressSnapshot *)snapshot
+{
+    return (snapshot &&
+            self.state == snapshot.state &&
+            self.countOfBytesReceived == snapshot.countOfBytesReceived &&
+            self.countOfBytesExpectedToReceive == snapshot.countOfBytesExpectedToReceive &&
+            [self.downloadURL isEqual:snapshot.downloadURL]);
+}
+
+- (BOOL)isEqual:(id)object
+{
+    return (self == object || ([object isKindOfClass:[IGDownloadProgressSnapshot class]] && [self isEqualToSnapshot:object]));
+}
+
+- (NSUInteger)hash
+{
+    return [self.downloadURL hash] ^ (NSUInteger)self.countOfBytesReceived ^ (NSUInteger)self.state;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %@ state %ld, %lld of %lld>", NSStringFromClass([self class]), self.downloadURL, (long)self.state, self.countOfBytesReceived, self.countOfBytesExpectedToReceive];
+}
+
+@end
+
+@interface IGDownloadProgressHub ()
+
+@property (nonatomic, copy) IGDownloadProgressSnapshot * (^progressProvider)(NSURL *downloadURL);
+@property (nonatomic, strong) CADisplayLink *displayLink;
+
+@end
+
+@implementation IGDownloadProgressHub
+{
+    NSMutableDictionary *_observersByURL;
+    NSMutableDictionary *_snapshotsByURL;
+}
+
++ (instancetype)sharedHub
+{
+    static IGDownloadProgressHub *sharedHub = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedHub = [[self alloc] initWithProgressProvider:^IGDownloadProgressSnapshot *(NSURL *downloadURL) {
+            return [IGNetworkManager downloadProgressForURL:downloadURL];
+        }];
+    });
+    return sharedHub;
+}
+
+- (id)initWithProgressProvider:(IGDownloadProgressSnapshot * (^)(NSURL *downloadURL))progressProvider
+{
+    if (!(self = [super init])) return nil;
+    
+    _progressProvider = [progressProvider copy];
+    _observersByURL = [[NSMutableDictionary alloc] init];
+    _snapshotsByURL = [[NSMutableDictionary alloc] init];
+    
+    // Tasks starting or stopping wake the hub up, while they run the display link samples them.
+    for (NSString *notificationName in @[AFNetworkingTaskDidStartNotification, AFNetworkingTaskDidSuspendNotification, AFNetworkingTaskDidFinishNotification])
+    {
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(setNeedsUpdate)
+                                                     name:notificationName
+                                                   object:nil];
+    }
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    [_displayLink invalidate];
+}
+
+#pragma mark - Observers
+
+- (void)addObserver:(id<IGDownloadProgressObserver>)observer forURL:(NSURL *)downloadURL
+{
+    if (!observer || !downloadURL)
+    {
+        return;
+    }
+    
+    NSHashTable *observers = [_observersByURL objectForKey:downloadURL];
+    if (!observers)
+    {
+        observers = [NSHashTable weakObjectsHashTable];
+        [_observersByURL setObject:observers forKey:downloadURL];
+    }
+    [observers addObject:observer];
+    
+    IGDownloadProgressSnapshot *snapshot = [self sampleURL:downloadURL];
+    [_snapshotsByURL setObject:snapshot forKey:downloadURL];
+    [observer downloadProgressDidChange:snapshot];
+    
+    [self updateDisplayLink];
+}
+
+- (void)removeObserver:(id<IGDownloadProgressObserver>)observer forURL:(NSURL *)downloadURL
+{
+    if (!downloadURL)
+    {
+        return;
+    }
+    
+    NSHashTable *observers = [_observersByURL objectForKey:downloadURL];
+    [observers removeObject:observer];
+    if ([[observers allObjects] count] == 0)
+    {
+        [_observersByURL removeObjectForKey:downloadURL];
+        [_snapshotsByURL removeObjectForKey:downloadURL];
+    }
+    
+    [self updateDisplayLink];
+}
+
+#pragma mark - Sampling
+
+- (void)setNeedsUpdate
+{
+    if (![NSThread isMainThread])
+    {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [self setNeedsUpdate];
+        });
+        return;
+    }
+    
+    [self publishChangedSnapshots];
+}
+
+- (IGDownloadProgressSnapshot *)sampleURL:(NSURL *)downloadURL
+{
+    IGDownloadProgressSnapshot *snapshot = self.progressProvider ? self.progressProvider(downloadURL) : nil;
+    return snapshot ?: [[IGDownloadProgressSnapshot alloc] initWithDownloadURL:downloadURL
+                                                                         state:IGDownloadProgressStateNone
+                                                          countOfBytesReceived:0
+                                                 countOfBytesExpectedToReceive:0];
+}
+
+/**
+ * Samples every observed download and delivers the snapshots that changed. Called by the display link on every screen refresh while a download is running.
+ */
+- (void)publishChangedSnapshots
+{
+    for (NSURL *downloadURL in [_observersByURL allKeys])
+    {
+        // Observers that went away without removing themselves leave nothing to deliver to.
+        NSArray *observers = [[_observersByURL objectForKey:downloadURL] allObjects];
+        if ([observers count] == 0)
+        {
+            [_observersByURL removeObjectForKey:downloadURL];
+            [_snapshotsByURL removeObjectForKey:downloadURL];
+            continue;
+        }
+        
+        IGDownloadProgressSnapshot *snapshot = [self sampleURL:downloadURL];
+        if ([snapshot isEqualToSnapshot:[_snapshotsByURL objectForKey:downloadURL]])
+        {
+            continue;
+        }
+        
+        [_snapshotsByURL setObject:snapshot forKey:downloadURL];
+        for (id<IGDownloadProgressObserver> observer in observers)
+        {
+            [observer downloadProgressDidChange:snapshot];
+        }
+    }
+    
+    [self updateDisplayLink];
+}
+
+/**
+ * Runs the display link only while an observed download is running, waiting and suspended downloads do not change until a task starts.
+ */
+- (void)updateDisplayLink
+{
+    BOOL running = NO;
+    for (IGDownloadProgressSnapshot *snapshot in [_snapshotsByURL allValues])
+    {
+        if (snapshot.state == IGDownloadProgressStateRunning)
+        {
+            running = YES;
+            break;
+        }
+    }
+    
+    if (running && !self.displayLink)
+    {
+        self.displayLink = [CADisplayLink displayLinkWithTarget:self selector:@selector(publishChangedSnapshots)];
+        [self.displayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+    }
+    else if (!running && self.displayLink)
+    {
+        [self.displayLink invalidate];
+        self.displayLink = nil;
+    }
+}
+
+@end
@@ -0,0 +1,194 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+/* Download Priorities, most urgent first */
+typedef NS_ENUM(NSInteger, IGDownloadPriority) {
+    IGDownloadPriorityPlayNext,
+    IGDownloadPriorityUserRequested,
+    IGDownloadPriorityAutomatic
+};
+
+/* Network Classes */
+typedef NS_ENUM(NSInteger, IGDownloadNetwork) {
+    IGDownloadNetworkWiFi,
+    IGDownloadNetworkCellular
+};
+
+extern NSString * const IGDownloadQueueKey;
+
+/**
+ * The IGDownloadScheduler class decides when queued episode downloads are started.
+ *
+ * At most maximumConcurrentDownloads transfers run at once, the rest wait in the queue ordered by priority and then by the order they were queued in. When a more urgent download is waiting and every slot is taken the least urgent running transfer is suspended to make room, it is resumed when a slot frees up. The queue is persisted so it survives relaunch.
+ *
+ * Each download records whether it may use cellular data. While the device is on a cellular network, or once cellular data is no longer allowed, downloads that may not use it are parked: a running transfer is stopped keeping what it has received, and parked downloads keep their place in the queue until they can be started again.
+ *
+ * All methods must be called on the main thread.
+ */
+@interface IGDownloadScheduler : NSObject
+
+/**
+ * Returns the shared download scheduler, its queue is persisted under IGDownloadQueueKey.
+ */
++ (instancetype)sharedScheduler;
+
+/**
+ * Initializes a download scheduler that persists its queue in the standard user defaults under the given key.
+ *
+ * @param The user defaults key to persist the queue under.
+ */
+- (id)initWithQueueStateKey:(NSString *)queueStateKey;
+
+/**
+ * The maximum number of transfers that run at once. Defaults to 2, can not be less than 1.
+ */
+@property (nonatomic, assign) NSUInteger maximumConcurrentDownloads;
+
+/**
+ * Sets the block that starts the transfer of a download when it is given a slot. The transfer must report back with finishDownloadWithURL:success:error: when it completes.
+ *
+ * @param The block to execute.
+ */
+- (void)setStartDownloadBlock:(void (^)(NSURL *downloadURL, NSURL *destinationURL))block;
+
+/**
+ * Sets the block that stops the transfer of a running download when it is parked, keeping what has been received so the transfer can carry on later. The block returns YES if a transfer was stopped, the transfer must then report back with finishDownloadWithURL:success:error: and the download is not started again until it has. Without a block the transfer is suspended.
+ *
+ * @param The block to execute.
+ */
+- (void)setParkDownloadBlock:(BOOL (^)(NSURL *downloadURL))block;
+
+/**
+ * Sets the block that suspends the transfer of a running download to make room for a more urgent one. The block returns YES if the transfer was stopped rather than suspended, the transfer must then report back with finishDownloadWithURL:success:error: and the download is not started again until it has. A suspended transfer is picked up again by the start block. Without a block the download task is suspended, and resumed when the download is given a slot again.
+ *
+ * @param The block to execute.
+ */
+- (void)setSuspendDownloadBlock:(BOOL (^)(NSURL *downloadURL))block;
+
+#pragma mark - Network
+
+/**
+ * @name Network
+ */
+
+/**
+ * The network the device is on. Downloads that may not use cellular data are parked while it is IGDownloadNetworkCellular. Defaults to IGDownloadNetworkWiFi.
+ */
+@property (nonatomic, assign) IGDownloadNetwork network;
+
+/**
+ * Whether any download may use cellular data, set to NO once the monthly cellular data limit has been reached. Defaults to YES.
+ */
+@property (nonatomic, assign, getter = isCellularDataAllowed) BOOL cellularDataAllowed;
+
+#pragma mark - Queueing Downloads
+
+/**
+ * @name Queueing Downloads
+ */
+
+/**
+ * Queues a download. Queueing a download that is already queued or running raises its priority when the new priority is more urgent and adds the completion block to the ones already registered.
+ *
+ * @param The URL to download from.
+ * @param The URL to save the download to.
+ * @param The priority class of the download.
+ * @param The completion handler block to execute on the main queue.
+ */
+- (void)enqueueDownloadWithURL:(NSURL *)downloadURL
+                destinationURL:(NSURL *)destinationURL
+                      priority:(IGDownloadPriority)priority
+                    completion:(void (^)(BOOL success, NSError *error))completion;
+
+/**
+ * Queues a download that may or may not use cellular data. Queueing a download that is already queued or running also lets it use cellular data when allowsCellularAccess is YES.
+ *
+ * @param The URL to download from.
+ * @param The URL to save the download to.
+ * @param The priority class of the download.
+ * @param YES if the download may use cellular data, NO if it must wait for Wi-Fi.
+ * @param The completion handler block to execute on the main queue.
+ */
+- (void)enqueueDownloadWithURL:(NSURL *)downloadURL
+                destinationURL:(NSURL *)destinationURL
+                      priority:(IGDownloadPriority)priority
+          allowsCellularAccess:(BOOL)allowsCellularAccess
+                    completion:(void (^)(BOOL success, NSError *error))completion;
+
+/**
+ * Moves a queued download to the front of the queue with play next priority, starting it straight away if need be. Does nothing if the download is not queued.
+ *
+ * @param The URL of the download.
+ */
+- (void)prioritizeDownloadWithURL:(NSURL *)downloadURL;
+
+/**
+ * Removes a download from the queue without executing its completion blocks. A running transfer is not cancelled, that is left to the caller.
+ *
+ * @param The URL of the download.
+ */
+- (void)removeDownloadWithURL:(NSURL *)downloadURL;
+
+/**
+ * Reports that the transfer of a download has completed, executing its completion blocks and starting the next waiting download. A failure reported for a download that is not running is ignored, it comes from a transfer that was stopped to park or suspend it.
+ *
+ * @param The URL of the download.
+ * @param YES if the transfer succeeded, NO otherwise.
+ * @param The error the transfer failed with.
+ */
+- (void)finishDownloadWithURL:(NSURL *)downloadURL success:(BOOL)success error:(NSError *)error;
+
+/**
+ * Restores the persisted queue. Downloads whose transfer is still running in the background session take a slot, the rest wait to be started again. No download is started before this is called.
+ *
+ * @param An array of the URLs of the transfers still running.
+ */
+- (void)restoreQueueWithRunningDownloadURLs:(NSArray *)runningDownloadURLs;
+
+#pragma mark - Inspecting the Queue
+
+/**
+ * @name Inspecting the Queue
+ */
+
+/**
+ * Returns YES if the download is queued or running, NO otherwise.
+ */
+- (BOOL)isDownloadQueuedWithURL:(NSURL *)downloadURL;
+
+/**
+ * Returns the URLs of the queued and running downloads in the order they will be given a slot.
+ */
+- (NSArray *)queuedDownloadURLs;
+
+/**
+ * Returns the URLs of the downloads that have been given a slot.
+ */
+- (NSArray *)runningDownloadURLs;
+
+/**
+ * Returns YES if the download is queued but may not use the network the device is on, NO otherwise.
+ */
+- (BOOL)isDownloadParkedWithURL:(NSURL *)downloadURL;
+
+@end
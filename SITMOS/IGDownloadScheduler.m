@@ -0,0 +1,468 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGDownloadScheduler.h"
+
+#import "IGDownloadTaskRegistry.h"
+
+NSString * const IGDownloadQueueKey = @"DownloadQueue";
+
+static NSString * const IGDownloadQueueURLKey = @"URL";
+static NSString * const IGDownloadQueueDestinationKey = @"Destination";
+static NSString * const IGDownloadQueuePriorityKey = @"Priority";
+static NSString * const IGDownloadQueueAllowsCellularAccessKey = @"AllowsCellularAccess";
+
+static NSUInteger const IGDefaultMaximumConcurrentDownloads = 2;
+
+/**
+ * A download held by the scheduler, either waiting for a slot or running.
+ */
+@interface IGScheduledDownload : NSObject
+
+@property (nonatomic, strong) NSURL *downloadURL;
+@property (nonatomic, strong) NSURL *destinationURL;
+@property (nonatomic, assign) IGDownloadPriority priority;
+@property (nonatomic, assign) NSInteger sequence;
+@property (nonatomic, assign, getter = isRunning) BOOL running;
+@property (nonatomic, assign) BOOL allowsCellularAccess;
+@property (nonatomic, assign, getter = isStopping) BOOL stopping;
+@property (nonatomic, strong) NSMutableArray *completionBlocks;
+
+@end
+
+@implementation IGScheduledDownload
+
+- (NSComparisonResult)compare:(IGScheduledDownload *)download
+{
+    if (self.priority != download.priority)
+    {
+        return self.priority < download.priority ? NSOrderedAscending : NSOrderedDescending;
+    }
+    
+    if (self.sequence != download.sequence)
+    {
+        return self.sequence < download.sequence ? NSOrderedAscending : NSOrderedDescending;
+    }
+    
+    return NSOrderedSame;
+}
+
+@end
+
+@interface IGDownloadScheduler ()
+
+@property (nonatomic, copy) NSString *queueStateKey;
+@property (nonatomic, strong) NSMutableDictionary *downloads;
+@property (nonatomic, copy) void (^startDownloadBlock)(NSURL *downloadURL, NSURL *destinationURL);
+@property (nonatomic, copy) BOOL (^parkDownloadBlock)(NSURL *downloadURL);
+@property (nonatomic, copy) BOOL (^suspendDownloadBlock)(NSURL *downloadURL);
+
+@end
+
+@implementation IGDownloadScheduler
+{
+    NSInteger _firstSequence;
+    NSInteger _lastSequence;
+    BOOL _restored;
+}
+
++ (instancetype)sharedScheduler
+{
+    static IGDownloadScheduler *sharedScheduler = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedScheduler = [[self alloc] initWithQueueStateKey:IGDownloadQueueKey];
+    });
+    return sharedScheduler;
+}
+
+- (id)initWithQueueStateKey:(NSString *)queueStateKey
+{
+    if (!(self = [super init])) return nil;
+    
+    _queueStateKey = [queueStateKey copy];
+    _downloads = [[NSMutableDictionary alloc] init];
+    _maximumConcurrentDownloads = IGDefaultMaximumConcurrentDownloads;
+    _network = IGDownloadNetworkWiFi;
+    _cellularDataAllowed = YES;
+    
+    // Loaded straight away so downloads queued before the restore are merged with the persisted ones rather than replacing them.
+    [self loadQueueState];
+    
+    return self;
+}
+
+- (void)setMaximumConcurrentDownloads:(NSUInteger)maximumConcurrentDownloads
+{
+    _maximumConcurrentDownloads = MAX(maximumConcurrentDownloads, 1);
+    
+    [self startWaitingDownloads];
+}
+
+#pragma mark - Network
+
+- (void)setNetwork:(IGDownloadNetwork)network
+{
+    if (_network == network)
+    {
+        return;
+    }
+    
+    _network = network;
+    
+    [self startWaitingDownloads];
+}
+
+- (void)setCellularDataAllowed:(BOOL)cellularDataAllowed
+{
+    if (_cellularDataAllowed == cellularDataAllowed)
+    {
+        return;
+    }
+    
+    _cellularDataAllowed = cellularDataAllowed;
+    
+    [self startWaitingDownloads];
+}
+
+- (BOOL)mayUseNetworkForDownload:(IGScheduledDownload *)download
+{
+    return self.network == IGDownloadNetworkWiFi || (self.cellularDataAllowed && download.allowsCellularAccess);
+}
+
+#pragma mark - Queueing Downloads
+
+- (void)enqueueDownloadWithURL:(NSURL *)downloadURL
+                destinationURL:(NSURL *)destinationURL
+                      priority:(IGDownloadPriority)priority
+                    completion:(void (^)(BOOL success, NSError *error))completion
+{
+    [self enqueueDownloadWithURL:downloadURL
+                  destinationURL:destinationURL
+                        priority:priority
+            allowsCellularAccess:YES
+                      completion:completion];
+}
+
+- (void)enqueueDownloadWithURL:(NSURL *)downloadURL
+                destinationURL:(NSURL *)destinationURL
+                      priority:(IGDownloadPriority)priority
+          allowsCellularAccess:(BOOL)allowsCellularAccess
+                    completion:(void (^)(BOOL success, NSError *error))completion
+{
+    if (!downloadURL)
+    {
+        return;
+    }
+    
+    IGScheduledDownload *download = [self.downloads objectForKey:downloadURL];
+    if (!download)
+    {
+        download = [self scheduledDownloadWithURL:downloadURL destinationURL:destinationURL priority:priority];
+        download.allowsCellularAccess = allowsCellularAccess;
+        [self.downloads setObject:download forKey:downloadURL];
+    }
+    else
+    {
+        download.priority = MIN(download.priority, priority);
+        download.allowsCellularAccess = download.allowsCellularAccess || allowsCellularAccess;
+    }
+    
+    if (completion)
+    {
+        [download.completionBlocks addObject:[completion copy]];
+    }
+    
+    [self startWaitingDownloads];
+}
+
+- (void)prioritizeDownloadWithURL:(NSURL *)downloadURL
+{
+    IGScheduledDownload *download = [self.downloads objectForKey:downloadURL];
+    if (!download)
+    {
+        return;
+    }
+    
+    download.priority = IGDownloadPriorityPlayNext;
+    if (![download isRunning])
+    {
+        download.sequence = --_firstSequence;
+    }
+    
+    [self startWaitingDownloads];
+}
+
+- (void)removeDownloadWithURL:(NSURL *)downloadURL
+{
+    if (!downloadURL || ![self.downloads objectForKey:downloadURL])
+    {
+        return;
+    }
+    
+    [self.downloads removeObjectForKey:downloadURL];
+    
+    [self startWaitingDownloads];
+}
+
+- (void)finishDownloadWithURL:(NSURL *)downloadURL success:(BOOL)success error:(NSError *)error
+{
+    IGScheduledDownload *download = downloadURL ? [self.downloads objectForKey:downloadURL] : nil;
+    if (!download)
+    {
+        return;
+    }
+    
+    if ([download isStopping])
+    {
+        download.stopping = NO;
+        
+        // A transfer that completed before it could be stopped is finished as usual.
+        if (!success)
+        {
+            [self startWaitingDownloads];
+            return;
+        }
+    }
+    else if (![download isRunning] && !success)
+    {
+        return;
+    }
+    
+    [self.downloads removeObjectForKey:downloadURL];
+    
+    for (void (^completion)(BOOL success, NSError *error) in download.completionBlocks)
+    {
+        completion(success, error);
+    }
+    
+    [self startWaitingDownloads];
+}
+
+- (void)restoreQueueWithRunningDownloadURLs:(NSArray *)runningDownloadURLs
+{
+    for (NSURL *downloadURL in runningDownloadURLs)
+    {
+        IGScheduledDownload *download = [self.downloads objectForKey:downloadURL];
+        if (!download)
+        {
+            // Transfers started before the queue was persisted still take a slot.
+            download = [self scheduledDownloadWithURL:downloadURL
+                                       destinationURL:nil
+                                             priority:IGDownloadPriorityUserRequested];
+            [self.downloads setObject:download forKey:downloadURL];
+        }
+        download.running = YES;
+    }
+    
+    _restored = YES;
+    
+    [self startWaitingDownloads];
+}
+
+- (IGScheduledDownload *)scheduledDownloadWithURL:(NSURL *)downloadURL destinationURL:(NSURL *)destinationURL priority:(IGDownloadPriority)priority
+{
+    IGScheduledDownload *download = [[IGScheduledDownload alloc] init];
+    download.downloadURL = downloadURL;
+    download.destinationURL = destinationURL;
+    download.priority = priority;
+    download.allowsCellularAccess = YES;
+    download.sequence = ++_lastSequence;
+    download.completionBlocks = [[NSMutableArray alloc] init];
+    return download;
+}
+
+#pragma mark - Inspecting the Queue
+
+- (BOOL)isDownloadQueuedWithURL:(NSURL *)downloadURL
+{
+    return downloadURL && [self.downloads objectForKey:downloadURL];
+}
+
+- (NSArray *)queuedDownloadURLs
+{
+    return [[self sortedDownloadsPassingTest:nil] valueForKey:@"downloadURL"];
+}
+
+- (NSArray *)runningDownloadURLs
+{
+    return [[self sortedDownloadsPassingTest:^BOOL(IGScheduledDownload *download) {
+        return [download isRunning];
+    }] valueForKey:@"downloadURL"];
+}
+
+- (BOOL)isDownloadParkedWithURL:(NSURL *)downloadURL
+{
+    IGScheduledDownload *download = downloadURL ? [self.downloads objectForKey:downloadURL] : nil;
+    return download && ![self mayUseNetworkForDownload:download];
+}
+
+- (NSArray *)sortedDownloadsPassingTest:(BOOL (^)(IGScheduledDownload *download))test
+{
+    NSMutableArray *downloads = [NSMutableArray arrayWithCapacity:[self.downloads count]];
+    for (IGScheduledDownload *download in [self.downloads objectEnumerator])
+    {
+        if (!test || test(download))
+        {
+            [downloads addObject:download];
+        }
+    }
+    [downloads sortUsingSelector:@selector(compare:)];
+    return downloads;
+}
+
+#pragma mark - Scheduling
+
+/**
+ * Parks the running downloads that may not use the network, then gives free slots to the most urgent waiting downloads, suspending less urgent running transfers when a more urgent download is waiting and no slot is free, then persists the queue.
+ */
+- (void)startWaitingDownloads
+{
+    // Until it is known which transfers are still running nothing is started, it could be started twice.
+    if (_restored)
+    {
+        for (IGScheduledDownload *download in [self sortedDownloadsPassingTest:^BOOL(IGScheduledDownload *download) {
+            return [download isRunning] && ![self mayUseNetworkForDownload:download];
+        }])
+        {
+            [self parkDownload:download];
+        }
+    }
+    
+    while (_restored)
+    {
+        IGScheduledDownload *nextDownload = [[self sortedDownloadsPassingTest:^BOOL(IGScheduledDownload *download) {
+            return ![download isRunning] && ![download isStopping] && [self mayUseNetworkForDownload:download];
+        }] firstObject];
+        if (!nextDownload)
+        {
+            break;
+        }
+        
+        NSArray *runningDownloads = [self sortedDownloadsPassingTest:^BOOL(IGScheduledDownload *download) {
+            return [download isRunning];
+        }];
+        if ([runningDownloads count] >= self.maximumConcurrentDownloads)
+        {
+            IGScheduledDownload *leastUrgentDownload = [runningDownloads lastObject];
+            if (leastUrgentDownload.priority <= nextDownload.priority)
+            {
+                break;
+            }
+            
+            [self suspendDownload:leastUrgentDownload];
+        }
+        
+        [self startDownload:nextDownload];
+    }
+    
+    [self saveQueueState];
+}
+
+- (void)startDownload:(IGScheduledDownload *)download
+{
+    download.running = YES;
+    
+    // A transfer suspended to make room for a more urgent one picks up where it left off.
+    NSURLSessionDownloadTask *downloadTask = [[IGDownloadTaskRegistry sharedRegistry] downloadTaskForURL:download.downloadURL];
+    if (downloadTask)
+    {
+        [downloadTask resume];
+    }
+    else if (self.startDownloadBlock)
+    {
+        self.startDownloadBlock(download.downloadURL, download.destinationURL);
+    }
+}
+
+- (void)suspendDownload:(IGScheduledDownload *)download
+{
+    download.running = NO;
+    
+    // Transfers other than download tasks would otherwise keep running and be started a second time.
+    if (self.suspendDownloadBlock)
+    {
+        download.stopping = self.suspendDownloadBlock(download.downloadURL);
+        return;
+    }
+    
+    [[[IGDownloadTaskRegistry sharedRegistry] downloadTaskForURL:download.downloadURL] suspend];
+}
+
+- (void)parkDownload:(IGScheduledDownload *)download
+{
+    if (!self.parkDownloadBlock)
+    {
+        [self suspendDownload:download];
+        return;
+    }
+    
+    download.running = NO;
+    download.stopping = self.parkDownloadBlock(download.downloadURL);
+}
+
+- (void)loadQueueState
+{
+    NSArray *queueState = [[NSUserDefaults standardUserDefaults] arrayForKey:self.queueStateKey];
+    for (NSDictionary *state in queueState)
+    {
+        NSURL *downloadURL = [NSURL URLWithString:[state objectForKey:IGDownloadQueueURLKey]];
+        if (!downloadURL || [self.downloads objectForKey:downloadURL])
+        {
+            continue;
+        }
+        
+        NSString *destinationPath = [state objectForKey:IGDownloadQueueDestinationKey];
+        NSURL *destinationURL = destinationPath ? [NSURL fileURLWithPath:[destinationPath stringByExpandingTildeInPath]] : nil;
+        IGScheduledDownload *download = [self scheduledDownloadWithURL:downloadURL
+                                                        destinationURL:destinationURL
+                                                              priority:[[state objectForKey:IGDownloadQueuePriorityKey] integerValue]];
+        // Downloads queued before they were tagged kept using any network.
+        NSNumber *allowsCellularAccess = [state objectForKey:IGDownloadQueueAllowsCellularAccessKey];
+        download.allowsCellularAccess = allowsCellularAccess ? [allowsCellularAccess boolValue] : YES;
+        [self.downloads setObject:download forKey:downloadURL];
+    }
+}
+
+- (void)saveQueueState
+{
+    NSArray *downloads = [self sortedDownloadsPassingTest:nil];
+    NSMutableArray *queueState = [NSMutableArray arrayWithCapacity:[downloads count]];
+    for (IGScheduledDownload *download in downloads)
+    {
+        NSMutableDictionary *state = [NSMutableDictionary dictionaryWithCapacity:4];
+        [state setObject:[download.downloadURL absoluteString] forKey:IGDownloadQueueURLKey];
+        [state setObject:@(download.priority) forKey:IGDownloadQueuePriorityKey];
+        [state setObject:@(download.allowsCellularAccess) forKey:IGDownloadQueueAllowsCellularAccessKey];
+        if (download.destinationURL)
+        {
+            // The app container moves between installs, the destination is kept relative to it.
+            [state setObject:[[download.destinationURL path] stringByAbbreviatingWithTildeInPath] forKey:IGDownloadQueueDestinationKey];
+        }
+        [queueState addObject:state];
+    }
+    
+    NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
+    [userDefaults setObject:queueState forKey:self.queueStateKey];
+    [userDefaults synchronize];
+}
+
+@end
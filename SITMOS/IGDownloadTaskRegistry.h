@@ -0,0 +1,81 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * Keeps an index of the running episode download tasks keyed by the URL of their original request.
+ *
+ * The index is an immutable dictionary that is replaced as a whole whenever a task is added or removed, so looking up a task is a single dictionary read that never waits on the download session or on a writer. Changes are serialized between writers only.
+ */
+@interface IGDownloadTaskRegistry : NSObject
+
+/**
+ * Returns the shared download task registry.
+ */
++ (instancetype)sharedRegistry;
+
+#pragma mark - Looking Up Download Tasks
+
+/**
+ * @name Looking Up Download Tasks
+ */
+
+/**
+ * Returns the download task for the given URL, nil if there is none or it has completed.
+ *
+ * @param The URL of the original request of the download task.
+ */
+- (NSURLSessionDownloadTask *)downloadTaskForURL:(NSURL *)url;
+
+/**
+ * Returns an array of all the registered NSURLSessionDownloadTask's.
+ */
+- (NSArray *)downloadTasks;
+
+#pragma mark - Registering Download Tasks
+
+/**
+ * @name Registering Download Tasks
+ */
+
+/**
+ * Adds the download task to the registry, replacing any previous task for the same URL.
+ *
+ * @param The NSURLSessionDownloadTask to add.
+ */
+- (void)registerDownloadTask:(NSURLSessionDownloadTask *)downloadTask;
+
+/**
+ * Adds the download tasks that are still running or suspended. Used to rebuild the registry from the tasks of the background session at launch, tasks already registered for the same URL are kept.
+ *
+ * @param An array of NSURLSessionTask's, tasks that are not download tasks are ignored.
+ */
+- (void)registerDownloadTasks:(NSArray *)downloadTasks;
+
+/**
+ * Removes the task from the registry. Nothing is removed if the registry has since been given a different task for the same URL.
+ *
+ * @param The NSURLSessionTask to remove.
+ */
+- (void)unregisterTask:(NSURLSessionTask *)task;
+
+@end
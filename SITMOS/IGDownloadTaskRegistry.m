@@ -0,0 +1,162 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGDownloadTaskRegistry.h"
+
+#import "AFURLSessionManager.h"
+
+@interface IGDownloadTaskRegistry ()
+
+/* Atomic so a reader always gets a retained snapshot while a writer swaps it */
+@property (atomic, copy) NSDictionary *downloadTasksByURL;
+
+@end
+
+@implementation IGDownloadTaskRegistry
+
++ (instancetype)sharedRegistry
+{
+    static IGDownloadTaskRegistry *sharedRegistry = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedRegistry = [[self alloc] init];
+    });
+    return sharedRegistry;
+}
+
+- (id)init
+{
+    if (!(self = [super init])) return nil;
+    
+    _downloadTasksByURL = [NSDictionary dictionary];
+    
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(taskDidStart:)
+                                                 name:AFNetworkingTaskDidStartNotification
+                                               object:nil];
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+#pragma mark - Looking Up Download Tasks
+
+- (NSURLSessionDownloadTask *)downloadTaskForURL:(NSURL *)url
+{
+    if (!url)
+    {
+        return nil;
+    }
+    
+    NSURLSessionDownloadTask *downloadTask = [self.downloadTasksByURL objectForKey:url];
+    
+    // The completion callback may not have been delivered yet.
+    return [downloadTask state] == NSURLSessionTaskStateCompleted ? nil : downloadTask;
+}
+
+- (NSArray *)downloadTasks
+{
+    return [self.downloadTasksByURL allValues];
+}
+
+#pragma mark - Registering Download Tasks
+
+- (void)registerDownloadTask:(NSURLSessionDownloadTask *)downloadTask
+{
+    NSURL *url = [downloadTask.originalRequest URL];
+    if (!url)
+    {
+        return;
+    }
+    
+    @synchronized(self)
+    {
+        NSDictionary *downloadTasksByURL = self.downloadTasksByURL;
+        if ([downloadTasksByURL objectForKey:url] == downloadTask)
+        {
+            return;
+        }
+        
+        NSMutableDictionary *mutableDownloadTasksByURL = [downloadTasksByURL mutableCopy];
+        [mutableDownloadTasksByURL setObject:downloadTask forKey:url];
+        self.downloadTasksByURL = mutableDownloadTasksByURL;
+    }
+}
+
+- (void)registerDownloadTasks:(NSArray *)downloadTasks
+{
+    @synchronized(self)
+    {
+        NSMutableDictionary *mutableDownloadTasksByURL = [self.downloadTasksByURL mutableCopy];
+        for (NSURLSessionTask *task in downloadTasks)
+        {
+            NSURL *url = [task.originalRequest URL];
+            if (![task isKindOfClass:[NSURLSessionDownloadTask class]] || !url || [mutableDownloadTasksByURL objectForKey:url])
+            {
+                continue;
+            }
+            
+            if ([task state] == NSURLSessionTaskStateRunning || [task state] == NSURLSessionTaskStateSuspended)
+            {
+                [mutableDownloadTasksByURL setObject:task forKey:url];
+            }
+        }
+        self.downloadTasksByURL = mutableDownloadTasksByURL;
+    }
+}
+
+- (void)unregisterTask:(NSURLSessionTask *)task
+{
+    NSURL *url = [task.originalRequest URL];
+    if (!url)
+    {
+        return;
+    }
+    
+    @synchronized(self)
+    {
+        NSDictionary *downloadTasksByURL = self.downloadTasksByURL;
+        if ([downloadTasksByURL objectForKey:url] != task)
+        {
+            return;
+        }
+        
+        NSMutableDictionary *mutableDownloadTasksByURL = [downloadTasksByURL mutableCopy];
+        [mutableDownloadTasksByURL removeObjectForKey:url];
+        self.downloadTasksByURL = mutableDownloadTasksByURL;
+    }
+}
+
+#pragma mark - Notifications
+
+- (void)taskDidStart:(NSNotification *)notification
+{
+    if ([[notification object] isKindOfClass:[NSURLSessionDownloadTask class]])
+    {
+        [self registerDownloadTask:[notification object]];
+    }
+}
+
+@end
@@ -0,0 +1,119 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+extern NSString * const IGDownloadVerifierErrorDomain;
+
+/* Download Verifier Errors */
+typedef NS_ENUM(NSInteger, IGDownloadVerifierError) {
+    IGDownloadVerifierErrorFileNotReadable = 1,
+    IGDownloadVerifierErrorCorrupt
+};
+
+/* Download Verification Warnings */
+typedef NS_OPTIONS(NSUInteger, IGDownloadVerificationWarnings) {
+    IGDownloadVerificationWarningUnrecognisedTrailingData = 1 << 0,
+    IGDownloadVerificationWarningContentNotRead = 1 << 1
+};
+
+@class IGDownloadVerification;
+
+/**
+ * The IGDownloadVerifier class checks a downloaded episode before it is played, so a truncated file or a badly spliced resumed download is caught while it can still be repaired.
+ *
+ * The file is memory mapped and read once from start to end. Its length is checked against the length the server declared, its MD5 hash is computed and, for MPEG audio, the chain of frame headers is followed to find the byte ranges where frame sync is lost. Only those ranges, and any bytes missing from the end, need fetching again.
+ *
+ * Data after the last frame that is not a recognised tag, or a file too large to map, is only reported as a warning. Neither is reason enough to throw away a file the server may well be serving as is.
+ */
+@interface IGDownloadVerifier : NSObject
+
+/**
+ * Verifies a downloaded file. Reads the whole file, call it off the main thread.
+ *
+ * @param The file URL of the downloaded file.
+ * @param The length the file should have, 0 if it is not known.
+ * @param The MD5 hash the file should have, nil if it is not known.
+ * @param On return, the error that occurred if the file could not be read.
+ * @return The verification of the file, nil if it could not be opened.
+ */
++ (IGDownloadVerification *)verifyFileAtURL:(NSURL *)fileURL
+                             expectedLength:(int64_t)expectedLength
+                                expectedMD5:(NSData *)expectedMD5
+                                      error:(NSError **)error;
+
+/**
+ * Returns the length of the whole file the response is for, taken from Content-Range for a partial response, 0 if the server did not send it.
+ *
+ * @param The response the file was downloaded with.
+ */
++ (int64_t)expectedLengthOfResponse:(NSURLResponse *)response;
+
+/**
+ * Returns the MD5 hash the server sent in the Content-MD5 header, nil if it did not send one or the response is only part of the file.
+ *
+ * @param The response the file was downloaded with.
+ */
++ (NSData *)expectedMD5OfResponse:(NSURLResponse *)response;
+
+@end
+
+/**
+ * The IGDownloadVerification class holds the outcome of verifying a downloaded file.
+ */
+@interface IGDownloadVerification : NSObject
+
+/**
+ * The length of the file in bytes.
+ */
+@property (nonatomic, assign, readonly) int64_t fileLength;
+
+/**
+ * The length the file should have, 0 if it was not known.
+ */
+@property (nonatomic, assign, readonly) int64_t expectedLength;
+
+/**
+ * The MD5 hash of the file, nil if its content could not be read.
+ */
+@property (nonatomic, copy, readonly) NSData *contentMD5;
+
+/**
+ * YES if the file was recognised as MPEG audio and its frames were checked, NO otherwise.
+ */
+@property (nonatomic, assign, readonly) BOOL frameSyncChecked;
+
+/**
+ * The byte ranges of the file that need fetching again, relative to the expected length of the file. Empty if the file is valid.
+ */
+@property (nonatomic, strong, readonly) NSIndexSet *corruptRanges;
+
+/**
+ * The checks that could not be completed or found something unexpected without condemning the file.
+ */
+@property (nonatomic, assign, readonly) IGDownloadVerificationWarnings warnings;
+
+/**
+ * Returns YES if the file passed every check, NO otherwise.
+ */
+- (BOOL)isValid;
+
+@end
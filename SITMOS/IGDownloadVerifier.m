@@ -0,0 +1,446 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGDownloadVerifier.h"
+
+#import <CommonCrypto/CommonDigest.h>
+#import <fcntl.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import <unistd.h>
+
+NSString * const IGDownloadVerifierErrorDomain = @"com.idlegeniussoftware.sitmos.download-verifier";
+
+/* ID3 Tags */
+static NSUInteger const IGID3HeaderLength = 10;
+static uint8_t const IGID3FooterPresentFlag = 0x10;
+static NSUInteger const IGID3v1TagLength = 128;
+
+/* APE Tags */
+static NSUInteger const IGAPETagFooterLength = 32;
+static uint32_t const IGAPETagHeaderPresentFlag = 0x80000000;
+
+/* MPEG Audio Frames */
+static NSUInteger const IGMPEGFrameHeaderLength = 4;
+/* How far into the audio the first frame is looked for before the file is taken not to be MPEG audio */
+static NSUInteger const IGMPEGFirstFrameSearchLength = 64 * 1024;
+
+/* The hash is brought up to the frame being checked in chunks of this size */
+static NSUInteger const IGDownloadVerifierHashChunkLength = 1024 * 1024;
+
+/**
+ * Returns the length of the MPEG audio frame starting with the header, 0 if the bytes are not a valid frame header.
+ */
+static NSUInteger IGMPEGFrameLength(const uint8_t *header)
+{
+    // Kilobits per second by MPEG 1 or MPEG 2 and 2.5, then Layer I, II and III.
+    static const uint16_t bitrates[2][3][15] = {
+        {
+            { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448 },
+            { 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384 },
+            { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 }
+        },
+        {
+            { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256 },
+            { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 },
+            { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 }
+        }
+    };
+    // By the version bits, MPEG 2.5, reserved, MPEG 2 and MPEG 1.
+    static const uint32_t sampleRates[4][3] = {
+        { 11025, 12000, 8000 },
+        { 0, 0, 0 },
+        { 22050, 24000, 16000 },
+        { 44100, 48000, 32000 }
+    };
+    
+    if (header[0] != 0xFF || (header[1] & 0xE0) != 0xE0)
+    {
+        return 0;
+    }
+    
+    NSUInteger version = (header[1] >> 3) & 0x03;
+    NSUInteger layer = (header[1] >> 1) & 0x03;
+    NSUInteger bitrateIndex = header[2] >> 4;
+    NSUInteger sampleRateIndex = (header[2] >> 2) & 0x03;
+    NSUInteger padding = (header[2] >> 1) & 0x01;
+    if (version == 1 || layer == 0 || bitrateIndex == 0 || bitrateIndex == 15 || sampleRateIndex == 3)
+    {
+        // Reserved values, or a free format bitrate whose frame length can not be worked out from the header.
+        return 0;
+    }
+    
+    BOOL MPEG1 = (version == 3);
+    NSUInteger layerIndex = 3 - layer;
+    uint32_t bitrate = bitrates[MPEG1 ? 0 : 1][layerIndex][bitrateIndex] * 1000;
+    uint32_t sampleRate = sampleRates[version][sampleRateIndex];
+    
+    if (layerIndex == 0)
+    {
+        return (12 * bitrate / sampleRate + padding) * 4;
+    }
+    else if (layerIndex == 2 && !MPEG1)
+    {
+        return 72 * bitrate / sampleRate + padding;
+    }
+    
+    return 144 * bitrate / sampleRate + padding;
+}
+
+/**
+ * Returns YES if a frame starts at the offset and is followed by another frame or the end of the audio. Requiring two frames in a row keeps stray 0xFF bytes in the audio data from being taken as frame sync.
+ */
+static BOOL IGMPEGFramesSyncAtOffset(const uint8_t *bytes, NSUInteger offset, NSUInteger end)
+{
+    if (offset + IGMPEGFrameHeaderLength > end)
+    {
+        return NO;
+    }
+    
+    NSUInteger frameLength = IGMPEGFrameLength(bytes + offset);
+    if (frameLength == 0 || offset + frameLength > end)
+    {
+        return NO;
+    }
+    
+    NSUInteger nextOffset = offset + frameLength;
+    return (nextOffset + IGMPEGFrameHeaderLength > end || IGMPEGFrameLength(bytes + nextOffset) > 0);
+}
+
+/**
+ * Returns the offset of the first frame sync found from the offset up to the limit, NSNotFound if there is none.
+ */
+static NSUInteger IGMPEGNextFrameSyncOffset(const uint8_t *bytes, NSUInteger offset, NSUInteger limit, NSUInteger end)
+{
+    for (NSUInteger syncOffset = offset; syncOffset < limit; syncOffset++)
+    {
+        if (bytes[syncOffset] == 0xFF && IGMPEGFramesSyncAtOffset(bytes, syncOffset, end))
+        {
+            return syncOffset;
+        }
+    }
+    
+    return NSNotFound;
+}
+
+/**
+ * Returns the length of the ID3v2 tag at the start of the file including its header and footer, 0 if the file does not start with one.
+ */
+static NSUInteger IGID3TagLength(const uint8_t *bytes, NSUInteger length)
+{
+    if (length < IGID3HeaderLength || bytes[0] != 'I' || bytes[1] != 'D' || bytes[2] != '3' || (bytes[6] | bytes[7] | bytes[8] | bytes[9]) & 0x80)
+    {
+        return 0;
+    }
+    
+    NSUInteger tagSize = ((NSUInteger)bytes[6] << 21) | ((NSUInteger)bytes[7] << 14) | ((NSUInteger)bytes[8] << 7) | (NSUInteger)bytes[9];
+    NSUInteger footerLength = (bytes[5] & IGID3FooterPresentFlag) ? IGID3HeaderLength : 0;
+    
+    return MIN(IGID3HeaderLength + tagSize + footerLength, length);
+}
+
+/**
+ * Returns the length of the tags appended to the end of the audio, an ID3v1 tag and any APE or ID3v2 tags before it, 0 if there are none.
+ */
+static NSUInteger IGTrailingTagsLength(const uint8_t *bytes, NSUInteger start, NSUInteger end)
+{
+    NSUInteger tagsEnd = end;
+    if (tagsEnd - start >= IGID3v1TagLength && memcmp(bytes + tagsEnd - IGID3v1TagLength, "TAG", 3) == 0)
+    {
+        tagsEnd -= IGID3v1TagLength;
+    }
+    
+    while (YES)
+    {
+        if (tagsEnd - start >= IGAPETagFooterLength && memcmp(bytes + tagsEnd - IGAPETagFooterLength, "APETAGEX", 8) == 0)
+        {
+            // Little endian, the size counts the items and the footer but not the header.
+            const uint8_t *footer = bytes + tagsEnd - IGAPETagFooterLength;
+            NSUInteger tagSize = (NSUInteger)footer[12] | ((NSUInteger)footer[13] << 8) | ((NSUInteger)footer[14] << 16) | ((NSUInteger)footer[15] << 24);
+            uint32_t flags = (uint32_t)footer[20] | ((uint32_t)footer[21] << 8) | ((uint32_t)footer[22] << 16) | ((uint32_t)footer[23] << 24);
+            NSUInteger tagLength = tagSize + ((flags & IGAPETagHeaderPresentFlag) ? IGAPETagFooterLength : 0);
+            if (tagSize < IGAPETagFooterLength || tagLength > tagsEnd - start)
+            {
+                break;
+            }
+            tagsEnd -= tagLength;
+        }
+        else if (tagsEnd - start >= IGID3HeaderLength && memcmp(bytes + tagsEnd - IGID3HeaderLength, "3DI", 3) == 0)
+        {
+            const uint8_t *footer = bytes + tagsEnd - IGID3HeaderLength;
+            if ((footer[6] | footer[7] | footer[8] | footer[9]) & 0x80)
+            {
+                break;
+            }
+            NSUInteger tagSize = ((NSUInteger)footer[6] << 21) | ((NSUInteger)footer[7] << 14) | ((NSUInteger)footer[8] << 7) | (NSUInteger)footer[9];
+            NSUInteger tagLength = 2 * IGID3HeaderLength + tagSize;
+            if (tagLength > tagsEnd - start)
+            {
+                break;
+            }
+            tagsEnd -= tagLength;
+        }
+        else
+        {
+            break;
+        }
+    }
+    
+    return end - tagsEnd;
+}
+
+@interface IGDownloadVerification ()
+
+- (id)initWithFileLength:(int64_t)fileLength
+          expectedLength:(int64_t)expectedLength
+              contentMD5:(NSData *)contentMD5
+        frameSyncChecked:(BOOL)frameSyncChecked
+           corruptRanges:(NSIndexSet *)corruptRanges
+                warnings:(IGDownloadVerificationWarnings)warnings;
+
+@end
+
+@implementation IGDownloadVerifier
+
++ (IGDownloadVerification *)verifyFileAtURL:(NSURL *)fileURL
+                             expectedLength:(int64_t)expectedLength
+                                expectedMD5:(NSData *)expectedMD5
+                                      error:(NSError **)error
+{
+    int fileDescriptor = open([[fileURL path] fileSystemRepresentation], O_RDONLY);
+    struct stat fileStat;
+    if (fileDescriptor < 0 || fstat(fileDescriptor, &fileStat) != 0)
+    {
+        if (error)
+        {
+            NSError *underlyingError = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+            *error = [NSError errorWithDomain:IGDownloadVerifierErrorDomain code:IGDownloadVerifierErrorFileNotReadable userInfo:@{ NSUnderlyingErrorKey: underlyingError }];
+        }
+        if (fileDescriptor >= 0)
+        {
+            close(fileDescriptor);
+        }
+        return nil;
+    }
+    
+    NSUInteger length = (NSUInteger)fileStat.st_size;
+    const uint8_t *bytes = NULL;
+    IGDownloadVerificationWarnings warnings = 0;
+    if (length > 0)
+    {
+        void *mappedBytes = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+        if (mappedBytes == MAP_FAILED)
+        {
+            // Address space runs out before the file does, only its length can be checked.
+            warnings |= IGDownloadVerificationWarningContentNotRead;
+        }
+        else
+        {
+            // Read once from start to end, pages behind the scan can be dropped.
+            madvise(mappedBytes, length, MADV_SEQUENTIAL);
+            bytes = mappedBytes;
+        }
+    }
+    close(fileDescriptor);
+    
+    NSMutableIndexSet *corruptRanges = [NSMutableIndexSet indexSet];
+    NSMutableData *contentMD5 = nil;
+    BOOL frameSyncChecked = NO;
+    if (bytes)
+    {
+        contentMD5 = [NSMutableData dataWithLength:CC_MD5_DIGEST_LENGTH];
+        frameSyncChecked = [self scanBytes:bytes length:length corruptRanges:corruptRanges warnings:&warnings contentMD5:contentMD5];
+        munmap((void *)bytes, length);
+    }
+    
+    if (expectedLength > 0 && (int64_t)length < expectedLength)
+    {
+        [corruptRanges addIndexesInRange:NSMakeRange(length, (NSUInteger)(expectedLength - length))];
+    }
+    else if (expectedLength > 0 && (int64_t)length > expectedLength)
+    {
+        // Extra bytes mean a range was written at the wrong offset, nothing after it is where it belongs.
+        [corruptRanges addIndexesInRange:NSMakeRange(0, (NSUInteger)expectedLength)];
+    }
+    
+    if (contentMD5 && expectedMD5 && ![expectedMD5 isEqualToData:contentMD5] && [corruptRanges count] == 0)
+    {
+        // A hash does not tell which bytes are wrong.
+        [corruptRanges addIndexesInRange:NSMakeRange(0, length)];
+    }
+    
+    return [[IGDownloadVerification alloc] initWithFileLength:length
+                                               expectedLength:expectedLength
+                                                   contentMD5:contentMD5
+                                             frameSyncChecked:frameSyncChecked
+                                                corruptRanges:corruptRanges
+                                                     warnings:warnings];
+}
+
+/**
+ * Follows the chain of MPEG frame headers through the mapped file, adding the ranges where frame sync is lost, and hashes the file on the way.
+ *
+ * @return YES if the file was recognised as MPEG audio, NO otherwise.
+ */
++ (BOOL)scanBytes:(const uint8_t *)bytes
+           length:(NSUInteger)length
+    corruptRanges:(NSMutableIndexSet *)corruptRanges
+         warnings:(IGDownloadVerificationWarnings *)warnings
+       contentMD5:(NSMutableData *)contentMD5
+{
+    CC_MD5_CTX MD5Context;
+    CC_MD5_Init(&MD5Context);
+    NSUInteger hashedLength = 0;
+    
+    NSUInteger audioStart = IGID3TagLength(bytes, length);
+    NSUInteger audioEnd = length - IGTrailingTagsLength(bytes, audioStart, length);
+    
+    // Files that do not start with MPEG frames, such as AAC or video episodes, only have their length and hash checked.
+    NSUInteger offset = IGMPEGNextFrameSyncOffset(bytes, audioStart, MIN(audioStart + IGMPEGFirstFrameSearchLength, audioEnd), audioEnd);
+    BOOL frameSyncChecked = (offset != NSNotFound);
+    NSUInteger lastFrameOffset = offset;
+    while (frameSyncChecked && offset < audioEnd)
+    {
+        if (offset - hashedLength >= IGDownloadVerifierHashChunkLength)
+        {
+            CC_MD5_Update(&MD5Context, bytes + hashedLength, (CC_LONG)(offset - hashedLength));
+            hashedLength = offset;
+        }
+        
+        NSUInteger frameLength = (offset + IGMPEGFrameHeaderLength <= audioEnd) ? IGMPEGFrameLength(bytes + offset) : 0;
+        if (frameLength > 0 && offset + frameLength <= audioEnd)
+        {
+            lastFrameOffset = offset;
+            offset += frameLength;
+            continue;
+        }
+        
+        // Sync is lost inside the previous frame, whose audio data can not be trusted either.
+        NSUInteger syncOffset = IGMPEGNextFrameSyncOffset(bytes, offset + 1, audioEnd, audioEnd);
+        if (syncOffset == NSNotFound)
+        {
+            // Padding or a tag that is not recognised, a missing end is caught by the length check.
+            *warnings |= IGDownloadVerificationWarningUnrecognisedTrailingData;
+            break;
+        }
+        
+        [corruptRanges addIndexesInRange:NSMakeRange(lastFrameOffset, syncOffset - lastFrameOffset)];
+        lastFrameOffset = syncOffset;
+        offset = syncOffset;
+    }
+    
+    if (length > hashedLength)
+    {
+        CC_MD5_Update(&MD5Context, bytes + hashedLength, (CC_LONG)(length - hashedLength));
+    }
+    CC_MD5_Final([contentMD5 mutableBytes], &MD5Context);
+    
+    return frameSyncChecked;
+}
+
++ (BOOL)isEncodedResponse:(NSHTTPURLResponse *)response
+{
+    NSString *contentEncoding = [[response allHeaderFields] objectForKey:@"Content-Encoding"];
+    return (contentEncoding && ![contentEncoding isEqualToString:@"identity"]);
+}
+
++ (int64_t)expectedLengthOfResponse:(NSURLResponse *)response
+{
+    if (![response isKindOfClass:[NSHTTPURLResponse class]])
+    {
+        return MAX([response expectedContentLength], 0);
+    }
+    
+    // The lengths the server sends are those of the encoded body, not of the file that was saved.
+    NSHTTPURLResponse *HTTPResponse = (NSHTTPURLResponse *)response;
+    if ([self isEncodedResponse:HTTPResponse])
+    {
+        return 0;
+    }
+    
+    if ([HTTPResponse statusCode] == 206)
+    {
+        NSString *contentRange = [[HTTPResponse allHeaderFields] objectForKey:@"Content-Range"];
+        NSRange separatorRange = [contentRange rangeOfString:@"/" options:NSBackwardsSearch];
+        if (separatorRange.location == NSNotFound)
+        {
+            return 0;
+        }
+        
+        return MAX([[contentRange substringFromIndex:NSMaxRange(separatorRange)] longLongValue], 0);
+    }
+    
+    return MAX([HTTPResponse expectedContentLength], 0);
+}
+
++ (NSData *)expectedMD5OfResponse:(NSURLResponse *)response
+{
+    if (![response isKindOfClass:[NSHTTPURLResponse class]])
+    {
+        return nil;
+    }
+    
+    NSHTTPURLResponse *HTTPResponse = (NSHTTPURLResponse *)response;
+    if ([HTTPResponse statusCode] != 200 || [self isEncodedResponse:HTTPResponse])
+    {
+        return nil;
+    }
+    
+    NSString *contentMD5 = [[HTTPResponse allHeaderFields] objectForKey:@"Content-MD5"];
+    NSData *MD5 = contentMD5 ? [[NSData alloc] initWithBase64EncodedString:contentMD5 options:0] : nil;
+    
+    return ([MD5 length] == CC_MD5_DIGEST_LENGTH) ? MD5 : nil;
+}
+
+@end
+
+@implementation IGDownloadVerification
+
+- (id)initWithFileLength:(int64_t)fileLength
+          expectedLength:(int64_t)expectedLength
+              contentMD5:(NSData *)contentMD5
+        frameSyncChecked:(BOOL)frameSyncChecked
+           corruptRanges:(NSIndexSet *)corruptRanges
+                warnings:(IGDownloadVerificationWarnings)warnings
+{
+    if (!(self = [super init])) return nil;
+    
+    _fileLength = fileLength;
+    _expectedLength = expectedLength;
+    _contentMD5 = [contentMD5 copy];
+    _frameSyncChecked = frameSyncChecked;
+    _corruptRanges = [corruptRanges copy];
+    _warnings = warnings;
+    
+    return self;
+}
+
+- (BOOL)isValid
+{
+    return (self.fileLength > 0 && [self.corruptRanges count] == 0);
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %lld of %lld bytes, %lu corrupt, warnings %lu>", NSStringFromClass([self class]), self.fileLength, self.expectedLength, (unsigned long)[self.corruptRanges count], (unsigned long)self.warnings];
+}
+
+@end
@@ -21,6 +21,8 @@
 
 #import <CoreData/CoreData.h>
 
+@class IGMediaAsset;
+
 /* Episode Download Statuses */
 typedef enum {
     IGEpisodeDownloadStatusNotDownloading,
@@ -41,6 +43,13 @@ typedef enum {
 
 @interface IGEpisode : NSManagedObject
 
+/**
+ * Indicates the globally unique identifier of the episode, taken from the feed item's guid.
+ *
+ * Episodes are identified by guid rather than title so episodes sharing a title are kept apart.
+ */
+@property (nonatomic, strong) NSString *guid;
+
 /**
  * Indicates how long the episode is in time.
  */
@@ -81,6 +90,16 @@ typedef enum {
  */
 @property (nonatomic, strong) NSString *downloadURL;
 
+/**
+ * Indicates the name of the downloaded episode file in the episodes directory, nil if the episode has not been downloaded.
+ */
+@property (nonatomic, strong) NSString *downloadedFileName;
+
+/**
+ * Indicates the size in bytes of the downloaded episode file, 0 if the episode has not been downloaded.
+ */
+@property (nonatomic, strong) NSNumber *downloadedFileSize;
+
 /**
  * Indicates the current progress of the episode.
  *
@@ -95,11 +114,58 @@ typedef enum {
  */
 
 /**
- * 
+ * Imports an array of IGFeedItem objects as parsed from the podcast feed.
  */
 + (void)importPodcastFeedItems:(NSArray *)feed
                     completion:(void (^) (BOOL success, NSError *error))completion;
 
+/**
+ * Returns the publication date of the newest episode stored, nil if there are no episodes.
+ *
+ * Used to sync only the part of the podcast feed that is newer than what is already stored.
+ */
++ (NSDate *)latestPubDate;
+
+#pragma mark - Finding Episodes
+
+/**
+ * @name Finding Episodes
+ */
+
+/**
+ * Returns the episode with the given guid, nil if there is none.
+ */
++ (instancetype)episodeWithGUID:(NSString *)guid;
+
+/**
+ * Returns the episode with the given identifier, as returned by identifier, nil if there is none. An identifier taken before the episode was given its guid still finds it by its download URL.
+ */
++ (instancetype)episodeWithIdentifier:(NSString *)identifier;
+
+/**
+ * Returns the identifier the episode is looked up by, its guid or, for an episode stored before guids were recorded and not imported since, its download URL.
+ */
+- (NSString *)identifier;
+
+/**
+ * Returns the episode the given media asset was created for, nil if there is none.
+ */
++ (instancetype)episodeWithMediaAsset:(IGMediaAsset *)asset;
+
+/**
+ * Returns the newest episodes that have neither been played nor downloaded, newest first. These are the episodes most likely to be streamed next.
+ *
+ * @param The maximum number of episodes to return.
+ */
++ (NSArray *)latestUnplayedStreamingEpisodesWithLimit:(NSUInteger)limit;
+
+/**
+ * Returns the episodes the user is most likely to play next, downloaded or not. Half-played episodes come first, then the newest unplayed ones, newest first within each.
+ *
+ * @param The maximum number of episodes to return.
+ */
++ (NSArray *)likelyNextEpisodesWithLimit:(NSUInteger)limit;
+
 #pragma mark - File Management
 
 /**
@@ -113,6 +179,20 @@ typedef enum {
  */
 + (NSURL *)episodesDirectory;
 
+/**
+ * Returns the directory episodes are transferred and verified in before they are moved to the episodes directory.
+ *
+ * Nothing in it is recorded as downloaded, or counted against the storage budget.
+ *
+ * @return The directory episodes are transferred and verified in.
+ */
++ (NSURL *)stagingDirectory;
+
+/**
+ * Returns the URL in the staging directory the given episode file is transferred to.
+ */
++ (NSURL *)stagingURLForFileURL:(NSURL *)fileURL;
+
 /**
  * Returns the name of the file the episode will be saved as when downloaded.
  *
@@ -127,20 +207,36 @@ typedef enum {
  */
 - (NSURL *)fileURL;
 
+/**
+ * Returns the full file path the episode with the given download URL is saved to, nil if there is no such episode.
+ *
+ * Can be called from any thread, the episode is looked up in a private context.
+ */
++ (NSURL *)fileURLForDownloadURL:(NSURL *)downloadURL;
+
+/**
+ * Returns the length in bytes the podcast feed declares for the episode with the given download URL, 0 if it declares none or there is no such episode.
+ *
+ * Can be called from any thread, the episode is looked up in a private context.
+ */
++ (int64_t)fileSizeForDownloadURL:(NSURL *)downloadURL;
+
 /**
  * Returns a human readable file size.
  */
 - (NSString *)readableFileSize;
 
 /**
- * Deletes the downloaded episode file from the directory it is saved in.
+ * Deletes the downloaded episode file from the directory it is saved in and clears the recorded download state. The change is not saved, that is left to the caller.
  *
  * If the episode is currently being played, it will be stoped before it gets deleted.
  */
 - (void)deleteDownloadedEpisode;
 
 /**
- * @return YES if the episode has been downloaded, NO otherwise.
+ * Returns YES if the episode has been downloaded, NO otherwise.
+ *
+ * The recorded download state is returned, the file system is not checked.
  */
 - (BOOL)isDownloaded;
 
@@ -149,6 +245,68 @@ typedef enum {
  */
 - (BOOL)isDownloading;
 
+#pragma mark - Recording Download State
+
+/**
+ * @name Recording Download State
+ */
+
+/**
+ * Records that the episode with the given download URL has finished downloading, along with the name and size of its file. Nothing is recorded if the file is not where the episode is saved to.
+ *
+ * Can be called from any thread.
+ *
+ * @param The download URL of the episode.
+ * @param The completion handler block to execute.
+ */
++ (void)recordFinishedDownloadForDownloadURL:(NSURL *)downloadURL
+                                  completion:(void (^) (BOOL success, NSError *error))completion;
+
+/**
+ * Brings the recorded download state of every episode in line with the files in the episodes directory. Episodes whose file has gone are marked as not downloaded, files that have appeared are recorded. Only episodes whose state differs are written.
+ *
+ * @param The completion handler block to execute.
+ */
++ (void)reconcileDownloadedEpisodesWithCompletion:(void (^) (BOOL success, NSError *error))completion;
+
+/**
+ * Reconciles the recorded download state now and again whenever the contents of the episodes directory change. Should be called once at launch.
+ */
++ (void)startReconcilingDownloadedEpisodes;
+
+/**
+ * Removes downloaded episodes until they fit in the storage budget, played episodes first and then the least recently used. The episode playing is never removed.
+ *
+ * @param The name of a file that must not be removed either, such as an episode that has just been downloaded.
+ */
++ (void)enforceStorageBudgetSparingFileName:(NSString *)fileName;
+
+#pragma mark - Playback Position
+
+/**
+ * @name Playback Position
+ */
+
+/**
+ * Folds the positions recorded in the playback journal into the progress of the episodes in the background, and marks the folded positions in the journal once they are saved. Should be called at launch and whenever playback pauses or stops.
+ *
+ * @param The completion handler block to execute.
+ */
++ (void)applyPlaybackJournalWithCompletion:(void (^) (BOOL success, NSError *error))completion;
+
+/**
+ * Records the playback position of the episode of the media asset in the playback journal. The position of an episode the journal can not hold, such as one whose asset carries no identifier, is saved to its progress in the background instead.
+ *
+ * @param The playback position in seconds.
+ * @param The media asset of the episode.
+ */
++ (void)recordPlaybackPosition:(Float64)position forMediaAsset:(IGMediaAsset *)asset;
+
+/**
+ * Returns the playback position of the episode, the latest one in the playback journal if it has not been folded yet.
+ */
+- (NSNumber *)playbackPosition;
+
 #pragma mark - File Media Type
 
 /**
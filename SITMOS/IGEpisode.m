@@ -22,10 +22,16 @@
 #import "IGEpisode.h"
 
 #import "IGNetworkManager.h"
+#import "IGEpisodeStorage.h"
+#import "IGFeedItem.h"
+#import "IGMediaAsset.h"
+#import "IGPlaybackJournal.h"
 #import "IGDefines.h"
-#import "NSDate+Helper.h"
 #import "NSString+MD5.h"
 
+#import <fcntl.h>
+#import <libkern/OSAtomic.h>
+
 @interface IGEpisode ()
 
 /**
@@ -33,10 +39,19 @@
  */
 @property (nonatomic, strong) NSNumber *played;
 
+/**
+ * Indicates if the episode file has been downloaded.
+ */
+@property (nonatomic, strong) NSNumber *downloaded;
+
 @end
 
+/* Coalesces the changes to the episodes directory into one reconcile pass */
+static NSTimeInterval const IGEpisodesDirectoryReconcileDelay = 1.0;
+
 @implementation IGEpisode
 
+@dynamic guid;
 @dynamic duration;
 @dynamic fileSize;
 @dynamic imageURL;
@@ -47,6 +62,9 @@
 @dynamic downloadURL;
 @dynamic progress;
 @dynamic played;
+@dynamic downloaded;
+@dynamic downloadedFileName;
+@dynamic downloadedFileSize;
 
 #pragma mark - Import Podcast Feed Items
 
@@ -62,24 +80,29 @@
         return;
     }
     
-    NSDate *latestEpisodePubDate = latestEpisodePubDate = [NSDate dateFromString:[[feed lastObject] valueForKey:@"pubDate"]
-                                                                      withFormat:IGDateFormatString];;
-    if  ([IGEpisode MR_countOfEntities] > 0)
-    {
-        IGEpisode *latestEpisode = [IGEpisode MR_findFirstOrderedByAttribute:@"pubDate"
-                                                                   ascending:NO];
-        latestEpisodePubDate = [latestEpisode pubDate];
-    }
+    // With no episodes stored, the last item in the feed sets the cut-off for unplayed episodes.
+    NSDate *latestEpisodePubDate = [IGEpisode latestPubDate] ?: [(IGFeedItem *)[feed lastObject] pubDate];
     
-    __block IGEpisode *episode = nil;
     [MagicalRecord saveWithBlock:^(NSManagedObjectContext *localContext) {
-        [feed enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
-            NSString *title = [obj valueForKey:@"title"];
-            episode = [IGEpisode episodeWithTitle:title
-                                        inContext:localContext];
-            [episode MR_importValuesForKeysWithObject:obj];
+        NSMutableDictionary *episodes = [IGEpisode episodesForFeedItems:feed
+                                                              inContext:localContext];
+        [feed enumerateObjectsUsingBlock:^(IGFeedItem *feedItem, NSUInteger idx, BOOL *stop) {
+            if (![feedItem guid])
+            {
+                // Without a guid or an enclosure there is nothing to identify or play.
+                return;
+            }
+            
+            IGEpisode *episode = [episodes objectForKey:[feedItem guid]];
+            if (!episode)
+            {
+                episode = [IGEpisode MR_createInContext:localContext];
+                // A feed listing the same guid twice updates one episode.
+                [episodes setObject:episode forKey:[feedItem guid]];
+            }
+            [episode updateWithFeedItem:feedItem];
             
-            if ([latestEpisodePubDate isEqualToDate:[episode pubDate]] || [[episode pubDate] compare:latestEpisodePubDate] == NSOrderedDescending)
+            if ([episode isInserted] && [[episode pubDate] compare:latestEpisodePubDate] != NSOrderedAscending)
             {
                 // If there are no episodes saved, only mark the latest episode as unplayed or if there are episodes already saved, mark all new episodes as unplayed
                 [episode markAsPlayed:NO];
@@ -93,18 +116,201 @@
     }];
 }
 
-+ (instancetype)episodeWithTitle:(NSString *)title inContext:(NSManagedObjectContext *)context
+/**
+ * Returns YES if the two values are different, treating two nils as equal.
+ */
+static inline BOOL IGValueChanged(id oldValue, id newValue)
+{
+    return oldValue != newValue && ![oldValue isEqual:newValue];
+}
+
+/**
+ * Copies the values of the feed item onto the episode, each attribute is only written when its value has changed so an episode the feed has not changed is not dirtied and saved again. Values missing from the feed item leave the attribute untouched.
+ *
+ * @return YES if any attribute was changed, NO otherwise.
+ */
+- (BOOL)updateWithFeedItem:(IGFeedItem *)feedItem
+{
+    BOOL changed = NO;
+    
+    NSString *guid = [feedItem guid];
+    if (guid && IGValueChanged([self guid], guid))
+    {
+        [self setGuid:guid];
+        changed = YES;
+    }
+    
+    NSString *title = [feedItem title];
+    if (title && IGValueChanged([self title], title))
+    {
+        [self setTitle:title];
+        changed = YES;
+    }
+    
+    NSString *summary = [feedItem summary];
+    if (summary && IGValueChanged([self summary], summary))
+    {
+        [self setSummary:summary];
+        changed = YES;
+    }
+    
+    NSDate *pubDate = [feedItem pubDate];
+    if (pubDate && IGValueChanged([self pubDate], pubDate))
+    {
+        [self setPubDate:pubDate];
+        changed = YES;
+    }
+    
+    // An enclosure without a length or an item without a duration reads as 0, which is not a value to keep.
+    if ([feedItem fileSize] > 0 && [[self fileSize] longLongValue] != [feedItem fileSize])
+    {
+        [self setFileSize:@([feedItem fileSize])];
+        changed = YES;
+    }
+    
+    NSString *duration = ([feedItem duration] > 0) ? [feedItem durationString] : nil;
+    if (duration && IGValueChanged([self duration], duration))
+    {
+        [self setDuration:duration];
+        changed = YES;
+    }
+    
+    NSString *downloadURL = [feedItem downloadURL];
+    if (downloadURL && IGValueChanged([self downloadURL], downloadURL))
+    {
+        [self setDownloadURL:downloadURL];
+        changed = YES;
+    }
+    
+    NSString *mediaType = [feedItem mediaType];
+    if (mediaType && IGValueChanged([self mediaType], mediaType))
+    {
+        [self setMediaType:mediaType];
+        changed = YES;
+    }
+    
+    NSString *imageURL = [feedItem imageURL];
+    if (imageURL && IGValueChanged([self imageURL], imageURL))
+    {
+        [self setImageURL:imageURL];
+        changed = YES;
+    }
+    
+    return changed;
+}
+
++ (NSDate *)latestPubDate
+{
+    IGEpisode *latestEpisode = [IGEpisode MR_findFirstOrderedByAttribute:@"pubDate"
+                                                               ascending:NO];
+    return [latestEpisode pubDate];
+}
+
+/**
+ * Fetches the stored episodes for the given feed items in a single request, keyed by guid.
+ *
+ * Episodes stored before the guid attribute existed are matched by download URL, importing the feed item then sets their guid.
+ */
++ (NSMutableDictionary *)episodesForFeedItems:(NSArray *)feedItems inContext:(NSManagedObjectContext *)context
+{
+    NSArray *guids = [feedItems valueForKey:@"guid"];
+    NSArray *downloadURLs = [feedItems valueForKey:@"downloadURL"];
+    NSPredicate *predicate = [NSPredicate predicateWithFormat:@"guid IN %@ OR (guid == nil AND downloadURL IN %@)", guids, downloadURLs];
+    NSFetchRequest *request = [self MR_requestAllWithPredicate:predicate
+                                                     inContext:context];
+    // Every match is written to, fetching them as faults would cost another trip to the store each.
+    [request setReturnsObjectsAsFaults:NO];
+    NSArray *episodes = [self MR_executeFetchRequest:request
+                                           inContext:context];
+    
+    NSDictionary *guidsByDownloadURL = [NSDictionary dictionaryWithObjects:guids forKeys:downloadURLs];
+    NSMutableDictionary *episodesByGUID = [NSMutableDictionary dictionaryWithCapacity:[feedItems count]];
+    for (IGEpisode *episode in episodes)
+    {
+        NSString *guid = [episode guid] ?: [guidsByDownloadURL objectForKey:[episode downloadURL]];
+        if (guid)
+        {
+            [episodesByGUID setObject:episode forKey:guid];
+        }
+    }
+    
+    return episodesByGUID;
+}
+
+#pragma mark - Finding Episodes
+
++ (instancetype)episodeWithGUID:(NSString *)guid
+{
+    if (!guid)
+    {
+        return nil;
+    }
+    
+    return [self MR_findFirstByAttribute:@"guid"
+                               withValue:guid];
+}
+
++ (instancetype)episodeWithIdentifier:(NSString *)identifier
 {
-    IGEpisode *episode = [self MR_findFirstByAttribute:@"title"
-                                             withValue:title
-                                             inContext:context];
-    if (!episode)
+    return [self episodeWithIdentifier:identifier inContext:[NSManagedObjectContext MR_defaultContext]];
+}
+
++ (instancetype)episodeWithIdentifier:(NSString *)identifier inContext:(NSManagedObjectContext *)context
+{
+    if (!identifier)
     {
-        episode = [self MR_createInContext:context];
-        [episode setTitle:title];
+        return nil;
     }
     
-    return episode;
+    return [self MR_findFirstByAttribute:@"guid" withValue:identifier inContext:context] ?: [self MR_findFirstByAttribute:@"downloadURL" withValue:identifier inContext:context];
+}
+
+- (NSString *)identifier
+{
+    return [self guid] ?: [self downloadURL];
+}
+
++ (instancetype)episodeWithMediaAsset:(IGMediaAsset *)asset
+{
+    if ([asset identifier])
+    {
+        return [self episodeWithIdentifier:[asset identifier]];
+    }
+    
+    // Assets saved before they carried the episode's identifier only know its title.
+    return [self MR_findFirstByAttribute:@"title"
+                               withValue:[asset title]];
+}
+
++ (NSArray *)latestUnplayedStreamingEpisodesWithLimit:(NSUInteger)limit
+{
+    NSFetchRequest *fetchRequest = [IGEpisode MR_requestAllSortedBy:@"pubDate"
+                                                           ascending:NO
+                                                       withPredicate:[NSPredicate predicateWithFormat:@"played == NO AND downloaded == NO AND downloadURL != nil"]];
+    [fetchRequest setFetchLimit:limit];
+    
+    return [IGEpisode MR_executeFetchRequest:fetchRequest];
+}
+
++ (NSArray *)likelyNextEpisodesWithLimit:(NSUInteger)limit
+{
+    NSFetchRequest *halfPlayedRequest = [IGEpisode MR_requestAllSortedBy:@"pubDate"
+                                                                ascending:NO
+                                                            withPredicate:[NSPredicate predicateWithFormat:@"played == NO AND progress > 0"]];
+    [halfPlayedRequest setFetchLimit:limit];
+    NSMutableArray *episodes = [NSMutableArray arrayWithArray:[IGEpisode MR_executeFetchRequest:halfPlayedRequest]];
+    if ([episodes count] >= limit)
+    {
+        return episodes;
+    }
+    
+    NSFetchRequest *unplayedRequest = [IGEpisode MR_requestAllSortedBy:@"pubDate"
+                                                              ascending:NO
+                                                          withPredicate:[NSPredicate predicateWithFormat:@"played == NO AND (progress == nil OR progress == 0)"]];
+    [unplayedRequest setFetchLimit:limit - [episodes count]];
+    [episodes addObjectsFromArray:[IGEpisode MR_executeFetchRequest:unplayedRequest]];
+    
+    return episodes;
 }
 
 #pragma mark - File Management
@@ -127,6 +333,34 @@
     return episodesDirectory;
 }
 
++ (NSURL *)stagingDirectory
+{
+    static NSURL *stagingDirectory = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSURL *cacheDir = [[[NSFileManager defaultManager] URLsForDirectory:NSCachesDirectory
+                                                                  inDomains:NSUserDomainMask] lastObject];
+        stagingDirectory = [cacheDir URLByAppendingPathComponent:@"Staging"];
+        
+        NSError *error = nil;
+        if (![[NSFileManager defaultManager] createDirectoryAtURL:stagingDirectory withIntermediateDirectories:YES attributes:nil error:&error]) {
+            NSLog(@"Failed to create staging dir at %@, reason %@", stagingDirectory, [error localizedDescription]);
+        }
+    });
+    
+    return stagingDirectory;
+}
+
++ (NSURL *)stagingURLForFileURL:(NSURL *)fileURL
+{
+    if (!fileURL)
+    {
+        return nil;
+    }
+    
+    return [[IGEpisode stagingDirectory] URLByAppendingPathComponent:[fileURL lastPathComponent]];
+}
+
 - (NSString *)fileName
 {
     return [NSString stringWithFormat:@"%@.mp3", [self title]];
@@ -134,7 +368,46 @@
 
 - (NSURL *)fileURL
 {
-    return [[IGEpisode episodesDirectory] URLByAppendingPathComponent:[self fileName]];
+    NSString *fileName = [self downloadedFileName] ?: [self fileName];
+    return [[IGEpisode episodesDirectory] URLByAppendingPathComponent:fileName];
+}
+
++ (NSURL *)fileURLForDownloadURL:(NSURL *)downloadURL
+{
+    if (!downloadURL)
+    {
+        return nil;
+    }
+    
+    __block NSURL *fileURL = nil;
+    NSManagedObjectContext *context = [NSManagedObjectContext MR_contextWithParent:[NSManagedObjectContext MR_rootSavingContext]];
+    [context performBlockAndWait:^{
+        IGEpisode *episode = [self MR_findFirstByAttribute:@"downloadURL"
+                                                 withValue:[downloadURL absoluteString]
+                                                 inContext:context];
+        fileURL = [episode fileURL];
+    }];
+    
+    return fileURL;
+}
+
++ (int64_t)fileSizeForDownloadURL:(NSURL *)downloadURL
+{
+    if (!downloadURL)
+    {
+        return 0;
+    }
+    
+    __block int64_t fileSize = 0;
+    NSManagedObjectContext *context = [NSManagedObjectContext MR_contextWithParent:[NSManagedObjectContext MR_rootSavingContext]];
+    [context performBlockAndWait:^{
+        IGEpisode *episode = [self MR_findFirstByAttribute:@"downloadURL"
+                                                 withValue:[downloadURL absoluteString]
+                                                 inContext:context];
+        fileSize = [[episode fileSize] longLongValue];
+    }];
+    
+    return fileSize;
 }
 
 - (NSString *)readableFileSize
@@ -150,31 +423,249 @@
 
 - (void)deleteDownloadedEpisode
 {
-    NSURLSessionDownloadTask *task = [IGNetworkManager downloadTaskForURL:[NSURL URLWithString:self.downloadURL]];
-    if (task)
-    {
-        [task cancel];
-    }
+    [IGNetworkManager cancelDownloadForURL:[NSURL URLWithString:self.downloadURL]];
     
     if ([self isDownloaded])
     {
         NSError *error = nil;
-        if (![[NSFileManager defaultManager] removeItemAtPath:[[self fileURL] path] error:&error])
+        if (![[NSFileManager defaultManager] removeItemAtURL:[self fileURL] error:&error] && [error code] != NSFileNoSuchFileError)
         {
             NSLog(@"Failed to delete episode at %@, reason %@", [[self fileURL] path], [error localizedDescription]);
         }
+        [[IGEpisodeStorage sharedStorage] recordRemovalOfFileWithName:[[self fileURL] lastPathComponent]];
+        
+        [self setDownloaded:@NO];
+        [self setDownloadedFileName:nil];
+        [self setDownloadedFileSize:@0];
     }
 }
 
 - (BOOL)isDownloaded
 {
-    return [[NSFileManager defaultManager] fileExistsAtPath:[[self fileURL] path]];
+    return [[self downloaded] boolValue];
 }
 
 - (BOOL)isDownloading
 {
-    NSURLSessionTask *downloadTask = [IGNetworkManager downloadTaskForURL:[NSURL URLWithString:self.downloadURL]];
-    return downloadTask ? YES : NO;
+    NSURL *downloadURL = [NSURL URLWithString:self.downloadURL];
+    return [IGNetworkManager downloadTaskForURL:downloadURL] || [IGNetworkManager isDownloadScheduledForURL:downloadURL];
+}
+
+#pragma mark - Recording Download State
+
++ (void)recordFinishedDownloadForDownloadURL:(NSURL *)downloadURL
+                                  completion:(void (^) (BOOL success, NSError *error))completion
+{
+    __block NSString *fileName = nil;
+    [MagicalRecord saveWithBlock:^(NSManagedObjectContext *localContext) {
+        IGEpisode *episode = [IGEpisode MR_findFirstByAttribute:@"downloadURL"
+                                                      withValue:[downloadURL absoluteString]
+                                                      inContext:localContext];
+        NSNumber *fileSize = nil;
+        [[episode fileURL] getResourceValue:&fileSize forKey:NSURLFileSizeKey error:nil];
+        fileName = fileSize ? [[episode fileURL] lastPathComponent] : nil;
+        [episode updateDownloadedFileName:fileName
+                                 fileSize:fileSize];
+        [[IGEpisodeStorage sharedStorage] recordFileWithName:fileName size:[fileSize longLongValue]];
+    } completion:^(BOOL success, NSError *error) {
+        if (fileName)
+        {
+            [IGEpisode enforceStorageBudgetSparingFileName:fileName];
+        }
+        
+        if (completion)
+        {
+            completion(success, error);
+        }
+    }];
+}
+
++ (void)reconcileDownloadedEpisodesWithCompletion:(void (^) (BOOL success, NSError *error))completion
+{
+    [MagicalRecord saveWithBlock:^(NSManagedObjectContext *localContext) {
+        // One directory listing replaces a stat per episode.
+        NSArray *fileURLs = [[NSFileManager defaultManager] contentsOfDirectoryAtURL:[IGEpisode episodesDirectory]
+                                                          includingPropertiesForKeys:@[NSURLFileSizeKey]
+                                                                             options:NSDirectoryEnumerationSkipsHiddenFiles
+                                                                               error:nil];
+        NSMutableDictionary *fileSizes = [NSMutableDictionary dictionaryWithCapacity:[fileURLs count]];
+        for (NSURL *fileURL in fileURLs)
+        {
+            NSNumber *fileSize = nil;
+            [fileURL getResourceValue:&fileSize forKey:NSURLFileSizeKey error:nil];
+            [fileSizes setObject:(fileSize ?: @0) forKey:[fileURL lastPathComponent]];
+        }
+        
+        IGEpisodeStorage *episodeStorage = [IGEpisodeStorage sharedStorage];
+        [episodeStorage reconcileWithFileSizes:fileSizes];
+        
+        NSFetchRequest *request = [IGEpisode MR_requestAllInContext:localContext];
+        [request setReturnsObjectsAsFaults:NO];
+        NSArray *episodes = [IGEpisode MR_executeFetchRequest:request
+                                                    inContext:localContext];
+        for (IGEpisode *episode in episodes)
+        {
+            // Episodes downloaded before the download state was recorded are found by the name they were saved as.
+            NSString *fileName = [episode downloadedFileName] ?: [episode fileName];
+            NSNumber *fileSize = [fileSizes objectForKey:fileName];
+            [episode updateDownloadedFileName:(fileSize ? fileName : nil)
+                                     fileSize:fileSize];
+            [episodeStorage recordPlayed:[episode isPlayed] forFileWithName:fileName];
+        }
+    } completion:^(BOOL success, NSError *error) {
+        if (completion)
+        {
+            completion(success, error);
+        }
+    }];
+}
+
++ (void)startReconcilingDownloadedEpisodes
+{
+    static dispatch_source_t source = NULL;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        [IGEpisode reconcileDownloadedEpisodesWithCompletion:nil];
+        
+        int fileDescriptor = open([[[IGEpisode episodesDirectory] path] fileSystemRepresentation], O_EVTONLY);
+        if (fileDescriptor < 0)
+        {
+            NSLog(@"Failed to monitor episodes dir at %@", [IGEpisode episodesDirectory]);
+            return;
+        }
+        
+        dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0);
+        source = dispatch_source_create(DISPATCH_SOURCE_TYPE_VNODE, fileDescriptor, DISPATCH_VNODE_WRITE | DISPATCH_VNODE_DELETE | DISPATCH_VNODE_RENAME, queue);
+        __block int32_t reconcilePending = 0;
+        dispatch_source_set_event_handler(source, ^{
+            if (!OSAtomicCompareAndSwap32Barrier(0, 1, &reconcilePending))
+            {
+                return;
+            }
+            
+            dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(IGEpisodesDirectoryReconcileDelay * NSEC_PER_SEC)), queue, ^{
+                OSAtomicCompareAndSwap32Barrier(1, 0, &reconcilePending);
+                [IGEpisode reconcileDownloadedEpisodesWithCompletion:nil];
+            });
+        });
+        dispatch_source_set_cancel_handler(source, ^{
+            close(fileDescriptor);
+        });
+        dispatch_resume(source);
+    });
+}
+
++ (void)enforceStorageBudgetSparingFileName:(NSString *)fileName
+{
+    IGEpisodeStorage *episodeStorage = [IGEpisodeStorage sharedStorage];
+    NSMutableSet *sparedFileNames = [NSMutableSet set];
+    if (fileName)
+    {
+        [sparedFileNames addObject:fileName];
+    }
+    if ([episodeStorage fileNameInUse])
+    {
+        [sparedFileNames addObject:[episodeStorage fileNameInUse]];
+    }
+    
+    // The episodes removed are marked as not downloaded by the reconciliation that follows the change to the episodes directory.
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
+        [episodeStorage enforceBudgetSparingFileNames:sparedFileNames];
+    });
+}
+
+/**
+ * Records the downloaded file of the episode, a nil file name marks the episode as not downloaded. Each attribute is only written when its value has changed.
+ *
+ * @return YES if any attribute was changed, NO otherwise.
+ */
+- (BOOL)updateDownloadedFileName:(NSString *)fileName fileSize:(NSNumber *)fileSize
+{
+    BOOL changed = NO;
+    
+    NSNumber *downloaded = @(fileName != nil);
+    if (IGValueChanged([self downloaded], downloaded))
+    {
+        [self setDownloaded:downloaded];
+        changed = YES;
+    }
+    
+    if (IGValueChanged([self downloadedFileName], fileName))
+    {
+        [self setDownloadedFileName:fileName];
+        changed = YES;
+    }
+    
+    NSNumber *downloadedFileSize = fileName ? (fileSize ?: @0) : @0;
+    if ([[self downloadedFileSize] longLongValue] != [downloadedFileSize longLongValue])
+    {
+        [self setDownloadedFileSize:downloadedFileSize];
+        changed = YES;
+    }
+    
+    return changed;
+}
+
+#pragma mark - Playback Position
+
++ (void)applyPlaybackJournalWithCompletion:(void (^) (BOOL success, NSError *error))completion
+{
+    IGPlaybackJournal *journal = [IGPlaybackJournal sharedJournal];
+    uint64_t sequenceNumber = 0;
+    NSDictionary *positions = [journal latestPositionsReturningSequenceNumber:&sequenceNumber];
+    if ([positions count] == 0)
+    {
+        if (completion)
+        {
+            completion(YES, nil);
+        }
+        return;
+    }
+    
+    [MagicalRecord saveWithBlock:^(NSManagedObjectContext *localContext) {
+        [positions enumerateKeysAndObjectsUsingBlock:^(NSString *identifier, NSNumber *position, BOOL *stop) {
+            IGEpisode *episode = [IGEpisode episodeWithIdentifier:identifier inContext:localContext];
+            if (episode && ![[episode progress] isEqualToNumber:position])
+            {
+                [episode setProgress:position];
+            }
+        }];
+    } completion:^(BOOL success, NSError *error) {
+        // A save with nothing to write reports NO without an error, the positions are in the store either way
+        if (!error)
+        {
+            [journal removePositionsUpToSequenceNumber:sequenceNumber];
+        }
+        
+        if (completion)
+        {
+            completion(!error, error);
+        }
+    }];
+}
+
++ (void)recordPlaybackPosition:(Float64)position forMediaAsset:(IGMediaAsset *)asset
+{
+    NSString *identifier = [asset identifier];
+    if (!asset || [[IGPlaybackJournal sharedJournal] appendPosition:position forEpisodeWithGUID:identifier])
+    {
+        return;
+    }
+    
+    NSString *title = [asset title];
+    [MagicalRecord saveWithBlock:^(NSManagedObjectContext *localContext) {
+        // Assets saved before they carried the episode's identifier only know its title.
+        IGEpisode *episode = identifier ? [IGEpisode episodeWithIdentifier:identifier inContext:localContext] : [IGEpisode MR_findFirstByAttribute:@"title" withValue:title inContext:localContext];
+        if (episode && ![[episode progress] isEqualToNumber:@(position)])
+        {
+            [episode setProgress:@(position)];
+        }
+    }];
+}
+
+- (NSNumber *)playbackPosition
+{
+    return [[IGPlaybackJournal sharedJournal] positionForEpisodeWithGUID:[self identifier]] ?: [self progress];
 }
 
 #pragma mark - File Media Type
@@ -190,6 +681,11 @@
 {
     [self setPlayed:@(played)];
     
+    if ([self isDownloaded])
+    {
+        [[IGEpisodeStorage sharedStorage] recordPlayed:played forFileWithName:[[self fileURL] lastPathComponent]];
+    }
+    
     NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
     if ([userDefaults boolForKey:IGShowApplicationBadgeForUnseenKey])
     {
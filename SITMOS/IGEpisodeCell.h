@@ -29,6 +29,13 @@
 
 @interface IGEpisodeCell : UITableViewCell
 
+/**
+ * Returns the identifier of the episode.
+ *
+ * @discussion Used to look up the episode the cell is showing.
+ */
+@property (nonatomic, copy) NSString *identifier;
+
 /**
  * Returns the title of the episode.
  */
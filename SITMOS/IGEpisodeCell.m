@@ -22,12 +22,10 @@
 #import "IGEpisodeCell.h"
 
 #import "IGNetworkManager.h"
-#import "NSDate+Helper.h"
+#import "IGDownloadProgressHub.h"
+#import "NSDate+IGDateParsing.h"
 
-static void * IGTaskStateChangedContext = &IGTaskStateChangedContext;
-static void * IGTaskReceivedDataContext = &IGTaskReceivedDataContext;
-
-@interface IGEpisodeCell ()
+@interface IGEpisodeCell () <IGDownloadProgressObserver>
 
 @property (nonatomic, weak) IBOutlet UILabel *titleLabel;
 @property (nonatomic, weak) IBOutlet UILabel *summaryLabel;
@@ -37,8 +35,7 @@ static void * IGTaskReceivedDataContext = &IGTaskReceivedDataContext;
 @property (nonatomic, weak) IBOutlet UIImageView *episodeDownloadedImageView;
 @property (nonatomic, weak) IBOutlet UIProgressView *downloadProgressView;
 @property (nonatomic, weak) IBOutlet UIButton *downloadButton;
-@property (nonatomic, strong) NSURLSessionDownloadTask *downloadTask;
-@property (nonatomic, strong) NSProgress *downloadProgress;
+@property (nonatomic, assign) IGDownloadProgressState downloadProgressState;
 
 @end
 
@@ -46,7 +43,7 @@ static void * IGTaskReceivedDataContext = &IGTaskReceivedDataContext;
 
 - (void)dealloc
 {
-    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    [[IGDownloadProgressHub sharedHub] removeObserver:self forURL:_downloadURL];
 }
 
 - (NSString *)description
@@ -54,66 +51,99 @@ static void * IGTaskReceivedDataContext = &IGTaskReceivedDataContext;
     return [NSString stringWithFormat:@"<Episode Title: %@>", self.title];
 }
 
-#pragma mark - Initializers
+#pragma mark - Download Progress
 
-- (void)awakeFromNib
+- (void)didMoveToWindow
 {
-    [[NSNotificationCenter defaultCenter] addObserver:self
-                                             selector:@selector(downloadTaskDidStart:)
-                                                 name:AFNetworkingTaskDidStartNotification
-                                               object:nil];
+    [super didMoveToWindow];
+    
+    // Only cells on screen observe the progress of their download, cells waiting to be reused do not.
+    if (self.window)
+    {
+        [[IGDownloadProgressHub sharedHub] addObserver:self forURL:self.downloadURL];
+    }
+    else
+    {
+        [[IGDownloadProgressHub sharedHub] removeObserver:self forURL:self.downloadURL];
+    }
 }
 
-#pragma mark - Layout
-
-- (void)layoutSubviews
+- (void)setDownloadURL:(NSURL *)downloadURL
 {
-    [super layoutSubviews];
+    if ([downloadURL isEqual:_downloadURL]) return;
+    
+    IGDownloadProgressHub *progressHub = [IGDownloadProgressHub sharedHub];
+    [progressHub removeObserver:self forURL:_downloadURL];
+    
+    _downloadURL = downloadURL;
     
-    NSURLSessionDownloadTask *task = [IGNetworkManager downloadTaskForURL:self.downloadURL];
-    if (task)
+    if (!downloadURL)
     {
-        self.downloadTask = task;
-        [self layoutForDownloadTaskRunning];
+        [self layoutForDownloadNotRunning];
     }
-    else if (self.downloadTask && ![[self.downloadTask.originalRequest URL] isEqual:self.downloadURL])
+    else if (self.window)
     {
-        // When the cell gets re-used and the re-used cell is now not downloading we need to update the UI.
-        [self layoutForDownloadTaskNotRunning];
+        [progressHub addObserver:self forURL:downloadURL];
     }
 }
 
-- (void)layoutForDownloadTaskRunning
+- (void)downloadProgressDidChange:(IGDownloadProgressSnapshot *)progress
 {
-    if (!self.downloadProgress)
+    if (![progress.downloadURL isEqual:self.downloadURL])
     {
-        self.downloadProgress = [[NSProgress alloc] initWithParent:nil userInfo:@{NSProgressKindFile: NSProgressFileOperationKindDownloading}];
-        self.downloadProgress.kind = NSProgressKindFile;
-        self.downloadProgress.totalUnitCount = [self.downloadTask countOfBytesExpectedToReceive];
-        self.downloadProgress.completedUnitCount = [self.downloadTask countOfBytesReceived];
+        return;
     }
     
-    self.downloadProgressView.progress = [self.downloadProgress fractionCompleted];
-    self.downloadProgressLabel.text = ([self.downloadProgress fractionCompleted] == 0) ? NSLocalizedString(@"Loading", nil) : self.downloadProgress.localizedAdditionalDescription;
-    
-    self.titleLabel.textColor = [self unplayedColor];
+    if (progress.state == IGDownloadProgressStateNone)
+    {
+        [self layoutForDownloadNotRunning];
+    }
+    else
+    {
+        [self layoutForDownloadProgress:progress];
+    }
+}
+
+#pragma mark - Layout
+
+- (void)layoutForDownloadProgress:(IGDownloadProgressSnapshot *)progress
+{
+    if (self.downloadProgressState == IGDownloadProgressStateNone)
+    {
+        self.titleLabel.textColor = [self unplayedColor];
+        
+        [self.downloadProgressView setHidden:NO];
+        [self.downloadProgressLabel setHidden:NO];
+        [self.downloadButton setHidden:NO];
+        [self.summaryLabel setHidden:YES];
+        [self.playedStatusImageView setHidden:YES];
+        [self.pubDateAndTimeLeftLabel setHidden:YES];
+        [self.showNotesButton setHidden:YES];
+    }
     
-    [self.downloadProgressView setHidden:NO];
-    [self.downloadProgressLabel setHidden:NO];
-    [self.downloadButton setHidden:NO];
-    [self.summaryLabel setHidden:YES];
-    [self.playedStatusImageView setHidden:YES];
-    [self.pubDateAndTimeLeftLabel setHidden:YES];
-    [self.showNotesButton setHidden:YES];
+    if (self.downloadProgressState != progress.state)
+    {
+        [self updateDownloadButtonImageForSessionState:(progress.state == IGDownloadProgressStateSuspended) ? NSURLSessionTaskStateSuspended : NSURLSessionTaskStateRunning];
+    }
+    self.downloadProgressState = progress.state;
     
-    [self updateDownloadButtonImageForSessionState:NSURLSessionTaskStateRunning];
+    double fractionCompleted = [progress fractionCompleted];
+    self.downloadProgressView.progress = fractionCompleted;
     
-    [self.downloadTask addObserver:self forKeyPath:@"state" options:NSKeyValueObservingOptionOld|NSKeyValueObservingOptionNew context:IGTaskStateChangedContext];
-    [self.downloadTask addObserver:self forKeyPath:@"countOfBytesReceived" options:NSKeyValueObservingOptionOld|NSKeyValueObservingOptionNew context:IGTaskReceivedDataContext];
+    NSString *progressText = (fractionCompleted == 0) ? NSLocalizedString(@"Loading", nil) : [progress localizedAdditionalDescription];
+    if (![progressText isEqualToString:self.downloadProgressLabel.text])
+    {
+        self.downloadProgressLabel.text = progressText;
+    }
 }
 
-- (void)layoutForDownloadTaskNotRunning
+- (void)layoutForDownloadNotRunning
 {
+    if (self.downloadProgressState == IGDownloadProgressStateNone)
+    {
+        return;
+    }
+    
     self.titleLabel.textColor = (self.playedStatus == IGEpisodePlayedStatusPlayed) ? [self playedColor] : [self unplayedColor];
     
     [self.summaryLabel setHidden:NO];
@@ -124,15 +154,8 @@ static void * IGTaskReceivedDataContext = &IGTaskReceivedDataContext;
     [self.downloadProgressLabel setHidden:YES];
     [self.downloadButton setHidden:YES];
     
-    @try
-    {
-        [self.downloadTask removeObserver:self forKeyPath:@"state" context:IGTaskStateChangedContext];
-        [self.downloadTask removeObserver:self forKeyPath:@"countOfBytesReceived" context:IGTaskReceivedDataContext];
-    } @catch (NSException *exception) {}
-    
     self.downloadProgressView.progress = 0;
-    self.downloadTask = nil;
-    self.downloadProgress = nil;
+    self.downloadProgressState = IGDownloadProgressStateNone;
 }
 
 #pragma mark - Setters
@@ -199,7 +222,7 @@ static void * IGTaskReceivedDataContext = &IGTaskReceivedDataContext;
     
     _pubDate = pubDate;
     
-    [_pubDateAndTimeLeftLabel setText:[NSString stringWithFormat:@"%@ - %@", [NSDate stringFromDate:pubDate withFormat:@"dd MMM yyyy"], _timeLeft]];
+    [_pubDateAndTimeLeftLabel setText:[NSString stringWithFormat:@"%@ - %@", [pubDate displayStringWithFormat:@"dd MMM yyyy"], _timeLeft]];
 }
 
 - (void)setTimeLeft:(NSString *)timeLeft
@@ -208,7 +231,7 @@ static void * IGTaskReceivedDataContext = &IGTaskReceivedDataContext;
     
     _timeLeft = timeLeft;
     
-    [_pubDateAndTimeLeftLabel setText:[NSString stringWithFormat:@"%@ - %@", [NSDate stringFromDate:_pubDate withFormat:@"dd MMM yyyy"], timeLeft]];
+    [_pubDateAndTimeLeftLabel setText:[NSString stringWithFormat:@"%@ - %@", [_pubDate displayStringWithFormat:@"dd MMM yyyy"], timeLeft]];
 }
 
 #pragma mark - Color's for the episode title label
@@ -258,91 +281,4 @@ static void * IGTaskReceivedDataContext = &IGTaskReceivedDataContext;
     }
 }
 
-#pragma mark - Notification
-
-- (void)downloadTaskDidStart:(NSNotification *)notification
-{
-    NSURLSessionDownloadTask *task = (NSURLSessionDownloadTask *)notification.object;
-    if ([[task.originalRequest URL] isEqual:self.downloadURL])
-    {
-        self.downloadTask = task;
-        [self layoutForDownloadTaskRunning];
-    }
-}
-
-#pragma mark - NSKeyValueObserving
-
-- (void)observeValueForKeyPath:(NSString *)keyPath
-                      ofObject:(id)object
-                        change:(NSDictionary *)change
-                       context:(void *)context
-{
-    if (context == IGTaskStateChangedContext && [keyPath isEqualToString:@"state"])
-    {
-        NSURLSessionTask *task = (NSURLSessionTask *)object;
-        if (![[task.originalRequest URL] isEqual:self.downloadURL])
-        {
-            return;
-        }
-        
-        switch (task.state)
-        {
-            case NSURLSessionTaskStateRunning:
-            {
-                dispatch_async(dispatch_get_main_queue(), ^{
-                    [self layoutForDownloadTaskRunning];
-                });
-                break;
-            }
-            case NSURLSessionTaskStateSuspended:
-            {
-                dispatch_async(dispatch_get_main_queue(), ^{
-                    [self updateDownloadButtonImageForSessionState:NSURLSessionTaskStateSuspended];
-                });
-                break;
-            }
-            case NSURLSessionTaskStateCompleted:
-            {
-                dispatch_async(dispatch_get_main_queue(), ^{
-                    if (![object error])
-                    {
-                        self.downloadStatus = IGEpisodeDownloadStatusDownloaded;
-                    }
-                    
-                    [self layoutForDownloadTaskNotRunning];
-                });
-                
-                @try
-                {
-                    [object removeObserver:self forKeyPath:@"state" context:IGTaskStateChangedContext];
-                    [object removeObserver:self forKeyPath:@"countOfBytesReceived" context:IGTaskReceivedDataContext];
-                } @catch (NSException *exception) {}
-                break;
-            }
-            default:
-                break;
-        }
-    }
-    else if (context == IGTaskReceivedDataContext && [keyPath isEqualToString:@"countOfBytesReceived"])
-    {
-        NSURLSessionTask *task = (NSURLSessionTask *)object;
-        if (![[task.originalRequest URL] isEqual:self.downloadURL])
-        {
-            return;
-        }
-
-        self.downloadProgress.totalUnitCount = task.countOfBytesExpectedToReceive;
-        self.downloadProgress.completedUnitCount = task.countOfBytesReceived;
-            
-        dispatch_async(dispatch_get_main_queue(), ^{
-            self.downloadProgressView.progress = self.downloadProgress.fractionCompleted;
-            self.downloadProgressLabel.text = self.downloadProgress.localizedAdditionalDescription;
-        });
-    }
-    else
-    {
-        [super observeValueForKeyPath:keyPath ofObject:object change:change context:context];
-    }
-}
-
 @end
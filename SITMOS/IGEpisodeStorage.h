@@ -0,0 +1,123 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * The IGEpisodeStorage class keeps downloaded episodes within a storage budget.
+ *
+ * An index of the files in the episodes directory records the size of each file, when it was last played or downloaded and whether its episode has been played, and keeps a running total of their size so the space used is known without walking the directory. When the total goes over the budget episodes are removed, played episodes first and then those least recently used. Removing a file is enough for the episode to be marked as not downloaded, the episodes directory is monitored for that.
+ *
+ * Downloads in flight and awaiting verification are kept in the staging directory, so only finished episodes are counted against the budget or removed to make room.
+ */
+@interface IGEpisodeStorage : NSObject
+
+/**
+ * Returns the shared episode storage, which manages the episodes directory and takes its budget from the settings.
+ */
++ (instancetype)sharedStorage;
+
+/**
+ * Initializes an episode storage that manages the files in the given directory.
+ *
+ * @param The directory the episodes are saved in.
+ * @param The file URL to save the index to.
+ */
+- (id)initWithDirectory:(NSURL *)directory indexURL:(NSURL *)indexURL;
+
+/**
+ * The number of bytes the episodes may use, 0 for no limit.
+ */
+@property (atomic, assign) int64_t budget;
+
+/**
+ * The name of the file of the episode loaded for playback, which is never removed.
+ */
+@property (atomic, copy) NSString *fileNameInUse;
+
+/**
+ * The number of bytes the episodes use.
+ */
+- (int64_t)usedSize;
+
+/**
+ * The number of bytes used by episodes that have been played, which are the first to be removed to make room.
+ */
+- (int64_t)playedSize;
+
+#pragma mark - Recording Files
+
+/**
+ * @name Recording Files
+ */
+
+/**
+ * Records a file that has been saved to the episodes directory, replacing any record of a file with the same name. It counts as just used.
+ *
+ * @param The name of the file.
+ * @param The size of the file in bytes.
+ */
+- (void)recordFileWithName:(NSString *)fileName size:(int64_t)size;
+
+/**
+ * Records that a file has been used, which moves it to the back of the files to remove.
+ *
+ * @param The name of the file.
+ */
+- (void)recordAccessToFileWithName:(NSString *)fileName;
+
+/**
+ * Records whether the episode of a file has been played, played episodes are removed first.
+ *
+ * @param YES if the episode has been played, NO otherwise.
+ * @param The name of the file.
+ */
+- (void)recordPlayed:(BOOL)played forFileWithName:(NSString *)fileName;
+
+/**
+ * Records that a file has been removed from the episodes directory.
+ *
+ * @param The name of the file.
+ */
+- (void)recordRemovalOfFileWithName:(NSString *)fileName;
+
+/**
+ * Brings the index in line with the files actually in the episodes directory. Files that are not recorded yet are added as last used when they were modified.
+ *
+ * @param The size of each file in the episodes directory keyed by file name.
+ */
+- (void)reconcileWithFileSizes:(NSDictionary *)fileSizes;
+
+#pragma mark - Enforcing the Budget
+
+/**
+ * @name Enforcing the Budget
+ */
+
+/**
+ * Removes episodes until the files fit in the budget, played episodes first and then the least recently used.
+ *
+ * @param The names of files that must not be removed, such as the episode playing.
+ * @return The names of the files removed.
+ */
+- (NSArray *)enforceBudgetSparingFileNames:(NSSet *)fileNames;
+
+@end
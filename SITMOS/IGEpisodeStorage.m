@@ -0,0 +1,293 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGEpisodeStorage.h"
+
+#import "IGEpisode.h"
+#import "IGDefines.h"
+
+static NSString * const IGEpisodeStorageSizeKey = @"Size";
+static NSString * const IGEpisodeStorageLastUsedDateKey = @"LastUsedDate";
+static NSString * const IGEpisodeStoragePlayedKey = @"Played";
+
+@implementation IGEpisodeStorage
+{
+    NSURL *_directory;
+    NSURL *_indexURL;
+    NSMutableDictionary *_index;
+    int64_t _usedSize;
+}
+
++ (instancetype)sharedStorage
+{
+    static IGEpisodeStorage *sharedStorage = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSURL *episodesDirectory = [IGEpisode episodesDirectory];
+        // Kept beside the episodes directory rather than in it, the directory only holds episodes.
+        NSURL *indexURL = [[episodesDirectory URLByDeletingLastPathComponent] URLByAppendingPathComponent:@"EpisodesStorage.plist"];
+        sharedStorage = [[self alloc] initWithDirectory:episodesDirectory indexURL:indexURL];
+        sharedStorage.budget = [[[NSUserDefaults standardUserDefaults] objectForKey:IGEpisodesStorageBudgetKey] longLongValue];
+    });
+    return sharedStorage;
+}
+
+- (id)initWithDirectory:(NSURL *)directory indexURL:(NSURL *)indexURL
+{
+    if (!(self = [super init])) return nil;
+    
+    _directory = directory;
+    _indexURL = indexURL;
+    _index = [[NSMutableDictionary alloc] init];
+    
+    NSDictionary *index = [NSDictionary dictionaryWithContentsOfURL:indexURL];
+    for (NSString *fileName in index)
+    {
+        NSMutableDictionary *record = [[index objectForKey:fileName] mutableCopy];
+        [_index setObject:record forKey:fileName];
+        _usedSize += [[record objectForKey:IGEpisodeStorageSizeKey] longLongValue];
+    }
+    
+    if (!index)
+    {
+        // Episodes downloaded before the index existed are recorded once, from then on it is kept up to date as files come and go.
+        NSArray *fileURLs = [[NSFileManager defaultManager] contentsOfDirectoryAtURL:directory
+                                                          includingPropertiesForKeys:@[NSURLFileSizeKey]
+                                                                             options:NSDirectoryEnumerationSkipsHiddenFiles
+                                                                               error:nil];
+        NSMutableDictionary *fileSizes = [NSMutableDictionary dictionaryWithCapacity:[fileURLs count]];
+        for (NSURL *fileURL in fileURLs)
+        {
+            NSNumber *fileSize = nil;
+            [fileURL getResourceValue:&fileSize forKey:NSURLFileSizeKey error:nil];
+            [fileSizes setObject:(fileSize ?: @0) forKey:[fileURL lastPathComponent]];
+        }
+        [self reconcileWithFileSizes:fileSizes];
+    }
+    
+    return self;
+}
+
+- (int64_t)usedSize
+{
+    @synchronized(self)
+    {
+        return _usedSize;
+    }
+}
+
+- (int64_t)playedSize
+{
+    @synchronized(self)
+    {
+        int64_t playedSize = 0;
+        for (NSDictionary *record in [_index allValues])
+        {
+            if ([[record objectForKey:IGEpisodeStoragePlayedKey] boolValue])
+            {
+                playedSize += [[record objectForKey:IGEpisodeStorageSizeKey] longLongValue];
+            }
+        }
+        return playedSize;
+    }
+}
+
+#pragma mark - Recording Files
+
+- (void)recordFileWithName:(NSString *)fileName size:(int64_t)size
+{
+    if (!fileName)
+    {
+        return;
+    }
+    
+    @synchronized(self)
+    {
+        _usedSize -= [[[_index objectForKey:fileName] objectForKey:IGEpisodeStorageSizeKey] longLongValue];
+        _usedSize += size;
+        
+        NSMutableDictionary *record = [@{ IGEpisodeStorageSizeKey: @(size),
+                                          IGEpisodeStorageLastUsedDateKey: [NSDate date],
+                                          IGEpisodeStoragePlayedKey: @NO } mutableCopy];
+        [_index setObject:record forKey:fileName];
+        [self saveIndex];
+    }
+}
+
+- (void)recordAccessToFileWithName:(NSString *)fileName
+{
+    @synchronized(self)
+    {
+        NSMutableDictionary *record = fileName ? [_index objectForKey:fileName] : nil;
+        if (!record)
+        {
+            return;
+        }
+        
+        [record setObject:[NSDate date] forKey:IGEpisodeStorageLastUsedDateKey];
+        [self saveIndex];
+    }
+}
+
+- (void)recordPlayed:(BOOL)played forFileWithName:(NSString *)fileName
+{
+    @synchronized(self)
+    {
+        NSMutableDictionary *record = fileName ? [_index objectForKey:fileName] : nil;
+        if (!record || [[record objectForKey:IGEpisodeStoragePlayedKey] boolValue] == played)
+        {
+            return;
+        }
+        
+        [record setObject:@(played) forKey:IGEpisodeStoragePlayedKey];
+        [self saveIndex];
+    }
+}
+
+- (void)recordRemovalOfFileWithName:(NSString *)fileName
+{
+    @synchronized(self)
+    {
+        NSMutableDictionary *record = fileName ? [_index objectForKey:fileName] : nil;
+        if (!record)
+        {
+            return;
+        }
+        
+        _usedSize -= [[record objectForKey:IGEpisodeStorageSizeKey] longLongValue];
+        [_index removeObjectForKey:fileName];
+        [self saveIndex];
+    }
+}
+
+- (void)reconcileWithFileSizes:(NSDictionary *)fileSizes
+{
+    @synchronized(self)
+    {
+        BOOL changed = NO;
+        for (NSString *fileName in [_index allKeys])
+        {
+            if (![fileSizes objectForKey:fileName] || [[fileName pathExtension] isEqualToString:@"part"])
+            {
+                _usedSize -= [[[_index objectForKey:fileName] objectForKey:IGEpisodeStorageSizeKey] longLongValue];
+                [_index removeObjectForKey:fileName];
+                changed = YES;
+            }
+        }
+        
+        for (NSString *fileName in fileSizes)
+        {
+            // Partial files left by segmented downloads from before transfers were staged are not episodes.
+            if ([[fileName pathExtension] isEqualToString:@"part"])
+            {
+                continue;
+            }
+            
+            int64_t size = [[fileSizes objectForKey:fileName] longLongValue];
+            NSMutableDictionary *record = [_index objectForKey:fileName];
+            if (!record)
+            {
+                NSDate *modificationDate = nil;
+                [[_directory URLByAppendingPathComponent:fileName] getResourceValue:&modificationDate forKey:NSURLContentModificationDateKey error:nil];
+                record = [@{ IGEpisodeStorageLastUsedDateKey: (modificationDate ?: [NSDate date]),
+                             IGEpisodeStoragePlayedKey: @NO } mutableCopy];
+                [_index setObject:record forKey:fileName];
+            }
+            else if ([[record objectForKey:IGEpisodeStorageSizeKey] longLongValue] == size)
+            {
+                continue;
+            }
+            
+            _usedSize += size - [[record objectForKey:IGEpisodeStorageSizeKey] longLongValue];
+            [record setObject:@(size) forKey:IGEpisodeStorageSizeKey];
+            changed = YES;
+        }
+        
+        if (changed)
+        {
+            [self saveIndex];
+        }
+    }
+}
+
+- (void)saveIndex
+{
+    [_index writeToURL:_indexURL atomically:YES];
+}
+
+#pragma mark - Enforcing the Budget
+
+- (NSArray *)enforceBudgetSparingFileNames:(NSSet *)fileNames
+{
+    NSMutableArray *removedFileNames = [NSMutableArray array];
+    
+    @synchronized(self)
+    {
+        int64_t budget = self.budget;
+        if (budget <= 0 || _usedSize <= budget)
+        {
+            return removedFileNames;
+        }
+        
+        NSArray *candidates = [[_index allKeys] sortedArrayUsingComparator:^NSComparisonResult(NSString *fileName1, NSString *fileName2) {
+            NSDictionary *record1 = [_index objectForKey:fileName1];
+            NSDictionary *record2 = [_index objectForKey:fileName2];
+            BOOL played1 = [[record1 objectForKey:IGEpisodeStoragePlayedKey] boolValue];
+            BOOL played2 = [[record2 objectForKey:IGEpisodeStoragePlayedKey] boolValue];
+            if (played1 != played2)
+            {
+                return played1 ? NSOrderedAscending : NSOrderedDescending;
+            }
+            
+            return [[record1 objectForKey:IGEpisodeStorageLastUsedDateKey] compare:[record2 objectForKey:IGEpisodeStorageLastUsedDateKey]];
+        }];
+        
+        for (NSString *fileName in candidates)
+        {
+            if (_usedSize <= budget)
+            {
+                break;
+            }
+            
+            if ([fileNames containsObject:fileName])
+            {
+                continue;
+            }
+            
+            NSError *error = nil;
+            if (![[NSFileManager defaultManager] removeItemAtURL:[_directory URLByAppendingPathComponent:fileName] error:&error] && [error code] != NSFileNoSuchFileError)
+            {
+                NSLog(@"Failed to remove episode at %@, reason %@", fileName, [error localizedDescription]);
+                continue;
+            }
+            
+            _usedSize -= [[[_index objectForKey:fileName] objectForKey:IGEpisodeStorageSizeKey] longLongValue];
+            [_index removeObjectForKey:fileName];
+            [removedFileNames addObject:fileName];
+        }
+        
+        [self saveIndex];
+    }
+    
+    return removedFileNames;
+}
+
+@end
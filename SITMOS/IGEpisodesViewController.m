@@ -34,9 +34,20 @@
 #import "UIActionSheet+Blocks.h"
 #import "UIAlertView+Blocks.h"
 #import "IGNetworkManager.h"
+#import "IGHeadPrefetcher.h"
+#import "IGAssetPreparationCache.h"
 #import "UIViewController+IGNowPlayingButton.h"
 #import "TDNotificationPanel.h"
 
+/* How long the list has to rest before the visible episodes are prefetched */
+static NSTimeInterval const IGEpisodesPrefetchLingerDelay = 1.0;
+
+/* The number of newest unplayed episodes prefetched after the feed is refreshed */
+static NSUInteger const IGEpisodesPrefetchLatestCount = 3;
+
+/* The number of episodes likely to be played next whose assets are prepared ahead of a tap */
+static NSUInteger const IGEpisodesPrepareLikelyCount = 3;
+
 @interface IGEpisodesViewController () <NSFetchedResultsControllerDelegate, UISearchBarDelegate, UISearchDisplayDelegate, UIDataSourceModelAssociation, SSPullToRefreshViewDelegate>
 
 @property (nonatomic, weak) IBOutlet UITableView *tableView;
@@ -82,6 +93,8 @@
     self.pullToRefreshView.backgroundColor = [UIColor whiteColor];
     
     [self refreshPodcastFeed];
+    [self prefetchLatestUnplayedEpisodes];
+    [self prepareLikelyEpisodes];
     
     [self observeMediaPlayerNotifications];
 }
@@ -117,8 +130,8 @@
     NSString *identifier = nil;
     if (idx && view)
     {
-        NSDictionary *episode = [self.fetchedResultsController objectAtIndexPath:idx];
-        identifier = [episode valueForKey:@"title"];
+        IGEpisode *episode = [self.fetchedResultsController objectAtIndexPath:idx];
+        identifier = [episode identifier];
     }
     
     return identifier;
@@ -129,9 +142,8 @@
     NSIndexPath *indexPath = nil;
     if (identifier && view)
     {
-        NSPredicate *predicate = [NSPredicate predicateWithFormat:@"title == %@", identifier];
         NSInteger row = [[self.fetchedResultsController fetchedObjects] indexOfObjectPassingTest:^BOOL(id obj, NSUInteger idx, BOOL *stop) {
-            return [predicate evaluateWithObject:obj];
+            return [[obj identifier] isEqualToString:identifier];
         }];
         
         if (row != NSNotFound)
@@ -193,6 +205,24 @@
     return episodeCell;
 }
 
+#pragma mark - UITableViewDelegate
+
+- (void)tableView:(UITableView *)tableView didHighlightRowAtIndexPath:(NSIndexPath *)indexPath
+{
+    // The touch down comes a moment before the tap, which is enough to get the asset's keys loading
+    IGEpisode *episode = nil;
+    if (tableView == self.searchDisplayController.searchResultsTableView)
+    {
+        episode = [self.filteredEpisodeArray objectAtIndex:indexPath.row];
+    }
+    else
+    {
+        episode = [self.fetchedResultsController objectAtIndexPath:indexPath];
+    }
+    
+    [self prepareEpisode:episode];
+}
+
 #pragma mark - NSFetchResultsControllerDelegate
 
 - (void)controllerWillChangeContent:(NSFetchedResultsController *)controller
@@ -263,8 +293,7 @@
     if ([gestureRecognizer state] == UIGestureRecognizerStateBegan && indexPath)
     {
         IGEpisodeCell *episodeCell = (IGEpisodeCell *)[self.tableView cellForRowAtIndexPath:indexPath];
-        IGEpisode *episode = [IGEpisode MR_findFirstByAttribute:@"title"
-                                                      withValue:[episodeCell title]];
+        IGEpisode *episode = [IGEpisode episodeWithIdentifier:[episodeCell identifier]];
         
         NSString *playedItemLabel = [episode isPlayed] ? NSLocalizedString(@"MarkAsUnplayed", nil) : NSLocalizedString(@"MarkAsPlayed", nil);
         BOOL isPlayed = [episode isPlayed] ? NO : YES;
@@ -288,12 +317,15 @@
         {
             deleteDownloadItem = [RIButtonItem itemWithLabel:NSLocalizedString(@"DeleteDownload", nil)];
             deleteDownloadItem.action = ^{
-                [episode deleteDownloadedEpisode];
-                
-                dispatch_async(dispatch_get_main_queue(), ^{
-                    [self.tableView reloadRowsAtIndexPaths:@[indexPath]
-                                          withRowAnimation:UITableViewRowAnimationNone];
-                });
+                [MagicalRecord saveWithBlock:^(NSManagedObjectContext *localContext) {
+                    IGEpisode *localEpisode = [episode MR_inContext:localContext];
+                    [localEpisode deleteDownloadedEpisode];
+                } completion:^(BOOL success, NSError *error) {
+                    dispatch_async(dispatch_get_main_queue(), ^{
+                        [self.tableView reloadRowsAtIndexPaths:@[indexPath]
+                                              withRowAnimation:UITableViewRowAnimationNone];
+                    });
+                }];
             };
         }
         else
@@ -308,17 +340,33 @@
                 else
                 {
                     [self downloadEpisodeFromURL:[NSURL URLWithString:[episode downloadURL]]
-                                      targetPath:[episode fileURL]];
+                                      targetPath:[episode fileURL]
+                            allowsCellularAccess:[[NSUserDefaults standardUserDefaults] boolForKey:IGAllowCellularDataDownloadingKey]];
                 }
             };
         }
         
+        IGMediaPlayer *mediaPlayer = [IGMediaPlayer sharedInstance];
+        IGMediaAsset *asset = [self mediaAssetForEpisode:episode];
+        BOOL isInUpNext = [mediaPlayer isAssetInUpNext:asset];
+        RIButtonItem *upNextItem = [RIButtonItem itemWithLabel:isInUpNext ? NSLocalizedString(@"RemoveFromUpNext", nil) : NSLocalizedString(@"AddToUpNext", nil)];
+        upNextItem.action = ^{
+            if (isInUpNext)
+            {
+                [mediaPlayer removeAssetFromUpNext:asset];
+            }
+            else
+            {
+                [mediaPlayer addAssetToUpNext:asset];
+            }
+        };
+        
         RIButtonItem *cancelItem = [RIButtonItem itemWithLabel:NSLocalizedString(@"Cancel", nil)];
         
         UIActionSheet *actionSheet = [[UIActionSheet alloc] initWithTitle:nil
                                                          cancelButtonItem:cancelItem
                                                     destructiveButtonItem:deleteDownloadItem
-                                                         otherButtonItems:playedItem, downloadItem, nil];
+                                                         otherButtonItems:upNextItem, playedItem, downloadItem, nil];
         [actionSheet showInView:[self view]];
     }
 }
@@ -327,6 +375,7 @@
 
 - (void)updateEpisodeCell:(IGEpisodeCell *)episodeCell episode:(IGEpisode *)episode
 {
+    [episodeCell setIdentifier:[episode identifier]];
     [episodeCell setTitle:[episode title]];
     [episodeCell setSummary:[episode summary]];
     [episodeCell setPubDate:[episode pubDate]];
@@ -343,9 +392,15 @@
     if ([identifier isEqualToString:@"audioPlayerSegue"] && [sender isKindOfClass:[UITableViewCell class]])
     {
         IGEpisodeCell *cell = (IGEpisodeCell *)sender;
-        IGEpisode *episode = [IGEpisode MR_findFirstByAttribute:@"title" withValue:cell.title];
+        IGEpisode *episode = [IGEpisode episodeWithIdentifier:cell.identifier];
         if ([episode isDownloading] || (![episode isDownloaded] && ![IGNetworkManager isNetworkReachable]))
         {
+            if ([episode isDownloading])
+            {
+                // The user wants this episode next, it goes ahead of anything else being downloaded.
+                [IGNetworkManager prioritizeDownloadForURL:[NSURL URLWithString:[episode downloadURL]]];
+            }
+            
             // Do not stream the episode if it is downloading or it is not downloaded and there is no Internet.
             [self.tableView deselectRowAtIndexPath:[self.tableView indexPathForCell:cell]
                                           animated:YES];
@@ -395,15 +450,16 @@
         IGEpisode *episode = nil;
         if ([sender isKindOfClass:[UITableViewCell class]])
         {
+            // Take the episode from the fetched results rather than fetching it again, unless the cell belongs to the search results
             IGEpisodeCell *cell = (IGEpisodeCell *)sender;
-            episode = [IGEpisode MR_findFirstByAttribute:@"title" withValue:cell.title];
+            NSIndexPath *indexPath = [self.tableView indexPathForCell:cell];
+            episode = indexPath ? [self.fetchedResultsController objectAtIndexPath:indexPath] : [IGEpisode episodeWithIdentifier:cell.identifier];
         }
         else
         {
             // Tapped from the nav bar
             IGMediaPlayer *mediaPlayer = [IGMediaPlayer sharedInstance];
-            episode = [IGEpisode MR_findFirstByAttribute:@"title"
-                                               withValue:[mediaPlayer.asset title]];
+            episode = [IGEpisode episodeWithMediaAsset:mediaPlayer.asset];
             
         }
         [audioPlayerViewController loadAudioPlayerWithEpisode:episode];
@@ -453,7 +509,7 @@
 - (void)refreshPodcastFeed
 {
     IGNetworkManager *networkManager = [[IGNetworkManager alloc] init];
-    [networkManager syncPodcastFeedWithCompletion:^(BOOL success, NSArray *feedItems, NSError *error) {
+    [networkManager syncPodcastFeedNewerThanPubDate:[IGEpisode latestPubDate] completion:^(BOOL success, NSArray *feedItems, NSError *error) {
         if (!success && error)
         {
             [TDNotificationPanel showNotificationInView:self.view
@@ -466,28 +522,168 @@
         }
         else
         {
-            [IGEpisode importPodcastFeedItems:feedItems completion:nil];
+            [IGEpisode importPodcastFeedItems:feedItems completion:^(BOOL success, NSError *error) {
+                [self prefetchLatestUnplayedEpisodes];
+                [self prepareLikelyEpisodes];
+            }];
         }
         
         [self.pullToRefreshView finishLoading];
     }];
 }
 
+#pragma mark - Prefetching Streams
+
+/**
+ * Returns YES if the heads of episodes may be fetched ahead of being streamed, which is only done on networks the user allows streaming on.
+ */
+- (BOOL)canPrefetchStreams
+{
+    if (![IGNetworkManager isNetworkReachable])
+    {
+        return NO;
+    }
+    
+    return (![IGNetworkManager isOnCellularNetwork] || [[NSUserDefaults standardUserDefaults] boolForKey:IGAllowCellularDataStreamingKey]);
+}
+
+- (void)prefetchLatestUnplayedEpisodes
+{
+    if (![self canPrefetchStreams])
+    {
+        return;
+    }
+    
+    NSArray *episodes = [IGEpisode latestUnplayedStreamingEpisodesWithLimit:IGEpisodesPrefetchLatestCount];
+    NSMutableArray *downloadURLs = [NSMutableArray arrayWithCapacity:[episodes count]];
+    for (IGEpisode *episode in episodes)
+    {
+        [downloadURLs addObject:[NSURL URLWithString:[episode downloadURL]]];
+    }
+    
+    [[IGHeadPrefetcher sharedPrefetcher] prefetchHeadsForURLs:downloadURLs];
+}
+
+/**
+ * Prefetches the heads of the visible episodes that are not downloaded, called once the user has stopped scrolling on them for a moment.
+ */
+- (void)prefetchVisibleEpisodes
+{
+    if (![self canPrefetchStreams])
+    {
+        return;
+    }
+    
+    NSMutableArray *downloadURLs = [NSMutableArray array];
+    for (NSIndexPath *indexPath in [self.tableView indexPathsForVisibleRows])
+    {
+        IGEpisode *episode = [self.fetchedResultsController objectAtIndexPath:indexPath];
+        if (![episode isDownloaded] && [episode downloadURL])
+        {
+            [downloadURLs addObject:[NSURL URLWithString:[episode downloadURL]]];
+        }
+    }
+    
+    [[IGHeadPrefetcher sharedPrefetcher] prefetchHeadsForURLs:downloadURLs];
+}
+
+- (void)schedulePrefetchOfVisibleEpisodes
+{
+    [NSObject cancelPreviousPerformRequestsWithTarget:self
+                                             selector:@selector(prefetchVisibleEpisodes)
+                                               object:nil];
+    [self performSelector:@selector(prefetchVisibleEpisodes)
+               withObject:nil
+               afterDelay:IGEpisodesPrefetchLingerDelay];
+}
+
+#pragma mark - Preparing Assets
+
+/**
+ * Returns a media asset for the episode, playing its file when it is downloaded and streaming it otherwise.
+ */
+- (IGMediaAsset *)mediaAssetForEpisode:(IGEpisode *)episode
+{
+    NSURL *contentURL = ([episode isDownloaded]) ? [episode fileURL] : [NSURL URLWithString:[episode downloadURL]];
+    
+    return [[IGMediaAsset alloc] initWithTitle:[episode title]
+                                    identifier:[episode identifier]
+                                    contentURL:contentURL
+                                       isAudio:[episode isAudio]];
+}
+
+/**
+ * Prepares the asset of the episode so playback can begin straight away. Streamed episodes are only prepared on networks the user allows streaming on.
+ */
+- (void)prepareEpisode:(IGEpisode *)episode
+{
+    if (!episode || (![episode isDownloaded] && (![episode downloadURL] || ![self canPrefetchStreams])))
+    {
+        return;
+    }
+    
+    [[IGAssetPreparationCache sharedCache] prepareAsset:[self mediaAssetForEpisode:episode]];
+}
+
+/**
+ * Prepares the assets of the half-played and newest unplayed episodes.
+ */
+- (void)prepareLikelyEpisodes
+{
+    for (IGEpisode *episode in [IGEpisode likelyNextEpisodesWithLimit:IGEpisodesPrepareLikelyCount])
+    {
+        [self prepareEpisode:episode];
+    }
+}
+
+#pragma mark - UIScrollViewDelegate
+
+- (void)scrollViewWillBeginDragging:(UIScrollView *)scrollView
+{
+    [NSObject cancelPreviousPerformRequestsWithTarget:self
+                                             selector:@selector(prefetchVisibleEpisodes)
+                                               object:nil];
+}
+
+- (void)scrollViewDidEndDragging:(UIScrollView *)scrollView willDecelerate:(BOOL)decelerate
+{
+    if (!decelerate && scrollView == self.tableView)
+    {
+        [self schedulePrefetchOfVisibleEpisodes];
+    }
+}
+
+- (void)scrollViewDidEndDecelerating:(UIScrollView *)scrollView
+{
+    if (scrollView == self.tableView)
+    {
+        [self schedulePrefetchOfVisibleEpisodes];
+    }
+}
+
 #pragma mark - Episode Download Methods
 
 - (void)showAllowCellularDataDownloadingAlertWithDownloadURL:(NSURL *)downloadURL targetPath:(NSURL *)targetPath
 {
     RIButtonItem *cancelItem = [RIButtonItem itemWithLabel:NSLocalizedString(@"No", nil)];
+    RIButtonItem *waitItem = [RIButtonItem itemWithLabel:NSLocalizedString(@"DownloadOnWiFi", nil)];
+    waitItem.action = ^{
+        // Parked by the download scheduler until there is Wi-Fi.
+        [self downloadEpisodeFromURL:downloadURL
+                          targetPath:targetPath
+                allowsCellularAccess:NO];
+    };
     RIButtonItem *downloadItem = [RIButtonItem itemWithLabel:NSLocalizedString(@"Download", nil)];
     downloadItem.action = ^{
         [self downloadEpisodeFromURL:downloadURL
-                          targetPath:targetPath];
+                          targetPath:targetPath
+                allowsCellularAccess:YES];
     };
     
     UIAlertView *alertView = [[UIAlertView alloc] initWithTitle:NSLocalizedString(@"DownloadingWithCellularDataAlertTitle", nil)
                                                         message:NSLocalizedString(@"DownloadingWithCellularDataAlertMessage", nil)
                                                cancelButtonItem:cancelItem
-                                               otherButtonItems:downloadItem, nil];
+                                               otherButtonItems:waitItem, downloadItem, nil];
     [alertView show];
 }
 
@@ -496,15 +692,16 @@
  *
  * @param downloadFromURL The URL to download the episode from.
  * @param targetPath The path to save the episode to.
+ * @param allowsCellularAccess YES if the download may use cellular data, NO if it waits for WiFi.
  */
-- (void)downloadEpisodeFromURL:(NSURL *)downloadURL targetPath:(NSURL *)targetPath
+- (void)downloadEpisodeFromURL:(NSURL *)downloadURL targetPath:(NSURL *)targetPath allowsCellularAccess:(BOOL)allowsCellularAccess
 {
     IGNetworkManager *networkManager = [[IGNetworkManager alloc] init];
-    [networkManager downloadEpisodeWithDownloadURL:downloadURL destinationURL:targetPath completion:^(BOOL success, NSError *error) {
+    [networkManager downloadEpisodeWithDownloadURL:downloadURL destinationURL:targetPath priority:IGDownloadPriorityUserRequested allowsCellularAccess:allowsCellularAccess completion:^(BOOL success, NSError *error) {
         // Don't display an error notification when the user cancels the download (error code -999).
         if (error && [error code] != -999)
         {
-            IGEpisode *episode = [IGEpisode MR_findFirstByAttribute:@"downloadURL" withValue:downloadURL];
+            IGEpisode *episode = [IGEpisode MR_findFirstByAttribute:@"downloadURL" withValue:[downloadURL absoluteString]];
             [TDNotificationPanel showNotificationInView:self.view
                                                   title:[NSString stringWithFormat:NSLocalizedString(@"EpisodeFailedToDownload", nil), episode.title]
                                                subtitle:[error localizedDescription]
@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * The IGFeedItem class is an immutable record of a single <item> in the podcast feed.
+ *
+ * Values are kept in their parsed types so nothing has to be formatted to a string and read back again on import.
+ */
+
+@interface IGFeedItem : NSObject <NSCopying>
+
+/**
+ * Indicates the globally unique identifier of the item, the enclosure URL if the feed does not give one.
+ */
+@property (nonatomic, copy, readonly) NSString *guid;
+
+/**
+ * Indicates the title of the item.
+ */
+@property (nonatomic, copy, readonly) NSString *title;
+
+/**
+ * Indicates a summary describing what the item is about.
+ */
+@property (nonatomic, copy, readonly) NSString *summary;
+
+/**
+ * Indicates the date the item was published.
+ */
+@property (nonatomic, strong, readonly) NSDate *pubDate;
+
+/**
+ * Indicates the length of the enclosure in bytes, 0 if unknown.
+ */
+@property (nonatomic, assign, readonly) int64_t fileSize;
+
+/**
+ * Indicates how long the item is in seconds, 0 if unknown.
+ */
+@property (nonatomic, assign, readonly) NSInteger duration;
+
+/**
+ * Indicates the URL of the enclosure.
+ */
+@property (nonatomic, copy, readonly) NSString *downloadURL;
+
+/**
+ * Indicates the media type of the enclosure eg. audio/mpeg.
+ */
+@property (nonatomic, copy, readonly) NSString *mediaType;
+
+/**
+ * Indicates the URL of the item's artwork.
+ */
+@property (nonatomic, copy, readonly) NSString *imageURL;
+
+/**
+ * Creates a feed item with the given values. The download URL is used as the guid if guid is empty.
+ */
+- (id)initWithGUID:(NSString *)guid
+             title:(NSString *)title
+           summary:(NSString *)summary
+           pubDate:(NSDate *)pubDate
+          fileSize:(int64_t)fileSize
+          duration:(NSInteger)duration
+       downloadURL:(NSString *)downloadURL
+         mediaType:(NSString *)mediaType
+          imageURL:(NSString *)imageURL;
+
+/**
+ * Returns the duration formatted for display eg. 31:15 or 1:02:03.
+ *
+ * The episode entity stores the duration in this form.
+ */
+- (NSString *)durationString;
+
+/**
+ * Returns the number of seconds in an itunes:duration value, which may be given as HH:MM:SS, MM:SS or SS.
+ */
++ (NSInteger)durationFromString:(NSString *)string;
+
+@end
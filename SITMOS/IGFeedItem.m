@@ -0,0 +1,98 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGFeedItem.h"
+
+@implementation IGFeedItem
+
+- (id)initWithGUID:(NSString *)guid
+             title:(NSString *)title
+           summary:(NSString *)summary
+           pubDate:(NSDate *)pubDate
+          fileSize:(int64_t)fileSize
+          duration:(NSInteger)duration
+       downloadURL:(NSString *)downloadURL
+         mediaType:(NSString *)mediaType
+          imageURL:(NSString *)imageURL {
+    if (!(self = [super init])) {
+        return nil;
+    }
+    
+    _guid = [guid length] > 0 ? [guid copy] : [downloadURL copy];
+    _title = [title copy];
+    _summary = [summary copy];
+    _pubDate = pubDate;
+    _fileSize = fileSize;
+    _duration = duration;
+    _downloadURL = [downloadURL copy];
+    _mediaType = [mediaType copy];
+    _imageURL = [imageURL copy];
+    
+    return self;
+}
+
+- (NSString *)durationString {
+    NSInteger hours = _duration / 3600;
+    NSInteger minutes = (_duration / 60) % 60;
+    NSInteger seconds = _duration % 60;
+    
+    if (hours > 0) {
+        return [NSString stringWithFormat:@"%ld:%02ld:%02ld", (long)hours, (long)minutes, (long)seconds];
+    }
+    
+    return [NSString stringWithFormat:@"%ld:%02ld", (long)minutes, (long)seconds];
+}
+
++ (NSInteger)durationFromString:(NSString *)string {
+    NSInteger duration = 0;
+    NSInteger component = 0;
+    NSUInteger length = [string length];
+    
+    for (NSUInteger i = 0; i < length; i++) {
+        unichar c = [string characterAtIndex:i];
+        if (c >= '0' && c <= '9') {
+            component = component * 10 + (c - '0');
+        } else if (c == ':') {
+            duration = (duration + component) * 60;
+            component = 0;
+        } else if (c == '.') {
+            // Fractions of a second are dropped.
+            break;
+        }
+    }
+    
+    return duration + component;
+}
+
+#pragma mark - NSCopying
+
+- (id)copyWithZone:(NSZone *)zone {
+    // Immutable, a copy can share the instance.
+    return self;
+}
+
+#pragma mark - NSObject
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@: %p, guid: %@, title: %@, pubDate: %@>", NSStringFromClass([self class]), self, _guid, _title, _pubDate];
+}
+
+@end
@@ -0,0 +1,76 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class IGStreamingCache;
+
+/**
+ * The IGHeadPrefetcher class fetches the first bytes of episodes that are likely to be streamed into the streaming cache, so playback can start from local bytes while the rest is fetched.
+ *
+ * The head is headLength bytes of audio. When the file starts with an ID3v2 tag, which can hold large artwork, the tag is fetched in full on top of that. The length and type of the file are recorded in the cache along with the bytes, so the player does not have to ask the server for them either.
+ *
+ * @see IGMediaResourceLoader
+ */
+@interface IGHeadPrefetcher : NSObject
+
+/**
+ * Returns the shared head prefetcher, which prefetches into the shared streaming cache.
+ */
++ (instancetype)sharedPrefetcher;
+
+/**
+ * Initializes a head prefetcher that prefetches into the given streaming cache.
+ *
+ * @param The streaming cache to prefetch into.
+ */
+- (id)initWithStreamingCache:(IGStreamingCache *)streamingCache;
+
+/**
+ * The number of bytes of audio prefetched. Defaults to 256 KB, roughly the first 15 seconds of a 128 kbps episode.
+ */
+@property (nonatomic, assign) int64_t headLength;
+
+/**
+ * The maximum number of heads fetched at once. Defaults to 2.
+ */
+@property (nonatomic, assign) NSUInteger maximumConcurrentPrefetches;
+
+/**
+ * Queues the heads of the files to be prefetched. The files are put in front of those already waiting, the first URL is prefetched first. Files whose head is cached are skipped.
+ *
+ * @param The URLs of the remote files.
+ */
+- (void)prefetchHeadsForURLs:(NSArray *)URLs;
+
+/**
+ * Removes every file waiting to be prefetched. Prefetches already running are finished.
+ */
+- (void)cancelWaitingPrefetches;
+
+/**
+ * Returns YES if the head of the file is cached, NO otherwise.
+ *
+ * @param The URL of the remote file.
+ */
+- (BOOL)isHeadCachedForURL:(NSURL *)URL;
+
+@end
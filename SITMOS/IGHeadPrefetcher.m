@@ -0,0 +1,180 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGHeadPrefetcher.h"
+
+#import "IGStreamingCache.h"
+
+static int64_t const IGHeadPrefetcherDefaultHeadLength = 256 * 1024;
+static NSUInteger const IGHeadPrefetcherDefaultMaximumConcurrentPrefetches = 2;
+
+/* ID3v2 Tag Header */
+static NSUInteger const IGID3HeaderLength = 10;
+static uint8_t const IGID3FooterPresentFlag = 0x10;
+
+@implementation IGHeadPrefetcher
+{
+    IGStreamingCache *_streamingCache;
+    dispatch_queue_t _queue;
+    NSMutableArray *_waitingURLs;
+    NSMutableDictionary *_runningEntries;
+}
+
++ (instancetype)sharedPrefetcher
+{
+    static IGHeadPrefetcher *sharedPrefetcher = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedPrefetcher = [[self alloc] initWithStreamingCache:[IGStreamingCache sharedCache]];
+    });
+    return sharedPrefetcher;
+}
+
+- (id)initWithStreamingCache:(IGStreamingCache *)streamingCache
+{
+    if (!(self = [super init])) return nil;
+    
+    _streamingCache = streamingCache;
+    _queue = dispatch_queue_create("com.idlegeniussoftware.sitmos.head-prefetcher", DISPATCH_QUEUE_SERIAL);
+    _waitingURLs = [[NSMutableArray alloc] init];
+    _runningEntries = [[NSMutableDictionary alloc] init];
+    _headLength = IGHeadPrefetcherDefaultHeadLength;
+    _maximumConcurrentPrefetches = IGHeadPrefetcherDefaultMaximumConcurrentPrefetches;
+    
+    return self;
+}
+
+#pragma mark - Prefetching
+
+- (void)prefetchHeadsForURLs:(NSArray *)URLs
+{
+    dispatch_async(_queue, ^{
+        NSUInteger index = 0;
+        for (NSURL *URL in URLs)
+        {
+            if ([_runningEntries objectForKey:URL] || [self isHeadCachedForURL:URL])
+            {
+                continue;
+            }
+            
+            [_waitingURLs removeObject:URL];
+            [_waitingURLs insertObject:URL atIndex:index++];
+        }
+        
+        [self startWaitingPrefetches];
+    });
+}
+
+- (void)cancelWaitingPrefetches
+{
+    dispatch_async(_queue, ^{
+        [_waitingURLs removeAllObjects];
+    });
+}
+
+- (BOOL)isHeadCachedForURL:(NSURL *)URL
+{
+    IGStreamingCacheEntry *entry = [_streamingCache existingEntryForURL:URL];
+    return (entry && ([entry isComplete] || [entry cachedLengthFromOffset:0] >= [self headLengthOfEntry:entry]));
+}
+
+/**
+ * Must be called on the prefetcher's queue.
+ */
+- (void)startWaitingPrefetches
+{
+    while ([_runningEntries count] < MAX(self.maximumConcurrentPrefetches, 1) && [_waitingURLs count] > 0)
+    {
+        NSURL *URL = [_waitingURLs firstObject];
+        [_waitingURLs removeObjectAtIndex:0];
+        [self prefetchHeadForURL:URL];
+    }
+}
+
+- (void)prefetchHeadForURL:(NSURL *)URL
+{
+    IGStreamingCacheEntry *entry = [_streamingCache entryForURL:URL];
+    int64_t cachedLength = [entry cachedLengthFromOffset:0];
+    int64_t missingLength = [self headLengthOfEntry:entry] - cachedLength;
+    if (missingLength <= 0 || [entry isComplete])
+    {
+        return;
+    }
+    
+    // The entry is kept alive while its head is being fetched.
+    [_runningEntries setObject:entry forKey:URL];
+    
+    [entry fetchFromOffset:cachedLength length:missingLength dataHandler:nil completion:^(NSError *error) {
+        dispatch_async(_queue, ^{
+            [_runningEntries removeObjectForKey:URL];
+            
+            // Once the start of the file is known it may turn out the ID3 tag needs fetching too.
+            BOOL madeProgress = ([entry cachedLengthFromOffset:0] > cachedLength);
+            if (!error && madeProgress && ![self isHeadCachedForURL:URL])
+            {
+                [_waitingURLs insertObject:URL atIndex:0];
+            }
+            
+            [self startWaitingPrefetches];
+        });
+    }];
+}
+
+#pragma mark - ID3 Tag
+
+/**
+ * Returns the number of bytes from the start of the file that make up the head, which is the ID3v2 tag, if the file has one, followed by headLength bytes of audio.
+ */
+- (int64_t)headLengthOfEntry:(IGStreamingCacheEntry *)entry
+{
+    int64_t headLength = self.headLength;
+    if ([entry cachedLengthFromOffset:0] >= IGID3HeaderLength)
+    {
+        headLength += [self ID3TagLengthOfHeader:[entry readDataFromOffset:0 length:IGID3HeaderLength]];
+    }
+    
+    int64_t contentLength = [entry contentLength];
+    return (contentLength > 0) ? MIN(headLength, contentLength) : headLength;
+}
+
+/**
+ * Returns the length of the ID3v2 tag including its header and footer, 0 if the header is not that of an ID3v2 tag. The tag size is stored as a 28 bit synchsafe integer, the top bit of each byte is always 0.
+ */
+- (int64_t)ID3TagLengthOfHeader:(NSData *)header
+{
+    if ([header length] < IGID3HeaderLength)
+    {
+        return 0;
+    }
+    
+    const uint8_t *bytes = [header bytes];
+    if (bytes[0] != 'I' || bytes[1] != 'D' || bytes[2] != '3' || (bytes[6] | bytes[7] | bytes[8] | bytes[9]) & 0x80)
+    {
+        return 0;
+    }
+    
+    int64_t tagSize = ((int64_t)bytes[6] << 21) | ((int64_t)bytes[7] << 14) | ((int64_t)bytes[8] << 7) | (int64_t)bytes[9];
+    int64_t footerLength = (bytes[5] & IGID3FooterPresentFlag) ? IGID3HeaderLength : 0;
+    
+    return IGID3HeaderLength + tagSize + footerLength;
+}
+
+@end
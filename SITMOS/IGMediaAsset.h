@@ -21,6 +21,8 @@
 
 #import <Foundation/Foundation.h>
 
+@class AVURLAsset;
+
 @interface IGMediaAsset : NSObject
 
 /**
@@ -28,6 +30,11 @@
  */
 @property (readonly, nonatomic, copy) NSString *title;
 
+/**
+ * The identifier of the model object the asset was created for, such as an episode's identifier. (read-only)
+ */
+@property (readonly, nonatomic, copy) NSString *identifier;
+
 /**
  * The URL with which the asset was initialized. (read-only)
  */
@@ -43,13 +50,33 @@
  */
 
 /**
- * Initializes a new media asset with the specified title, content url and is audio. This is the designated initializer.
+ * Initializes a new media asset with the specified title, identifier, content url and is audio. This is the designated initializer.
  *
  * @param title The title of the media playing.
+ * @param identifier The identifier of the model object the media belongs to.
  * @param contentURL The location of the media
  */
 - (id)initWithTitle:(NSString *)title
+         identifier:(NSString *)identifier
          contentURL:(NSURL *)contentURL
             isAudio:(BOOL)audio;
 
+/**
+ * Initializes a new media asset without an identifier.
+ */
+- (id)initWithTitle:(NSString *)title
+         contentURL:(NSURL *)contentURL
+            isAudio:(BOOL)audio;
+
+/**
+ * @name Creating the Player Asset
+ */
+
+/**
+ * Returns a new AVURLAsset for the content URL. Remote content is loaded through the streaming cache, so bytes that have been streamed once are not fetched again.
+ *
+ * @see IGMediaResourceLoader
+ */
+- (AVURLAsset *)URLAsset;
+
 @end
@@ -21,13 +21,19 @@
 
 #import "IGMediaAsset.h"
 
+#import "IGMediaResourceLoader.h"
+
+#import <AVFoundation/AVFoundation.h>
+
 NSString * const IGMediaAssetTitleKey = @"MediaAssetTitle";
+NSString * const IGMediaAssetIdentifierKey = @"MediaAssetIdentifier";
 NSString * const IGMediaAssetContentURLKey = @"MediaAssetContentURL";
 NSString * const IGMediaAssetAudioKey = @"MediaAssetAudio";
 
 @interface IGMediaAsset () <NSCoding>
 
 @property (readwrite, nonatomic, copy) NSString *title;
+@property (readwrite, nonatomic, copy) NSString *identifier;
 @property (readwrite, nonatomic, copy) NSURL *contentURL;
 @property (readwrite, nonatomic, assign, getter = isAudio) BOOL audio;
 
@@ -36,27 +42,54 @@ NSString * const IGMediaAssetAudioKey = @"MediaAssetAudio";
 @implementation IGMediaAsset
 
 - (id)initWithTitle:(NSString *)title
+         identifier:(NSString *)identifier
          contentURL:(NSURL *)contentURL
             isAudio:(BOOL)audio
 {
     if (!(self = [super init])) return nil;
     
     self.title = title;
+    self.identifier = identifier;
     self.contentURL = contentURL;
     self.audio = audio;
     
     return self;
 }
 
+- (id)initWithTitle:(NSString *)title
+         contentURL:(NSURL *)contentURL
+            isAudio:(BOOL)audio
+{
+    return [self initWithTitle:title
+                    identifier:nil
+                    contentURL:contentURL
+                       isAudio:audio];
+}
+
+#pragma mark - Creating the Player Asset
+
+- (AVURLAsset *)URLAsset
+{
+    NSString *scheme = [[self.contentURL scheme] lowercaseString];
+    if ([scheme isEqualToString:@"http"] || [scheme isEqualToString:@"https"])
+    {
+        return [IGMediaResourceLoader URLAssetWithURL:self.contentURL];
+    }
+    
+    return [AVURLAsset URLAssetWithURL:self.contentURL options:nil];
+}
+
 #pragma mark - NSCoding
 
 - (id)initWithCoder:(NSCoder *)decoder
 {
     NSString *title = [decoder decodeObjectForKey:IGMediaAssetTitleKey];
+    NSString *identifier = [decoder decodeObjectForKey:IGMediaAssetIdentifierKey];
     NSURL *contentURL = [decoder decodeObjectForKey:IGMediaAssetContentURLKey];
     BOOL isAudio = [decoder decodeBoolForKey:IGMediaAssetAudioKey];
     
     self = [self initWithTitle:title
+                    identifier:identifier
                     contentURL:contentURL
                        isAudio:isAudio];
     
@@ -66,6 +99,7 @@ NSString * const IGMediaAssetAudioKey = @"MediaAssetAudio";
 - (void)encodeWithCoder:(NSCoder *)encoder
 {
     [encoder encodeObject:self.title forKey:IGMediaAssetTitleKey];
+    [encoder encodeObject:self.identifier forKey:IGMediaAssetIdentifierKey];
     [encoder encodeObject:self.contentURL forKey:IGMediaAssetContentURLKey];
     [encoder encodeBool:self.isAudio forKey:IGMediaAssetAudioKey];
 }
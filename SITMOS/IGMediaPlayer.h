@@ -32,6 +32,7 @@ extern NSString * const IGMediaPlayerPlaybackStateSeekingBackwardNotification;
 extern NSString * const IGMediaPlayerPlaybackStateFailedNotification;
 extern NSString * const IGMediaPlayerPlaybackStateDidReachEndNotification;
 extern NSString * const IGMediaPlayerPlaybackLikelyToKeepUpNotification;
+extern NSString * const IGMediaPlayerCurrentAssetDidChangeNotification;
 
 typedef enum {
     IGMediaPlayerPlaybackStateLoading,
@@ -48,9 +49,13 @@ typedef enum {
 
 typedef void (^IGMediaPlayerPausedBlock)(Float64 currentTime);
 typedef void (^IGMediaPlayerStoppedBlock)(Float64 currentTime, BOOL playbackEnded);
+typedef void (^IGMediaPlayerPositionBlock)(Float64 currentTime);
+typedef void (^IGMediaPlayerProgressBlock)(Float64 currentTime, Float64 duration);
 
 @class IGMediaAsset;
 
+typedef Float64 (^IGMediaPlayerUpNextBlock)(IGMediaAsset *asset);
+
 /**
  * The IGMediaPlayer class provides a centralized point of control for media playing in SITMOS.
  *
@@ -98,6 +103,37 @@ typedef void (^IGMediaPlayerStoppedBlock)(Float64 currentTime, BOOL playbackEnde
  */
 @property (nonatomic, copy) IGMediaPlayerStoppedBlock stoppedBlock;
 
+/**
+ * The block to execute periodically while media is playing, every positionInterval seconds of playback.
+ */
+@property (nonatomic, copy) IGMediaPlayerPositionBlock positionBlock;
+
+/**
+ * The interval of playback time between invocations of the position block. Defaults to 5 seconds.
+ *
+ * A change takes effect the next time media is started.
+ */
+@property (nonatomic, assign) NSTimeInterval positionInterval;
+
+/**
+ * The block to execute as playback progresses, every progressInterval seconds of playback and whenever the time jumps, such as after a seek. Meant for the playback progress UI.
+ *
+ * Unlike the other blocks it is kept when playback stops, the object that set it is responsible for removing it.
+ */
+@property (nonatomic, copy) IGMediaPlayerProgressBlock progressBlock;
+
+/**
+ * The interval of playback time between invocations of the progress block, 0 stops the periodic invocations altogether. Defaults to 0.
+ *
+ * A change takes effect straight away.
+ */
+@property (nonatomic, assign) NSTimeInterval progressInterval;
+
+/**
+ * The block to execute when an asset from the up next queue becomes the current asset, it returns the time to begin playback of the asset from.
+ */
+@property (nonatomic, copy) IGMediaPlayerUpNextBlock upNextBlock;
+
 /**
  * The asset of which the media was initialized.
  *
@@ -105,6 +141,13 @@ typedef void (^IGMediaPlayerStoppedBlock)(Float64 currentTime, BOOL playbackEnde
  */
 @property (nonatomic, strong, readonly) IGMediaAsset *asset;
 
+/**
+ * The assets to play once the current asset reaches the end, in order. (read-only)
+ *
+ * The queue is saved and restored along with the current asset.
+ */
+@property (nonatomic, copy, readonly) NSArray *upNextAssets;
+
 #pragma mark - Getting the Media Player Instance
 
 /**
@@ -175,6 +218,44 @@ typedef void (^IGMediaPlayerStoppedBlock)(Float64 currentTime, BOOL playbackEnde
  */
 - (BOOL)isPaused;
 
+#pragma mark - Managing the Up Next Queue
+
+/**
+ * @name Managing the Up Next Queue
+ */
+
+/**
+ * Adds an asset to the end of the up next queue, moving it there if it is already queued.
+ *
+ * While an asset is playing the first asset of the queue is loaded and buffered ahead of the end, so playback moves on to it without a gap. The player, its observers and the audio session are kept across the transition.
+ *
+ * A queued asset that fails to load or is not playable is dropped from the queue. If the first asset is not buffered by the time the current one ends, it is started from scratch instead.
+ *
+ * @param asset The asset to add.
+ */
+- (void)addAssetToUpNext:(IGMediaAsset *)asset;
+
+/**
+ * Removes an asset from the up next queue.
+ *
+ * @param asset The asset to remove.
+ */
+- (void)removeAssetFromUpNext:(IGMediaAsset *)asset;
+
+/**
+ * Removes every asset from the up next queue.
+ */
+- (void)removeAllAssetsFromUpNext;
+
+/**
+ * Indicates whether an asset is in the up next queue.
+ *
+ * @param asset The asset to look for.
+ *
+ * @return YES if the asset is queued, NO otherwise.
+ */
+- (BOOL)isAssetInUpNext:(IGMediaAsset *)asset;
+
 #pragma mark - Managing Time
 
 /**
@@ -182,10 +263,26 @@ typedef void (^IGMediaPlayerStoppedBlock)(Float64 currentTime, BOOL playbackEnde
  */
 
 /**
- * Moves the playback cursor to a given time.
+ * Moves the playback cursor to a given time exactly.
+ *
+ * Only one seek is in flight at a time, seeks asked for meanwhile are collapsed into the latest one. While seeking, currentTime reports the time being sought to, and the now playing info is updated once the seeks have settled.
  *
  * @param time The time to which to move the playback cursor.
  */
 - (void)seekToTime:(Float64)time;
 
+/**
+ * Moves the playback cursor near a given time while the user is scrubbing. The player is allowed to land wherever is cheapest to reach around the time, which for streamed media avoids a range request per position.
+ *
+ * @param time The time to which to move the playback cursor.
+ */
+- (void)scrubToTime:(Float64)time;
+
+/**
+ * Moves the playback cursor to the time scrubbing ended at exactly.
+ *
+ * @param time The time to which to move the playback cursor.
+ */
+- (void)endScrubbingAtTime:(Float64)time;
+
 @end
@@ -22,6 +22,8 @@
 #import "IGMediaPlayer.h"
 
 #import "IGMediaAsset.h"
+#import "IGAssetPreparationCache.h"
+#import "IGSeekCoordinator.h"
 
 #import <AVFoundation/AVFoundation.h>
 #import <AudioToolbox/AudioToolbox.h>
@@ -29,6 +31,7 @@
 
 /* Saved Asset */
 static NSString * const IGMediaPlayerCurrentAssetKey = @"MediaPlayerCurrentAsset";
+static NSString * const IGMediaPlayerUpNextAssetsKey = @"MediaPlayerUpNextAssets";
 
 /* Media Player Notifications */
 NSString * const IGMediaPlayerPlaybackStateLoadingNotification = @"com.idlegeniussoftware.media-player.playback.state.loading";
@@ -41,6 +44,7 @@ NSString * const IGMediaPlayerPlaybackStateSeekingBackwardNotification = @"com.i
 NSString * const IGMediaPlayerPlaybackStateDidReachEndNotification = @"com.idlegeniussoftware.media-player.playback.state.did-reach-end";
 NSString * const IGMediaPlayerPlaybackStateFailedNotification = @"com.idlegeniussoftware.media-player.playback.state.failed";
 NSString * const IGMediaPlayerPlaybackLikelyToKeepUpNotification = @"com.idlegeniussoftware.media-player.playback.likely-to-keep-up";
+NSString * const IGMediaPlayerCurrentAssetDidChangeNotification = @"com.idlegeniussoftware.media-player.current-asset.did-change";
 
 /* Asset Keys */
 NSString * const kTracksKey = @"tracks";
@@ -61,15 +65,34 @@ static void * IGMediaPlayerDurationObservationContext = &IGMediaPlayerDurationOb
 static void * IGMediaPlayerPlaybackBufferEmptyObservationContext = &IGMediaPlayerPlaybackBufferEmptyObservationContext;
 static void * IGMediaPlayerPlaybackLikelyToKeepUpObservationContext = &IGMediaPlayerPlaybackLikelyToKeepUpObservationContext;
 
+/**
+ * Returns YES if both assets are for the same model object, or for the same content when they have no identifier.
+ */
+static BOOL IGMediaAssetsMatch(IGMediaAsset *asset, IGMediaAsset *otherAsset)
+{
+    if ([asset identifier] || [otherAsset identifier])
+    {
+        return [[asset identifier] isEqualToString:[otherAsset identifier]];
+    }
+    
+    return [[asset contentURL] isEqual:[otherAsset contentURL]];
+}
+
 @interface IGMediaPlayer ()
 
-@property (nonatomic, strong) AVPlayer *player;
+@property (nonatomic, strong) AVQueuePlayer *player;
 @property (nonatomic, strong) AVPlayerItem *playerItem;
 @property (nonatomic, strong) AVURLAsset *urlAsset;
 @property (nonatomic, readwrite) Float64 currentTime;
 @property (nonatomic, readwrite) Float64 duration;
 @property (nonatomic, readwrite) IGMediaPlayerPlaybackState playbackState;
 @property (nonatomic, strong, readwrite) IGMediaAsset *asset;
+@property (nonatomic, strong) id positionObserver;
+@property (nonatomic, strong) id progressObserver;
+@property (nonatomic, strong) NSMutableArray *queuedAssets;
+@property (nonatomic, strong) AVPlayerItem *upNextItem;
+@property (nonatomic, strong) IGMediaAsset *upNextItemAsset;
+@property (nonatomic, strong) IGSeekCoordinator *seekCoordinator;
 
 @end
 
@@ -100,11 +123,25 @@ static void * IGMediaPlayerPlaybackLikelyToKeepUpObservationContext = &IGMediaPl
  */
 - (void)cleanUp
 {
+    if (_positionObserver)
+    {
+        [_player removeTimeObserver:_positionObserver];
+        _positionObserver = nil;
+    }
+    if (_progressObserver)
+    {
+        [_player removeTimeObserver:_progressObserver];
+        _progressObserver = nil;
+    }
+    [_seekCoordinator cancelSeeks];
     _player = nil;
+    _upNextItem = nil;
+    _upNextItemAsset = nil;
     _asset = nil;
     _urlAsset = nil;
     _pausedBlock = nil;
     _stoppedBlock = nil;
+    _positionBlock = nil;
     _currentTime = 0.f;
     _duration = 0.f;
 }
@@ -119,6 +156,27 @@ static void * IGMediaPlayerPlaybackLikelyToKeepUpObservationContext = &IGMediaPl
     _duration = 0.f;
     _currentTime = 0.f;
     _playbackRate = 1.f;
+    _positionInterval = 5.0;
+    
+    __weak IGMediaPlayer *weakSelf = self;
+    _seekCoordinator = [[IGSeekCoordinator alloc] initWithSeekBlock:^(Float64 time, BOOL exact, IGSeekCompletionBlock completion) {
+        AVPlayer *player = weakSelf.player;
+        if (!player)
+        {
+            completion(NO);
+            return;
+        }
+        
+        CMTime tolerance = exact ? kCMTimeZero : kCMTimePositiveInfinity;
+        [player seekToTime:CMTimeMakeWithSeconds(time, NSEC_PER_SEC) toleranceBefore:tolerance toleranceAfter:tolerance completionHandler:^(BOOL finished) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                completion(finished);
+            });
+        }];
+    }];
+    [_seekCoordinator setSettledBlock:^(Float64 time) {
+        [weakSelf updateNowPlayingInfoElapsedPlaybackTime];
+    }];
     
     NSData *assetData = [[NSUserDefaults standardUserDefaults] objectForKey:IGMediaPlayerCurrentAssetKey];
     if (assetData)
@@ -127,6 +185,10 @@ static void * IGMediaPlayerPlaybackLikelyToKeepUpObservationContext = &IGMediaPl
         self.asset = asset;
     }
     
+    NSData *upNextAssetsData = [[NSUserDefaults standardUserDefaults] objectForKey:IGMediaPlayerUpNextAssetsKey];
+    NSArray *upNextAssets = upNextAssetsData ? [NSKeyedUnarchiver unarchiveObjectWithData:upNextAssetsData] : nil;
+    _queuedAssets = [NSMutableArray arrayWithArray:upNextAssets];
+    
     [[AVAudioSession sharedInstance] setCategory:AVAudioSessionCategoryPlayback error:nil];
     
     [[NSNotificationCenter defaultCenter] addObserver:self
@@ -159,6 +221,7 @@ static void * IGMediaPlayerPlaybackLikelyToKeepUpObservationContext = &IGMediaPl
                     _startFromTime = 0.f;
                 }
                 [self play];
+                [self prepareUpNextItem];
                 
                 break;
             case AVPlayerStatusFailed:
@@ -208,6 +271,7 @@ static void * IGMediaPlayerPlaybackLikelyToKeepUpObservationContext = &IGMediaPl
     NSParameterAssert(asset != nil);
     
     self.asset = asset;
+    [self removeAssetFromUpNext:asset];
     
     [self setPlaybackState:IGMediaPlayerPlaybackStateLoading];
     
@@ -215,7 +279,8 @@ static void * IGMediaPlayerPlaybackLikelyToKeepUpObservationContext = &IGMediaPl
         [[NSNotificationCenter defaultCenter] postNotification:[NSNotification notificationWithName:IGMediaPlayerPlaybackStateLoadingNotification object:self userInfo:nil]];
     });
     
-    self.urlAsset = [AVURLAsset assetWithURL:asset.contentURL];
+    // A prepared asset has its keys loaded or loading already
+    self.urlAsset = [[IGAssetPreparationCache sharedCache] takeURLAssetForAsset:asset] ?: [asset URLAsset];
     
     NSArray *requestedKeys = @[kTracksKey, kPlayableKey];
     [self.urlAsset loadValuesAsynchronouslyForKeys:requestedKeys completionHandler:^{
@@ -255,60 +320,37 @@ static void * IGMediaPlayerPlaybackLikelyToKeepUpObservationContext = &IGMediaPl
         return;
     }
     
+    [self discardUpNextItem];
+    
     if (_playerItem)
     {
-        [_playerItem removeObserver:self 
-                         forKeyPath:kStatusKey];
-        
-        [_playerItem removeObserver:self
-                         forKeyPath:kDurationKey];
-        
-        [_playerItem removeObserver:self
-                         forKeyPath:kPlaybackBufferEmptyKey];
-        
-        [_playerItem removeObserver:self
-                         forKeyPath:kPlaybackLikelyToKeepUpKey];
-		
-        [[NSNotificationCenter defaultCenter] removeObserver:self
-                                                        name:AVPlayerItemDidPlayToEndTimeNotification
-                                                      object:_playerItem];
+        [self removeObserversFromPlayerItem:_playerItem];
     }
 	
     _playerItem = [AVPlayerItem playerItemWithAsset:asset];
-    
-    [_playerItem addObserver:self 
-                  forKeyPath:kStatusKey 
-                     options:NSKeyValueObservingOptionInitial | NSKeyValueObservingOptionNew
-                     context:IGMediaPlayerStatusObservationContext];
-    
-    [_playerItem addObserver:self 
-                  forKeyPath:kDurationKey 
-                     options:NSKeyValueObservingOptionInitial | NSKeyValueObservingOptionNew
-                     context:IGMediaPlayerDurationObservationContext];
-    
-    [_playerItem addObserver:self
-                  forKeyPath:kPlaybackBufferEmptyKey
-                     options:NSKeyValueObservingOptionInitial | NSKeyValueObservingOptionNew
-                     context:IGMediaPlayerPlaybackBufferEmptyObservationContext];
-    
-    [_playerItem addObserver:self
-                  forKeyPath:kPlaybackLikelyToKeepUpKey
-                     options:NSKeyValueObservingOptionInitial | NSKeyValueObservingOptionNew
-                     context:IGMediaPlayerPlaybackLikelyToKeepUpObservationContext];
-	
-    [[NSNotificationCenter defaultCenter] addObserver:self
-                                             selector:@selector(playerItemDidReachEnd:)
-                                                 name:AVPlayerItemDidPlayToEndTimeNotification
-                                               object:_playerItem];
+    [self addObserversToPlayerItem:_playerItem];
 	
     if (!_player)
     {
-        [self setPlayer:[AVPlayer playerWithPlayerItem:_playerItem]];
+        [self setPlayer:[AVQueuePlayer queuePlayerWithItems:@[_playerItem]]];
         
         [_player addObserver:self 
                   forKeyPath:kCurrentItemKey 
                      options:NSKeyValueObservingOptionInitial | NSKeyValueObservingOptionNew
                      context:IGMediaPlayerCurrentItemObservationContext];
+        
+        __weak IGMediaPlayer *weakSelf = self;
+        [self setPositionObserver:[_player addPeriodicTimeObserverForInterval:CMTimeMakeWithSeconds(_positionInterval, NSEC_PER_SEC)
+                                                                        queue:dispatch_get_main_queue()
+                                                                   usingBlock:^(CMTime time) {
+                                                                       IGMediaPlayer *strongSelf = weakSelf;
+                                                                       if (strongSelf.positionBlock && [strongSelf isPlaying] && CMTIME_IS_NUMERIC(time))
+                                                                       {
+                                                                           strongSelf.positionBlock(CMTimeGetSeconds(time));
+                                                                       }
+                                                                   }]];
+        
+        [self updateProgressObserver];
     }
     
     if (_player.currentItem != _playerItem)
@@ -319,6 +361,53 @@ static void * IGMediaPlayerPlaybackLikelyToKeepUpObservationContext = &IGMediaPl
     [[AVAudioSession sharedInstance] setActive:YES error:nil];
 }
 
+- (void)addObserversToPlayerItem:(AVPlayerItem *)playerItem
+{
+    [playerItem addObserver:self 
+                 forKeyPath:kStatusKey 
+                    options:NSKeyValueObservingOptionInitial | NSKeyValueObservingOptionNew
+                    context:IGMediaPlayerStatusObservationContext];
+    
+    [playerItem addObserver:self 
+                 forKeyPath:kDurationKey 
+                    options:NSKeyValueObservingOptionInitial | NSKeyValueObservingOptionNew
+                    context:IGMediaPlayerDurationObservationContext];
+    
+    [playerItem addObserver:self
+                 forKeyPath:kPlaybackBufferEmptyKey
+                    options:NSKeyValueObservingOptionInitial | NSKeyValueObservingOptionNew
+                    context:IGMediaPlayerPlaybackBufferEmptyObservationContext];
+    
+    [playerItem addObserver:self
+                 forKeyPath:kPlaybackLikelyToKeepUpKey
+                    options:NSKeyValueObservingOptionInitial | NSKeyValueObservingOptionNew
+                    context:IGMediaPlayerPlaybackLikelyToKeepUpObservationContext];
+	
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(playerItemDidReachEnd:)
+                                                 name:AVPlayerItemDidPlayToEndTimeNotification
+                                               object:playerItem];
+}
+
+- (void)removeObserversFromPlayerItem:(AVPlayerItem *)playerItem
+{
+    [playerItem removeObserver:self 
+                    forKeyPath:kStatusKey];
+    
+    [playerItem removeObserver:self
+                    forKeyPath:kDurationKey];
+    
+    [playerItem removeObserver:self
+                    forKeyPath:kPlaybackBufferEmptyKey];
+    
+    [playerItem removeObserver:self
+                    forKeyPath:kPlaybackLikelyToKeepUpKey];
+    
+    [[NSNotificationCenter defaultCenter] removeObserver:self
+                                                    name:AVPlayerItemDidPlayToEndTimeNotification
+                                                  object:playerItem];
+}
+
 - (void)play
 {
     [self setPlaybackState:IGMediaPlayerPlaybackStatePlaying];
@@ -400,7 +489,7 @@ static void * IGMediaPlayerPlaybackLikelyToKeepUpObservationContext = &IGMediaPl
 
 - (void)seekToBeginning
 {
-    [_player seekToTime:kCMTimeZero];
+    [self seekToTime:0];
 }
 
 - (BOOL)isPlaying
@@ -429,6 +518,19 @@ static void * IGMediaPlayerPlaybackLikelyToKeepUpObservationContext = &IGMediaPl
 
 - (void)playerItemDidReachEnd:(NSNotification *)notification
 {
+    if (_upNextItem && [[_player items] containsObject:_upNextItem])
+    {
+        [self advanceToUpNextItemFromPlayerItem:[notification object]];
+        return;
+    }
+    
+    // The up next item was not ready in time, the next asset is started from scratch instead of ending playback
+    if ([_queuedAssets count] > 0)
+    {
+        [self startFirstQueuedAssetFromPlayerItem:[notification object]];
+        return;
+    }
+    
     [self setPlaybackState:IGMediaPlayerPlaybackStateDidReachEnd];
     
     dispatch_async(dispatch_get_main_queue(), ^{
@@ -460,21 +562,300 @@ static void * IGMediaPlayerPlaybackLikelyToKeepUpObservationContext = &IGMediaPl
     [[NSUserDefaults standardUserDefaults] removeObjectForKey:IGMediaPlayerCurrentAssetKey];
 }
 
+#pragma mark - Publishing Progress
+
+- (void)setProgressBlock:(IGMediaPlayerProgressBlock)progressBlock
+{
+    _progressBlock = [progressBlock copy];
+    [self updateProgressObserver];
+}
+
+- (void)setProgressInterval:(NSTimeInterval)progressInterval
+{
+    if (_progressInterval != progressInterval)
+    {
+        _progressInterval = progressInterval;
+        [self updateProgressObserver];
+    }
+}
+
+/**
+ * Replaces the periodic time observer driving the progress block, so it runs at the current interval and only while there is a block and an interval.
+ */
+- (void)updateProgressObserver
+{
+    if (_progressObserver)
+    {
+        [_player removeTimeObserver:_progressObserver];
+        _progressObserver = nil;
+    }
+    
+    if (!_player || !_progressBlock || _progressInterval <= 0)
+    {
+        return;
+    }
+    
+    __weak IGMediaPlayer *weakSelf = self;
+    [self setProgressObserver:[_player addPeriodicTimeObserverForInterval:CMTimeMakeWithSeconds(_progressInterval, NSEC_PER_SEC)
+                                                                    queue:dispatch_get_main_queue()
+                                                               usingBlock:^(CMTime time) {
+                                                                   IGMediaPlayer *strongSelf = weakSelf;
+                                                                   if (strongSelf.progressBlock)
+                                                                   {
+                                                                       strongSelf.progressBlock([strongSelf currentTime], [strongSelf duration]);
+                                                                   }
+                                                               }]];
+}
+
+#pragma mark - Managing the Up Next Queue
+
+- (NSArray *)upNextAssets
+{
+    return [_queuedAssets copy];
+}
+
+- (void)addAssetToUpNext:(IGMediaAsset *)asset
+{
+    NSParameterAssert(asset != nil);
+    
+    [self removeQueuedAssetsMatchingAsset:asset];
+    [_queuedAssets addObject:asset];
+    [self upNextAssetsDidChange];
+}
+
+- (void)removeAssetFromUpNext:(IGMediaAsset *)asset
+{
+    if ([self removeQueuedAssetsMatchingAsset:asset])
+    {
+        [self upNextAssetsDidChange];
+    }
+}
+
+- (void)removeAllAssetsFromUpNext
+{
+    [_queuedAssets removeAllObjects];
+    [self upNextAssetsDidChange];
+}
+
+- (BOOL)isAssetInUpNext:(IGMediaAsset *)asset
+{
+    for (IGMediaAsset *queuedAsset in _queuedAssets)
+    {
+        if (IGMediaAssetsMatch(queuedAsset, asset))
+        {
+            return YES;
+        }
+    }
+    
+    return NO;
+}
+
+/**
+ * Removes the queued assets that match the given asset.
+ *
+ * @return YES if an asset was removed, NO otherwise.
+ */
+- (BOOL)removeQueuedAssetsMatchingAsset:(IGMediaAsset *)asset
+{
+    NSIndexSet *indexes = [_queuedAssets indexesOfObjectsPassingTest:^BOOL(IGMediaAsset *queuedAsset, NSUInteger idx, BOOL *stop) {
+        return IGMediaAssetsMatch(queuedAsset, asset);
+    }];
+    [_queuedAssets removeObjectsAtIndexes:indexes];
+    
+    return [indexes count] > 0;
+}
+
+/**
+ * Saves the queue and prepares its first asset if it has changed.
+ */
+- (void)upNextAssetsDidChange
+{
+    NSData *upNextAssetsData = [NSKeyedArchiver archivedDataWithRootObject:[_queuedAssets copy]];
+    [[NSUserDefaults standardUserDefaults] setObject:upNextAssetsData forKey:IGMediaPlayerUpNextAssetsKey];
+    
+    if ([_playerItem status] == AVPlayerItemStatusReadyToPlay)
+    {
+        [self prepareUpNextItem];
+    }
+}
+
+/**
+ * Loads the asset keys of the first queued asset and inserts a player item for it after the current item, so the queue player buffers it ahead of the end of the current item.
+ */
+- (void)prepareUpNextItem
+{
+    IGMediaAsset *asset = [_queuedAssets firstObject];
+    if (_upNextItemAsset && IGMediaAssetsMatch(asset, _upNextItemAsset))
+    {
+        return;
+    }
+    
+    [self discardUpNextItem];
+    
+    if (!asset || !_player)
+    {
+        return;
+    }
+    
+    self.upNextItemAsset = asset;
+    
+    AVURLAsset *urlAsset = [[IGAssetPreparationCache sharedCache] takeURLAssetForAsset:asset] ?: [asset URLAsset];
+    NSArray *requestedKeys = @[kTracksKey, kPlayableKey];
+    [urlAsset loadValuesAsynchronouslyForKeys:requestedKeys completionHandler:^{
+        dispatch_async(dispatch_get_main_queue(), ^{
+            // The queue or the player may have changed while the keys were loading
+            if (self.upNextItemAsset != asset || self.upNextItem || !self.player)
+            {
+                return;
+            }
+            
+            // An asset that can not be played would hold up the rest of the queue
+            for (NSString *thisKey in requestedKeys)
+            {
+                if ([urlAsset statusOfValueForKey:thisKey error:nil] != AVKeyValueStatusLoaded)
+                {
+                    [self dropUnplayableUpNextAsset:asset];
+                    return;
+                }
+            }
+            
+            if (![urlAsset isPlayable])
+            {
+                [self dropUnplayableUpNextAsset:asset];
+                return;
+            }
+            
+            AVPlayerItem *playerItem = [AVPlayerItem playerItemWithAsset:urlAsset];
+            if (![self.player canInsertItem:playerItem afterItem:self.playerItem])
+            {
+                return;
+            }
+            
+            [self.player insertItem:playerItem afterItem:self.playerItem];
+            self.upNextItem = playerItem;
+        });
+    }];
+}
+
+/**
+ * Removes a queued asset whose keys failed to load or which is not playable, so the asset after it is prepared instead.
+ */
+- (void)dropUnplayableUpNextAsset:(IGMediaAsset *)asset
+{
+    self.upNextItemAsset = nil;
+    [self removeQueuedAssetsMatchingAsset:asset];
+    [self upNextAssetsDidChange];
+}
+
+/**
+ * Takes the prepared up next item out of the queue player.
+ */
+- (void)discardUpNextItem
+{
+    if (_upNextItem)
+    {
+        [_player removeItem:_upNextItem];
+    }
+    
+    self.upNextItem = nil;
+    self.upNextItemAsset = nil;
+}
+
+/**
+ * Moves playback on to the prepared up next item once the current item has reached the end. The player keeps running, only the observers move over to the new item.
+ */
+- (void)advanceToUpNextItemFromPlayerItem:(AVPlayerItem *)playerItem
+{
+    if (_stoppedBlock)
+    {
+        _stoppedBlock(CMTimeGetSeconds([playerItem currentTime]), YES);
+    }
+    
+    IGMediaAsset *asset = _upNextItemAsset;
+    AVPlayerItem *upNextItem = _upNextItem;
+    self.upNextItem = nil;
+    self.upNextItemAsset = nil;
+    
+    [self removeObserversFromPlayerItem:_playerItem];
+    [self removeQueuedAssetsMatchingAsset:asset];
+    
+    self.asset = asset;
+    _startFromTime = _upNextBlock ? _upNextBlock(asset) : 0.f;
+    _playerItem = upNextItem;
+    if (_player.currentItem != _playerItem)
+    {
+        [_player advanceToNextItem];
+    }
+    [self addObserversToPlayerItem:_playerItem];
+    
+    NSData *assetData = [NSKeyedArchiver archivedDataWithRootObject:asset];
+    [[NSUserDefaults standardUserDefaults] setObject:assetData forKey:IGMediaPlayerCurrentAssetKey];
+    [self upNextAssetsDidChange];
+    
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [[NSNotificationCenter defaultCenter] postNotification:[NSNotification notificationWithName:IGMediaPlayerCurrentAssetDidChangeNotification object:self userInfo:nil]];
+    });
+}
+
+/**
+ * Starts the first queued asset once the current item has reached the end without a prepared up next item, for example because its keys were still loading.
+ */
+- (void)startFirstQueuedAssetFromPlayerItem:(AVPlayerItem *)playerItem
+{
+    if (_stoppedBlock)
+    {
+        _stoppedBlock(CMTimeGetSeconds([playerItem currentTime]), YES);
+    }
+    
+    IGMediaAsset *asset = [_queuedAssets firstObject];
+    _startFromTime = _upNextBlock ? _upNextBlock(asset) : 0.f;
+    [self startWithAsset:asset];
+    
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [[NSNotificationCenter defaultCenter] postNotification:[NSNotification notificationWithName:IGMediaPlayerCurrentAssetDidChangeNotification object:self userInfo:nil]];
+    });
+}
+
 #pragma mark - Managing Time
 
 - (Float64)currentTime
 {
+    // While seeking the player still reports the time it is leaving, report where it is headed so skips add up
+    if ([_seekCoordinator isSeeking])
+    {
+        return [_seekCoordinator targetTime];
+    }
+    
     return CMTIME_IS_VALID([self.player currentTime]) ? CMTimeGetSeconds([_player currentTime]) : 0.f;
 }
 
 - (void)seekToTime:(Float64)time
 {
-    [_player seekToTime:CMTimeMakeWithSeconds(time, NSEC_PER_SEC)];
+    [_seekCoordinator seekToTime:[self clampedTime:time] exact:YES];
+}
+
+- (void)scrubToTime:(Float64)time
+{
+    [_seekCoordinator seekToTime:[self clampedTime:time] exact:NO];
+}
+
+- (void)endScrubbingAtTime:(Float64)time
+{
+    [_seekCoordinator seekToTime:[self clampedTime:time] exact:YES];
+}
+
+/**
+ * Returns the time limited to the duration of the media, when it is known.
+ */
+- (Float64)clampedTime:(Float64)time
+{
+    time = MAX(time, 0.f);
+    if (_duration > 0 && !isnan(_duration))
+    {
+        time = MIN(time, _duration);
+    }
     
-    MPNowPlayingInfoCenter *playingInfoCenter = [MPNowPlayingInfoCenter defaultCenter];
-    NSMutableDictionary *nowPlayingInfo = [NSMutableDictionary dictionaryWithDictionary:playingInfoCenter.nowPlayingInfo];
-    [nowPlayingInfo setObject:@(time) forKey:MPNowPlayingInfoPropertyElapsedPlaybackTime];
-    [playingInfoCenter setNowPlayingInfo:nowPlayingInfo];
+    return time;
 }
 
 #pragma mark - MPNowPlayingInfoCenter
@@ -520,6 +901,17 @@ static void * IGMediaPlayerPlaybackLikelyToKeepUpObservationContext = &IGMediaPl
     [playingInfoCenter setNowPlayingInfo:nowPlayingInfo];
 }
 
+/**
+ * Invoked once a run of seeks has settled. Sets the elapsed playback time of the now playing info to where the player landed.
+ */
+- (void)updateNowPlayingInfoElapsedPlaybackTime
+{
+    MPNowPlayingInfoCenter *playingInfoCenter = [MPNowPlayingInfoCenter defaultCenter];
+    NSMutableDictionary *nowPlayingInfo = [NSMutableDictionary dictionaryWithDictionary:playingInfoCenter.nowPlayingInfo];
+    [nowPlayingInfo setObject:@(self.currentTime) forKey:MPNowPlayingInfoPropertyElapsedPlaybackTime];
+    [playingInfoCenter setNowPlayingInfo:nowPlayingInfo];
+}
+
 #pragma mark - Handle Interruptions
 
 - (void)handleInterruption:(NSNotification *)notification
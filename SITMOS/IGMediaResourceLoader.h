@@ -0,0 +1,52 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <AVFoundation/AVFoundation.h>
+
+/**
+ * The IGMediaResourceLoader class loads the bytes of a streamed asset through the streaming cache.
+ *
+ * The asset is given a URL with a custom scheme so AVFoundation asks the resource loader for every byte range it needs. Cached bytes are handed over straight from the cache file, gaps are fetched with Range requests and written to the cache as they arrive, so seeking back within what has been played never goes to the network and a download of the episode later only fetches what playback skipped.
+ *
+ * @see IGStreamingCache
+ */
+@interface IGMediaResourceLoader : NSObject <AVAssetResourceLoaderDelegate>
+
+/**
+ * Returns an asset for the remote file whose bytes are loaded through the streaming cache. The asset keeps its resource loader alive.
+ *
+ * @param The http or https URL of the remote file.
+ */
++ (AVURLAsset *)URLAssetWithURL:(NSURL *)URL;
+
+/**
+ * Initializes a resource loader for the remote file.
+ *
+ * @param The http or https URL of the remote file.
+ */
+- (id)initWithURL:(NSURL *)URL;
+
+/**
+ * The URL of the remote file.
+ */
+@property (nonatomic, strong, readonly) NSURL *URL;
+
+@end
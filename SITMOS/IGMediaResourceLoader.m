@@ -0,0 +1,233 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGMediaResourceLoader.h"
+
+#import "IGStreamingCache.h"
+
+#import <MobileCoreServices/MobileCoreServices.h>
+#import <objc/runtime.h>
+
+static NSString * const IGMediaResourceLoaderSchemePrefix = @"sitmos-";
+
+/* The most bytes handed to a data request at once, larger runs of cached bytes are handed over in pieces */
+static NSUInteger const IGMediaResourceLoaderChunkLength = 256 * 1024;
+
+static char IGMediaResourceLoaderAssetKey;
+
+/**
+ * A loading request and the range being fetched for it.
+ */
+@interface IGMediaLoadingOperation : NSObject
+
+@property (nonatomic, strong) AVAssetResourceLoadingRequest *loadingRequest;
+@property (nonatomic, strong) NSURLSessionDataTask *fetchTask;
+
+@end
+
+@implementation IGMediaLoadingOperation
+@end
+
+@implementation IGMediaResourceLoader
+{
+    IGStreamingCacheEntry *_cacheEntry;
+    dispatch_queue_t _queue;
+    NSMutableArray *_operations;
+}
+
++ (AVURLAsset *)URLAssetWithURL:(NSURL *)URL
+{
+    IGMediaResourceLoader *resourceLoader = [[self alloc] initWithURL:URL];
+    
+    // AVFoundation only asks the delegate for URLs it can not load itself.
+    NSURLComponents *components = [NSURLComponents componentsWithURL:URL resolvingAgainstBaseURL:NO];
+    components.scheme = [IGMediaResourceLoaderSchemePrefix stringByAppendingString:[URL scheme]];
+    
+    AVURLAsset *asset = [AVURLAsset URLAssetWithURL:[components URL] options:nil];
+    [asset.resourceLoader setDelegate:resourceLoader queue:resourceLoader->_queue];
+    
+    // The resource loader only keeps a weak reference to its delegate.
+    objc_setAssociatedObject(asset, &IGMediaResourceLoaderAssetKey, resourceLoader, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+    
+    return asset;
+}
+
+- (id)initWithURL:(NSURL *)URL
+{
+    if (!(self = [super init])) return nil;
+    
+    _URL = URL;
+    _cacheEntry = [[IGStreamingCache sharedCache] entryForURL:URL];
+    _queue = dispatch_queue_create("com.idlegeniussoftware.sitmos.media-resource-loader", DISPATCH_QUEUE_SERIAL);
+    _operations = [[NSMutableArray alloc] init];
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    for (IGMediaLoadingOperation *operation in _operations)
+    {
+        [operation.fetchTask cancel];
+    }
+}
+
+#pragma mark - AVAssetResourceLoaderDelegate
+
+- (BOOL)resourceLoader:(AVAssetResourceLoader *)resourceLoader shouldWaitForLoadingOfRequestedResource:(AVAssetResourceLoadingRequest *)loadingRequest
+{
+    if (![[[[loadingRequest request] URL] scheme] hasPrefix:IGMediaResourceLoaderSchemePrefix])
+    {
+        return NO;
+    }
+    
+    IGMediaLoadingOperation *operation = [[IGMediaLoadingOperation alloc] init];
+    operation.loadingRequest = loadingRequest;
+    [_operations addObject:operation];
+    [self processOperation:operation];
+    
+    return YES;
+}
+
+- (void)resourceLoader:(AVAssetResourceLoader *)resourceLoader didCancelLoadingRequest:(AVAssetResourceLoadingRequest *)loadingRequest
+{
+    for (IGMediaLoadingOperation *operation in [_operations copy])
+    {
+        if (operation.loadingRequest == loadingRequest)
+        {
+            [operation.fetchTask cancel];
+            [_operations removeObject:operation];
+        }
+    }
+}
+
+#pragma mark - Loading
+
+/**
+ * Answers as much of the loading request as is cached, and fetches the next gap when nothing is being fetched for it yet. Called again on the resource loader's queue each time fetched bytes have been cached. Finishes the loading request once it has been answered in full.
+ */
+- (void)processOperation:(IGMediaLoadingOperation *)operation
+{
+    if (![_operations containsObject:operation])
+    {
+        return;
+    }
+    
+    AVAssetResourceLoadingRequest *loadingRequest = operation.loadingRequest;
+    AVAssetResourceLoadingContentInformationRequest *contentInformationRequest = [loadingRequest contentInformationRequest];
+    AVAssetResourceLoadingDataRequest *dataRequest = [loadingRequest dataRequest];
+    
+    int64_t contentLength = [_cacheEntry contentLength];
+    if (contentInformationRequest && contentLength > 0)
+    {
+        contentInformationRequest.contentType = [self uniformTypeIdentifierForMIMEType:[_cacheEntry contentType]];
+        contentInformationRequest.contentLength = contentLength;
+        contentInformationRequest.byteRangeAccessSupported = YES;
+    }
+    
+    // A request for the content information alone only needs the first byte fetched to learn the length.
+    int64_t offset = dataRequest ? [dataRequest currentOffset] : 0;
+    int64_t end = dataRequest ? [dataRequest requestedOffset] + [dataRequest requestedLength] : 1;
+    if (contentLength > 0)
+    {
+        end = MIN(end, contentLength);
+    }
+    
+    int64_t cachedLength = 0;
+    while (dataRequest && offset < end && (cachedLength = [_cacheEntry cachedLengthFromOffset:offset]) > 0)
+    {
+        NSUInteger length = (NSUInteger)MIN(MIN(cachedLength, end - offset), IGMediaResourceLoaderChunkLength);
+        NSData *data = [_cacheEntry readDataFromOffset:offset length:length];
+        if (!data)
+        {
+            break;
+        }
+        
+        [dataRequest respondWithData:data];
+        offset += length;
+    }
+    
+    BOOL contentInformationLoaded = (!contentInformationRequest || contentLength > 0);
+    if (contentInformationLoaded && (!dataRequest || offset >= end))
+    {
+        [loadingRequest finishLoading];
+        [_operations removeObject:operation];
+        return;
+    }
+    
+    if (operation.fetchTask)
+    {
+        return;
+    }
+    
+    int64_t missingLength = [_cacheEntry missingLengthFromOffset:offset];
+    int64_t length = (missingLength >= 0) ? MIN(missingLength, end - offset) : end - offset;
+    
+    __weak IGMediaResourceLoader *weakSelf = self;
+    dispatch_queue_t queue = _queue;
+    operation.fetchTask = [_cacheEntry fetchFromOffset:offset length:length dataHandler:^{
+        dispatch_async(queue, ^{
+            [weakSelf processOperation:operation];
+        });
+    } completion:^(NSError *error) {
+        dispatch_async(queue, ^{
+            operation.fetchTask = nil;
+            [weakSelf finishFetchForOperation:operation fromOffset:offset error:error];
+        });
+    }];
+}
+
+- (void)finishFetchForOperation:(IGMediaLoadingOperation *)operation fromOffset:(int64_t)offset error:(NSError *)error
+{
+    if (![_operations containsObject:operation])
+    {
+        return;
+    }
+    
+    if (!error && [_cacheEntry cachedLengthFromOffset:offset] == 0)
+    {
+        // Nothing was fetched, asking again would not fetch anything either.
+        error = [NSError errorWithDomain:IGStreamingCacheErrorDomain code:IGStreamingCacheErrorUnexpectedResponse userInfo:nil];
+    }
+    
+    if (error)
+    {
+        [operation.loadingRequest finishLoadingWithError:error];
+        [_operations removeObject:operation];
+        return;
+    }
+    
+    [self processOperation:operation];
+}
+
+- (NSString *)uniformTypeIdentifierForMIMEType:(NSString *)MIMEType
+{
+    NSString *uniformTypeIdentifier = nil;
+    if (MIMEType)
+    {
+        uniformTypeIdentifier = CFBridgingRelease(UTTypeCreatePreferredIdentifierForTag(kUTTagClassMIMEType, (__bridge CFStringRef)MIMEType, NULL));
+    }
+    
+    // Dynamic identifiers are made up for unknown types, AVFoundation can not play those. Episodes are MP3s.
+    return (uniformTypeIdentifier && ![uniformTypeIdentifier hasPrefix:@"dyn."]) ? uniformTypeIdentifier : (__bridge NSString *)kUTTypeMP3;
+}
+
+@end
@@ -20,15 +20,22 @@
  */
 
 #import "AFNetworking.h"
+#import "IGDownloadScheduler.h"
 
 #import <Foundation/Foundation.h>
 
+@class IGFeedItem;
+@class IGDownloadProgressSnapshot;
+
 extern NSString * const IGDevelopmentBaseURL;
 extern NSString * const IGDevelopmentPodcastFeedURL;
 
 extern NSString * const IGBaseURL;
 extern NSString * const IGPodcastFeedURL;
 
+extern NSString * const IGPodcastFeedValidatorsKey;
+extern NSString * const IGPodcastFeedLastFullSyncDateKey;
+
 @interface IGNetworkManager : NSObject
 
 #pragma mark - Development Mode
@@ -61,6 +68,26 @@ extern NSString * const IGPodcastFeedURL;
  */
 + (BOOL)isOnCellularNetwork;
 
+/**
+ * Returns YES if on Wi-Fi network, NO otherwise.
+ */
++ (BOOL)isOnWiFiNetwork;
+
+#pragma mark - Cellular Data
+
+/**
+ * @name Cellular Data
+ */
+
+/**
+ * Sets the number of bytes downloads may use with cellular data each month and saves it to the settings. Downloads are parked once the limit is reached, until a new month begins or they are on Wi-Fi.
+ *
+ * @param The monthly limit in bytes, 0 for no limit.
+ *
+ * @see IGDataUsageMeter
+ */
++ (void)setMonthlyCellularDataLimit:(int64_t)limit;
+
 #pragma mark - Obtaining Download Tasks
 
 /**
@@ -68,19 +95,47 @@ extern NSString * const IGPodcastFeedURL;
  */
 
 /**
- * Returns an array of NSURLSessionDownloadTask's, nil if there are none.
+ * Returns an array of the running NSURLSessionDownloadTask's. The tasks are read from an in-memory registry, the download session is not queried.
  */
 + (NSArray *)downloadTasks;
 
 /**
- * Returns the NSURLSessionDownloadTask for the given URL.
+ * Returns the NSURLSessionDownloadTask for the given URL. This is a single dictionary lookup that never blocks, so it is safe to call while laying out table view cells.
  *
  * @param The URL of the NSURLSessionDownloadTask.
  *
- * @return The NSURLSessionDownloadTask for the given URL. Returns nil if a request operation is not found.
+ * @return The NSURLSessionDownloadTask for the given URL. Returns nil if a download task is not found.
  */
 + (NSURLSessionDownloadTask *)downloadTaskForURL:(NSURL *)url;
 
+/**
+ * Returns YES if a download from the given URL is waiting in the download queue or running, NO otherwise.
+ *
+ * @param The URL of the download.
+ */
++ (BOOL)isDownloadScheduledForURL:(NSURL *)url;
+
+/**
+ * Returns the current progress of the download from the given URL, whether it runs on the background session, as a segmented download or from the streaming cache. Returns nil if there is no download for the URL. Must be called on the main queue.
+ *
+ * @param The URL of the download.
+ *
+ * @see IGDownloadProgressHub
+ */
++ (IGDownloadProgressSnapshot *)downloadProgressForURL:(NSURL *)url;
+
+/**
+ * Reconnects to the background download session and rebuilds the download task registry from the tasks it still holds. Should be called once at launch, before any download tasks are looked up.
+ */
++ (void)restoreDownloadTasks;
+
+/**
+ * Starts monitoring network reachability and queues the downloads that were interrupted and left resume data behind, now and every time the network becomes reachable again. Downloads carry on from where they stopped instead of starting over. Should be called once at launch, after restoreDownloadTasks.
+ *
+ * @see IGResumeDataStore
+ */
++ (void)startResumingInterruptedDownloads;
+
 #pragma mark - Push Notifications
 
 /**
@@ -116,6 +171,24 @@ extern NSString * const IGPodcastFeedURL;
  */
 - (void)syncPodcastFeedWithCompletion:(void (^)(BOOL success, NSArray *feedItems, NSError *error))completion;
 
+/**
+ * Syncs the podcast feed, pushing the bytes to the feed parser as they arrive so parsing overlaps the transfer. The feed item handler is executed on the parsing queue for each item while the transfer is still running, the completion handler is executed on the main queue once both the transfer and parsing have finished.
+ *
+ * @param The block to execute for each parsed feed item.
+ * @param The completion handler block to execute.
+ */
+- (void)syncPodcastFeedWithFeedItemHandler:(void (^)(IGFeedItem *feedItem))feedItemHandler
+                                completion:(void (^)(BOOL success, NSArray *feedItems, NSError *error))completion;
+
+/**
+ * Syncs only the items of the podcast feed that are newer than the given publication date. The feed is ordered newest first, so parsing and the transfer are stopped as soon as an already known item is reached. A full sync is performed instead when pubDate is nil or when the last full sync is more than a week old, so changes to older items are still picked up. An incremental sync is conditional, sending the ETag and Last-Modified validators of the last successful sync, and a 304 Not Modified response completes successfully with nil feed items without any parsing. A full sync is never conditional. Every sync answered with 200 OK stores new validators, including an incremental sync that stopped at a known item.
+ *
+ * @param The publication date of the newest episode already stored.
+ * @param The completion handler block to execute.
+ */
+- (void)syncPodcastFeedNewerThanPubDate:(NSDate *)pubDate
+                             completion:(void (^)(BOOL success, NSArray *feedItems, NSError *error))completion;
+
 #pragma mark - Download Episode
 
 /**
@@ -123,14 +196,60 @@ extern NSString * const IGPodcastFeedURL;
  */
 
 /**
- * Starts downloading the episode from the downloadURL parameter and saves to the targetPath parameter. A completion block is fired and a local notification is posted when download succeeds or fails.
+ * Queues the episode to be downloaded from the downloadURL parameter and saved to the targetPath parameter with user requested priority. A completion block is fired and a local notification is posted when download succeeds or fails.
+ *
+ * @param The URL to download the episode from.
+ * @param The URL to save the download to.
+ * @param The completion handler block to execute.
+ */
+- (void)downloadEpisodeWithDownloadURL:(NSURL *)downloadURL
+                        destinationURL:(NSURL *)destinationURL
+                            completion:(void (^)(BOOL success, NSError *error))completion;
+
+/**
+ * Queues the episode to be downloaded with the given priority. The download starts once the download scheduler gives it a slot, more urgent downloads are given a slot first. It uses cellular data when the settings allow it, otherwise it waits for Wi-Fi.
  *
  * @param The URL to download the episode from.
  * @param The URL to save the download to.
+ * @param The priority class of the download.
  * @param The completion handler block to execute.
+ *
+ * @see IGDownloadScheduler
  */
 - (void)downloadEpisodeWithDownloadURL:(NSURL *)downloadURL
                         destinationURL:(NSURL *)destinationURL
+                              priority:(IGDownloadPriority)priority
                             completion:(void (^)(BOOL success, NSError *error))completion;
 
+/**
+ * Queues the episode to be downloaded with the given priority on the networks allowed. A download that may not use cellular data is parked while on a cellular network and carries on from where it stopped once on Wi-Fi.
+ *
+ * @param The URL to download the episode from.
+ * @param The URL to save the download to.
+ * @param The priority class of the download.
+ * @param YES if the download may use cellular data, NO if it must wait for Wi-Fi.
+ * @param The completion handler block to execute.
+ *
+ * @see IGDownloadScheduler
+ */
+- (void)downloadEpisodeWithDownloadURL:(NSURL *)downloadURL
+                        destinationURL:(NSURL *)destinationURL
+                              priority:(IGDownloadPriority)priority
+                  allowsCellularAccess:(BOOL)allowsCellularAccess
+                            completion:(void (^)(BOOL success, NSError *error))completion;
+
+/**
+ * Moves the queued download to the front of the download queue, used when the user wants to play an episode that is waiting to be downloaded.
+ *
+ * @param The URL of the download.
+ */
++ (void)prioritizeDownloadForURL:(NSURL *)downloadURL;
+
+/**
+ * Removes the download from the download queue and cancels its transfer if it is running.
+ *
+ * @param The URL of the download.
+ */
++ (void)cancelDownloadForURL:(NSURL *)downloadURL;
+
 @end
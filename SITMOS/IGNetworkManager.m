@@ -22,14 +22,22 @@
 #import "IGNetworkManager.h"
 
 #import "IGAppDelegate.h"
+#import "IGDownloadTaskRegistry.h"
+#import "IGResumeDataStore.h"
+#import "IGDownloadScheduler.h"
+#import "IGDownloadProgressHub.h"
+#import "IGDownloadVerifier.h"
+#import "IGDataUsageMeter.h"
+#import "IGSegmentedDownload.h"
+#import "IGStreamingCache.h"
+#import "IGEpisode.h"
 #import "IGXMLResponseSerialization.h"
 #import "IGPodcastFeedParser.h"
 #import "IGDefines.h"
 #import "IGAPIKeys.h"
 #import "AFNetworking.h"
 #import "AFNetworkActivityIndicatorManager.h"
-#import "NSDate+Helper.h"
-#import "NSString+MD5.h"
+#import "NSDate+IGDateParsing.h"
 
 #import <WindowsAzureMobileServices/WindowsAzureMobileServices.h>
 
@@ -39,22 +47,68 @@ NSString * const IGDevelopmentPodcastFeedURL = @"http://www.tomdiggle.com/sitmos
 NSString * const IGBaseURL = @"http://www.dereksweet.com/";
 NSString * const IGPodcastFeedURL = @"http://www.dereksweet.com/sitmos/sitmos.xml";
 
-NSString * const IGPodcastFeedLastModifiedDateKey = @"PodcastFeedLastModifiedDate";
+NSString * const IGPodcastFeedValidatorsKey = @"PodcastFeedValidators";
+NSString * const IGPodcastFeedLastFullSyncDateKey = @"PodcastFeedLastFullSyncDate";
+
+/* How often an incremental sync is replaced by a full pass over the feed */
+static NSTimeInterval const IGPodcastFeedFullSyncInterval = 7 * 24 * 60 * 60;
 
 NSString * const IGWindowsAzureMobileServicesURL = @"https://sitmos.azure-mobile.net/";
 
 static BOOL __developmentMode = NO;
 
+/* Episodes at least this long are fetched over several connections while the app is active, shorter ones are not worth the extra requests */
+static int64_t const IGSegmentedDownloadMinimumFileSize = 16 * 1024 * 1024;
+
+/* Segmented downloads in flight keyed by download URL, only touched on the main thread */
+static NSMutableDictionary *__segmentedDownloads = nil;
+
 static NSDictionary *deviceToken = nil;
 
+/* Destination URLs of the downloads being completed from the streaming cache keyed by download URL, only touched on the main thread */
+static NSMutableDictionary *__cacheFills = nil;
+
+/* Bytes of segmented downloads and cache fills already counted by the data usage meter keyed by download URL, only touched on the main thread */
+static NSMutableDictionary *__countedTransferBytes = nil;
+
+/* Podcast feed transfers keyed by the identifier of their data task */
+static NSMutableDictionary *__podcastFeedTransfers = nil;
+
+/* Bytes of background download tasks already counted by the data usage meter, keyed by task identifier */
+static NSMutableDictionary *__countedBytes = nil;
+
+/**
+ * A transfer of the podcast feed, the parser its data is pushed to and the handler to execute when it completes.
+ */
+@interface IGPodcastFeedTransfer : NSObject
+
+@property (nonatomic, strong) IGPodcastFeedParser *feedParser;
+@property (nonatomic, copy) void (^completion)(NSURLResponse *response, NSError *error);
+@property (nonatomic, strong) NSError *error;
+
+@end
+
+@implementation IGPodcastFeedTransfer
+@end
+
+/**
+ * Pushes the data of the podcast feed transfers to their parsers as it arrives.
+ */
+@interface IGPodcastFeedSessionDelegate : NSObject <NSURLSessionDataDelegate>
+@end
+
 @interface IGNetworkManager ()
 
 @property (nonatomic, strong) NSURL *podcastFeedURL;
-@property (nonatomic, strong) AFURLSessionManager *podcastFeedSessionManager;
+@property (nonatomic, strong) NSURLSession *podcastFeedSession;
 @property (nonatomic, strong) AFURLSessionManager *downloadSessionManager;
 @property (nonatomic, strong) NSDictionary *deviceToken;
 @property (nonatomic, strong) MSClient *azureClient;
 
++ (IGPodcastFeedTransfer *)podcastFeedTransferForTask:(NSURLSessionTask *)task;
++ (void)setPodcastFeedTransfer:(IGPodcastFeedTransfer *)transfer forTask:(NSURLSessionTask *)task;
++ (BOOL)validatePodcastFeedResponse:(NSURLResponse *)response error:(NSError **)error;
+
 @end
 
 @implementation IGNetworkManager
@@ -78,70 +132,320 @@ static NSDictionary *deviceToken = nil;
     return [AFNetworkReachabilityManager.sharedManager isReachableViaWWAN];
 }
 
-#pragma mark -
++ (BOOL)isOnWiFiNetwork
+{
+    return [AFNetworkReachabilityManager.sharedManager isReachableViaWiFi];
+}
 
-+ (NSString *)incompleteDownloadsDirectory
+/**
+ * Tells the download scheduler which network the device is on and whether cellular data may still be used this month. An unknown or unreachable network leaves the scheduler as it is, downloads wait for reachability either way.
+ */
++ (void)updateDownloadNetworkWithStatus:(AFNetworkReachabilityStatus)status
 {
-    static NSString *incompleteDownloadsDirectory = nil;
-    static dispatch_once_t onceToken;
-    dispatch_once(&onceToken, ^{
-        NSString *cacheDir = NSTemporaryDirectory();
-        incompleteDownloadsDirectory = [cacheDir stringByAppendingPathComponent:@"Incomplete"];
-        
-        NSError *error = nil;
-        if (![[NSFileManager defaultManager] createDirectoryAtPath:incompleteDownloadsDirectory withIntermediateDirectories:YES attributes:nil error:&error])
-        {
-            NSLog(@"Failed to create episodes dir at %@, reason %@", incompleteDownloadsDirectory, [error localizedDescription]);
-        }
+    // The bytes received so far were received on the network being left.
+    for (NSURL *downloadURL in [__countedTransferBytes allKeys])
+    {
+        [IGNetworkManager recordBytesOfTransferWithURL:downloadURL];
+    }
+    
+    IGDownloadScheduler *downloadScheduler = [IGDownloadScheduler sharedScheduler];
+    if (status == AFNetworkReachabilityStatusReachableViaWWAN)
+    {
+        downloadScheduler.network = IGDownloadNetworkCellular;
+    }
+    else if (status == AFNetworkReachabilityStatusReachableViaWiFi)
+    {
+        downloadScheduler.network = IGDownloadNetworkWiFi;
+    }
+    
+    downloadScheduler.cellularDataAllowed = ![[IGDataUsageMeter sharedMeter] isMonthlyCellularLimitReached];
+}
+
+#pragma mark - Cellular Data
+
++ (void)setMonthlyCellularDataLimit:(int64_t)limit
+{
+    [[IGDataUsageMeter sharedMeter] setMonthlyCellularLimit:limit];
+    
+    NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
+    [userDefaults setObject:@(limit) forKey:IGMonthlyCellularDataLimitKey];
+    [userDefaults synchronize];
+    
+    [IGNetworkManager updateDownloadNetworkWithStatus:[[AFNetworkReachabilityManager sharedManager] networkReachabilityStatus]];
+}
+
+/**
+ * Counts bytes downloaded on the network the device is on, parking the downloads that use cellular data once the monthly limit is reached.
+ */
++ (void)recordDownloadedBytes:(int64_t)bytes
+{
+    // The meter and the scheduler are confined to the main thread.
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [IGNetworkManager recordDownloadedBytes:bytes onNetwork:[[IGDownloadScheduler sharedScheduler] network]];
     });
-    return incompleteDownloadsDirectory;
+}
+
+/**
+ * Counts bytes downloaded on the given network. Must be called on the main thread.
+ */
++ (void)recordDownloadedBytes:(int64_t)bytes onNetwork:(IGDownloadNetwork)network
+{
+    IGDownloadScheduler *downloadScheduler = [IGDownloadScheduler sharedScheduler];
+    IGDataUsageMeter *dataUsageMeter = [IGDataUsageMeter sharedMeter];
+    [dataUsageMeter recordBytes:bytes onNetwork:network];
+    downloadScheduler.cellularDataAllowed = ![dataUsageMeter isMonthlyCellularLimitReached];
+}
+
+/**
+ * Starts counting the bytes received by a segmented download or a cache fill, which report no progress of their own. Bytes the transfer already has are not counted.
+ */
++ (void)beginCountingBytesOfTransferWithURL:(NSURL *)downloadURL countOfBytesReceived:(int64_t)countOfBytesReceived
+{
+    if (!__countedTransferBytes)
+    {
+        __countedTransferBytes = [[NSMutableDictionary alloc] init];
+    }
+    [__countedTransferBytes setObject:@(countOfBytesReceived) forKey:downloadURL];
+}
+
+/**
+ * Counts the bytes a segmented download or a cache fill has received since they were last counted, on the network the device is on.
+ */
++ (void)recordBytesOfTransferWithURL:(NSURL *)downloadURL
+{
+    NSNumber *countedBytes = [__countedTransferBytes objectForKey:downloadURL];
+    if (!countedBytes)
+    {
+        return;
+    }
+    
+    IGSegmentedDownload *segmentedDownload = [__segmentedDownloads objectForKey:downloadURL];
+    int64_t countOfBytesReceived = segmentedDownload ? [segmentedDownload countOfBytesReceived] : [[[IGStreamingCache sharedCache] existingEntryForURL:downloadURL] countOfBytesCached];
+    if (countOfBytesReceived > [countedBytes longLongValue])
+    {
+        [IGNetworkManager recordDownloadedBytes:countOfBytesReceived - [countedBytes longLongValue] onNetwork:[[IGDownloadScheduler sharedScheduler] network]];
+    }
+    [__countedTransferBytes setObject:@(countOfBytesReceived) forKey:downloadURL];
+}
+
+/**
+ * Counts the last bytes of a segmented download or a cache fill that has finished.
+ */
++ (void)endCountingBytesOfTransferWithURL:(NSURL *)downloadURL
+{
+    [IGNetworkManager recordBytesOfTransferWithURL:downloadURL];
+    [__countedTransferBytes removeObjectForKey:downloadURL];
 }
 
 #pragma mark - Download Operations
 
 + (NSURLSessionDownloadTask *)downloadTaskForURL:(NSURL *)url
 {
-    __block NSURLSessionDownloadTask *sessionTask = nil;
+    return [[IGDownloadTaskRegistry sharedRegistry] downloadTaskForURL:url];
+}
+
++ (NSArray *)downloadTasks
+{
+    return [[IGDownloadTaskRegistry sharedRegistry] downloadTasks];
+}
+
++ (BOOL)isDownloadScheduledForURL:(NSURL *)url
+{
+    return [[IGDownloadScheduler sharedScheduler] isDownloadQueuedWithURL:url];
+}
+
++ (IGDownloadProgressSnapshot *)downloadProgressForURL:(NSURL *)url
+{
+    NSURLSessionDownloadTask *downloadTask = [IGNetworkManager downloadTaskForURL:url];
+    if (downloadTask)
+    {
+        IGDownloadProgressState state = ([downloadTask state] == NSURLSessionTaskStateRunning) ? IGDownloadProgressStateRunning : IGDownloadProgressStateSuspended;
+        return [[IGDownloadProgressSnapshot alloc] initWithDownloadURL:url
+                                                                 state:state
+                                                  countOfBytesReceived:[downloadTask countOfBytesReceived]
+                                         countOfBytesExpectedToReceive:[downloadTask countOfBytesExpectedToReceive]];
+    }
+    
+    IGSegmentedDownload *segmentedDownload = [__segmentedDownloads objectForKey:url];
+    if (segmentedDownload)
+    {
+        IGDownloadProgressState state = [segmentedDownload isSuspended] ? IGDownloadProgressStateSuspended : IGDownloadProgressStateRunning;
+        return [[IGDownloadProgressSnapshot alloc] initWithDownloadURL:url
+                                                                 state:state
+                                                  countOfBytesReceived:[segmentedDownload countOfBytesReceived]
+                                         countOfBytesExpectedToReceive:[segmentedDownload countOfBytesExpectedToReceive]];
+    }
+    
+    IGDownloadScheduler *downloadScheduler = [IGDownloadScheduler sharedScheduler];
+    if ([[downloadScheduler runningDownloadURLs] containsObject:url])
+    {
+        // Filled from the streaming cache, or about to get its task.
+        IGStreamingCacheEntry *cacheEntry = [[IGStreamingCache sharedCache] existingEntryForURL:url];
+        return [[IGDownloadProgressSnapshot alloc] initWithDownloadURL:url
+                                                                 state:IGDownloadProgressStateRunning
+                                                  countOfBytesReceived:[cacheEntry countOfBytesCached]
+                                         countOfBytesExpectedToReceive:[cacheEntry contentLength]];
+    }
+    
+    if ([downloadScheduler isDownloadQueuedWithURL:url])
+    {
+        return [[IGDownloadProgressSnapshot alloc] initWithDownloadURL:url
+                                                                 state:IGDownloadProgressStateWaiting
+                                                  countOfBytesReceived:0
+                                         countOfBytesExpectedToReceive:0];
+    }
     
-    NSArray *downloadTasks = [IGNetworkManager downloadTasks];
-    [downloadTasks enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
-        NSURLSessionDownloadTask *task = (NSURLSessionDownloadTask *)obj;
-        if ([[task.originalRequest URL] isEqual:url])
+    return nil;
+}
+
++ (void)restoreDownloadTasks
+{
+    // Creating the session manager registers the tasks the background session carried over from a previous launch.
+    [[[IGNetworkManager alloc] init] downloadSessionManager];
+}
+
++ (void)startResumingInterruptedDownloads
+{
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        [[AFNetworkReachabilityManager sharedManager] startMonitoring];
+        [[NSNotificationCenter defaultCenter] addObserverForName:AFNetworkingReachabilityDidChangeNotification object:nil queue:[NSOperationQueue mainQueue] usingBlock:^(NSNotification *notification) {
+            AFNetworkReachabilityStatus status = [[[notification userInfo] objectForKey:AFNetworkingReachabilityNotificationStatusItem] integerValue];
+            [IGNetworkManager updateDownloadNetworkWithStatus:status];
+            if (status == AFNetworkReachabilityStatusReachableViaWWAN || status == AFNetworkReachabilityStatusReachableViaWiFi)
+            {
+                [IGNetworkManager resumeInterruptedDownloads];
+            }
+        }];
+        
+        // A new month lifts the cellular limit without any change in reachability, downloads parked on it would otherwise wait for one.
+        for (NSString *name in @[UIApplicationWillEnterForegroundNotification, UIApplicationSignificantTimeChangeNotification])
         {
-            sessionTask = task;
-            *stop = YES;
+            [[NSNotificationCenter defaultCenter] addObserverForName:name object:nil queue:[NSOperationQueue mainQueue] usingBlock:^(NSNotification *notification) {
+                [IGNetworkManager updateDownloadNetworkWithStatus:[[AFNetworkReachabilityManager sharedManager] networkReachabilityStatus]];
+            }];
         }
-    }];
-    
-    return sessionTask;
+        
+        [IGNetworkManager updateDownloadNetworkWithStatus:[[AFNetworkReachabilityManager sharedManager] networkReachabilityStatus]];
+        [IGNetworkManager resumeInterruptedDownloads];
+    });
 }
 
-+ (NSArray *)downloadTasks
+/**
+ * Queues every download that has resume data and is not already scheduled. Resume data of episodes that no longer exist or have since been downloaded is removed.
+ */
++ (void)resumeInterruptedDownloads
 {
+    IGResumeDataStore *resumeDataStore = [IGResumeDataStore sharedStore];
+    [resumeDataStore removeExpiredResumeData];
+    
     IGNetworkManager *networkManager = [[IGNetworkManager alloc] init];
-    return [networkManager.downloadSessionManager downloadTasks];
+    for (NSURL *downloadURL in [resumeDataStore downloadURLs])
+    {
+        if ([IGNetworkManager isDownloadScheduledForURL:downloadURL])
+        {
+            continue;
+        }
+        
+        NSURL *destinationURL = [IGEpisode fileURLForDownloadURL:downloadURL];
+        if (!destinationURL || [[NSFileManager defaultManager] fileExistsAtPath:[destinationURL path]])
+        {
+            [resumeDataStore removeResumeDataForDownloadURL:downloadURL];
+            continue;
+        }
+        
+        [networkManager downloadEpisodeWithDownloadURL:downloadURL
+                                        destinationURL:destinationURL
+                                              priority:IGDownloadPriorityUserRequested
+                                            completion:nil];
+    }
 }
 
 #pragma mark - Podcast Feed URL
 
 - (NSURL *)podcastFeedURL
 {
+    if (_podcastFeedURL)
+    {
+        return _podcastFeedURL;
+    }
+    
     return __developmentMode ? [NSURL URLWithString:IGDevelopmentPodcastFeedURL] : [NSURL URLWithString:IGPodcastFeedURL];
 }
 
-#pragma mark - Podcast Feed Session Manager
+#pragma mark - Podcast Feed Session
 
-- (AFURLSessionManager *)podcastFeedSessionManager
+- (NSURLSession *)podcastFeedSession
 {
-    static AFURLSessionManager *podcastFeedSessionManager = nil;
+    static NSURLSession *podcastFeedSession = nil;
     static dispatch_once_t onceToken;
     dispatch_once(&onceToken, ^{
         NSURLSessionConfiguration *sessionConfig = [NSURLSessionConfiguration defaultSessionConfiguration];
         sessionConfig.HTTPMaximumConnectionsPerHost = 1;
-        podcastFeedSessionManager = [[AFURLSessionManager alloc] initWithSessionConfiguration:sessionConfig];
-        podcastFeedSessionManager.responseSerializer = [IGXMLResponseSerialization serializer];
+        
+        __podcastFeedTransfers = [[NSMutableDictionary alloc] init];
+        
+        // A plain session rather than a session manager, which would keep the whole feed in memory alongside the parser.
+        podcastFeedSession = [NSURLSession sessionWithConfiguration:sessionConfig
+                                                           delegate:[[IGPodcastFeedSessionDelegate alloc] init]
+                                                      delegateQueue:nil];
+    });
+    return podcastFeedSession;
+}
+
++ (IGPodcastFeedTransfer *)podcastFeedTransferForTask:(NSURLSessionTask *)task
+{
+    @synchronized(__podcastFeedTransfers)
+    {
+        return [__podcastFeedTransfers objectForKey:@(task.taskIdentifier)];
+    }
+}
+
++ (void)setPodcastFeedTransfer:(IGPodcastFeedTransfer *)transfer forTask:(NSURLSessionTask *)task
+{
+    @synchronized(__podcastFeedTransfers)
+    {
+        if (transfer)
+        {
+            [__podcastFeedTransfers setObject:transfer forKey:@(task.taskIdentifier)];
+        }
+        else
+        {
+            [__podcastFeedTransfers removeObjectForKey:@(task.taskIdentifier)];
+        }
+    }
+}
+
+/**
+ * Checks the status code and the content type of a podcast feed response before any of its body is parsed, so an error page is never pushed to the parser.
+ */
++ (BOOL)validatePodcastFeedResponse:(NSURLResponse *)response error:(NSError **)error
+{
+    static IGXMLResponseSerialization *responseSerializer = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        responseSerializer = [IGXMLResponseSerialization serializer];
     });
-    return podcastFeedSessionManager;
+    
+    if (![responseSerializer validateResponse:(NSHTTPURLResponse *)response data:nil error:error])
+    {
+        return NO;
+    }
+    
+    // The serializer only checks the content type against a body, which is never kept here.
+    if ([(NSHTTPURLResponse *)response statusCode] != 304 && ![responseSerializer.acceptableContentTypes containsObject:[response MIMEType]])
+    {
+        if (error)
+        {
+            NSDictionary *userInfo = @{ NSLocalizedDescriptionKey: [NSString stringWithFormat:NSLocalizedStringFromTable(@"Request failed: unacceptable content-type: %@", @"AFNetworking", nil), [response MIMEType]],
+                                        NSURLErrorFailingURLErrorKey: [response URL],
+                                        AFNetworkingOperationFailingURLResponseErrorKey: response };
+            *error = [NSError errorWithDomain:AFNetworkingErrorDomain code:NSURLErrorCannotDecodeContentData userInfo:userInfo];
+        }
+        return NO;
+    }
+    
+    return YES;
 }
 
 #pragma mark - Background Download Session Manager
@@ -168,6 +472,116 @@ static NSDictionary *deviceToken = nil;
             localNotification.soundName = UILocalNotificationDefaultSoundName;
             [[UIApplication sharedApplication] presentLocalNotificationNow:localNotification];
         }];
+        
+        [downloadSessionManager setDownloadTaskDidFinishDownloadingBlock:^NSURL *(NSURLSession *session, NSURLSessionDownloadTask *downloadTask, NSURL *location) {
+            // Only used for tasks carried over from a previous launch, tasks started by this launch are given their destination when they are created.
+            return [IGEpisode stagingURLForFileURL:[IGEpisode fileURLForDownloadURL:[downloadTask.originalRequest URL]]];
+        }];
+        
+        __countedBytes = [[NSMutableDictionary alloc] init];
+        [downloadSessionManager setDownloadTaskDidWriteDataBlock:^(NSURLSession *session, NSURLSessionDownloadTask *downloadTask, int64_t bytesWritten, int64_t totalBytesWritten, int64_t totalBytesExpectedToWrite) {
+            @synchronized(__countedBytes)
+            {
+                [__countedBytes setObject:@(totalBytesWritten) forKey:@(downloadTask.taskIdentifier)];
+            }
+            [IGNetworkManager recordDownloadedBytes:bytesWritten];
+        }];
+        
+        IGDownloadTaskRegistry *downloadTaskRegistry = [IGDownloadTaskRegistry sharedRegistry];
+        [downloadSessionManager setTaskDidCompleteBlock:^(NSURLSession *session, NSURLSessionTask *task, NSError *error) {
+            [downloadTaskRegistry unregisterTask:task];
+            
+            // Bytes received while the app was suspended are only seen now. A task carried over from a previous launch is counted in full, which errs on the side of the cellular limit.
+            NSNumber *countedBytes = nil;
+            @synchronized(__countedBytes)
+            {
+                countedBytes = [__countedBytes objectForKey:@(task.taskIdentifier)];
+                [__countedBytes removeObjectForKey:@(task.taskIdentifier)];
+            }
+            [IGNetworkManager recordDownloadedBytes:task.countOfBytesReceived - [countedBytes longLongValue]];
+            
+            // Saved here rather than in each task's completion handler so tasks carried over from a previous launch keep their resume data too.
+            NSData *resumeData = [[error userInfo] objectForKey:NSURLSessionDownloadTaskResumeData];
+            if (resumeData)
+            {
+                [[IGResumeDataStore sharedStore] saveResumeData:resumeData
+                                                 forDownloadURL:[task.originalRequest URL]
+                                                       response:task.response];
+            }
+            
+            NSInteger statusCode = [(NSHTTPURLResponse *)task.response statusCode];
+            BOOL success = (!error && statusCode >= 200 && statusCode < 300);
+            if (success)
+            {
+                [[IGResumeDataStore sharedStore] removeResumeDataForDownloadURL:[task.originalRequest URL]];
+                [[[IGNetworkManager alloc] init] verifyDownloadWithURL:[task.originalRequest URL]
+                                                        destinationURL:[IGEpisode fileURLForDownloadURL:[task.originalRequest URL]]
+                                                        expectedLength:[IGDownloadVerifier expectedLengthOfResponse:task.response]
+                                                           expectedMD5:[IGDownloadVerifier expectedMD5OfResponse:task.response]
+                                                                repair:YES];
+                return;
+            }
+            
+            dispatch_async(dispatch_get_main_queue(), ^{
+                [[IGDownloadScheduler sharedScheduler] finishDownloadWithURL:[task.originalRequest URL]
+                                                                     success:success
+                                                                       error:error];
+            });
+        }];
+        
+        [[IGDownloadScheduler sharedScheduler] setStartDownloadBlock:^(NSURL *downloadURL, NSURL *destinationURL) {
+            IGNetworkManager *networkManager = [[IGNetworkManager alloc] init];
+            destinationURL = destinationURL ?: [IGEpisode fileURLForDownloadURL:downloadURL];
+            BOOL applicationActive = ([[UIApplication sharedApplication] applicationState] == UIApplicationStateActive);
+            IGStreamingCacheEntry *cacheEntry = [[IGStreamingCache sharedCache] existingEntryForURL:downloadURL];
+            IGSegmentedDownload *segmentedDownload = [__segmentedDownloads objectForKey:downloadURL];
+            if (segmentedDownload)
+            {
+                // Suspended to make room for a more urgent download.
+                [segmentedDownload resume];
+            }
+            else if (cacheEntry && ([cacheEntry isComplete] || applicationActive))
+            {
+                [networkManager startCachedDownloadWithDownloadURL:downloadURL destinationURL:destinationURL];
+            }
+            else if (applicationActive && [IGEpisode fileSizeForDownloadURL:downloadURL] >= IGSegmentedDownloadMinimumFileSize)
+            {
+                [networkManager startSegmentedDownloadWithDownloadURL:downloadURL destinationURL:destinationURL];
+            }
+            else
+            {
+                [networkManager startDownloadWithDownloadURL:downloadURL destinationURL:destinationURL];
+            }
+            
+            [[IGDownloadProgressHub sharedHub] setNeedsUpdate];
+        }];
+        
+        // Cache fills run on a foreground session that dies with the app, they carry on in the background session instead.
+        [[NSNotificationCenter defaultCenter] addObserverForName:UIApplicationWillResignActiveNotification object:nil queue:[NSOperationQueue mainQueue] usingBlock:^(NSNotification *notification) {
+            [[[IGNetworkManager alloc] init] handOffCacheFills];
+        }];
+        
+        [[IGDownloadScheduler sharedScheduler] setParkDownloadBlock:^BOOL(NSURL *downloadURL) {
+            BOOL stopped = [[[IGNetworkManager alloc] init] stopTransferOfDownloadWithURL:downloadURL];
+            [[IGDownloadProgressHub sharedHub] setNeedsUpdate];
+            return stopped;
+        }];
+        
+        [[IGDownloadScheduler sharedScheduler] setSuspendDownloadBlock:^BOOL(NSURL *downloadURL) {
+            BOOL stopped = [[[IGNetworkManager alloc] init] suspendTransferOfDownloadWithURL:downloadURL];
+            [[IGDownloadProgressHub sharedHub] setNeedsUpdate];
+            return stopped;
+        }];
+        
+        // The only time the session is asked for its tasks, from then on the registry is kept up to date as tasks start and complete.
+        [downloadSessionManager.session getTasksWithCompletionHandler:^(NSArray *dataTasks, NSArray *uploadTasks, NSArray *downloadTasks) {
+            [downloadTaskRegistry registerDownloadTasks:downloadTasks];
+            
+            NSArray *runningDownloadURLs = [[downloadTaskRegistry downloadTasks] valueForKeyPath:@"originalRequest.URL"];
+            dispatch_async(dispatch_get_main_queue(), ^{
+                [[IGDownloadScheduler sharedScheduler] restoreQueueWithRunningDownloadURLs:runningDownloadURLs];
+            });
+        }];
     });
     return downloadSessionManager;
 }
@@ -223,138 +637,638 @@ static NSDictionary *deviceToken = nil;
 #pragma mark - Syncing Podcast Feed
 
 - (void)syncPodcastFeedWithCompletion:(void (^)(BOOL success, NSArray *feedItems, NSError *error))completion
+{
+    [self syncPodcastFeedWithFeedItemHandler:nil completion:completion];
+}
+
+- (void)syncPodcastFeedWithFeedItemHandler:(void (^)(IGFeedItem *feedItem))feedItemHandler completion:(void (^)(BOOL success, NSArray *feedItems, NSError *error))completion
+{
+    [self syncPodcastFeedNewerThanPubDate:nil conditional:NO feedItemHandler:feedItemHandler completion:completion];
+}
+
+- (void)syncPodcastFeedNewerThanPubDate:(NSDate *)pubDate completion:(void (^)(BOOL success, NSArray *feedItems, NSError *error))completion
+{
+    NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
+    NSDate *lastFullSyncDate = [userDefaults objectForKey:IGPodcastFeedLastFullSyncDateKey];
+    BOOL fullSync = (!pubDate || !lastFullSyncDate || -[lastFullSyncDate timeIntervalSinceNow] > IGPodcastFeedFullSyncInterval);
+    
+    // A full sync always gets the whole feed, a 304 would skip the reconcile it is there for.
+    [self syncPodcastFeedNewerThanPubDate:(fullSync ? nil : pubDate) conditional:!fullSync feedItemHandler:nil completion:^(BOOL success, NSArray *feedItems, NSError *error) {
+        if (success && fullSync)
+        {
+            [userDefaults setObject:[NSDate date] forKey:IGPodcastFeedLastFullSyncDateKey];
+            [userDefaults synchronize];
+        }
+        
+        if (completion)
+        {
+            completion(success, feedItems, error);
+        }
+    }];
+}
+
+- (void)syncPodcastFeedNewerThanPubDate:(NSDate *)pubDate conditional:(BOOL)conditional feedItemHandler:(void (^)(IGFeedItem *feedItem))feedItemHandler completion:(void (^)(BOOL success, NSArray *feedItems, NSError *error))completion
 {
     NSMutableURLRequest *request = [[NSMutableURLRequest alloc] initWithURL:self.podcastFeedURL];
     [request setCachePolicy:NSURLRequestReloadIgnoringCacheData];
     
-    NSURLSessionDataTask *dataTask = [self.podcastFeedSessionManager dataTaskWithRequest:request completionHandler:^(NSURLResponse *response, id responseObject, NSError *error) {
-        NSHTTPURLResponse *HTTPURLResponse = (NSHTTPURLResponse *)response;
-        if ([self isPodcastFeedModifiedSince:[HTTPURLResponse.allHeaderFields valueForKey:@"Last-Modified"]])
+    if (conditional)
+    {
+        NSDictionary *validators = [self podcastFeedValidators];
+        [request setValue:[validators objectForKey:@"ETag"] forHTTPHeaderField:@"If-None-Match"];
+        [request setValue:[validators objectForKey:@"Last-Modified"] forHTTPHeaderField:@"If-Modified-Since"];
+    }
+    
+    // The sync completes once both the transfer and the parser have finished.
+    dispatch_group_t group = dispatch_group_create();
+    __block NSArray *parsedFeedItems = nil;
+    __block NSError *parserError = nil;
+    __block NSError *transferError = nil;
+    __block NSHTTPURLResponse *HTTPURLResponse = nil;
+    
+    __block NSURLSessionDataTask *dataTask = nil;
+    __block IGPodcastFeedParser *feedParser = nil;
+    
+    dispatch_group_enter(group);
+    feedParser = [IGPodcastFeedParser PodcastFeedParserWithFeedItemHandler:feedItemHandler completion:^(NSArray *feedItems, NSError *error) {
+        parsedFeedItems = feedItems;
+        parserError = error;
+        if ([feedParser isStoppedAtKnownItem])
         {
-            [IGPodcastFeedParser PodcastFeedParserWithXMLParser:responseObject completion:^(NSArray *feedItems, NSError *error) {
-                if (completion)
-                {
-                    dispatch_async(dispatch_get_main_queue(), ^{
-                        completion(error ? NO : YES, feedItems, error);
-                    });
-                }
-            }];
+            // Nothing after a known item is needed, stop the transfer.
+            [[IGNetworkManager podcastFeedTransferForTask:dataTask] setFeedParser:nil];
+            [dataTask cancel];
+        }
+        dispatch_group_leave(group);
+    }];
+    feedParser.newestKnownPubDate = pubDate;
+    
+    dispatch_group_enter(group);
+    IGPodcastFeedTransfer *transfer = [[IGPodcastFeedTransfer alloc] init];
+    transfer.feedParser = feedParser;
+    transfer.completion = ^(NSURLResponse *response, NSError *error) {
+        HTTPURLResponse = (NSHTTPURLResponse *)response;
+        transferError = error;
+        if ([HTTPURLResponse statusCode] == 304)
+        {
+            // Not modified, there is nothing to parse.
+            [feedParser cancel];
+        }
+        else if (error)
+        {
+            [feedParser abortWithError:error];
         }
         else
         {
-            if (completion)
-            {
-                dispatch_async(dispatch_get_main_queue(), ^{
-                    completion(error ? NO : YES, nil, error);
-                });
-            }
+            [feedParser finish];
         }
-    }];
+        dispatch_group_leave(group);
+    };
+    dataTask = [self.podcastFeedSession dataTaskWithRequest:request];
+    [IGNetworkManager setPodcastFeedTransfer:transfer forTask:dataTask];
+    [[AFNetworkActivityIndicatorManager sharedManager] incrementActivityCount];
     [dataTask resume];
+    
+    dispatch_group_notify(group, dispatch_get_main_queue(), ^{
+        if ([feedParser isStoppedAtKnownItem] && [transferError code] == NSURLErrorCancelled)
+        {
+            transferError = nil;
+        }
+        
+        NSError *error = transferError ?: parserError;
+        if (!error && [HTTPURLResponse statusCode] == 200)
+        {
+            // An incremental sync that stopped at a known item has still seen the current feed, everything after that item was already stored.
+            [self setPodcastFeedValidatorsFromResponse:HTTPURLResponse];
+        }
+        NSArray *feedItems = error ? nil : parsedFeedItems;
+        
+        if (completion)
+        {
+            completion(error ? NO : YES, feedItems, error);
+        }
+        
+        // Breaks the retain cycles between the blocks, the parser and the data task.
+        feedParser = nil;
+        dataTask = nil;
+    });
+}
+
+#pragma mark - Podcast Feed Validators
+
+/**
+ * Returns the ETag and Last-Modified values of the last podcast feed response, keyed by header name.
+ */
+- (NSDictionary *)podcastFeedValidators
+{
+    NSDictionary *validators = [[NSUserDefaults standardUserDefaults] objectForKey:IGPodcastFeedValidatorsKey];
+    return [validators objectForKey:[self.podcastFeedURL absoluteString]];
 }
 
-- (BOOL)isPodcastFeedModifiedSince:(NSString *)modifiedDate
+/**
+ * Persists the validators of the podcast feed response so the next sync can be a conditional request. Validators are kept per feed URL so the development feed does not invalidate the live one.
+ */
+- (void)setPodcastFeedValidatorsFromResponse:(NSHTTPURLResponse *)response
 {
-    NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
-    NSDate *feedLastRefreshed = [NSDate dateFromString:[userDefaults objectForKey:IGPodcastFeedLastModifiedDateKey]
-                                            withFormat:IGDateFormatString];
-    NSDate *feedLastModified = [NSDate dateFromString:modifiedDate
-                                           withFormat:IGDateFormatString];
-    
-    if (!feedLastRefreshed || ([feedLastRefreshed compare:feedLastModified] == NSOrderedAscending))
+    NSMutableDictionary *feedValidators = [NSMutableDictionary dictionary];
+    NSString *ETag = [response.allHeaderFields valueForKey:@"ETag"];
+    if (ETag)
     {
-        [userDefaults setObject:[NSDate stringFromDate:[NSDate date] withFormat:IGDateFormatString]
-                         forKey:IGPodcastFeedLastModifiedDateKey];
-        [userDefaults synchronize];
-        return YES;
+        [feedValidators setObject:ETag forKey:@"ETag"];
+    }
+    NSString *lastModified = [response.allHeaderFields valueForKey:@"Last-Modified"];
+    if (lastModified && [NSDate dateFromRFC822String:lastModified])
+    {
+        // A malformed date would be sent back as If-Modified-Since on every sync, only keep one that parses.
+        [feedValidators setObject:lastModified forKey:@"Last-Modified"];
     }
     
-    return NO;
+    NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
+    NSMutableDictionary *validators = [NSMutableDictionary dictionaryWithDictionary:[userDefaults objectForKey:IGPodcastFeedValidatorsKey]];
+    [validators setObject:feedValidators forKey:[self.podcastFeedURL absoluteString]];
+    [userDefaults setObject:validators forKey:IGPodcastFeedValidatorsKey];
+    [userDefaults synchronize];
 }
 
 #pragma mark - Download Episode
 
 - (void)downloadEpisodeWithDownloadURL:(NSURL *)downloadURL destinationURL:(NSURL *)destinationURL completion:(void (^)(BOOL success, NSError *error))completion
 {
-    NSData *resumeData = [self loadResumeDataForDownloadURL:downloadURL];
-    if (resumeData)
+    [self downloadEpisodeWithDownloadURL:downloadURL destinationURL:destinationURL priority:IGDownloadPriorityUserRequested completion:completion];
+}
+
+- (void)downloadEpisodeWithDownloadURL:(NSURL *)downloadURL destinationURL:(NSURL *)destinationURL priority:(IGDownloadPriority)priority completion:(void (^)(BOOL success, NSError *error))completion
+{
+    [self downloadEpisodeWithDownloadURL:downloadURL
+                          destinationURL:destinationURL
+                                priority:priority
+                    allowsCellularAccess:[[NSUserDefaults standardUserDefaults] boolForKey:IGAllowCellularDataDownloadingKey]
+                              completion:completion];
+}
+
+- (void)downloadEpisodeWithDownloadURL:(NSURL *)downloadURL destinationURL:(NSURL *)destinationURL priority:(IGDownloadPriority)priority allowsCellularAccess:(BOOL)allowsCellularAccess completion:(void (^)(BOOL success, NSError *error))completion
+{
+    // The scheduler's start and park blocks are set up along with the session.
+    [self downloadSessionManager];
+    
+    [[IGDownloadScheduler sharedScheduler] enqueueDownloadWithURL:downloadURL
+                                                   destinationURL:destinationURL
+                                                         priority:priority
+                                             allowsCellularAccess:allowsCellularAccess
+                                                       completion:completion];
+    [[IGDownloadProgressHub sharedHub] setNeedsUpdate];
+}
+
++ (void)prioritizeDownloadForURL:(NSURL *)downloadURL
+{
+    [[IGDownloadScheduler sharedScheduler] prioritizeDownloadWithURL:downloadURL];
+}
+
++ (void)cancelDownloadForURL:(NSURL *)downloadURL
+{
+    // Removed from the queue first so the cancelled transfer does not report back as a failure.
+    void (^cancel)(void) = ^{
+        [[IGDownloadScheduler sharedScheduler] removeDownloadWithURL:downloadURL];
+        [[IGNetworkManager downloadTaskForURL:downloadURL] cancel];
+        [(IGSegmentedDownload *)[__segmentedDownloads objectForKey:downloadURL] cancel];
+        [[IGResumeDataStore sharedStore] removeResumeDataForDownloadURL:downloadURL];
+        [[[IGStreamingCache sharedCache] existingEntryForURL:downloadURL] cancelFill];
+        [[IGDownloadProgressHub sharedHub] setNeedsUpdate];
+    };
+    
+    // Episodes are deleted from background contexts too, the scheduler is confined to the main thread.
+    if ([NSThread isMainThread])
+    {
+        cancel();
+    }
+    else
     {
-        [self downloadEpisodeWithResumeData:resumeData downloadURL:downloadURL destinationURL:destinationURL completion:completion];
+        dispatch_async(dispatch_get_main_queue(), cancel);
+    }
+}
+
+/**
+ * Starts the transfer of a download given a slot by the scheduler, resuming from saved resume data when the file has not changed on the server since. The scheduler is told when the transfer completes by the download session's task did complete block.
+ */
+- (void)startDownloadWithDownloadURL:(NSURL *)downloadURL destinationURL:(NSURL *)destinationURL
+{
+    [[IGResumeDataStore sharedStore] validateResumeDataForDownloadURL:downloadURL completion:^(NSData *resumeData) {
+        IGDownloadScheduler *downloadScheduler = [IGDownloadScheduler sharedScheduler];
+        if (![[downloadScheduler runningDownloadURLs] containsObject:downloadURL])
+        {
+            // Cancelled or parked while the validators were checked, a parked download waits for its transfer to report back.
+            [downloadScheduler finishDownloadWithURL:downloadURL success:NO error:nil];
+            return;
+        }
+        
+        // Parked and started again while the validators were checked.
+        if ([IGNetworkManager downloadTaskForURL:downloadURL])
+        {
+            return;
+        }
+        
+        if (resumeData && [self startDownloadWithResumeData:resumeData downloadURL:downloadURL destinationURL:destinationURL])
+        {
+            return;
+        }
         
+        NSMutableURLRequest *request = [[NSMutableURLRequest alloc] initWithURL:downloadURL];
+        [request setCachePolicy:NSURLRequestReloadIgnoringCacheData];
+        
+        NSURLSessionDownloadTask *downloadTask = [self.downloadSessionManager downloadTaskWithRequest:request progress:nil destination:^NSURL *(NSURL *targetPath, NSURLResponse *response) {
+            
+            return [IGEpisode stagingURLForFileURL:destinationURL];
+        } completionHandler:nil];
+        [[IGDownloadTaskRegistry sharedRegistry] registerDownloadTask:downloadTask];
+        [downloadTask resume];
+    }];
+}
+
+/**
+ * Completes a download from the bytes cached while the episode was streamed, fetching only the ranges playback skipped. Should the server not support ranges the cached bytes are dropped and the download falls back to the background session, as it does should the fill fail or the app resign active.
+ */
+- (void)startCachedDownloadWithDownloadURL:(NSURL *)downloadURL destinationURL:(NSURL *)destinationURL
+{
+    IGStreamingCache *streamingCache = [IGStreamingCache sharedCache];
+    IGStreamingCacheEntry *cacheEntry = [streamingCache existingEntryForURL:downloadURL];
+    if (!cacheEntry)
+    {
+        [self startDownloadWithDownloadURL:downloadURL destinationURL:destinationURL];
         return;
     }
     
-    NSMutableURLRequest *request = [[NSMutableURLRequest alloc] initWithURL:downloadURL];
-    [request setCachePolicy:NSURLRequestReloadIgnoringCacheData];
+    // Already being completed from the cache, a second fill would only report back twice.
+    if ([__cacheFills objectForKey:downloadURL])
+    {
+        return;
+    }
+    
+    if (!__cacheFills)
+    {
+        __cacheFills = [[NSMutableDictionary alloc] init];
+    }
+    [__cacheFills setObject:destinationURL forKey:downloadURL];
     
-    NSURLSessionDownloadTask *downloadTask = [self.downloadSessionManager downloadTaskWithRequest:request progress:nil destination:^NSURL *(NSURL *targetPath, NSURLResponse *response) {
+    [IGNetworkManager beginCountingBytesOfTransferWithURL:downloadURL countOfBytesReceived:[cacheEntry countOfBytesCached]];
+    [cacheEntry fillWithCompletion:^(BOOL success, NSError *error) {
+        [IGNetworkManager endCountingBytesOfTransferWithURL:downloadURL];
         
-        return destinationURL;
-    } completionHandler:^(NSURLResponse *response, NSURL *filePath, NSError *error) {
-        if (error)
+        // Handed off to the background session, which reports back to the scheduler.
+        if (![__cacheFills objectForKey:downloadURL])
         {
-            NSData *resumeData = [[error userInfo] objectForKey:NSURLSessionDownloadTaskResumeData];
-            [self saveResumableData:resumeData withFileName:[NSString MD5Hash:[downloadURL absoluteString]]];
+            return;
         }
+        [__cacheFills removeObjectForKey:downloadURL];
         
-        if (completion)
+        int64_t contentLength = [cacheEntry contentLength];
+        NSError *moveError = nil;
+        if (success && ![streamingCache moveEntryForURL:downloadURL toURL:[IGEpisode stagingURLForFileURL:destinationURL] error:&moveError])
         {
-            dispatch_async(dispatch_get_main_queue(), ^{
-                completion(error ? NO : YES, error);
-            });
+            success = NO;
+            error = moveError;
         }
+        
+        if ([[error domain] isEqualToString:IGStreamingCacheErrorDomain] && [error code] == IGStreamingCacheErrorUnexpectedResponse)
+        {
+            [streamingCache removeEntryForURL:downloadURL];
+            [self startDownloadWithDownloadURL:downloadURL destinationURL:destinationURL];
+            return;
+        }
+        
+        if (!success && [error code] != NSURLErrorCancelled && [[[IGDownloadScheduler sharedScheduler] runningDownloadURLs] containsObject:downloadURL])
+        {
+            // A failed fill has no resume data, the background session starts over and keeps its own should it fail too.
+            [self startDownloadWithDownloadURL:downloadURL destinationURL:destinationURL];
+            return;
+        }
+        
+        if (success)
+        {
+            [[IGResumeDataStore sharedStore] removeResumeDataForDownloadURL:downloadURL];
+            [self verifyDownloadWithURL:downloadURL
+                         destinationURL:destinationURL
+                         expectedLength:contentLength
+                            expectedMD5:nil
+                                 repair:YES];
+            return;
+        }
+        
+        [[IGDownloadScheduler sharedScheduler] finishDownloadWithURL:downloadURL
+                                                             success:success
+                                                               error:error];
     }];
-    [downloadTask resume];
 }
 
-- (void)downloadEpisodeWithResumeData:(NSData *)resumeData downloadURL:(NSURL *)downloadURL destinationURL:(NSURL *)destinationURL completion:(void (^)(BOOL success, NSError *error))completion
+/**
+ * Moves the cache fills in progress to the background session, so they are not lost when the app is suspended. The bytes already cached are kept for streaming.
+ */
+- (void)handOffCacheFills
 {
-    NSURLSessionDownloadTask *downloadTask = [self.downloadSessionManager downloadTaskWithResumeData:resumeData progress:nil destination:^NSURL *(NSURL *targetPath, NSURLResponse *response) {
+    IGStreamingCache *streamingCache = [IGStreamingCache sharedCache];
+    NSDictionary *cacheFills = [__cacheFills copy];
+    [__cacheFills removeAllObjects];
+    [cacheFills enumerateKeysAndObjectsUsingBlock:^(NSURL *downloadURL, NSURL *destinationURL, BOOL *stop) {
+        [[streamingCache existingEntryForURL:downloadURL] cancelFill];
+        [self startDownloadWithDownloadURL:downloadURL destinationURL:destinationURL];
+    }];
+}
+
+/**
+ * Starts a segmented download on a foreground session. Should the server not support ranges the download falls back to the background session.
+ */
+- (void)startSegmentedDownloadWithDownloadURL:(NSURL *)downloadURL destinationURL:(NSURL *)destinationURL
+{
+    if (!__segmentedDownloads)
+    {
+        __segmentedDownloads = [[NSMutableDictionary alloc] init];
+    }
+    
+    // The partial file is written beside the staged file, outside the episodes directory.
+    IGSegmentedDownload *segmentedDownload = [[IGSegmentedDownload alloc] initWithDownloadURL:downloadURL destinationURL:[IGEpisode stagingURLForFileURL:destinationURL]];
+    [__segmentedDownloads setObject:segmentedDownload forKey:downloadURL];
+    [IGNetworkManager beginCountingBytesOfTransferWithURL:downloadURL countOfBytesReceived:0];
+    __weak IGSegmentedDownload *weakSegmentedDownload = segmentedDownload;
+    [segmentedDownload startWithCompletion:^(BOOL success, NSError *error) {
+        int64_t expectedLength = [weakSegmentedDownload countOfBytesExpectedToReceive];
+        [IGNetworkManager endCountingBytesOfTransferWithURL:downloadURL];
+        [__segmentedDownloads removeObjectForKey:downloadURL];
         
-        return destinationURL;
-    } completionHandler:^(NSURLResponse *response, NSURL *filePath, NSError *error) {
-        if (error)
+        if ([[error domain] isEqualToString:IGSegmentedDownloadErrorDomain] && [error code] == IGSegmentedDownloadErrorRangesNotSupported)
         {
-            NSData *resumeData = [[error userInfo] objectForKey:NSURLSessionDownloadTaskResumeData];
-            [self saveResumableData:resumeData withFileName:[NSString MD5Hash:[downloadURL absoluteString]]];
+            [self startDownloadWithDownloadURL:downloadURL destinationURL:destinationURL];
+            return;
         }
         
-        if (completion)
+        if (success)
         {
-            dispatch_async(dispatch_get_main_queue(), ^{
-                completion(error ? NO : YES, error);
-            });
+            // Ranges written over several connections are exactly what verification is there to catch.
+            [self verifyDownloadWithURL:downloadURL
+                         destinationURL:destinationURL
+                         expectedLength:expectedLength
+                            expectedMD5:nil
+                                 repair:YES];
+            return;
         }
+        
+        [[IGDownloadScheduler sharedScheduler] finishDownloadWithURL:downloadURL
+                                                             success:success
+                                                               error:error];
     }];
-    [downloadTask resume];
 }
 
-- (void)saveResumableData:(NSData *)data withFileName:(NSString *)fileName
+/**
+ * Stops the transfer of a parked download. A background download task is cancelled producing resume data, a cache fill keeps what it has fetched and a segmented download starts over. Every stopped transfer reports back to the scheduler as a failure.
+ *
+ * @return YES if a transfer was stopped, NO if none is running.
+ */
+- (BOOL)stopTransferOfDownloadWithURL:(NSURL *)downloadURL
 {
-    if (!data || !fileName)
+    NSURLSessionDownloadTask *downloadTask = [IGNetworkManager downloadTaskForURL:downloadURL];
+    if (downloadTask)
     {
-        return;
+        [downloadTask cancelByProducingResumeData:^(NSData *resumeData) {
+            if (resumeData)
+            {
+                [[IGResumeDataStore sharedStore] saveResumeData:resumeData
+                                                 forDownloadURL:downloadURL
+                                                       response:downloadTask.response];
+            }
+        }];
+        return YES;
+    }
+    
+    IGSegmentedDownload *segmentedDownload = [__segmentedDownloads objectForKey:downloadURL];
+    if (segmentedDownload)
+    {
+        [segmentedDownload cancel];
+        return YES;
     }
     
-    NSString *resumeDataPath = [[IGNetworkManager incompleteDownloadsDirectory] stringByAppendingPathComponent:fileName];
-    [[NSFileManager defaultManager] createFileAtPath:resumeDataPath contents:data attributes:nil];
+    IGStreamingCacheEntry *cacheEntry = [[IGStreamingCache sharedCache] existingEntryForURL:downloadURL];
+    if ([cacheEntry isFilling])
+    {
+        [cacheEntry cancelFill];
+        return YES;
+    }
+    
+    return NO;
 }
 
-- (NSData *)loadResumeDataForDownloadURL:(NSURL *)downloadURL
+/**
+ * Suspends the transfer of a download to make room for a more urgent one. A background download task or a segmented download is suspended where it is, a cache fill is stopped as it would be when parked.
+ *
+ * @return YES if a transfer was stopped, NO if it was suspended or none is running.
+ */
+- (BOOL)suspendTransferOfDownloadWithURL:(NSURL *)downloadURL
 {
-    if (!downloadURL)
+    NSURLSessionDownloadTask *downloadTask = [IGNetworkManager downloadTaskForURL:downloadURL];
+    if (downloadTask)
     {
-        return nil;
+        [downloadTask suspend];
+        return NO;
     }
     
-    NSString *fileName = [NSString MD5Hash:[downloadURL absoluteString]];
-    NSString *resumeDataPath = [[IGNetworkManager incompleteDownloadsDirectory] stringByAppendingPathComponent:fileName];
-    if ([[NSFileManager defaultManager] fileExistsAtPath:resumeDataPath])
+    IGSegmentedDownload *segmentedDownload = [__segmentedDownloads objectForKey:downloadURL];
+    if (segmentedDownload)
     {
-        return [NSData dataWithContentsOfFile:resumeDataPath];
+        [segmentedDownload suspend];
+        return NO;
     }
     
-    return nil;
+    return [self stopTransferOfDownloadWithURL:downloadURL];
+}
+
+/**
+ * Returns NO if no download task could be created from the resume data, in which case the resume data is removed.
+ */
+- (BOOL)startDownloadWithResumeData:(NSData *)resumeData downloadURL:(NSURL *)downloadURL destinationURL:(NSURL *)destinationURL
+{
+    NSURLSessionDownloadTask *downloadTask = [self.downloadSessionManager downloadTaskWithResumeData:resumeData progress:nil destination:^NSURL *(NSURL *targetPath, NSURLResponse *response) {
+        
+        return [IGEpisode stagingURLForFileURL:destinationURL];
+    } completionHandler:nil];
+    
+    // The blob is spent once the task has it, fresh resume data is saved should the task be interrupted again.
+    [[IGResumeDataStore sharedStore] removeResumeDataForDownloadURL:downloadURL];
+    if (!downloadTask)
+    {
+        return NO;
+    }
+    
+    [[IGDownloadTaskRegistry sharedRegistry] registerDownloadTask:downloadTask];
+    [downloadTask resume];
+    
+    return YES;
+}
+
+#pragma mark - Download Verification
+
+/**
+ * Verifies a transferred episode in the staging directory and only then moves it to the destination, so a truncated or badly spliced file is never seen in the episodes directory. The scheduler is told once the episode has been recorded or has failed.
+ *
+ * A file that fails is taken out of the staging directory into the streaming cache, keeping the ranges that passed, and only the corrupt ranges are fetched again before it is verified once more. A file that still fails is removed.
+ */
+- (void)verifyDownloadWithURL:(NSURL *)downloadURL
+               destinationURL:(NSURL *)destinationURL
+               expectedLength:(int64_t)expectedLength
+                  expectedMD5:(NSData *)expectedMD5
+                       repair:(BOOL)repair
+{
+    NSURL *stagingURL = [IGEpisode stagingURLForFileURL:destinationURL];
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{
+        // Only the length the server sent is checked, the enclosure length in the feed is often out of date.
+        NSError *error = nil;
+        IGDownloadVerification *verification = [IGDownloadVerifier verifyFileAtURL:stagingURL
+                                                                    expectedLength:expectedLength
+                                                                       expectedMD5:expectedMD5
+                                                                             error:&error];
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            // The download may have been cancelled while it was verified.
+            if (![IGNetworkManager isDownloadScheduledForURL:downloadURL])
+            {
+                [[NSFileManager defaultManager] removeItemAtURL:stagingURL error:nil];
+                return;
+            }
+            
+            // A refetch that fails again in the same way is the file as the server has it, which is better kept than thrown away.
+            BOOL matchesServer = (!repair && verification.expectedLength > 0 && verification.fileLength == verification.expectedLength);
+            if ([verification isValid] || matchesServer)
+            {
+                NSFileManager *fileManager = [NSFileManager defaultManager];
+                NSError *moveError = nil;
+                [fileManager removeItemAtURL:destinationURL error:nil];
+                if (![fileManager moveItemAtURL:stagingURL toURL:destinationURL error:&moveError])
+                {
+                    [fileManager removeItemAtURL:stagingURL error:nil];
+                    [[IGDownloadScheduler sharedScheduler] finishDownloadWithURL:downloadURL
+                                                                         success:NO
+                                                                           error:moveError];
+                    return;
+                }
+                
+                [IGEpisode recordFinishedDownloadForDownloadURL:downloadURL
+                                                     completion:nil];
+                [[IGDownloadScheduler sharedScheduler] finishDownloadWithURL:downloadURL
+                                                                     success:YES
+                                                                       error:nil];
+                return;
+            }
+            
+            NSLog(@"Verification of %@ failed, %@", downloadURL, verification ?: [error localizedDescription]);
+            if (verification && repair)
+            {
+                [self repairDownloadWithURL:downloadURL
+                             destinationURL:destinationURL
+                               verification:verification
+                                expectedMD5:expectedMD5];
+                return;
+            }
+            
+            [[NSFileManager defaultManager] removeItemAtURL:stagingURL error:nil];
+            [[IGDownloadScheduler sharedScheduler] finishDownloadWithURL:downloadURL
+                                                                 success:NO
+                                                                   error:error ?: [NSError errorWithDomain:IGDownloadVerifierErrorDomain code:IGDownloadVerifierErrorCorrupt userInfo:nil]];
+        });
+    });
+}
+
+/**
+ * Quarantines a file that failed verification in the streaming cache and fetches its corrupt ranges again. Should the repair be interrupted the good ranges stay cached, so the next attempt carries on from them.
+ */
+- (void)repairDownloadWithURL:(NSURL *)downloadURL
+               destinationURL:(NSURL *)destinationURL
+                 verification:(IGDownloadVerification *)verification
+                  expectedMD5:(NSData *)expectedMD5
+{
+    int64_t goodLength = (verification.expectedLength > 0) ? MIN(verification.fileLength, verification.expectedLength) : verification.fileLength;
+    NSMutableIndexSet *goodRanges = [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(0, (NSUInteger)goodLength)];
+    [goodRanges removeIndexes:verification.corruptRanges];
+    
+    IGStreamingCache *streamingCache = [IGStreamingCache sharedCache];
+    NSURL *stagingURL = [IGEpisode stagingURLForFileURL:destinationURL];
+    NSError *error = nil;
+    IGStreamingCacheEntry *cacheEntry = [streamingCache adoptFileAtURL:stagingURL
+                                                                forURL:downloadURL
+                                                          cachedRanges:goodRanges
+                                                         contentLength:verification.expectedLength
+                                                                 error:&error];
+    if (!cacheEntry)
+    {
+        [[NSFileManager defaultManager] removeItemAtURL:stagingURL error:nil];
+        [[IGDownloadScheduler sharedScheduler] finishDownloadWithURL:downloadURL
+                                                             success:NO
+                                                               error:error];
+        return;
+    }
+    
+    [cacheEntry fillWithCompletion:^(BOOL success, NSError *error) {
+        NSError *moveError = nil;
+        if (success && ![streamingCache moveEntryForURL:downloadURL toURL:stagingURL error:&moveError])
+        {
+            success = NO;
+            error = moveError;
+        }
+        
+        if (!success)
+        {
+            if ([[error domain] isEqualToString:IGStreamingCacheErrorDomain] && [error code] == IGStreamingCacheErrorUnexpectedResponse)
+            {
+                [streamingCache removeEntryForURL:downloadURL];
+            }
+            
+            [[IGDownloadScheduler sharedScheduler] finishDownloadWithURL:downloadURL
+                                                                 success:NO
+                                                                   error:error];
+            return;
+        }
+        
+        [self verifyDownloadWithURL:downloadURL
+                     destinationURL:destinationURL
+                     expectedLength:verification.expectedLength
+                        expectedMD5:expectedMD5
+                             repair:NO];
+    }];
+}
+
+@end
+
+@implementation IGPodcastFeedSessionDelegate
+
+#pragma mark - NSURLSessionDataDelegate
+
+- (void)URLSession:(NSURLSession *)session dataTask:(NSURLSessionDataTask *)dataTask didReceiveResponse:(NSURLResponse *)response completionHandler:(void (^)(NSURLSessionResponseDisposition disposition))completionHandler
+{
+    IGPodcastFeedTransfer *transfer = [IGNetworkManager podcastFeedTransferForTask:dataTask];
+    NSError *error = nil;
+    if (transfer && ![IGNetworkManager validatePodcastFeedResponse:response error:&error])
+    {
+        // The task completes with the validation error instead of the cancellation.
+        transfer.error = error;
+        completionHandler(NSURLSessionResponseCancel);
+        return;
+    }
+    
+    completionHandler(NSURLSessionResponseAllow);
+}
+
+- (void)URLSession:(NSURLSession *)session dataTask:(NSURLSessionDataTask *)dataTask didReceiveData:(NSData *)data
+{
+    [[[IGNetworkManager podcastFeedTransferForTask:dataTask] feedParser] appendData:data];
+}
+
+- (void)URLSession:(NSURLSession *)session task:(NSURLSessionTask *)task didCompleteWithError:(NSError *)error
+{
+    IGPodcastFeedTransfer *transfer = [IGNetworkManager podcastFeedTransferForTask:task];
+    [IGNetworkManager setPodcastFeedTransfer:nil forTask:task];
+    
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [[AFNetworkActivityIndicatorManager sharedManager] decrementActivityCount];
+        if (transfer.completion)
+        {
+            transfer.completion(task.response, transfer.error ?: error);
+        }
+    });
 }
 
 @end
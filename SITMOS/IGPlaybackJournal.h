@@ -0,0 +1,115 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * The IGPlaybackJournal class records the playback position of episodes in an append-only, memory-mapped file.
+ *
+ * Appending a position copies one fixed-size record into the mapped file, so positions can be recorded every few seconds during playback without touching Core Data. Each record carries a checksum and a sequence number, a record torn by a crash is ignored when the journal is opened again.
+ *
+ * The positions are folded into the episodes from time to time, after which the sequence number of the last folded record is recorded in the journal. When the journal is full it is compacted down to the latest unfolded position of each episode, so the file is only rewritten once every capacity appends.
+ */
+@interface IGPlaybackJournal : NSObject
+
+/**
+ * Returns the shared playback journal, which is kept in the Application Support directory.
+ */
++ (instancetype)sharedJournal;
+
+/**
+ * Initializes a playback journal mapped from the file at the given path, the file is created if it does not exist.
+ *
+ * @param The path of the journal file.
+ * @param The number of records the journal holds before it is compacted.
+ */
+- (id)initWithPath:(NSString *)path capacity:(NSUInteger)capacity;
+
+/**
+ * The number of records the journal holds before it is compacted.
+ */
+@property (nonatomic, readonly) NSUInteger capacity;
+
+#pragma mark - Recording Positions
+
+/**
+ * @name Recording Positions
+ */
+
+/**
+ * Appends the position of an episode to the journal. Nothing is appended when the position equals the latest one recorded for the episode.
+ *
+ * @param The playback position in seconds.
+ * @param The guid of the episode.
+ *
+ * @return YES if the position is recorded, NO if the guid is too long or the journal could not be mapped.
+ */
+- (BOOL)appendPosition:(Float64)position forEpisodeWithGUID:(NSString *)guid;
+
+/**
+ * Asks the system to write the mapped records to disk.
+ */
+- (void)synchronize;
+
+#pragma mark - Reading Positions
+
+/**
+ * @name Reading Positions
+ */
+
+/**
+ * Returns the latest position recorded for an episode, nil if there is none.
+ *
+ * @param The guid of the episode.
+ */
+- (NSNumber *)positionForEpisodeWithGUID:(NSString *)guid;
+
+/**
+ * Returns the latest position of each episode in the journal, keyed by guid.
+ */
+- (NSDictionary *)latestPositions;
+
+/**
+ * Returns the latest position of each episode in the journal, keyed by guid, along with the sequence number of the last record.
+ *
+ * @param On return the sequence number of the last record, pass it to removePositionsUpToSequenceNumber: once the positions are folded.
+ */
+- (NSDictionary *)latestPositionsReturningSequenceNumber:(uint64_t *)sequenceNumber;
+
+/**
+ * Returns the number of records in the journal.
+ */
+- (NSUInteger)numberOfRecords;
+
+#pragma mark - Removing Positions
+
+/**
+ * @name Removing Positions
+ */
+
+/**
+ * Marks every record up to and including the given sequence number as folded, keeping the positions recorded after it. Nothing is rewritten, the folded records are dropped when the journal is next compacted.
+ *
+ * @param The sequence number returned by latestPositionsReturningSequenceNumber:.
+ */
+- (void)removePositionsUpToSequenceNumber:(uint64_t)sequenceNumber;
+
+@end
@@ -0,0 +1,377 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGPlaybackJournal.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static NSUInteger const IGPlaybackJournalDefaultCapacity = 1024;
+
+#define IGPlaybackJournalMaximumGUIDLength 224
+
+/**
+ * A record of the journal file. The checksum covers every field after it and is written last, a record with a zero or mismatching checksum was never completely written.
+ */
+typedef struct {
+    uint32_t checksum;
+    uint32_t guidLength;
+    uint64_t sequenceNumber;
+    Float64 position;
+    NSTimeInterval timestamp;
+    char guid[IGPlaybackJournalMaximumGUIDLength];
+} IGPlaybackJournalRecord;
+
+/**
+ * Returns the FNV-1a hash of the fields of a record after its checksum, never zero.
+ */
+static uint32_t IGPlaybackJournalRecordChecksum(const IGPlaybackJournalRecord *record)
+{
+    const uint8_t *bytes = (const uint8_t *)record + sizeof(record->checksum);
+    size_t length = sizeof(IGPlaybackJournalRecord) - sizeof(record->checksum);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    
+    return hash ?: 1;
+}
+
+@implementation IGPlaybackJournal
+{
+    NSString *_path;
+    int _fileDescriptor;
+    IGPlaybackJournalRecord *_records;
+    uint64_t *_foldedSequenceNumber;
+    NSUInteger _numberOfRecords;
+    uint64_t _lastSequenceNumber;
+    NSMutableDictionary *_latestPositions;
+    NSMutableDictionary *_latestSequenceNumbers;
+}
+
++ (instancetype)sharedJournal
+{
+    static IGPlaybackJournal *sharedJournal = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSString *directory = [NSSearchPathForDirectoriesInDomains(NSApplicationSupportDirectory, NSUserDomainMask, YES) lastObject];
+        [[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:nil];
+        sharedJournal = [[self alloc] initWithPath:[directory stringByAppendingPathComponent:@"PlaybackJournal"]
+                                          capacity:IGPlaybackJournalDefaultCapacity];
+    });
+    return sharedJournal;
+}
+
+- (id)initWithPath:(NSString *)path capacity:(NSUInteger)capacity
+{
+    NSParameterAssert(path != nil);
+    NSParameterAssert(capacity > 0);
+    
+    if (!(self = [super init])) return nil;
+    
+    _path = [path copy];
+    _capacity = capacity;
+    _fileDescriptor = -1;
+    _latestPositions = [[NSMutableDictionary alloc] init];
+    _latestSequenceNumbers = [[NSMutableDictionary alloc] init];
+    
+    [self mapJournal];
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    [self unmapJournal];
+}
+
+#pragma mark - Mapping the Journal
+
+/**
+ * The records are followed by the sequence number of the last record folded into the episodes.
+ */
+- (size_t)mappedLength
+{
+    return _capacity * sizeof(IGPlaybackJournalRecord) + sizeof(uint64_t);
+}
+
+/**
+ * Maps the journal file and reads its records. Reading stops at the first record that is torn or out of sequence, records that have been folded are not read back as positions.
+ */
+- (void)mapJournal
+{
+    size_t length = [self mappedLength];
+    
+    _fileDescriptor = open([_path fileSystemRepresentation], O_RDWR | O_CREAT, 0644);
+    if (_fileDescriptor < 0 || ftruncate(_fileDescriptor, length) != 0)
+    {
+        NSLog(@"Failed to open playback journal at %@, reason %s", _path, strerror(errno));
+        [self unmapJournal];
+        return;
+    }
+    
+    void *records = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, _fileDescriptor, 0);
+    if (records == MAP_FAILED)
+    {
+        NSLog(@"Failed to map playback journal at %@, reason %s", _path, strerror(errno));
+        [self unmapJournal];
+        return;
+    }
+    _records = records;
+    _foldedSequenceNumber = (uint64_t *)(_records + _capacity);
+    
+    // Sequence numbers carry on after the folded records even when none of them is left.
+    _lastSequenceNumber = MAX(_lastSequenceNumber, *_foldedSequenceNumber);
+    _numberOfRecords = 0;
+    [_latestPositions removeAllObjects];
+    [_latestSequenceNumbers removeAllObjects];
+    for (NSUInteger i = 0; i < _capacity; i++)
+    {
+        IGPlaybackJournalRecord *record = &_records[i];
+        if (record->checksum == 0 ||
+            record->checksum != IGPlaybackJournalRecordChecksum(record) ||
+            record->guidLength > IGPlaybackJournalMaximumGUIDLength ||
+            (i > 0 && record->sequenceNumber <= _lastSequenceNumber))
+        {
+            break;
+        }
+        
+        NSString *guid = [[NSString alloc] initWithBytes:record->guid length:record->guidLength encoding:NSUTF8StringEncoding];
+        if (!guid)
+        {
+            break;
+        }
+        
+        if (record->sequenceNumber > *_foldedSequenceNumber)
+        {
+            [_latestPositions setObject:@(record->position) forKey:guid];
+            [_latestSequenceNumbers setObject:@(record->sequenceNumber) forKey:guid];
+        }
+        _lastSequenceNumber = MAX(_lastSequenceNumber, record->sequenceNumber);
+        _numberOfRecords++;
+    }
+    
+    // Clear whatever follows the last good record so a torn record is not read back after later appends
+    if (_numberOfRecords < _capacity && _records[_numberOfRecords].checksum != 0)
+    {
+        memset(&_records[_numberOfRecords], 0, (_capacity - _numberOfRecords) * sizeof(IGPlaybackJournalRecord));
+    }
+}
+
+- (void)unmapJournal
+{
+    if (_records)
+    {
+        munmap(_records, [self mappedLength]);
+        _records = NULL;
+        _foldedSequenceNumber = NULL;
+    }
+    
+    if (_fileDescriptor >= 0)
+    {
+        close(_fileDescriptor);
+        _fileDescriptor = -1;
+    }
+}
+
+/**
+ * Replaces the journal file with the given records. The new file is written aside and moved into place so a crash leaves either the old or the new journal.
+ */
+- (void)rewriteJournalWithRecords:(NSData *)records
+{
+    uint64_t foldedSequenceNumber = _foldedSequenceNumber ? *_foldedSequenceNumber : 0;
+    NSMutableData *data = [NSMutableData dataWithData:records];
+    [data setLength:_capacity * sizeof(IGPlaybackJournalRecord)];
+    [data appendBytes:&foldedSequenceNumber length:sizeof(foldedSequenceNumber)];
+    
+    [self unmapJournal];
+    
+    NSError *error = nil;
+    if (![data writeToFile:_path options:NSDataWritingAtomic error:&error])
+    {
+        NSLog(@"Failed to rewrite playback journal at %@, reason %@", _path, [error localizedDescription]);
+    }
+    
+    [self mapJournal];
+}
+
+/**
+ * Returns the latest record of each episode with a sequence number greater than the given one, in the order they were appended.
+ */
+- (NSData *)latestRecordsAfterSequenceNumber:(uint64_t)sequenceNumber
+{
+    NSMutableData *records = [NSMutableData data];
+    NSMutableSet *guids = [NSMutableSet set];
+    for (NSUInteger i = _numberOfRecords; i > 0; i--)
+    {
+        IGPlaybackJournalRecord *record = &_records[i - 1];
+        if (record->sequenceNumber <= sequenceNumber)
+        {
+            break;
+        }
+        
+        NSData *guid = [NSData dataWithBytes:record->guid length:record->guidLength];
+        if ([guids containsObject:guid])
+        {
+            continue;
+        }
+        [guids addObject:guid];
+        
+        [records replaceBytesInRange:NSMakeRange(0, 0) withBytes:record length:sizeof(IGPlaybackJournalRecord)];
+    }
+    
+    return records;
+}
+
+#pragma mark - Recording Positions
+
+- (BOOL)appendPosition:(Float64)position forEpisodeWithGUID:(NSString *)guid
+{
+    NSData *guidData = [guid dataUsingEncoding:NSUTF8StringEncoding];
+    if (!guidData || [guidData length] > IGPlaybackJournalMaximumGUIDLength)
+    {
+        return NO;
+    }
+    
+    @synchronized(self)
+    {
+        if (!_records)
+        {
+            return NO;
+        }
+        
+        if ([[_latestPositions objectForKey:guid] isEqualToNumber:@(position)])
+        {
+            return YES;
+        }
+        
+        if (_numberOfRecords == _capacity)
+        {
+            // Folded records are in the store already, only the latest unfolded record of each episode is kept.
+            [self rewriteJournalWithRecords:[self latestRecordsAfterSequenceNumber:*_foldedSequenceNumber]];
+            if (!_records || _numberOfRecords == _capacity)
+            {
+                return NO;
+            }
+        }
+        
+        IGPlaybackJournalRecord record;
+        memset(&record, 0, sizeof(record));
+        record.guidLength = (uint32_t)[guidData length];
+        record.sequenceNumber = _lastSequenceNumber + 1;
+        record.position = position;
+        record.timestamp = [NSDate timeIntervalSinceReferenceDate];
+        memcpy(record.guid, [guidData bytes], [guidData length]);
+        
+        // The checksum goes in after the rest of the record so a record is never seen complete before it is
+        IGPlaybackJournalRecord *slot = &_records[_numberOfRecords];
+        memcpy((uint8_t *)slot + sizeof(slot->checksum), (uint8_t *)&record + sizeof(record.checksum), sizeof(record) - sizeof(record.checksum));
+        __sync_synchronize();
+        slot->checksum = IGPlaybackJournalRecordChecksum(&record);
+        
+        _numberOfRecords++;
+        _lastSequenceNumber = record.sequenceNumber;
+        [_latestPositions setObject:@(position) forKey:guid];
+        [_latestSequenceNumbers setObject:@(record.sequenceNumber) forKey:guid];
+    }
+    
+    return YES;
+}
+
+- (void)synchronize
+{
+    @synchronized(self)
+    {
+        if (_records)
+        {
+            msync(_records, [self mappedLength], MS_ASYNC);
+        }
+    }
+}
+
+#pragma mark - Reading Positions
+
+- (NSNumber *)positionForEpisodeWithGUID:(NSString *)guid
+{
+    if (!guid)
+    {
+        return nil;
+    }
+    
+    @synchronized(self)
+    {
+        return [_latestPositions objectForKey:guid];
+    }
+}
+
+- (NSDictionary *)latestPositions
+{
+    return [self latestPositionsReturningSequenceNumber:NULL];
+}
+
+- (NSDictionary *)latestPositionsReturningSequenceNumber:(uint64_t *)sequenceNumber
+{
+    @synchronized(self)
+    {
+        if (sequenceNumber)
+        {
+            *sequenceNumber = _lastSequenceNumber;
+        }
+        
+        return [_latestPositions copy];
+    }
+}
+
+- (NSUInteger)numberOfRecords
+{
+    @synchronized(self)
+    {
+        return _numberOfRecords;
+    }
+}
+
+#pragma mark - Removing Positions
+
+- (void)removePositionsUpToSequenceNumber:(uint64_t)sequenceNumber
+{
+    @synchronized(self)
+    {
+        if (!_records || sequenceNumber <= *_foldedSequenceNumber)
+        {
+            return;
+        }
+        
+        // Only the mark moves, the records themselves are dropped the next time the journal is compacted.
+        *_foldedSequenceNumber = MIN(sequenceNumber, _lastSequenceNumber);
+        for (NSString *guid in [_latestSequenceNumbers allKeys])
+        {
+            if ([[_latestSequenceNumbers objectForKey:guid] unsignedLongLongValue] <= *_foldedSequenceNumber)
+            {
+                [_latestSequenceNumbers removeObjectForKey:guid];
+                [_latestPositions removeObjectForKey:guid];
+            }
+        }
+    }
+}
+
+@end
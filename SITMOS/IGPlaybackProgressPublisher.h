@@ -0,0 +1,82 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+typedef void (^IGPlaybackProgressTextBlock)(NSString *text);
+typedef void (^IGPlaybackProgressTimeBlock)(Float64 time);
+
+/**
+ * The IGPlaybackProgressPublisher class turns the playback time reported by the media player into updates for the playback progress UI, delivering each value only when it has changed.
+ *
+ * The elapsed and remaining time texts are only formatted and delivered when the whole second they show changes, so a publisher fed many times a second for a smooth slider does not touch its labels more than once a second.
+ */
+@interface IGPlaybackProgressPublisher : NSObject
+
+/**
+ * The block to execute with the elapsed time text, such as " 0:01:05", when it changes.
+ */
+@property (nonatomic, copy) IGPlaybackProgressTextBlock elapsedTimeTextBlock;
+
+/**
+ * The block to execute with the remaining time text, such as "-0:42:10", when it changes.
+ */
+@property (nonatomic, copy) IGPlaybackProgressTextBlock remainingTimeTextBlock;
+
+/**
+ * The block to execute with the duration when it changes.
+ */
+@property (nonatomic, copy) IGPlaybackProgressTimeBlock durationBlock;
+
+/**
+ * The block to execute with the current time when it changes.
+ */
+@property (nonatomic, copy) IGPlaybackProgressTimeBlock currentTimeBlock;
+
+/**
+ * Delivers the values that differ from the ones last delivered. Nothing is delivered while the duration is not known.
+ *
+ * @param The current playback time.
+ * @param The duration of the media.
+ */
+- (void)publishCurrentTime:(Float64)currentTime duration:(Float64)duration;
+
+/**
+ * Forgets the values last delivered, so the next publish delivers every value.
+ */
+- (void)reset;
+
+/**
+ * Returns the elapsed time text for a playback time.
+ *
+ * @param The current playback time.
+ */
++ (NSString *)elapsedTimeTextForTime:(Float64)currentTime;
+
+/**
+ * Returns the remaining time text for a playback time.
+ *
+ * @param The current playback time.
+ * @param The duration of the media.
+ */
++ (NSString *)remainingTimeTextForTime:(Float64)currentTime duration:(Float64)duration;
+
+@end
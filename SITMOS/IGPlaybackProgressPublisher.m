@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGPlaybackProgressPublisher.h"
+
+@implementation IGPlaybackProgressPublisher
+{
+    BOOL _hasPublished;
+    NSInteger _elapsedSeconds;
+    NSInteger _remainingSeconds;
+    Float64 _duration;
+    Float64 _currentTime;
+}
+
+- (void)publishCurrentTime:(Float64)currentTime duration:(Float64)duration
+{
+    if (isnan(duration) || isnan(currentTime))
+    {
+        return;
+    }
+    
+    NSInteger elapsedSeconds = (NSInteger)currentTime;
+    NSInteger remainingSeconds = (NSInteger)duration - (NSInteger)currentTime;
+    
+    if ((!_hasPublished || duration != _duration) && _durationBlock)
+    {
+        _durationBlock(duration);
+    }
+    
+    if ((!_hasPublished || currentTime != _currentTime) && _currentTimeBlock)
+    {
+        _currentTimeBlock(currentTime);
+    }
+    
+    if ((!_hasPublished || elapsedSeconds != _elapsedSeconds) && _elapsedTimeTextBlock)
+    {
+        _elapsedTimeTextBlock([[self class] elapsedTimeTextForTime:currentTime]);
+    }
+    
+    if ((!_hasPublished || remainingSeconds != _remainingSeconds) && _remainingTimeTextBlock)
+    {
+        _remainingTimeTextBlock([[self class] remainingTimeTextForTime:currentTime duration:duration]);
+    }
+    
+    _hasPublished = YES;
+    _duration = duration;
+    _currentTime = currentTime;
+    _elapsedSeconds = elapsedSeconds;
+    _remainingSeconds = remainingSeconds;
+}
+
+- (void)reset
+{
+    _hasPublished = NO;
+}
+
++ (NSString *)elapsedTimeTextForTime:(Float64)currentTime
+{
+    NSInteger secondsPlayed = (NSInteger)currentTime % 60;
+    NSInteger minutesPlayed = (NSInteger)currentTime / 60 % 60;
+    NSInteger hoursPlayed = ((NSInteger)currentTime / 60) / 60;
+    
+    return [NSString stringWithFormat:@"%2ld:%02ld:%02ld", (long)hoursPlayed, (long)minutesPlayed, (long)secondsPlayed];
+}
+
++ (NSString *)remainingTimeTextForTime:(Float64)currentTime duration:(Float64)duration
+{
+    NSInteger secondsLeft = ((NSInteger)duration - (NSInteger)currentTime) % 60;
+    NSInteger minutesLeft = ((NSInteger)duration - (NSInteger)currentTime) / 60 % 60;
+    NSInteger hoursLeft = (((NSInteger)duration - (NSInteger)currentTime) / 60) / 60;
+    
+    return [NSString stringWithFormat:@"-%1ld:%02ld:%02ld", (long)hoursLeft, (long)minutesLeft, (long)secondsLeft];
+}
+
+@end
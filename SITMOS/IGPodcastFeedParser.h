@@ -19,11 +19,68 @@
  * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#import "IGFeedItem.h"
+
 #import <Foundation/Foundation.h>
 
 @interface IGPodcastFeedParser : NSObject
 
+/**
+ * The block to execute each time an item has been parsed. Invoked on the queue the parser is running on.
+ */
+@property (nonatomic, copy) void (^feedItemHandler)(IGFeedItem *feedItem);
+
+/**
+ * The publication date of the newest item already known. The feed is ordered newest first, so parsing stops at the first item that is not newer than this date and the items before it are returned. Set to nil to parse the whole feed.
+ */
+@property (nonatomic, strong) NSDate *newestKnownPubDate;
+
+/**
+ * Returns YES if parsing stopped early because an already known item was reached.
+ */
+@property (nonatomic, readonly, getter = isStoppedAtKnownItem) BOOL stoppedAtKnownItem;
+
+/**
+ * Creates a parser for the given XML parser and parses it synchronously.
+ *
+ * The completion handler is given an array of IGFeedItem objects in feed order.
+ */
 + (IGPodcastFeedParser *)PodcastFeedParserWithXMLParser:(NSXMLParser *)XMLParser
                                              completion:(void (^) (NSArray *feedItems, NSError *error))completion;
 
+#pragma mark - Push Parsing
+
+/**
+ * @name Push Parsing
+ */
+
+/**
+ * Creates a parser that is fed incrementally with appendData: and finished with finish or abortWithError:. Parsing starts with the first push and runs on a background queue while data is still arriving, each item is handed to feedItemHandler as soon as it has been parsed.
+ *
+ * @param feedItemHandler The block to execute each time an item has been parsed.
+ * @param completion The completion handler block to execute, called exactly once on the parsing queue.
+ */
++ (IGPodcastFeedParser *)PodcastFeedParserWithFeedItemHandler:(void (^) (IGFeedItem *feedItem))feedItemHandler
+                                                   completion:(void (^) (NSArray *feedItems, NSError *error))completion;
+
+/**
+ * Pushes the next chunk of the feed to the parser. Blocks while the parser is behind, so the data source is throttled to the parse rate.
+ */
+- (void)appendData:(NSData *)data;
+
+/**
+ * Signals that all of the feed has been appended.
+ */
+- (void)finish;
+
+/**
+ * Stops parsing, the completion handler is executed with the given error.
+ */
+- (void)abortWithError:(NSError *)error;
+
+/**
+ * Stops the parser because there is nothing to parse, for example when the feed has not been modified. The completion handler is executed with nil feed items and no error.
+ */
+- (void)cancel;
+
 @end
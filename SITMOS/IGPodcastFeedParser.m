@@ -21,22 +21,58 @@
 
 #import "IGPodcastFeedParser.h"
 
-#import "IGDefines.h"
-#import "NSDate+Helper.h"
+#import "NSDate+IGDateParsing.h"
+
+/* The size of the buffer between the pushed data and the XML parser */
+static CFIndex const IGPodcastFeedParserStreamBufferSize = 64 * 1024;
+
+/* The elements the parser acts on, everything else is skipped */
+typedef NS_ENUM(NSInteger, IGFeedElement) {
+    IGFeedElementUnknown = 0,
+    IGFeedElementRSS,
+    IGFeedElementItem,
+    IGFeedElementGUID,
+    IGFeedElementTitle,
+    IGFeedElementPubDate,
+    IGFeedElementSummary,
+    IGFeedElementDuration,
+    IGFeedElementImage,
+    IGFeedElementEnclosure
+};
 
 @interface IGPodcastFeedParser () <NSXMLParserDelegate>
 
 @property (nonatomic, strong) NSXMLParser *XMLParser;
-@property (nonatomic, strong) NSNumberFormatter *numberFormatter;
+@property (nonatomic, strong) NSInputStream *inputStream;
+@property (nonatomic, strong) NSOutputStream *outputStream;
+@property (atomic, strong) NSError *abortError;
+@property (atomic, assign) BOOL cancelled;
+@property (nonatomic, assign) BOOL started;
+@property (nonatomic, assign) BOOL finished;
+@property (nonatomic, readwrite, getter = isStoppedAtKnownItem) BOOL stoppedAtKnownItem;
 @property (nonatomic, strong) NSMutableArray *feedItems;
-@property (nonatomic, strong) NSMutableDictionary *currentFeedItem;
-@property (nonatomic, strong) NSMutableString *tmpString;
-@property (nonatomic, strong) NSDateFormatter *dateFormatter;
 @property (nonatomic, copy) void (^completion)(NSArray *feedItems, NSError *error);
 
 @end
 
 @implementation IGPodcastFeedParser
+{
+    // The values of the item being parsed, turned into an IGFeedItem at </item>.
+    BOOL _inItem;
+    NSString *_guid;
+    NSString *_title;
+    NSString *_summary;
+    NSDate *_pubDate;
+    int64_t _fileSize;
+    NSInteger _duration;
+    NSString *_downloadURL;
+    NSString *_mediaType;
+    NSString *_imageURL;
+    
+    // One buffer is reused for the text of every element, characters are only collected inside an element that is kept.
+    NSMutableString *_characters;
+    BOOL _collectingCharacters;
+}
 
 + (IGPodcastFeedParser *)PodcastFeedParserWithXMLParser:(NSXMLParser *)XMLParser
                                              completion:(void (^) (NSArray *feedItems, NSError *error))completion {
@@ -47,6 +83,58 @@
     return feedParser;
 }
 
++ (IGPodcastFeedParser *)PodcastFeedParserWithFeedItemHandler:(void (^) (IGFeedItem *feedItem))feedItemHandler
+                                                   completion:(void (^) (NSArray *feedItems, NSError *error))completion {
+    CFReadStreamRef readStream = NULL;
+    CFWriteStreamRef writeStream = NULL;
+    CFStreamCreateBoundPair(kCFAllocatorDefault, &readStream, &writeStream, IGPodcastFeedParserStreamBufferSize);
+    
+    NSInputStream *inputStream = CFBridgingRelease(readStream);
+    NSOutputStream *outputStream = CFBridgingRelease(writeStream);
+    
+    IGPodcastFeedParser *feedParser = [[IGPodcastFeedParser alloc] initWithXMLParser:[[NSXMLParser alloc] initWithStream:inputStream]
+                                                                          completion:completion];
+    feedParser.feedItemHandler = feedItemHandler;
+    feedParser.inputStream = inputStream;
+    feedParser.outputStream = outputStream;
+    [outputStream open];
+    
+    return feedParser;
+}
+
++ (NSDictionary *)elementMap {
+    static NSDictionary *elementMap = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        elementMap = @{ @"rss": @(IGFeedElementRSS),
+                        @"item": @(IGFeedElementItem),
+                        @"guid": @(IGFeedElementGUID),
+                        @"title": @(IGFeedElementTitle),
+                        @"pubDate": @(IGFeedElementPubDate),
+                        @"itunes:summary": @(IGFeedElementSummary),
+                        @"itunes:duration": @(IGFeedElementDuration),
+                        @"itunes:image": @(IGFeedElementImage),
+                        @"enclosure": @(IGFeedElementEnclosure) };
+    });
+    return elementMap;
+}
+
+/**
+ * Maps an element name to the element it is with a single hash lookup rather than comparing it against each name in turn.
+ */
+static inline IGFeedElement IGFeedElementForName(NSString *elementName) {
+    return [[[IGPodcastFeedParser elementMap] objectForKey:elementName] integerValue];
+}
+
++ (dispatch_queue_t)parsingQueue {
+    static dispatch_queue_t parsingQueue = NULL;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        parsingQueue = dispatch_queue_create("com.idlegeniussoftware.sitmos.podcast-feed-parser", DISPATCH_QUEUE_SERIAL);
+    });
+    return parsingQueue;
+}
+
 - (id)initWithXMLParser:(NSXMLParser *)XMLParser
              completion:(void (^) (NSArray *feedItems, NSError *error))completion {
     if (!(self = [super init])) {
@@ -55,85 +143,215 @@
     
     _XMLParser = XMLParser;
     [_XMLParser setDelegate:self];
-    _numberFormatter = [[NSNumberFormatter alloc] init];
+    _characters = [[NSMutableString alloc] init];
     _feedItems = [[NSMutableArray alloc] init];
     _completion = completion;
-    _dateFormatter = [[NSDateFormatter alloc] init];
-    [_dateFormatter setLocale:[[NSLocale alloc] initWithLocaleIdentifier:@"en_US_POSIX"]];
-    [_dateFormatter setDateFormat:IGDateFormatString];
     
     return self;
 }
 
 - (void)start {
     BOOL parseSuccess = [_XMLParser parse];
-    if (!parseSuccess) {
-        if (_completion) {
-            _completion(nil, [_XMLParser parserError]);
+    
+    // Closing the read end unblocks a writer that is still pushing data after parsing has stopped.
+    [_inputStream close];
+    
+    if (self.cancelled) {
+        [self finishWithFeedItems:nil error:nil];
+    } else if (!parseSuccess && !_stoppedAtKnownItem) {
+        [self finishWithFeedItems:nil error:self.abortError ?: [_XMLParser parserError]];
+    } else {
+        // A feed without a closing rss element still completes.
+        [self finishWithFeedItems:_feedItems error:nil];
+    }
+}
+
+- (void)finishWithFeedItems:(NSArray *)feedItems error:(NSError *)error {
+    if (_finished) {
+        return;
+    }
+    _finished = YES;
+    
+    if (_completion) {
+        _completion(feedItems, error);
+    }
+}
+
+#pragma mark - Push Parsing
+
+/**
+ * Parsing is started by the first push so properties such as newestKnownPubDate can be set after creating the parser.
+ */
+- (void)startParsingIfNeeded {
+    @synchronized(self) {
+        if (_started) {
+            return;
+        }
+        _started = YES;
+    }
+    
+    dispatch_async([IGPodcastFeedParser parsingQueue], ^{
+        [self start];
+    });
+}
+
+- (void)appendData:(NSData *)data {
+    [self startParsingIfNeeded];
+    
+    const uint8_t *bytes = [data bytes];
+    NSUInteger remaining = [data length];
+    while (remaining > 0) {
+        // Writing to the bound stream blocks until the parser has consumed enough of the buffer.
+        NSInteger written = [_outputStream write:bytes maxLength:remaining];
+        if (written <= 0) {
+            return;
         }
+        bytes += written;
+        remaining -= written;
     }
 }
 
+- (void)finish {
+    [self startParsingIfNeeded];
+    [_outputStream close];
+}
+
+- (void)cancel {
+    self.cancelled = YES;
+    @synchronized(self) {
+        if (!_started) {
+            // Nothing has been pushed, there is no need to spin up the XML parser.
+            _started = YES;
+            dispatch_async([IGPodcastFeedParser parsingQueue], ^{
+                [self finishWithFeedItems:nil error:nil];
+            });
+            return;
+        }
+    }
+    [_outputStream close];
+}
+
+- (void)abortWithError:(NSError *)error {
+    self.abortError = error;
+    [self startParsingIfNeeded];
+    [_outputStream close];
+}
+
 #pragma mark - NSXMLParserDelegate
 
 - (void)parser:(NSXMLParser *)parser didStartElement:(NSString *)elementName namespaceURI:(NSString *)namespaceURI qualifiedName:(NSString *)qualifiedName attributes:(NSDictionary *)attributeDict {
-    _tmpString = [[NSMutableString alloc] init];
+    IGFeedElement element = IGFeedElementForName(elementName);
     
-    if ([elementName isEqualToString:@"item"]) {
-        _currentFeedItem = [[NSMutableDictionary alloc] init];
+    if (element == IGFeedElementItem) {
+        [self resetCurrentItem];
+        _inItem = YES;
+        return;
     }
     
-    if ([elementName isEqualToString:@"itunes:image"]) {
-        [_currentFeedItem setObject:[attributeDict valueForKey:@"href"] forKey:@"imageURL"];
+    if (!_inItem) {
+        // The channel's own title, summary and image are not needed.
+        return;
     }
     
-    if ([elementName isEqualToString:@"enclosure"]) {
-        [_currentFeedItem setObject:[attributeDict valueForKey:@"url"] forKey:@"downloadURL"];
-        
-        NSNumber *fileSize = [_numberFormatter numberFromString:[attributeDict valueForKey:@"length"]];
-        [_currentFeedItem setObject:fileSize forKey:@"fileSize"];
-         
-        [_currentFeedItem setObject:[attributeDict valueForKey:@"type"] forKey:@"mediaType"];
+    switch (element) {
+        case IGFeedElementGUID:
+        case IGFeedElementTitle:
+        case IGFeedElementPubDate:
+        case IGFeedElementSummary:
+        case IGFeedElementDuration:
+            [_characters setString:@""];
+            _collectingCharacters = YES;
+            break;
+        case IGFeedElementImage:
+            _imageURL = [attributeDict objectForKey:@"href"];
+            break;
+        case IGFeedElementEnclosure:
+            _downloadURL = [attributeDict objectForKey:@"url"];
+            _fileSize = [[attributeDict objectForKey:@"length"] longLongValue];
+            _mediaType = [attributeDict objectForKey:@"type"];
+            break;
+        default:
+            break;
     }
 }
 
 - (void)parser:(NSXMLParser *)parser didEndElement:(NSString *)elementName namespaceURI:(NSString *)namespaceURI qualifiedName:(NSString *)qName {
-    if ([elementName isEqualToString:@"item"]) {
-        [_feedItems addObject:_currentFeedItem];
-        _currentFeedItem = nil;
-    }
+    IGFeedElement element = IGFeedElementForName(elementName);
     
-    if (_currentFeedItem && _tmpString) {
-        if ([elementName isEqualToString:@"title"]) {
-            [_currentFeedItem setObject:_tmpString forKey:@"title"];
-        }
+    if (_collectingCharacters) {
+        _collectingCharacters = NO;
         
-        if ([elementName isEqualToString:@"pubDate"]) {
-            // Since iOS 7 the default locale can not be trusted to understand the feed's date strings.
-            NSDate *pubDate = [_dateFormatter dateFromString:_tmpString];
-            [_currentFeedItem setObject:[NSDate stringFromDate:pubDate withFormat:IGDateFormatString] forKey:@"pubDate"];
+        switch (element) {
+            case IGFeedElementGUID:
+                _guid = [_characters stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]];
+                break;
+            case IGFeedElementTitle:
+                _title = [_characters copy];
+                break;
+            case IGFeedElementPubDate:
+                _pubDate = [NSDate dateFromRFC822String:_characters];
+                break;
+            case IGFeedElementSummary:
+                _summary = [_characters copy];
+                break;
+            case IGFeedElementDuration:
+                _duration = [IGFeedItem durationFromString:_characters];
+                break;
+            default:
+                break;
         }
+        return;
+    }
+    
+    if (element == IGFeedElementItem) {
+        _inItem = NO;
         
-        if ([elementName isEqualToString:@"itunes:summary"]) {
-            [_currentFeedItem setObject:_tmpString forKey:@"summary"];
+        if (_newestKnownPubDate && _pubDate && [_pubDate compare:_newestKnownPubDate] != NSOrderedDescending) {
+            // The feed is ordered newest first, every item from here on is already known.
+            _stoppedAtKnownItem = YES;
+            [parser abortParsing];
+            [self finishWithFeedItems:_feedItems error:nil];
+            return;
         }
         
-        if ([elementName isEqualToString:@"itunes:duration"]) {
-            [_currentFeedItem setObject:_tmpString forKey:@"duration"];
-        }
-    
-        _tmpString = nil;
-    }
-    
-    if ([elementName isEqualToString:@"rss"]) {
-        if (_completion) {
-            _completion(_feedItems, nil);
+        IGFeedItem *feedItem = [[IGFeedItem alloc] initWithGUID:_guid
+                                                          title:_title
+                                                        summary:_summary
+                                                        pubDate:_pubDate
+                                                       fileSize:_fileSize
+                                                       duration:_duration
+                                                    downloadURL:_downloadURL
+                                                      mediaType:_mediaType
+                                                       imageURL:_imageURL];
+        [self resetCurrentItem];
+        
+        [_feedItems addObject:feedItem];
+        if (_feedItemHandler) {
+            _feedItemHandler(feedItem);
         }
+    } else if (element == IGFeedElementRSS) {
+        [self finishWithFeedItems:_feedItems error:nil];
     }
 }
 
 - (void)parser:(NSXMLParser *)parser foundCharacters:(NSString *)string {
-    [_tmpString appendString:string];
+    if (_collectingCharacters) {
+        [_characters appendString:string];
+    }
+}
+
+#pragma mark - Current Item
+
+- (void)resetCurrentItem {
+    _guid = nil;
+    _title = nil;
+    _summary = nil;
+    _pubDate = nil;
+    _fileSize = 0;
+    _duration = 0;
+    _downloadURL = nil;
+    _mediaType = nil;
+    _imageURL = nil;
 }
 
 @end
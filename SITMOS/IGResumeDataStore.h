@@ -0,0 +1,108 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * The IGResumeDataStore class keeps the resume data of interrupted downloads so they can carry on from where they stopped.
+ *
+ * Alongside each resume data blob the number of bytes received and the ETag and Last-Modified validators of the file are recorded. Blobs older than maximumAge are expired, and before a blob is used the server is asked for the current validators of the file, a blob for a file that has changed since is dropped.
+ */
+@interface IGResumeDataStore : NSObject
+
+/**
+ * Returns the shared resume data store, which keeps its blobs in the Incomplete directory of the temporary directory.
+ */
++ (instancetype)sharedStore;
+
+/**
+ * Initializes a resume data store that keeps its blobs in the given directory.
+ *
+ * @param The path of the directory to keep the blobs in.
+ */
+- (id)initWithDirectory:(NSString *)directory;
+
+/**
+ * The age after which resume data is expired. Defaults to 7 days.
+ */
+@property (nonatomic, assign) NSTimeInterval maximumAge;
+
+#pragma mark - Saving and Removing Resume Data
+
+/**
+ * @name Saving and Removing Resume Data
+ */
+
+/**
+ * Saves the resume data of an interrupted download, replacing any saved before.
+ *
+ * @param The resume data from the error of the interrupted download task.
+ * @param The URL of the download.
+ * @param The response of the interrupted download task, its validators are recorded.
+ */
+- (void)saveResumeData:(NSData *)resumeData forDownloadURL:(NSURL *)downloadURL response:(NSURLResponse *)response;
+
+/**
+ * Removes the resume data of a download.
+ *
+ * @param The URL of the download.
+ */
+- (void)removeResumeDataForDownloadURL:(NSURL *)downloadURL;
+
+/**
+ * Removes every blob that has expired or can no longer be used.
+ */
+- (void)removeExpiredResumeData;
+
+#pragma mark - Using Resume Data
+
+/**
+ * @name Using Resume Data
+ */
+
+/**
+ * Returns the URLs of the downloads that have resume data.
+ */
+- (NSArray *)downloadURLs;
+
+/**
+ * Returns the number of bytes the download had received when it was interrupted, 0 if there is no resume data.
+ *
+ * @param The URL of the download.
+ */
+- (int64_t)bytesReceivedForDownloadURL:(NSURL *)downloadURL;
+
+/**
+ * Returns the resume data of a download, nil if there is none or it has expired.
+ *
+ * @param The URL of the download.
+ */
+- (NSData *)resumeDataForDownloadURL:(NSURL *)downloadURL;
+
+/**
+ * Checks the recorded validators against the ones the server currently sends for the file, and executes the completion block on the main queue with the resume data when it is still valid. When the file has changed the resume data is removed and the completion block is executed with nil. When the server can not be reached the resume data is handed over unchecked.
+ *
+ * @param The URL of the download.
+ * @param The completion handler block to execute.
+ */
+- (void)validateResumeDataForDownloadURL:(NSURL *)downloadURL completion:(void (^)(NSData *resumeData))completion;
+
+@end
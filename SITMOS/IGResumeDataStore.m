@@ -0,0 +1,349 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGResumeDataStore.h"
+
+#import "NSString+MD5.h"
+
+static NSString * const IGResumeDataIndexFileName = @"ResumeData.plist";
+
+static NSString * const IGResumeDataURLKey = @"URL";
+static NSString * const IGResumeDataSavedDateKey = @"SavedDate";
+static NSString * const IGResumeDataBytesReceivedKey = @"BytesReceived";
+static NSString * const IGResumeDataETagKey = @"ETag";
+static NSString * const IGResumeDataLastModifiedKey = @"LastModified";
+
+/* Keys of the property list inside NSURLSessionDownloadTaskResumeData, they are not documented so each one is optional */
+static NSString * const IGURLSessionDownloadURLKey = @"NSURLSessionDownloadURL";
+static NSString * const IGURLSessionResumeBytesReceivedKey = @"NSURLSessionResumeBytesReceived";
+static NSString * const IGURLSessionResumeEntityTagKey = @"NSURLSessionResumeEntityTag";
+static NSString * const IGURLSessionResumeInfoLocalPathKey = @"NSURLSessionResumeInfoLocalPath";
+
+static NSTimeInterval const IGResumeDataDefaultMaximumAge = 7 * 24 * 60 * 60;
+
+/**
+ * Returns the property list inside the resume data, nil if it can not be read.
+ */
+static NSDictionary *IGResumeInfoFromResumeData(NSData *resumeData)
+{
+    if (!resumeData)
+    {
+        return nil;
+    }
+    
+    id resumeInfo = [NSPropertyListSerialization propertyListWithData:resumeData options:NSPropertyListImmutable format:NULL error:nil];
+    return [resumeInfo isKindOfClass:[NSDictionary class]] ? resumeInfo : nil;
+}
+
+@implementation IGResumeDataStore
+{
+    NSString *_directory;
+    NSMutableDictionary *_index;
+}
+
++ (instancetype)sharedStore
+{
+    static IGResumeDataStore *sharedStore = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedStore = [[self alloc] initWithDirectory:[NSTemporaryDirectory() stringByAppendingPathComponent:@"Incomplete"]];
+    });
+    return sharedStore;
+}
+
+- (id)initWithDirectory:(NSString *)directory
+{
+    if (!(self = [super init])) return nil;
+    
+    _directory = [directory copy];
+    
+    NSError *error = nil;
+    if (![[NSFileManager defaultManager] createDirectoryAtPath:_directory withIntermediateDirectories:YES attributes:nil error:&error])
+    {
+        NSLog(@"Failed to create resume data dir at %@, reason %@", _directory, [error localizedDescription]);
+    }
+    
+    _index = [[NSDictionary dictionaryWithContentsOfFile:[self indexPath]] mutableCopy] ?: [[NSMutableDictionary alloc] init];
+    _maximumAge = IGResumeDataDefaultMaximumAge;
+    
+    return self;
+}
+
+#pragma mark - Saving and Removing Resume Data
+
+- (void)saveResumeData:(NSData *)resumeData forDownloadURL:(NSURL *)downloadURL response:(NSURLResponse *)response
+{
+    if (!resumeData || !downloadURL)
+    {
+        return;
+    }
+    
+    NSDictionary *resumeInfo = IGResumeInfoFromResumeData(resumeData);
+    NSDictionary *headers = [response isKindOfClass:[NSHTTPURLResponse class]] ? [(NSHTTPURLResponse *)response allHeaderFields] : nil;
+    
+    NSMutableDictionary *entry = [NSMutableDictionary dictionaryWithCapacity:5];
+    [entry setObject:[downloadURL absoluteString] forKey:IGResumeDataURLKey];
+    [entry setObject:[NSDate date] forKey:IGResumeDataSavedDateKey];
+    [entry setObject:@([[resumeInfo objectForKey:IGURLSessionResumeBytesReceivedKey] longLongValue]) forKey:IGResumeDataBytesReceivedKey];
+    NSString *ETag = [headers valueForKey:@"ETag"] ?: [resumeInfo objectForKey:IGURLSessionResumeEntityTagKey];
+    if (ETag)
+    {
+        [entry setObject:ETag forKey:IGResumeDataETagKey];
+    }
+    NSString *lastModified = [headers valueForKey:@"Last-Modified"];
+    if (lastModified)
+    {
+        [entry setObject:lastModified forKey:IGResumeDataLastModifiedKey];
+    }
+    
+    NSString *fileName = [self fileNameForDownloadURL:downloadURL];
+    @synchronized(self)
+    {
+        [resumeData writeToFile:[_directory stringByAppendingPathComponent:fileName] atomically:YES];
+        [_index setObject:entry forKey:fileName];
+        [self saveIndex];
+    }
+}
+
+- (void)removeResumeDataForDownloadURL:(NSURL *)downloadURL
+{
+    if (!downloadURL)
+    {
+        return;
+    }
+    
+    @synchronized(self)
+    {
+        [self removeResumeDataWithFileName:[self fileNameForDownloadURL:downloadURL]];
+        [self saveIndex];
+    }
+}
+
+- (void)removeExpiredResumeData
+{
+    @synchronized(self)
+    {
+        NSArray *fileNames = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:_directory error:nil];
+        NSMutableSet *blobFileNames = [NSMutableSet setWithCapacity:[fileNames count]];
+        for (NSString *fileName in fileNames)
+        {
+            if ([fileName isEqualToString:IGResumeDataIndexFileName])
+            {
+                continue;
+            }
+            
+            // Blobs saved before the index existed are adopted, so they can be resumed as well.
+            NSDictionary *entry = [self entryForFileName:fileName];
+            if ([self isEntryUsable:entry fileName:fileName])
+            {
+                [_index setObject:entry forKey:fileName];
+                [blobFileNames addObject:fileName];
+            }
+            else
+            {
+                [self removeResumeDataWithFileName:fileName];
+            }
+        }
+        
+        for (NSString *fileName in [_index allKeys])
+        {
+            if (![blobFileNames containsObject:fileName])
+            {
+                [_index removeObjectForKey:fileName];
+            }
+        }
+        
+        [self saveIndex];
+    }
+}
+
+#pragma mark - Using Resume Data
+
+- (NSArray *)downloadURLs
+{
+    @synchronized(self)
+    {
+        NSMutableArray *downloadURLs = [NSMutableArray arrayWithCapacity:[_index count]];
+        [_index enumerateKeysAndObjectsUsingBlock:^(NSString *fileName, NSDictionary *entry, BOOL *stop) {
+            NSURL *downloadURL = [NSURL URLWithString:[entry objectForKey:IGResumeDataURLKey]];
+            if (downloadURL && [self isEntryUsable:entry fileName:fileName])
+            {
+                [downloadURLs addObject:downloadURL];
+            }
+        }];
+        return downloadURLs;
+    }
+}
+
+- (int64_t)bytesReceivedForDownloadURL:(NSURL *)downloadURL
+{
+    @synchronized(self)
+    {
+        return [[[_index objectForKey:[self fileNameForDownloadURL:downloadURL]] objectForKey:IGResumeDataBytesReceivedKey] longLongValue];
+    }
+}
+
+- (NSData *)resumeDataForDownloadURL:(NSURL *)downloadURL
+{
+    if (!downloadURL)
+    {
+        return nil;
+    }
+    
+    NSString *fileName = [self fileNameForDownloadURL:downloadURL];
+    @synchronized(self)
+    {
+        NSDictionary *entry = [self entryForFileName:fileName];
+        if (![self isEntryUsable:entry fileName:fileName])
+        {
+            if (entry)
+            {
+                [self removeResumeDataWithFileName:fileName];
+                [self saveIndex];
+            }
+            return nil;
+        }
+        
+        return [NSData dataWithContentsOfFile:[_directory stringByAppendingPathComponent:fileName]];
+    }
+}
+
+- (void)validateResumeDataForDownloadURL:(NSURL *)downloadURL completion:(void (^)(NSData *resumeData))completion
+{
+    NSData *resumeData = [self resumeDataForDownloadURL:downloadURL];
+    NSDictionary *entry = nil;
+    @synchronized(self)
+    {
+        entry = [_index objectForKey:[self fileNameForDownloadURL:downloadURL]];
+    }
+    
+    NSString *ETag = [entry objectForKey:IGResumeDataETagKey];
+    NSString *lastModified = [entry objectForKey:IGResumeDataLastModifiedKey];
+    if (!resumeData || (!ETag && !lastModified))
+    {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            completion(resumeData);
+        });
+        return;
+    }
+    
+    NSMutableURLRequest *request = [[NSMutableURLRequest alloc] initWithURL:downloadURL];
+    [request setHTTPMethod:@"HEAD"];
+    [request setCachePolicy:NSURLRequestReloadIgnoringLocalCacheData];
+    
+    NSURLSessionDataTask *dataTask = [[NSURLSession sharedSession] dataTaskWithRequest:request completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
+        NSData *validResumeData = resumeData;
+        if (!error && [response isKindOfClass:[NSHTTPURLResponse class]])
+        {
+            NSHTTPURLResponse *HTTPURLResponse = (NSHTTPURLResponse *)response;
+            NSString *currentETag = [[HTTPURLResponse allHeaderFields] valueForKey:@"ETag"];
+            NSString *currentLastModified = [[HTTPURLResponse allHeaderFields] valueForKey:@"Last-Modified"];
+            BOOL fileChanged = ((ETag && currentETag && ![ETag isEqualToString:currentETag]) ||
+                                (lastModified && currentLastModified && ![lastModified isEqualToString:currentLastModified]));
+            BOOL fileGone = ([HTTPURLResponse statusCode] == 404 || [HTTPURLResponse statusCode] == 410);
+            if (fileChanged || fileGone)
+            {
+                [self removeResumeDataForDownloadURL:downloadURL];
+                validResumeData = nil;
+            }
+        }
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            completion(validResumeData);
+        });
+    }];
+    [dataTask resume];
+}
+
+#pragma mark - Index
+
+- (NSString *)indexPath
+{
+    return [_directory stringByAppendingPathComponent:IGResumeDataIndexFileName];
+}
+
+- (NSString *)fileNameForDownloadURL:(NSURL *)downloadURL
+{
+    return [NSString MD5Hash:[downloadURL absoluteString]];
+}
+
+- (void)saveIndex
+{
+    [_index writeToFile:[self indexPath] atomically:YES];
+}
+
+/**
+ * Returns the index entry for the blob, building one from the blob itself when it was saved before the index existed.
+ */
+- (NSDictionary *)entryForFileName:(NSString *)fileName
+{
+    NSDictionary *entry = [_index objectForKey:fileName];
+    if (entry)
+    {
+        return entry;
+    }
+    
+    NSString *path = [_directory stringByAppendingPathComponent:fileName];
+    NSDictionary *resumeInfo = IGResumeInfoFromResumeData([NSData dataWithContentsOfFile:path]);
+    NSString *downloadURL = [resumeInfo objectForKey:IGURLSessionDownloadURLKey];
+    NSDate *savedDate = [[[NSFileManager defaultManager] attributesOfItemAtPath:path error:nil] fileModificationDate];
+    if (!downloadURL || !savedDate)
+    {
+        return nil;
+    }
+    
+    return @{ IGResumeDataURLKey: downloadURL,
+              IGResumeDataSavedDateKey: savedDate,
+              IGResumeDataBytesReceivedKey: @([[resumeInfo objectForKey:IGURLSessionResumeBytesReceivedKey] longLongValue]) };
+}
+
+- (BOOL)isEntryUsable:(NSDictionary *)entry fileName:(NSString *)fileName
+{
+    NSDate *savedDate = [entry objectForKey:IGResumeDataSavedDateKey];
+    if (!savedDate || -[savedDate timeIntervalSinceNow] > self.maximumAge)
+    {
+        return NO;
+    }
+    
+    NSString *path = [_directory stringByAppendingPathComponent:fileName];
+    NSDictionary *resumeInfo = IGResumeInfoFromResumeData([NSData dataWithContentsOfFile:path]);
+    if (!resumeInfo)
+    {
+        return NO;
+    }
+    
+    // The partial file lives in the temporary directory, which the system purges. Paths outside the app's container can not be checked.
+    NSString *localPath = [resumeInfo objectForKey:IGURLSessionResumeInfoLocalPathKey];
+    if ([localPath hasPrefix:NSHomeDirectory()] && ![[NSFileManager defaultManager] fileExistsAtPath:localPath])
+    {
+        return NO;
+    }
+    
+    return YES;
+}
+
+- (void)removeResumeDataWithFileName:(NSString *)fileName
+{
+    [[NSFileManager defaultManager] removeItemAtPath:[_directory stringByAppendingPathComponent:fileName] error:nil];
+    [_index removeObjectForKey:fileName];
+}
+
+@end
@@ -0,0 +1,72 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+typedef void (^IGSeekCompletionBlock)(BOOL finished);
+typedef void (^IGSeekBlock)(Float64 time, BOOL exact, IGSeekCompletionBlock completion);
+typedef void (^IGSeekSettledBlock)(Float64 time);
+
+/**
+ * The IGSeekCoordinator class keeps at most one seek in flight. Seeks asked for while one is in flight are collapsed into the latest of them, which is issued once the seek in flight completes.
+ *
+ * A seek is either exact or loose. Loose seeks suit scrubbing, where the player may land on whatever time is cheapest to reach near the target, an exact seek is issued once scrubbing ends.
+ *
+ * All methods must be called on the main thread, and the seek block must execute its completion block on the main thread.
+ */
+@interface IGSeekCoordinator : NSObject
+
+/**
+ * Initializes a seek coordinator that issues its seeks with the given block.
+ *
+ * @param The block that performs a seek and executes the completion block once it is done.
+ */
+- (id)initWithSeekBlock:(IGSeekBlock)seekBlock;
+
+/**
+ * The block to execute when the last seek asked for has completed and no other is waiting, with the time it went to. Suits work that only needs doing once a run of seeks has settled, such as updating the now playing info.
+ */
+@property (nonatomic, copy) IGSeekSettledBlock settledBlock;
+
+/**
+ * Indicates whether a seek is in flight. (read-only)
+ */
+@property (nonatomic, readonly, getter = isSeeking) BOOL seeking;
+
+/**
+ * The time of the latest seek asked for, whether it is in flight or waiting. Only meaningful while seeking. (read-only)
+ */
+@property (nonatomic, readonly) Float64 targetTime;
+
+/**
+ * Seeks to the given time, straight away if no seek is in flight, otherwise once it completes. A seek that is already waiting is replaced.
+ *
+ * @param The time to seek to.
+ * @param YES to land on the time exactly, NO to allow the player to land near it.
+ */
+- (void)seekToTime:(Float64)time exact:(BOOL)exact;
+
+/**
+ * Drops the waiting seek and forgets the seek in flight, whose completion is then ignored. Used when the player the seeks were for is torn down.
+ */
+- (void)cancelSeeks;
+
+@end
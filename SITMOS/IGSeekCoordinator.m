@@ -0,0 +1,97 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGSeekCoordinator.h"
+
+@implementation IGSeekCoordinator
+{
+    IGSeekBlock _seekBlock;
+    BOOL _hasPendingSeek;
+    BOOL _pendingSeekExact;
+    NSUInteger _generation;
+}
+
+- (id)initWithSeekBlock:(IGSeekBlock)seekBlock
+{
+    NSParameterAssert(seekBlock != nil);
+    
+    if (!(self = [super init])) return nil;
+    
+    _seekBlock = [seekBlock copy];
+    
+    return self;
+}
+
+- (void)seekToTime:(Float64)time exact:(BOOL)exact
+{
+    _targetTime = time;
+    
+    if (_seeking)
+    {
+        _hasPendingSeek = YES;
+        _pendingSeekExact = exact;
+        return;
+    }
+    
+    [self issueSeekToTime:time exact:exact];
+}
+
+- (void)issueSeekToTime:(Float64)time exact:(BOOL)exact
+{
+    _seeking = YES;
+    
+    NSUInteger generation = _generation;
+    __weak IGSeekCoordinator *weakSelf = self;
+    _seekBlock(time, exact, ^(BOOL finished) {
+        [weakSelf seekToTime:time didFinishInGeneration:generation];
+    });
+}
+
+- (void)seekToTime:(Float64)time didFinishInGeneration:(NSUInteger)generation
+{
+    if (generation != _generation)
+    {
+        return;
+    }
+    
+    if (_hasPendingSeek)
+    {
+        _hasPendingSeek = NO;
+        [self issueSeekToTime:_targetTime exact:_pendingSeekExact];
+        return;
+    }
+    
+    _seeking = NO;
+    
+    if (_settledBlock)
+    {
+        _settledBlock(time);
+    }
+}
+
+- (void)cancelSeeks
+{
+    _generation++;
+    _seeking = NO;
+    _hasPendingSeek = NO;
+}
+
+@end
@@ -0,0 +1,112 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+extern NSString * const IGSegmentedDownloadErrorDomain;
+
+/* Segmented Download Errors */
+typedef NS_ENUM(NSInteger, IGSegmentedDownloadError) {
+    IGSegmentedDownloadErrorRangesNotSupported = 1,
+    IGSegmentedDownloadErrorSegmentFailed,
+    IGSegmentedDownloadErrorFileNotWritable
+};
+
+/**
+ * The IGSegmentedDownload class downloads a file over several connections at once by splitting it into byte ranges.
+ *
+ * The server is first asked for the first byte of the file. When it answers with 206 Partial Content and the length of the file, the destination is preallocated and the ranges are fetched in parallel over at most maximumConnections connections, each range written at its own offset. A range that fails is retried from where it stopped, the ranges that succeeded are kept. When the server does not support ranges the download fails with IGSegmentedDownloadErrorRangesNotSupported before anything is written, so the caller can fall back to a single connection download.
+ *
+ * Segmented downloads run on a foreground session, they do not continue when the app is suspended. A download can be suspended and resumed, its connections are held open meanwhile, and a connection the server has dropped in the meantime is retried from where it stopped.
+ */
+@interface IGSegmentedDownload : NSObject
+
+/**
+ * Initializes a segmented download that saves to the given destination when every range has been fetched.
+ *
+ * @param The URL to download from.
+ * @param The file URL to save the download to.
+ */
+- (id)initWithDownloadURL:(NSURL *)downloadURL destinationURL:(NSURL *)destinationURL;
+
+/**
+ * The URL to download from.
+ */
+@property (nonatomic, strong, readonly) NSURL *downloadURL;
+
+/**
+ * The file URL the download is saved to.
+ */
+@property (nonatomic, strong, readonly) NSURL *destinationURL;
+
+/**
+ * The maximum number of connections used at once. Defaults to 4.
+ */
+@property (nonatomic, assign) NSUInteger maximumConnections;
+
+/**
+ * The shortest range fetched over one connection, smaller files are fetched in fewer ranges. Defaults to 1 MB.
+ */
+@property (nonatomic, assign) int64_t minimumSegmentLength;
+
+/**
+ * The number of times a failed range is retried before the download fails. Defaults to 3.
+ */
+@property (nonatomic, assign) NSUInteger maximumRetries;
+
+/**
+ * The length of the file in bytes, 0 until the server has answered.
+ */
+@property (readonly) int64_t countOfBytesExpectedToReceive;
+
+/**
+ * The number of bytes written so far.
+ */
+@property (readonly) int64_t countOfBytesReceived;
+
+/**
+ * YES while the download is suspended.
+ */
+@property (readonly, getter = isSuspended) BOOL suspended;
+
+/**
+ * Starts the download.
+ *
+ * @param The completion handler block to execute on the main queue.
+ */
+- (void)startWithCompletion:(void (^)(BOOL success, NSError *error))completion;
+
+/**
+ * Suspends every connection of the download, keeping what has been written. No range is started until the download is resumed.
+ */
+- (void)suspend;
+
+/**
+ * Resumes a suspended download.
+ */
+- (void)resume;
+
+/**
+ * Cancels the download, removing what has been written. The completion handler is executed with an NSURLErrorCancelled error.
+ */
+- (void)cancel;
+
+@end
@@ -0,0 +1,442 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGSegmentedDownload.h"
+
+#import <fcntl.h>
+#import <unistd.h>
+
+NSString * const IGSegmentedDownloadErrorDomain = @"IGSegmentedDownloadErrorDomain";
+
+static NSUInteger const IGSegmentedDownloadDefaultMaximumConnections = 4;
+static int64_t const IGSegmentedDownloadDefaultMinimumSegmentLength = 1024 * 1024;
+static NSUInteger const IGSegmentedDownloadDefaultMaximumRetries = 3;
+
+/* More ranges than connections keeps a retry small and every connection busy until the end */
+static NSUInteger const IGSegmentedDownloadSegmentsPerConnection = 4;
+
+/**
+ * Parses a Content-Range header such as "bytes 0-0/31415926".
+ */
+static BOOL IGParseContentRange(NSString *contentRange, int64_t *start, int64_t *length)
+{
+    if (!contentRange)
+    {
+        return NO;
+    }
+    
+    long long rangeStart = 0, rangeEnd = 0, rangeLength = 0;
+    NSScanner *scanner = [NSScanner scannerWithString:contentRange];
+    if (![scanner scanString:@"bytes" intoString:NULL] ||
+        ![scanner scanLongLong:&rangeStart] ||
+        ![scanner scanString:@"-" intoString:NULL] ||
+        ![scanner scanLongLong:&rangeEnd] ||
+        ![scanner scanString:@"/" intoString:NULL] ||
+        ![scanner scanLongLong:&rangeLength])
+    {
+        return NO;
+    }
+    
+    if (start) *start = rangeStart;
+    if (length) *length = rangeLength;
+    return YES;
+}
+
+/**
+ * A byte range of the file and how much of it has been written.
+ */
+@interface IGDownloadSegment : NSObject
+
+@property (nonatomic, assign) int64_t offset;
+@property (nonatomic, assign) int64_t length;
+@property (nonatomic, assign) int64_t received;
+@property (nonatomic, assign) NSUInteger attempts;
+@property (nonatomic, assign, getter = isResponseValid) BOOL responseValid;
+@property (nonatomic, strong) NSURLSessionDataTask *dataTask;
+
+@end
+
+@implementation IGDownloadSegment
+@end
+
+@interface IGSegmentedDownload () <NSURLSessionDataDelegate>
+
+@property (nonatomic, strong, readwrite) NSURL *downloadURL;
+@property (nonatomic, strong, readwrite) NSURL *destinationURL;
+@property (readwrite) int64_t countOfBytesExpectedToReceive;
+@property (readwrite) int64_t countOfBytesReceived;
+@property (readwrite, getter = isSuspended) BOOL suspended;
+@property (nonatomic, strong) NSURL *partialFileURL;
+@property (nonatomic, strong) NSURLSession *session;
+@property (nonatomic, strong) NSURLSessionDataTask *probeTask;
+@property (nonatomic, copy) NSString *validator;
+@property (nonatomic, strong) NSMutableArray *pendingSegments;
+@property (nonatomic, strong) NSMutableDictionary *activeSegments;
+@property (nonatomic, copy) void (^completion)(BOOL success, NSError *error);
+
+@end
+
+@implementation IGSegmentedDownload
+{
+    int _fileDescriptor;
+    NSUInteger _probeAttempts;
+    BOOL _finished;
+}
+
+- (id)initWithDownloadURL:(NSURL *)downloadURL destinationURL:(NSURL *)destinationURL
+{
+    if (!(self = [super init])) return nil;
+    
+    _downloadURL = downloadURL;
+    _destinationURL = destinationURL;
+    _partialFileURL = [destinationURL URLByAppendingPathExtension:@"part"];
+    _maximumConnections = IGSegmentedDownloadDefaultMaximumConnections;
+    _minimumSegmentLength = IGSegmentedDownloadDefaultMinimumSegmentLength;
+    _maximumRetries = IGSegmentedDownloadDefaultMaximumRetries;
+    _pendingSegments = [[NSMutableArray alloc] init];
+    _activeSegments = [[NSMutableDictionary alloc] init];
+    _fileDescriptor = -1;
+    
+    return self;
+}
+
+#pragma mark - Starting and Cancelling
+
+- (void)startWithCompletion:(void (^)(BOOL success, NSError *error))completion
+{
+    self.completion = completion;
+    
+    NSURLSessionConfiguration *sessionConfig = [NSURLSessionConfiguration defaultSessionConfiguration];
+    sessionConfig.HTTPMaximumConnectionsPerHost = self.maximumConnections;
+    sessionConfig.requestCachePolicy = NSURLRequestReloadIgnoringLocalCacheData;
+    
+    // Every callback is delivered on one serial queue, the segments need no other locking.
+    NSOperationQueue *delegateQueue = [[NSOperationQueue alloc] init];
+    delegateQueue.maxConcurrentOperationCount = 1;
+    self.session = [NSURLSession sessionWithConfiguration:sessionConfig delegate:self delegateQueue:delegateQueue];
+    
+    [self startProbe];
+}
+
+- (void)cancel
+{
+    [self.session.delegateQueue addOperationWithBlock:^{
+        [self finishWithError:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil]];
+    }];
+}
+
+- (void)suspend
+{
+    [self.session.delegateQueue addOperationWithBlock:^{
+        if (_finished || [self isSuspended])
+        {
+            return;
+        }
+        
+        self.suspended = YES;
+        [self.probeTask suspend];
+        for (IGDownloadSegment *segment in [self.activeSegments objectEnumerator])
+        {
+            [segment.dataTask suspend];
+        }
+    }];
+}
+
+- (void)resume
+{
+    [self.session.delegateQueue addOperationWithBlock:^{
+        if (_finished || ![self isSuspended])
+        {
+            return;
+        }
+        
+        self.suspended = NO;
+        [self.probeTask resume];
+        for (IGDownloadSegment *segment in [self.activeSegments objectEnumerator])
+        {
+            [segment.dataTask resume];
+        }
+        [self startPendingSegments];
+    }];
+}
+
+- (NSMutableURLRequest *)requestForRangeFrom:(int64_t)start to:(int64_t)end
+{
+    NSMutableURLRequest *request = [[NSMutableURLRequest alloc] initWithURL:self.downloadURL];
+    [request setValue:[NSString stringWithFormat:@"bytes=%lld-%lld", start, end] forHTTPHeaderField:@"Range"];
+    if (self.validator)
+    {
+        // Should the file change between ranges the server sends all of it instead, which fails the range.
+        [request setValue:self.validator forHTTPHeaderField:@"If-Range"];
+    }
+    return request;
+}
+
+#pragma mark - Probing
+
+/**
+ * Asks for the first byte of the file, the answer tells if ranges are supported and how long the file is.
+ */
+- (void)startProbe
+{
+    _probeAttempts++;
+    
+    self.probeTask = [self.session dataTaskWithRequest:[self requestForRangeFrom:0 to:0]];
+    if (![self isSuspended])
+    {
+        [self.probeTask resume];
+    }
+}
+
+- (void)probeDidFailWithError:(NSError *)error
+{
+    if (_probeAttempts <= self.maximumRetries)
+    {
+        [self startProbe];
+    }
+    else
+    {
+        [self finishWithError:error];
+    }
+}
+
+- (void)probeDidReceiveResponse:(NSHTTPURLResponse *)response
+{
+    self.probeTask = nil;
+    
+    int64_t length = 0;
+    if ([response statusCode] != 206 || !IGParseContentRange([[response allHeaderFields] objectForKey:@"Content-Range"], NULL, &length) || length <= 0)
+    {
+        [self finishWithError:[NSError errorWithDomain:IGSegmentedDownloadErrorDomain code:IGSegmentedDownloadErrorRangesNotSupported userInfo:nil]];
+        return;
+    }
+    
+    self.countOfBytesExpectedToReceive = length;
+    
+    // A weak ETag can not be used with If-Range.
+    NSString *ETag = [[response allHeaderFields] objectForKey:@"ETag"];
+    self.validator = (ETag && ![ETag hasPrefix:@"W/"]) ? ETag : [[response allHeaderFields] objectForKey:@"Last-Modified"];
+    
+    if (![self preallocateFileWithLength:length])
+    {
+        [self finishWithError:[NSError errorWithDomain:IGSegmentedDownloadErrorDomain code:IGSegmentedDownloadErrorFileNotWritable userInfo:nil]];
+        return;
+    }
+    
+    int64_t segmentCount = MIN(MAX((length + self.minimumSegmentLength - 1) / self.minimumSegmentLength, 1), (int64_t)(self.maximumConnections * IGSegmentedDownloadSegmentsPerConnection));
+    int64_t segmentLength = (length + segmentCount - 1) / segmentCount;
+    for (int64_t offset = 0; offset < length; offset += segmentLength)
+    {
+        IGDownloadSegment *segment = [[IGDownloadSegment alloc] init];
+        segment.offset = offset;
+        segment.length = MIN(segmentLength, length - offset);
+        [self.pendingSegments addObject:segment];
+    }
+    
+    [self startPendingSegments];
+}
+
+- (BOOL)preallocateFileWithLength:(int64_t)length
+{
+    _fileDescriptor = open([[self.partialFileURL path] fileSystemRepresentation], O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (_fileDescriptor < 0)
+    {
+        return NO;
+    }
+    
+    return ftruncate(_fileDescriptor, length) == 0;
+}
+
+#pragma mark - Segments
+
+- (void)startPendingSegments
+{
+    while (![self isSuspended] && [self.activeSegments count] < self.maximumConnections && [self.pendingSegments count] > 0)
+    {
+        IGDownloadSegment *segment = [self.pendingSegments objectAtIndex:0];
+        [self.pendingSegments removeObjectAtIndex:0];
+        
+        segment.attempts++;
+        segment.responseValid = NO;
+        
+        // A retried range picks up from the last byte written.
+        NSURLRequest *request = [self requestForRangeFrom:segment.offset + segment.received to:segment.offset + segment.length - 1];
+        NSURLSessionDataTask *dataTask = [self.session dataTaskWithRequest:request];
+        segment.dataTask = dataTask;
+        [self.activeSegments setObject:segment forKey:@(dataTask.taskIdentifier)];
+        [dataTask resume];
+    }
+}
+
+- (BOOL)writeBytes:(const void *)bytes length:(NSUInteger)length toSegment:(IGDownloadSegment *)segment
+{
+    // Anything beyond the range asked for is dropped.
+    length = (NSUInteger)MIN((int64_t)length, segment.length - segment.received);
+    
+    while (length > 0)
+    {
+        ssize_t written = pwrite(_fileDescriptor, bytes, length, segment.offset + segment.received);
+        if (written < 0)
+        {
+            return NO;
+        }
+        
+        bytes = (const char *)bytes + written;
+        length -= written;
+        segment.received += written;
+        self.countOfBytesReceived += written;
+    }
+    
+    return YES;
+}
+
+#pragma mark - NSURLSessionDataDelegate
+
+- (void)URLSession:(NSURLSession *)session dataTask:(NSURLSessionDataTask *)dataTask didReceiveResponse:(NSURLResponse *)response completionHandler:(void (^)(NSURLSessionResponseDisposition disposition))completionHandler
+{
+    if (dataTask == self.probeTask)
+    {
+        // Only the headers are needed, a server ignoring the range would otherwise send the whole file.
+        completionHandler(NSURLSessionResponseCancel);
+        [self probeDidReceiveResponse:(NSHTTPURLResponse *)response];
+        return;
+    }
+    
+    IGDownloadSegment *segment = [self.activeSegments objectForKey:@(dataTask.taskIdentifier)];
+    NSHTTPURLResponse *HTTPURLResponse = (NSHTTPURLResponse *)response;
+    
+    int64_t start = -1;
+    IGParseContentRange([[HTTPURLResponse allHeaderFields] objectForKey:@"Content-Range"], &start, NULL);
+    segment.responseValid = ([HTTPURLResponse statusCode] == 206 && start == segment.offset + segment.received);
+    
+    completionHandler([segment isResponseValid] ? NSURLSessionResponseAllow : NSURLSessionResponseCancel);
+}
+
+- (void)URLSession:(NSURLSession *)session dataTask:(NSURLSessionDataTask *)dataTask didReceiveData:(NSData *)data
+{
+    IGDownloadSegment *segment = [self.activeSegments objectForKey:@(dataTask.taskIdentifier)];
+    if (![segment isResponseValid] || _finished)
+    {
+        return;
+    }
+    
+    __block BOOL written = YES;
+    [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
+        written = [self writeBytes:bytes length:byteRange.length toSegment:segment];
+        *stop = !written;
+    }];
+    
+    if (!written)
+    {
+        [self finishWithError:[NSError errorWithDomain:IGSegmentedDownloadErrorDomain code:IGSegmentedDownloadErrorFileNotWritable userInfo:nil]];
+    }
+}
+
+- (void)URLSession:(NSURLSession *)session task:(NSURLSessionTask *)task didCompleteWithError:(NSError *)error
+{
+    if (task == self.probeTask && !_finished)
+    {
+        // Completing before a response arrived, the connection was lost.
+        self.probeTask = nil;
+        [self probeDidFailWithError:error];
+        return;
+    }
+    
+    IGDownloadSegment *segment = [self.activeSegments objectForKey:@(task.taskIdentifier)];
+    if (!segment || _finished)
+    {
+        return;
+    }
+    
+    [self.activeSegments removeObjectForKey:@(task.taskIdentifier)];
+    segment.dataTask = nil;
+    
+    if (segment.received < segment.length)
+    {
+        if (segment.attempts > self.maximumRetries)
+        {
+            NSDictionary *userInfo = error ? @{ NSUnderlyingErrorKey: error } : nil;
+            [self finishWithError:[NSError errorWithDomain:IGSegmentedDownloadErrorDomain code:IGSegmentedDownloadErrorSegmentFailed userInfo:userInfo]];
+            return;
+        }
+        
+        // Only this range is fetched again, the ranges already written are kept.
+        [self.pendingSegments insertObject:segment atIndex:0];
+    }
+    
+    if ([self.activeSegments count] == 0 && [self.pendingSegments count] == 0)
+    {
+        [self finishWithError:[self moveFileToDestination]];
+    }
+    else
+    {
+        [self startPendingSegments];
+    }
+}
+
+#pragma mark - Finishing
+
+- (NSError *)moveFileToDestination
+{
+    fsync(_fileDescriptor);
+    close(_fileDescriptor);
+    _fileDescriptor = -1;
+    
+    NSError *error = nil;
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    [fileManager removeItemAtURL:self.destinationURL error:nil];
+    [fileManager moveItemAtURL:self.partialFileURL toURL:self.destinationURL error:&error];
+    return error;
+}
+
+- (void)finishWithError:(NSError *)error
+{
+    if (_finished)
+    {
+        return;
+    }
+    _finished = YES;
+    
+    if (_fileDescriptor >= 0)
+    {
+        close(_fileDescriptor);
+        _fileDescriptor = -1;
+    }
+    
+    if (error)
+    {
+        [[NSFileManager defaultManager] removeItemAtURL:self.partialFileURL error:nil];
+    }
+    
+    // The session holds on to its delegate until it is invalidated.
+    [self.session invalidateAndCancel];
+    
+    void (^completion)(BOOL success, NSError *error) = self.completion;
+    self.completion = nil;
+    if (completion)
+    {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            completion(error ? NO : YES, error);
+        });
+    }
+}
+
+@end
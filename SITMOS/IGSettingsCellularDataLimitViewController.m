@@ -0,0 +1,96 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGSettingsCellularDataLimitViewController.h"
+
+#import "IGNetworkManager.h"
+#import "IGDataUsageMeter.h"
+
+@interface IGSettingsCellularDataLimitViewController ()
+
+@property (nonatomic, strong) NSArray *limits;
+
+@end
+
+@implementation IGSettingsCellularDataLimitViewController
+
+#pragma mark - View Lifecycle
+
+- (void)viewDidLoad
+{
+    [super viewDidLoad];
+    
+    // Decimal byte counts, the way carriers count data plans.
+    self.limits = @[@0, @(100000000LL), @(250000000LL), @(500000000LL), @(1000000000LL), @(2000000000LL), @(5000000000LL)];
+}
+
+#pragma mark - Orientation Support
+
+- (NSUInteger)supportedInterfaceOrientations
+{
+    return UIInterfaceOrientationMaskPortrait;
+}
+
+#pragma mark - UITableViewDataSource
+
+- (NSInteger)numberOfSectionsInTableView:(UITableView *)tableView
+{
+    return 1;
+}
+
+- (NSInteger)tableView:(UITableView *)tableView numberOfRowsInSection:(NSInteger)section
+{
+    return [self.limits count];
+}
+
+- (UITableViewCell *)tableView:(UITableView *)tableView cellForRowAtIndexPath:(NSIndexPath *)indexPath
+{
+    static NSString *cellIdentifier = @"cellIdentifier";
+    UITableViewCell *cell = [tableView dequeueReusableCellWithIdentifier:cellIdentifier
+                                                            forIndexPath:indexPath];
+    
+    int64_t limit = [[self.limits objectAtIndex:indexPath.row] longLongValue];
+    NSString *limitText = (limit == 0) ? NSLocalizedString(@"NoLimit", @"text label for no storage limit") : [NSByteCountFormatter stringFromByteCount:limit countStyle:NSByteCountFormatterCountStyleFile];
+    [[cell textLabel] setText:limitText];
+    
+    BOOL selected = (limit == [[IGDataUsageMeter sharedMeter] monthlyCellularLimit]);
+    [cell setAccessoryType:(selected ? UITableViewCellAccessoryCheckmark : UITableViewCellAccessoryNone)];
+    
+    return cell;
+}
+
+- (NSString *)tableView:(UITableView *)tableView titleForFooterInSection:(NSInteger)section
+{
+    NSString *usedSize = [NSByteCountFormatter stringFromByteCount:[[IGDataUsageMeter sharedMeter] bytesUsedOnNetwork:IGDownloadNetworkCellular]
+                                                        countStyle:NSByteCountFormatterCountStyleFile];
+    return [NSString stringWithFormat:NSLocalizedString(@"CellularDataLimitFooter", @"footer text for the monthly cellular data limit setting"), usedSize];
+}
+
+#pragma mark - UITableViewDelegate
+
+- (void)tableView:(UITableView *)tableView didSelectRowAtIndexPath:(NSIndexPath *)indexPath
+{
+    [IGNetworkManager setMonthlyCellularDataLimit:[[self.limits objectAtIndex:indexPath.row] longLongValue]];
+    
+    [tableView reloadData];
+}
+
+@end
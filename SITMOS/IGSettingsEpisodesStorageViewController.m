@@ -0,0 +1,104 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGSettingsEpisodesStorageViewController.h"
+
+#import "IGEpisode.h"
+#import "IGEpisodeStorage.h"
+#import "IGDefines.h"
+
+@interface IGSettingsEpisodesStorageViewController ()
+
+@property (nonatomic, strong) NSArray *budgets;
+
+@end
+
+@implementation IGSettingsEpisodesStorageViewController
+
+#pragma mark - View Lifecycle
+
+- (void)viewDidLoad
+{
+    [super viewDidLoad];
+    
+    // Decimal byte counts, so the limits read as round numbers.
+    self.budgets = @[@0, @(500000000LL), @(1000000000LL), @(2000000000LL), @(5000000000LL), @(10000000000LL)];
+}
+
+#pragma mark - Orientation Support
+
+- (NSUInteger)supportedInterfaceOrientations
+{
+    return UIInterfaceOrientationMaskPortrait;
+}
+
+#pragma mark - UITableViewDataSource
+
+- (NSInteger)numberOfSectionsInTableView:(UITableView *)tableView
+{
+    return 1;
+}
+
+- (NSInteger)tableView:(UITableView *)tableView numberOfRowsInSection:(NSInteger)section
+{
+    return [self.budgets count];
+}
+
+- (UITableViewCell *)tableView:(UITableView *)tableView cellForRowAtIndexPath:(NSIndexPath *)indexPath
+{
+    static NSString *cellIdentifier = @"cellIdentifier";
+    UITableViewCell *cell = [tableView dequeueReusableCellWithIdentifier:cellIdentifier
+                                                            forIndexPath:indexPath];
+    
+    int64_t budget = [[self.budgets objectAtIndex:indexPath.row] longLongValue];
+    NSString *budgetText = (budget == 0) ? NSLocalizedString(@"NoLimit", @"text label for no storage limit") : [NSByteCountFormatter stringFromByteCount:budget countStyle:NSByteCountFormatterCountStyleFile];
+    [[cell textLabel] setText:budgetText];
+    
+    BOOL selected = (budget == [[IGEpisodeStorage sharedStorage] budget]);
+    [cell setAccessoryType:(selected ? UITableViewCellAccessoryCheckmark : UITableViewCellAccessoryNone)];
+    
+    return cell;
+}
+
+- (NSString *)tableView:(UITableView *)tableView titleForFooterInSection:(NSInteger)section
+{
+    NSString *usedSize = [NSByteCountFormatter stringFromByteCount:[[IGEpisodeStorage sharedStorage] usedSize]
+                                                        countStyle:NSByteCountFormatterCountStyleFile];
+    return [NSString stringWithFormat:NSLocalizedString(@"StorageFooter", @"footer text for the storage limit setting"), usedSize];
+}
+
+#pragma mark - UITableViewDelegate
+
+- (void)tableView:(UITableView *)tableView didSelectRowAtIndexPath:(NSIndexPath *)indexPath
+{
+    NSNumber *budget = [self.budgets objectAtIndex:indexPath.row];
+    [[IGEpisodeStorage sharedStorage] setBudget:[budget longLongValue]];
+    
+    NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
+    [userDefaults setObject:budget forKey:IGEpisodesStorageBudgetKey];
+    [userDefaults synchronize];
+    
+    [IGEpisode enforceStorageBudgetSparingFileName:nil];
+    
+    [tableView reloadData];
+}
+
+@end
@@ -23,6 +23,8 @@
 
 #import "IGNetworkManager.h"
 #import "IGEpisode.h"
+#import "IGEpisodeStorage.h"
+#import "IGDataUsageMeter.h"
 #import "IGDefines.h"
 
 @interface IGSettingsViewController ()
@@ -78,7 +80,17 @@
     NSInteger section = indexPath.section;
     NSInteger row = indexPath.row;
     
-    if (section == 1)
+    if (section == 0)
+    {
+        // Cellular Data Section
+        if (row == 2)
+        {
+            int64_t limit = [[IGDataUsageMeter sharedMeter] monthlyCellularLimit];
+            NSString *limitText = (limit == 0) ? NSLocalizedString(@"NoLimit", @"text label for no storage limit") : [NSByteCountFormatter stringFromByteCount:limit countStyle:NSByteCountFormatterCountStyleFile];
+            [[cell detailTextLabel] setText:limitText];
+        }
+    }
+    else if (section == 1)
     {
         // Playback Section
         if (row == 0)
@@ -100,6 +112,18 @@
             NSString *deleteMethod = [self.userDefaults boolForKey:IGAutoDeleteAfterFinishedPlayingKey] ? NSLocalizedString(@"Automatically", @"text label for automatically") : NSLocalizedString(@"Never", @"text label for never");
             [[cell detailTextLabel] setText:deleteMethod];
         }
+        else if (row == 2)
+        {
+            IGEpisodeStorage *episodeStorage = [IGEpisodeStorage sharedStorage];
+            NSString *usedSize = [NSByteCountFormatter stringFromByteCount:[episodeStorage usedSize] countStyle:NSByteCountFormatterCountStyleFile];
+            NSString *storageUsage = usedSize;
+            if ([episodeStorage budget] > 0)
+            {
+                NSString *budget = [NSByteCountFormatter stringFromByteCount:[episodeStorage budget] countStyle:NSByteCountFormatterCountStyleFile];
+                storageUsage = [NSString stringWithFormat:NSLocalizedString(@"StorageUsage", @"text label for the storage used by episodes out of the storage limit"), usedSize, budget];
+            }
+            [[cell detailTextLabel] setText:storageUsage];
+        }
     }
     else if (section == 3)
     {
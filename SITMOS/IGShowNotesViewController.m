@@ -24,7 +24,7 @@
 #import "IGEpisode.h"
 #import "UIViewController+IGNowPlayingButton.h"
 #import "UIImageView+AFNetworking.h"
-#import "NSDate+Helper.h"
+#import "NSDate+IGDateParsing.h"
 
 @interface IGShowNotesViewController ()
 
@@ -45,11 +45,11 @@
 
 - (void)setupLabels
 {
-    NSString *pubDate = [NSDate stringFromDate:[self.episode pubDate] withFormat:@"dd MMM yyyy"];
+    NSString *pubDate = [[self.episode pubDate] displayStringWithFormat:@"dd MMM yyyy"];
     [self.titleLabel setText:[self.episode title]];
     [self.pubDateAndTimeLeftLabel setText:[NSString stringWithFormat:@"%@ - %@", pubDate, [self.episode duration]]];
     [self.durationLabel setText:[self.episode duration]];
-    [self.pubDateLabel setText:[NSDate stringFromDate:[self.episode pubDate] withFormat:@"dd MMM yyyy"]];
+    [self.pubDateLabel setText:[[self.episode pubDate] displayStringWithFormat:@"dd MMM yyyy"]];
     [self.fileSizeLabel setText:[self.episode readableFileSize]];
     [self.summaryLabel setText:[self.episode summary]];
     [self.episodeImageView setImageWithURL:[NSURL URLWithString:[self.episode imageURL]] placeholderImage:[UIImage imageNamed:@"episode-image-placeholder"]];
@@ -0,0 +1,191 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+extern NSString * const IGStreamingCacheErrorDomain;
+
+/* Streaming Cache Errors */
+typedef NS_ENUM(NSInteger, IGStreamingCacheError) {
+    IGStreamingCacheErrorUnexpectedResponse = 1,
+    IGStreamingCacheErrorNotComplete
+};
+
+@class IGStreamingCacheEntry;
+
+/**
+ * The IGStreamingCache class keeps the bytes of streamed episodes so they are only ever fetched once.
+ *
+ * Each remote file is cached in a sparse file of its full length, alongside a record of which byte ranges have been written. Playback reads what is cached and fetches the gaps with Range requests, downloading an episode that has been streamed only fetches the ranges playback skipped. Once every byte is cached the file can be moved into place as the downloaded episode.
+ */
+@interface IGStreamingCache : NSObject
+
+/**
+ * Returns the shared streaming cache, which keeps its files in the Streaming directory of the caches directory.
+ */
++ (instancetype)sharedCache;
+
+/**
+ * Initializes a streaming cache that keeps its files in the given directory.
+ *
+ * @param The path of the directory to keep the files in.
+ */
+- (id)initWithDirectory:(NSString *)directory;
+
+/**
+ * The size in bytes the cache is trimmed to when a new file is cached, the least recently used files are removed first. Files in use are never removed. Defaults to 300 MB.
+ */
+@property (nonatomic, assign) int64_t maximumSize;
+
+/**
+ * Returns the cache entry for the remote file, creating an empty one if nothing of it is cached yet. While an entry is in use the same instance is returned for the URL.
+ *
+ * @param The URL of the remote file.
+ */
+- (IGStreamingCacheEntry *)entryForURL:(NSURL *)URL;
+
+/**
+ * Returns the cache entry for the remote file, nil if nothing of it is cached.
+ *
+ * @param The URL of the remote file.
+ */
+- (IGStreamingCacheEntry *)existingEntryForURL:(NSURL *)URL;
+
+/**
+ * Moves the cached file to the destination and removes it from the cache. Fails with IGStreamingCacheErrorNotComplete unless every byte of the file is cached. An entry in use can still be read after it has been moved.
+ *
+ * @param The URL of the remote file.
+ * @param The file URL to move the cached file to.
+ * @param On return, the error that occurred.
+ *
+ * @return YES if the file was moved, NO otherwise.
+ */
+- (BOOL)moveEntryForURL:(NSURL *)URL toURL:(NSURL *)destinationURL error:(NSError **)error;
+
+/**
+ * Takes over a local copy of the remote file as its cache entry, so the ranges of it that can not be trusted are fetched again rather than the whole file. Whatever was cached for the remote file before is removed.
+ * @param The URL of the remote file.
+ * @param The file URL of the local copy, which is moved into the cache.
+ * @param The byte ranges of the local copy that are known to be good.
+ * @param The length of the remote file, 0 if it is not known. A longer local copy is truncated to it.
+ * @param On return, the error that occurred.
+ * @return The cache entry holding the good ranges, nil if the file could not be moved.
+ */
+- (IGStreamingCacheEntry *)adoptFileAtURL:(NSURL *)fileURL
+                                   forURL:(NSURL *)URL
+                             cachedRanges:(NSIndexSet *)cachedRanges
+                            contentLength:(int64_t)contentLength
+                                    error:(NSError **)error;
+
+/**
+ * Removes the cached file of the remote file.
+ *
+ * @param The URL of the remote file.
+ */
+- (void)removeEntryForURL:(NSURL *)URL;
+
+@end
+
+/**
+ * The IGStreamingCacheEntry class holds the cached byte ranges of one remote file. It is safe to use from any thread.
+ */
+@interface IGStreamingCacheEntry : NSObject
+
+/**
+ * The URL of the remote file.
+ */
+@property (nonatomic, strong, readonly) NSURL *URL;
+
+/**
+ * The length of the remote file in bytes, 0 until the server has answered.
+ */
+@property (readonly) int64_t contentLength;
+
+/**
+ * The MIME type the server sent for the file.
+ */
+@property (readonly, copy) NSString *contentType;
+
+/**
+ * The number of bytes cached.
+ */
+@property (readonly) int64_t countOfBytesCached;
+
+/**
+ * Returns YES if every byte of the file is cached, NO otherwise.
+ */
+- (BOOL)isComplete;
+
+/**
+ * Returns the number of bytes cached without a gap from the offset.
+ *
+ * @param The offset in the file.
+ */
+- (int64_t)cachedLengthFromOffset:(int64_t)offset;
+
+/**
+ * Returns the number of bytes missing from the offset up to the next cached byte or the end of the file, -1 while the length of the file is not known and nothing after the offset is cached.
+ *
+ * @param The offset in the file.
+ */
+- (int64_t)missingLengthFromOffset:(int64_t)offset;
+
+/**
+ * Reads cached bytes.
+ *
+ * @param The offset in the file.
+ * @param The number of bytes to read, which must all be cached.
+ */
+- (NSData *)readDataFromOffset:(int64_t)offset length:(NSUInteger)length;
+
+/**
+ * Fetches a range of the remote file into the cache.
+ *
+ * @param The offset in the file to fetch from.
+ * @param The number of bytes to fetch, -1 to fetch up to the end of the file.
+ * @param The block executed on a private queue each time bytes have been written to the cache.
+ * @param The completion handler block executed on a private queue.
+ *
+ * @return The task fetching the range, which may be cancelled.
+ */
+- (NSURLSessionDataTask *)fetchFromOffset:(int64_t)offset
+                                   length:(int64_t)length
+                              dataHandler:(void (^)(void))dataHandler
+                               completion:(void (^)(NSError *error))completion;
+
+/**
+ * Fetches every range that is not cached yet, one after the other. Asking for a fill while the entry is already being filled does not start another one, the completion handler is executed when the running fill completes.
+ *
+ * @param The completion handler block to execute on the main queue.
+ */
+- (void)fillWithCompletion:(void (^)(BOOL success, NSError *error))completion;
+
+/**
+ * Stops filling the entry, the completion handler is executed with an NSURLErrorCancelled error. What has been fetched is kept.
+ */
+- (void)cancelFill;
+
+/**
+ * Returns YES while the entry is being filled, NO otherwise.
+ */
+- (BOOL)isFilling;
+
+@end
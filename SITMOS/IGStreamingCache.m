@@ -0,0 +1,869 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGStreamingCache.h"
+
+#import "NSString+MD5.h"
+
+#import <fcntl.h>
+#import <unistd.h>
+
+NSString * const IGStreamingCacheErrorDomain = @"com.idlegeniussoftware.sitmos.streaming-cache";
+
+static NSString * const IGStreamingCacheDataExtension = @"cache";
+static NSString * const IGStreamingCacheMetadataExtension = @"plist";
+
+static NSString * const IGStreamingCacheURLKey = @"URL";
+static NSString * const IGStreamingCacheContentLengthKey = @"ContentLength";
+static NSString * const IGStreamingCacheContentTypeKey = @"ContentType";
+static NSString * const IGStreamingCacheValidatorKey = @"Validator";
+static NSString * const IGStreamingCacheRangesKey = @"Ranges";
+
+static int64_t const IGStreamingCacheDefaultMaximumSize = 300 * 1024 * 1024;
+
+/**
+ * Parses a Content-Range header such as "bytes 0-0/1234", returning NO if it can not be parsed.
+ */
+static BOOL IGParseContentRange(NSString *contentRange, int64_t *start, int64_t *length)
+{
+    if (!contentRange)
+    {
+        return NO;
+    }
+    
+    long long rangeStart = 0, rangeEnd = 0, rangeLength = 0;
+    NSScanner *scanner = [NSScanner scannerWithString:contentRange];
+    if (![scanner scanString:@"bytes" intoString:NULL] ||
+        ![scanner scanLongLong:&rangeStart] ||
+        ![scanner scanString:@"-" intoString:NULL] ||
+        ![scanner scanLongLong:&rangeEnd] ||
+        ![scanner scanString:@"/" intoString:NULL] ||
+        ![scanner scanLongLong:&rangeLength])
+    {
+        return NO;
+    }
+    
+    if (start) *start = rangeStart;
+    if (length) *length = rangeLength;
+    return YES;
+}
+
+@interface IGStreamingCacheEntry ()
+
+- (id)initWithURL:(NSURL *)URL basePath:(NSString *)basePath cache:(IGStreamingCache *)cache;
+
+/**
+ * Checks the response to a fetch from the offset, returning NO if its bytes can not be cached. When the file has changed on the server the cached bytes are thrown away.
+ */
+- (BOOL)cacheResponse:(NSHTTPURLResponse *)response fromOffset:(int64_t)offset;
+
+- (void)writeData:(NSData *)data atOffset:(int64_t)offset;
+
+/**
+ * Sets the length of a file whose length the server did not send, once it has been fetched to the end.
+ */
+- (void)setContentLengthIfUnknown:(int64_t)contentLength;
+
+- (void)save;
+
+/**
+ * Called once the entry's files have been moved or removed, the entry no longer saves its record.
+ */
+- (void)detach;
+
+@property (nonatomic, copy, readonly) NSString *dataPath;
+@property (nonatomic, copy, readonly) NSString *metadataPath;
+
+@end
+
+/**
+ * A range being fetched into a cache entry.
+ */
+@interface IGStreamingCacheFetch : NSObject
+
+@property (nonatomic, strong) IGStreamingCacheEntry *entry;
+@property (nonatomic, assign) int64_t offset;
+@property (nonatomic, assign) BOOL toEndOfFile;
+@property (nonatomic, copy) void (^dataHandler)(void);
+@property (nonatomic, copy) void (^completion)(NSError *error);
+@property (nonatomic, strong) NSError *error;
+
+@end
+
+@implementation IGStreamingCacheFetch
+@end
+
+@interface IGStreamingCache () <NSURLSessionDataDelegate>
+
+@property (nonatomic, strong) NSURLSession *session;
+
+- (NSURLSessionDataTask *)fetchTaskForEntry:(IGStreamingCacheEntry *)entry
+                                     offset:(int64_t)offset
+                                     length:(int64_t)length
+                                dataHandler:(void (^)(void))dataHandler
+                                 completion:(void (^)(NSError *error))completion;
+
+@end
+
+@implementation IGStreamingCache
+{
+    NSString *_directory;
+    NSMapTable *_entries;
+    NSMutableDictionary *_fetches;
+}
+
++ (instancetype)sharedCache
+{
+    static IGStreamingCache *sharedCache = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSString *cacheDir = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) lastObject];
+        sharedCache = [[self alloc] initWithDirectory:[cacheDir stringByAppendingPathComponent:@"Streaming"]];
+    });
+    return sharedCache;
+}
+
+- (id)initWithDirectory:(NSString *)directory
+{
+    if (!(self = [super init])) return nil;
+    
+    _directory = [directory copy];
+    _entries = [NSMapTable strongToWeakObjectsMapTable];
+    _fetches = [[NSMutableDictionary alloc] init];
+    _maximumSize = IGStreamingCacheDefaultMaximumSize;
+    
+    NSError *error = nil;
+    if (![[NSFileManager defaultManager] createDirectoryAtPath:_directory withIntermediateDirectories:YES attributes:nil error:&error])
+    {
+        NSLog(@"Failed to create streaming cache dir at %@, reason %@", _directory, [error localizedDescription]);
+    }
+    
+    // The bytes are cached here, keeping a second copy in the URL cache would be a waste.
+    NSURLSessionConfiguration *sessionConfig = [NSURLSessionConfiguration defaultSessionConfiguration];
+    sessionConfig.URLCache = nil;
+    sessionConfig.requestCachePolicy = NSURLRequestReloadIgnoringLocalCacheData;
+    NSOperationQueue *delegateQueue = [[NSOperationQueue alloc] init];
+    delegateQueue.maxConcurrentOperationCount = 1;
+    _session = [NSURLSession sessionWithConfiguration:sessionConfig delegate:self delegateQueue:delegateQueue];
+    
+    return self;
+}
+
+#pragma mark - Entries
+
+- (NSString *)basePathForURL:(NSURL *)URL
+{
+    return [_directory stringByAppendingPathComponent:[NSString MD5Hash:[URL absoluteString]]];
+}
+
+- (IGStreamingCacheEntry *)entryForURL:(NSURL *)URL
+{
+    @synchronized(self)
+    {
+        IGStreamingCacheEntry *entry = [_entries objectForKey:URL];
+        if (entry)
+        {
+            return entry;
+        }
+        
+        NSString *basePath = [self basePathForURL:URL];
+        NSString *metadataPath = [basePath stringByAppendingPathExtension:IGStreamingCacheMetadataExtension];
+        if ([[NSFileManager defaultManager] fileExistsAtPath:metadataPath])
+        {
+            // The record's modification date is when the file was last used.
+            [[NSFileManager defaultManager] setAttributes:@{ NSFileModificationDate: [NSDate date] } ofItemAtPath:metadataPath error:nil];
+        }
+        else
+        {
+            [self trimToMaximumSize];
+        }
+        
+        entry = [[IGStreamingCacheEntry alloc] initWithURL:URL basePath:basePath cache:self];
+        [_entries setObject:entry forKey:URL];
+        return entry;
+    }
+}
+
+- (IGStreamingCacheEntry *)existingEntryForURL:(NSURL *)URL
+{
+    if (!URL)
+    {
+        return nil;
+    }
+    
+    @synchronized(self)
+    {
+        IGStreamingCacheEntry *entry = [_entries objectForKey:URL];
+        if (!entry && [[NSFileManager defaultManager] fileExistsAtPath:[[self basePathForURL:URL] stringByAppendingPathExtension:IGStreamingCacheMetadataExtension]])
+        {
+            entry = [self entryForURL:URL];
+        }
+        return ([entry countOfBytesCached] > 0) ? entry : nil;
+    }
+}
+
+- (BOOL)moveEntryForURL:(NSURL *)URL toURL:(NSURL *)destinationURL error:(NSError **)error
+{
+    @synchronized(self)
+    {
+        IGStreamingCacheEntry *entry = [self existingEntryForURL:URL];
+        if (![entry isComplete])
+        {
+            if (error)
+            {
+                *error = [NSError errorWithDomain:IGStreamingCacheErrorDomain code:IGStreamingCacheErrorNotComplete userInfo:nil];
+            }
+            return NO;
+        }
+        
+        [[NSFileManager defaultManager] removeItemAtURL:destinationURL error:nil];
+        if (![[NSFileManager defaultManager] moveItemAtPath:[entry dataPath] toPath:[destinationURL path] error:error])
+        {
+            return NO;
+        }
+        
+        [entry detach];
+        [[NSFileManager defaultManager] removeItemAtPath:[entry metadataPath] error:nil];
+        [_entries removeObjectForKey:URL];
+        return YES;
+    }
+}
+
+- (IGStreamingCacheEntry *)adoptFileAtURL:(NSURL *)fileURL
+                                   forURL:(NSURL *)URL
+                             cachedRanges:(NSIndexSet *)cachedRanges
+                            contentLength:(int64_t)contentLength
+                                    error:(NSError **)error
+{
+    @synchronized(self)
+    {
+        [self removeEntryForURL:URL];
+        
+        NSString *basePath = [self basePathForURL:URL];
+        NSString *dataPath = [basePath stringByAppendingPathExtension:IGStreamingCacheDataExtension];
+        if (![[NSFileManager defaultManager] moveItemAtPath:[fileURL path] toPath:dataPath error:error])
+        {
+            return nil;
+        }
+        
+        if (contentLength > 0)
+        {
+            // Sets the length the same way a fetch would, a shorter copy is extended sparsely.
+            truncate([dataPath fileSystemRepresentation], contentLength);
+        }
+        
+        NSMutableArray *ranges = [NSMutableArray array];
+        [cachedRanges enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+            if (contentLength > 0)
+            {
+                range = NSIntersectionRange(range, NSMakeRange(0, (NSUInteger)contentLength));
+            }
+            if (range.length > 0)
+            {
+                [ranges addObject:@[@(range.location), @(range.length)]];
+            }
+        }];
+        
+        NSDictionary *metadata = @{ IGStreamingCacheURLKey: [URL absoluteString],
+                                    IGStreamingCacheContentLengthKey: @(contentLength),
+                                    IGStreamingCacheRangesKey: ranges };
+        [metadata writeToFile:[basePath stringByAppendingPathExtension:IGStreamingCacheMetadataExtension] atomically:YES];
+        
+        return [self entryForURL:URL];
+    }
+}
+
+- (void)removeEntryForURL:(NSURL *)URL
+{
+    if (!URL)
+    {
+        return;
+    }
+    
+    @synchronized(self)
+    {
+        [[_entries objectForKey:URL] detach];
+        [_entries removeObjectForKey:URL];
+        
+        NSString *basePath = [self basePathForURL:URL];
+        [[NSFileManager defaultManager] removeItemAtPath:[basePath stringByAppendingPathExtension:IGStreamingCacheDataExtension] error:nil];
+        [[NSFileManager defaultManager] removeItemAtPath:[basePath stringByAppendingPathExtension:IGStreamingCacheMetadataExtension] error:nil];
+    }
+}
+
+/**
+ * Removes the least recently used files until the cache fits in maximumSize. Only the blocks actually written count, the cache files are sparse.
+ */
+- (void)trimToMaximumSize
+{
+    NSMutableSet *basePathsInUse = [NSMutableSet set];
+    for (NSURL *URL in _entries)
+    {
+        [basePathsInUse addObject:[self basePathForURL:URL]];
+    }
+    
+    NSArray *fileNames = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:_directory error:nil];
+    NSMutableArray *basePaths = [NSMutableArray arrayWithCapacity:[fileNames count] / 2];
+    NSMutableDictionary *lastUsedDates = [NSMutableDictionary dictionaryWithCapacity:[fileNames count] / 2];
+    int64_t size = 0;
+    for (NSString *fileName in fileNames)
+    {
+        NSString *basePath = [_directory stringByAppendingPathComponent:[fileName stringByDeletingPathExtension]];
+        NSURL *fileURL = [NSURL fileURLWithPath:[_directory stringByAppendingPathComponent:fileName]];
+        if ([[fileName pathExtension] isEqualToString:IGStreamingCacheDataExtension])
+        {
+            NSNumber *allocatedSize = nil;
+            [fileURL getResourceValue:&allocatedSize forKey:NSURLTotalFileAllocatedSizeKey error:nil];
+            size += [allocatedSize longLongValue];
+        }
+        else if ([[fileName pathExtension] isEqualToString:IGStreamingCacheMetadataExtension] && ![basePathsInUse containsObject:basePath])
+        {
+            NSDate *lastUsedDate = nil;
+            [fileURL getResourceValue:&lastUsedDate forKey:NSURLContentModificationDateKey error:nil];
+            [lastUsedDates setObject:(lastUsedDate ?: [NSDate distantPast]) forKey:basePath];
+            [basePaths addObject:basePath];
+        }
+    }
+    
+    [basePaths sortUsingComparator:^NSComparisonResult(NSString *basePath1, NSString *basePath2) {
+        return [[lastUsedDates objectForKey:basePath1] compare:[lastUsedDates objectForKey:basePath2]];
+    }];
+    
+    for (NSString *basePath in basePaths)
+    {
+        if (size <= self.maximumSize)
+        {
+            break;
+        }
+        
+        NSString *dataPath = [basePath stringByAppendingPathExtension:IGStreamingCacheDataExtension];
+        NSNumber *allocatedSize = nil;
+        [[NSURL fileURLWithPath:dataPath] getResourceValue:&allocatedSize forKey:NSURLTotalFileAllocatedSizeKey error:nil];
+        size -= [allocatedSize longLongValue];
+        
+        [[NSFileManager defaultManager] removeItemAtPath:dataPath error:nil];
+        [[NSFileManager defaultManager] removeItemAtPath:[basePath stringByAppendingPathExtension:IGStreamingCacheMetadataExtension] error:nil];
+    }
+}
+
+#pragma mark - Fetching
+
+- (NSURLSessionDataTask *)fetchTaskForEntry:(IGStreamingCacheEntry *)entry
+                                     offset:(int64_t)offset
+                                     length:(int64_t)length
+                                dataHandler:(void (^)(void))dataHandler
+                                 completion:(void (^)(NSError *error))completion
+{
+    NSMutableURLRequest *request = [[NSMutableURLRequest alloc] initWithURL:[entry URL]];
+    NSString *range = (length >= 0) ? [NSString stringWithFormat:@"bytes=%lld-%lld", offset, offset + length - 1] : [NSString stringWithFormat:@"bytes=%lld-", offset];
+    [request setValue:range forHTTPHeaderField:@"Range"];
+    // Offsets are only meaningful in the file as it is stored on the server.
+    [request setValue:@"identity" forHTTPHeaderField:@"Accept-Encoding"];
+    
+    IGStreamingCacheFetch *fetch = [[IGStreamingCacheFetch alloc] init];
+    fetch.entry = entry;
+    fetch.offset = offset;
+    fetch.toEndOfFile = (length < 0);
+    fetch.dataHandler = dataHandler;
+    fetch.completion = completion;
+    
+    NSURLSessionDataTask *dataTask = [self.session dataTaskWithRequest:request];
+    @synchronized(_fetches)
+    {
+        [_fetches setObject:fetch forKey:@([dataTask taskIdentifier])];
+    }
+    [dataTask resume];
+    
+    return dataTask;
+}
+
+- (IGStreamingCacheFetch *)fetchForTask:(NSURLSessionTask *)task
+{
+    @synchronized(_fetches)
+    {
+        return [_fetches objectForKey:@([task taskIdentifier])];
+    }
+}
+
+#pragma mark - NSURLSessionDataDelegate
+
+- (void)URLSession:(NSURLSession *)session dataTask:(NSURLSessionDataTask *)dataTask didReceiveResponse:(NSURLResponse *)response completionHandler:(void (^)(NSURLSessionResponseDisposition disposition))completionHandler
+{
+    IGStreamingCacheFetch *fetch = [self fetchForTask:dataTask];
+    if (![response isKindOfClass:[NSHTTPURLResponse class]] || ![fetch.entry cacheResponse:(NSHTTPURLResponse *)response fromOffset:fetch.offset])
+    {
+        fetch.error = [NSError errorWithDomain:IGStreamingCacheErrorDomain code:IGStreamingCacheErrorUnexpectedResponse userInfo:nil];
+        completionHandler(NSURLSessionResponseCancel);
+        return;
+    }
+    
+    completionHandler(NSURLSessionResponseAllow);
+}
+
+- (void)URLSession:(NSURLSession *)session dataTask:(NSURLSessionDataTask *)dataTask didReceiveData:(NSData *)data
+{
+    IGStreamingCacheFetch *fetch = [self fetchForTask:dataTask];
+    [fetch.entry writeData:data atOffset:fetch.offset];
+    fetch.offset += [data length];
+    
+    if (fetch.dataHandler)
+    {
+        fetch.dataHandler();
+    }
+}
+
+- (void)URLSession:(NSURLSession *)session task:(NSURLSessionTask *)task didCompleteWithError:(NSError *)error
+{
+    IGStreamingCacheFetch *fetch = [self fetchForTask:task];
+    @synchronized(_fetches)
+    {
+        [_fetches removeObjectForKey:@([task taskIdentifier])];
+    }
+    
+    if (!error && !fetch.error && fetch.toEndOfFile)
+    {
+        [fetch.entry setContentLengthIfUnknown:fetch.offset];
+    }
+    [fetch.entry save];
+    
+    if (fetch.completion)
+    {
+        fetch.completion(fetch.error ?: error);
+    }
+}
+
+@end
+
+@implementation IGStreamingCacheEntry
+{
+    __weak IGStreamingCache *_cache;
+    int _fileDescriptor;
+    NSMutableIndexSet *_cachedRanges;
+    NSString *_validator;
+    BOOL _detached;
+    NSURLSessionDataTask *_fillTask;
+    BOOL _fillCancelled;
+    NSMutableArray *_fillCompletions;
+}
+
+@synthesize contentLength = _contentLength;
+@synthesize contentType = _contentType;
+
+- (id)initWithURL:(NSURL *)URL basePath:(NSString *)basePath cache:(IGStreamingCache *)cache
+{
+    if (!(self = [super init])) return nil;
+    
+    _URL = URL;
+    _cache = cache;
+    _dataPath = [basePath stringByAppendingPathExtension:IGStreamingCacheDataExtension];
+    _metadataPath = [basePath stringByAppendingPathExtension:IGStreamingCacheMetadataExtension];
+    _cachedRanges = [[NSMutableIndexSet alloc] init];
+    _fillCompletions = [[NSMutableArray alloc] init];
+    
+    NSDictionary *metadata = [NSDictionary dictionaryWithContentsOfFile:_metadataPath];
+    BOOL hasMetadata = [[metadata objectForKey:IGStreamingCacheURLKey] isEqualToString:[URL absoluteString]];
+    if (hasMetadata)
+    {
+        _contentLength = [[metadata objectForKey:IGStreamingCacheContentLengthKey] longLongValue];
+        _contentType = [metadata objectForKey:IGStreamingCacheContentTypeKey];
+        _validator = [metadata objectForKey:IGStreamingCacheValidatorKey];
+        for (NSArray *range in [metadata objectForKey:IGStreamingCacheRangesKey])
+        {
+            [_cachedRanges addIndexesInRange:NSMakeRange([[range firstObject] unsignedIntegerValue], [[range lastObject] unsignedIntegerValue])];
+        }
+    }
+    
+    _fileDescriptor = open([_dataPath fileSystemRepresentation], O_RDWR | O_CREAT, 0644);
+    if (_fileDescriptor < 0)
+    {
+        NSLog(@"Failed to open streaming cache file at %@, reason %s", _dataPath, strerror(errno));
+    }
+    else if (!hasMetadata)
+    {
+        // Bytes without a record of where they belong can not be used.
+        ftruncate(_fileDescriptor, 0);
+    }
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    [self save];
+    
+    if (_fileDescriptor >= 0)
+    {
+        close(_fileDescriptor);
+    }
+}
+
+#pragma mark - Cached Ranges
+
+- (int64_t)contentLength
+{
+    @synchronized(self)
+    {
+        return _contentLength;
+    }
+}
+
+- (NSString *)contentType
+{
+    @synchronized(self)
+    {
+        return _contentType;
+    }
+}
+
+- (int64_t)countOfBytesCached
+{
+    @synchronized(self)
+    {
+        return [_cachedRanges count];
+    }
+}
+
+- (BOOL)isComplete
+{
+    @synchronized(self)
+    {
+        return (_contentLength > 0 && [_cachedRanges containsIndexesInRange:NSMakeRange(0, (NSUInteger)_contentLength)]);
+    }
+}
+
+- (int64_t)cachedLengthFromOffset:(int64_t)offset
+{
+    @synchronized(self)
+    {
+        __block int64_t cachedLength = 0;
+        [_cachedRanges enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+            if (NSLocationInRange((NSUInteger)offset, range))
+            {
+                cachedLength = NSMaxRange(range) - offset;
+                *stop = YES;
+            }
+            else if (range.location > offset)
+            {
+                *stop = YES;
+            }
+        }];
+        return cachedLength;
+    }
+}
+
+- (int64_t)missingLengthFromOffset:(int64_t)offset
+{
+    @synchronized(self)
+    {
+        NSUInteger nextCachedOffset = [_cachedRanges indexGreaterThanOrEqualToIndex:(NSUInteger)offset];
+        if (nextCachedOffset != NSNotFound)
+        {
+            return nextCachedOffset - offset;
+        }
+        
+        return (_contentLength > 0) ? MAX(_contentLength - offset, 0) : -1;
+    }
+}
+
+- (NSData *)readDataFromOffset:(int64_t)offset length:(NSUInteger)length
+{
+    NSMutableData *data = [NSMutableData dataWithLength:length];
+    char *bytes = [data mutableBytes];
+    NSUInteger bytesRead = 0;
+    while (bytesRead < length)
+    {
+        ssize_t result = pread(_fileDescriptor, bytes + bytesRead, length - bytesRead, offset + bytesRead);
+        if (result <= 0)
+        {
+            return nil;
+        }
+        bytesRead += result;
+    }
+    
+    return data;
+}
+
+#pragma mark - Writing
+
+- (BOOL)cacheResponse:(NSHTTPURLResponse *)response fromOffset:(int64_t)offset
+{
+    int64_t start = 0, length = 0;
+    if ([response statusCode] == 206)
+    {
+        if (!IGParseContentRange([[response allHeaderFields] objectForKey:@"Content-Range"], &start, &length) || start != offset)
+        {
+            return NO;
+        }
+    }
+    else if ([response statusCode] == 200 && offset == 0)
+    {
+        // The server ignored the range and is sending the whole file.
+        length = MAX([response expectedContentLength], 0);
+    }
+    else
+    {
+        return NO;
+    }
+    
+    NSString *validator = [[response allHeaderFields] objectForKey:@"ETag"] ?: [[response allHeaderFields] objectForKey:@"Last-Modified"];
+    
+    @synchronized(self)
+    {
+        BOOL fileChanged = ((_validator && validator && ![_validator isEqualToString:validator]) ||
+                            (_contentLength > 0 && length > 0 && _contentLength != length));
+        if (fileChanged)
+        {
+            [_cachedRanges removeAllIndexes];
+            _contentLength = 0;
+            ftruncate(_fileDescriptor, 0);
+        }
+        
+        _validator = validator ?: _validator;
+        _contentType = [response MIMEType] ?: _contentType;
+        if (length > 0 && _contentLength == 0)
+        {
+            // Sets the length without allocating any blocks, the file stays sparse until the ranges are written.
+            _contentLength = length;
+            ftruncate(_fileDescriptor, length);
+        }
+    }
+    
+    return YES;
+}
+
+- (void)writeData:(NSData *)data atOffset:(int64_t)offset
+{
+    const char *bytes = [data bytes];
+    NSUInteger length = [data length];
+    NSUInteger bytesWritten = 0;
+    while (bytesWritten < length)
+    {
+        ssize_t result = pwrite(_fileDescriptor, bytes + bytesWritten, length - bytesWritten, offset + bytesWritten);
+        if (result <= 0)
+        {
+            break;
+        }
+        bytesWritten += result;
+    }
+    
+    @synchronized(self)
+    {
+        [_cachedRanges addIndexesInRange:NSMakeRange((NSUInteger)offset, bytesWritten)];
+    }
+}
+
+- (void)setContentLengthIfUnknown:(int64_t)contentLength
+{
+    @synchronized(self)
+    {
+        if (_contentLength == 0)
+        {
+            _contentLength = contentLength;
+        }
+    }
+}
+
+- (void)save
+{
+    @synchronized(self)
+    {
+        if (_detached)
+        {
+            return;
+        }
+        
+        NSMutableArray *ranges = [NSMutableArray array];
+        [_cachedRanges enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+            [ranges addObject:@[@(range.location), @(range.length)]];
+        }];
+        
+        NSMutableDictionary *metadata = [NSMutableDictionary dictionaryWithCapacity:5];
+        [metadata setObject:[self.URL absoluteString] forKey:IGStreamingCacheURLKey];
+        [metadata setObject:@(_contentLength) forKey:IGStreamingCacheContentLengthKey];
+        [metadata setObject:ranges forKey:IGStreamingCacheRangesKey];
+        if (_contentType)
+        {
+            [metadata setObject:_contentType forKey:IGStreamingCacheContentTypeKey];
+        }
+        if (_validator)
+        {
+            [metadata setObject:_validator forKey:IGStreamingCacheValidatorKey];
+        }
+        [metadata writeToFile:self.metadataPath atomically:YES];
+    }
+}
+
+- (void)detach
+{
+    @synchronized(self)
+    {
+        _detached = YES;
+    }
+}
+
+#pragma mark - Fetching
+
+- (NSURLSessionDataTask *)fetchFromOffset:(int64_t)offset
+                                   length:(int64_t)length
+                              dataHandler:(void (^)(void))dataHandler
+                               completion:(void (^)(NSError *error))completion
+{
+    IGStreamingCache *cache = _cache;
+    if (!cache || length == 0)
+    {
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            completion(nil);
+        });
+        return nil;
+    }
+    
+    return [cache fetchTaskForEntry:self offset:offset length:length dataHandler:dataHandler completion:completion];
+}
+
+- (void)fillWithCompletion:(void (^)(BOOL success, NSError *error))completion
+{
+    BOOL filling = NO;
+    @synchronized(self)
+    {
+        filling = [_fillCompletions count] > 0;
+        [_fillCompletions addObject:completion ? [completion copy] : ^(BOOL success, NSError *error) {}];
+        if (!filling)
+        {
+            _fillCancelled = NO;
+        }
+    }
+    
+    // A second fill would fetch the same ranges again, the caller waits for the running one instead.
+    if (filling)
+    {
+        return;
+    }
+    
+    [self fillNextRange];
+}
+
+- (void)fillNextRange
+{
+    BOOL cancelled = NO;
+    @synchronized(self)
+    {
+        cancelled = _fillCancelled;
+    }
+    
+    if (cancelled)
+    {
+        [self finishFillWithError:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil]];
+        return;
+    }
+    
+    if ([self isComplete])
+    {
+        [self finishFillWithError:nil];
+        return;
+    }
+    
+    // The first byte that is not cached.
+    __block NSUInteger offset = 0;
+    @synchronized(self)
+    {
+        [_cachedRanges enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+            if (range.location > offset)
+            {
+                *stop = YES;
+                return;
+            }
+            offset = NSMaxRange(range);
+        }];
+    }
+    
+    int64_t countOfBytesCached = [self countOfBytesCached];
+    NSURLSessionDataTask *fillTask = [self fetchFromOffset:offset length:[self missingLengthFromOffset:offset] dataHandler:nil completion:^(NSError *error) {
+        if (!error && [self countOfBytesCached] == countOfBytesCached)
+        {
+            // Nothing was fetched, asking again would not fetch anything either.
+            error = [NSError errorWithDomain:IGStreamingCacheErrorDomain code:IGStreamingCacheErrorUnexpectedResponse userInfo:nil];
+        }
+        
+        if (error)
+        {
+            [self finishFillWithError:error];
+        }
+        else
+        {
+            [self fillNextRange];
+        }
+    }];
+    
+    @synchronized(self)
+    {
+        _fillTask = fillTask;
+        cancelled = _fillCancelled;
+    }
+    
+    // Cancelled while the task was being created.
+    if (cancelled)
+    {
+        [fillTask cancel];
+    }
+}
+
+- (void)finishFillWithError:(NSError *)error
+{
+    NSArray *completions = nil;
+    @synchronized(self)
+    {
+        completions = [_fillCompletions copy];
+        [_fillCompletions removeAllObjects];
+        _fillTask = nil;
+    }
+    
+    if ([completions count] > 0)
+    {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            for (void (^completion)(BOOL success, NSError *error) in completions)
+            {
+                completion(error == nil, error);
+            }
+        });
+    }
+}
+
+- (void)cancelFill
+{
+    NSURLSessionDataTask *fillTask = nil;
+    @synchronized(self)
+    {
+        fillTask = _fillTask;
+        _fillCancelled = YES;
+    }
+    
+    [fillTask cancel];
+}
+
+- (BOOL)isFilling
+{
+    @synchronized(self)
+    {
+        return [_fillCompletions count] > 0;
+    }
+}
+
+@end
@@ -37,6 +37,11 @@
     
     self.acceptableContentTypes = [[NSSet alloc] initWithObjects:@"application/xml", @"text/xml", @"application/rss+xml", nil];
     
+    // 304 Not Modified is the expected answer to a conditional request for an unchanged feed.
+    NSMutableIndexSet *acceptableStatusCodes = [[NSMutableIndexSet alloc] initWithIndexesInRange:NSMakeRange(200, 100)];
+    [acceptableStatusCodes addIndex:304];
+    self.acceptableStatusCodes = acceptableStatusCodes;
+    
     return self;
 }
 
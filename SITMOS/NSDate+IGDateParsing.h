@@ -0,0 +1,59 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+@interface NSDate (IGDateParsing)
+
+#pragma mark - RFC 822 Dates
+
+/**
+ * @name RFC 822 Dates
+ */
+
+/**
+ * Parses an RFC 822/RFC 1123 date such as the pubDate of a feed item or a Last-Modified header.
+ *
+ * Dates in the common form eg. "Tue, 10 Aug 2010 00:00:00 MST" are parsed by hand without a formatter, anything else falls back to a cached formatter.
+ *
+ * @return The date, nil if the string is not a date.
+ */
++ (NSDate *)dateFromRFC822String:(NSString *)string;
+
+#pragma mark - Display Formatting
+
+/**
+ * @name Display Formatting
+ */
+
+/**
+ * Returns a date formatter for the given format in the current locale.
+ *
+ * Formatters are expensive to create and are not safe to share between threads, so each thread keeps its own formatter per format. The cache is emptied when the locale or time zone changes.
+ */
++ (NSDateFormatter *)cachedDateFormatterWithFormat:(NSString *)format;
+
+/**
+ * Returns the date formatted for display with a cached formatter for the given format.
+ */
+- (NSString *)displayStringWithFormat:(NSString *)format;
+
+@end
@@ -0,0 +1,331 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "NSDate+IGDateParsing.h"
+
+#import "IGDefines.h"
+
+#import <libkern/OSAtomic.h>
+
+/* The key of the formatter cache in each thread's dictionary */
+static NSString * const IGDateFormatterCacheKey = @"IGDateFormatterCache";
+
+/* The key of the generation a thread's cache was filled in */
+static NSString * const IGDateFormatterCacheGenerationKey = @"IGDateFormatterCacheGeneration";
+
+/* The key of the formatter used when a date can not be parsed by hand */
+static NSString * const IGRFC822FormatterKey = @"IGRFC822Formatter";
+
+/* Incremented when the locale or time zone changes, a thread's cache is emptied when it was filled in an earlier generation */
+static volatile int32_t IGDateFormatterCacheGeneration = 0;
+
+static const char *IGMonthNames[] = { "jan", "feb", "mar", "apr", "may", "jun", "jul", "aug", "sep", "oct", "nov", "dec" };
+
+typedef struct {
+    const char *name;
+    int offset;
+} IGTimeZoneAbbreviation;
+
+/* The zone names allowed by RFC 822 plus BST, offsets are in hours from GMT */
+static const IGTimeZoneAbbreviation IGTimeZoneAbbreviations[] = {
+    { "gmt", 0 }, { "ut", 0 }, { "utc", 0 }, { "z", 0 },
+    { "est", -5 }, { "edt", -4 },
+    { "cst", -6 }, { "cdt", -5 },
+    { "mst", -7 }, { "mdt", -6 },
+    { "pst", -8 }, { "pdt", -7 },
+    { "bst", 1 }
+};
+
+static inline BOOL IGIsDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static inline BOOL IGIsAlpha(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static inline char IGLowercase(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+static inline void IGSkipSpaces(const char **p)
+{
+    while (**p == ' ' || **p == '\t')
+    {
+        (*p)++;
+    }
+}
+
+static BOOL IGParseNumber(const char **p, NSInteger maxDigits, NSInteger *value)
+{
+    NSInteger digits = 0;
+    NSInteger result = 0;
+    while (IGIsDigit(**p) && digits < maxDigits)
+    {
+        result = result * 10 + (**p - '0');
+        (*p)++;
+        digits++;
+    }
+    *value = result;
+    return digits > 0;
+}
+
+/**
+ * Returns the number of days since 1970-01-01 of the given date in the proleptic Gregorian calendar.
+ */
+static int64_t IGDaysFromCivil(int64_t year, int64_t month, int64_t day)
+{
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t yearOfEra = year - era * 400;
+    int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+/**
+ * Parses "[Day,] DD Mon YYYY HH:MM[:SS] [Zone]". Returns NO for anything it does not understand so the caller can fall back to a formatter.
+ */
+static BOOL IGParseRFC822Date(const char *string, NSTimeInterval *timeInterval)
+{
+    const char *p = string;
+    IGSkipSpaces(&p);
+    
+    // The day name is optional and carries no information.
+    if (IGIsAlpha(*p))
+    {
+        while (IGIsAlpha(*p))
+        {
+            p++;
+        }
+        if (*p == ',')
+        {
+            p++;
+        }
+        IGSkipSpaces(&p);
+    }
+    
+    NSInteger day, year, hour, minute, second = 0;
+    if (!IGParseNumber(&p, 2, &day))
+    {
+        return NO;
+    }
+    IGSkipSpaces(&p);
+    
+    char monthName[3];
+    for (NSInteger i = 0; i < 3; i++)
+    {
+        if (!IGIsAlpha(p[i]))
+        {
+            return NO;
+        }
+        monthName[i] = IGLowercase(p[i]);
+    }
+    NSInteger month = 0;
+    for (NSInteger i = 0; i < 12; i++)
+    {
+        if (strncmp(monthName, IGMonthNames[i], 3) == 0)
+        {
+            month = i + 1;
+            break;
+        }
+    }
+    if (month == 0)
+    {
+        return NO;
+    }
+    // Some feeds spell out the month.
+    while (IGIsAlpha(*p))
+    {
+        p++;
+    }
+    IGSkipSpaces(&p);
+    
+    const char *yearStart = p;
+    if (!IGParseNumber(&p, 4, &year))
+    {
+        return NO;
+    }
+    if (p - yearStart == 2)
+    {
+        year += (year < 50) ? 2000 : 1900;
+    }
+    IGSkipSpaces(&p);
+    
+    if (!IGParseNumber(&p, 2, &hour) || *p++ != ':' || !IGParseNumber(&p, 2, &minute))
+    {
+        return NO;
+    }
+    if (*p == ':')
+    {
+        p++;
+        if (!IGParseNumber(&p, 2, &second))
+        {
+            return NO;
+        }
+    }
+    IGSkipSpaces(&p);
+    
+    if (day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60)
+    {
+        return NO;
+    }
+    
+    NSInteger offset = 0;
+    if (*p == '+' || *p == '-')
+    {
+        NSInteger sign = (*p == '-') ? -1 : 1;
+        p++;
+        const char *zoneStart = p;
+        NSInteger zone;
+        if (!IGParseNumber(&p, 4, &zone) || p - zoneStart != 4)
+        {
+            return NO;
+        }
+        offset = sign * ((zone / 100) * 3600 + (zone % 100) * 60);
+    }
+    else if (IGIsAlpha(*p))
+    {
+        char zoneName[4] = { 0 };
+        NSInteger length = 0;
+        while (IGIsAlpha(*p))
+        {
+            if (length == 3)
+            {
+                return NO;
+            }
+            zoneName[length++] = IGLowercase(*p++);
+        }
+        BOOL known = NO;
+        for (size_t i = 0; i < sizeof(IGTimeZoneAbbreviations) / sizeof(IGTimeZoneAbbreviations[0]); i++)
+        {
+            if (strcmp(zoneName, IGTimeZoneAbbreviations[i].name) == 0)
+            {
+                offset = IGTimeZoneAbbreviations[i].offset * 3600;
+                known = YES;
+                break;
+            }
+        }
+        if (!known)
+        {
+            return NO;
+        }
+    }
+    IGSkipSpaces(&p);
+    
+    if (*p != '\0')
+    {
+        return NO;
+    }
+    
+    int64_t days = IGDaysFromCivil(year, month, day);
+    *timeInterval = (NSTimeInterval)(days * 86400 + hour * 3600 + minute * 60 + second - offset);
+    
+    return YES;
+}
+
+@implementation NSDate (IGDateParsing)
+
+#pragma mark - RFC 822 Dates
+
++ (NSDate *)dateFromRFC822String:(NSString *)string
+{
+    if (!string)
+    {
+        return nil;
+    }
+    
+    char buffer[64];
+    NSTimeInterval timeInterval;
+    if ([string getCString:buffer maxLength:sizeof(buffer) encoding:NSASCIIStringEncoding] && IGParseRFC822Date(buffer, &timeInterval))
+    {
+        return [NSDate dateWithTimeIntervalSince1970:timeInterval];
+    }
+    
+    // Zone names outside RFC 822 such as CEST are left to the formatter.
+    return [[self cachedRFC822DateFormatter] dateFromString:string];
+}
+
++ (NSDateFormatter *)cachedRFC822DateFormatter
+{
+    NSMutableDictionary *cache = [self dateFormatterCache];
+    NSDateFormatter *dateFormatter = [cache objectForKey:IGRFC822FormatterKey];
+    if (!dateFormatter)
+    {
+        dateFormatter = [[NSDateFormatter alloc] init];
+        // The default locale can not be trusted to understand English day and month names.
+        [dateFormatter setLocale:[[NSLocale alloc] initWithLocaleIdentifier:@"en_US_POSIX"]];
+        [dateFormatter setDateFormat:IGDateFormatString];
+        [cache setObject:dateFormatter forKey:IGRFC822FormatterKey];
+    }
+    
+    return dateFormatter;
+}
+
+#pragma mark - Display Formatting
+
++ (NSMutableDictionary *)dateFormatterCache
+{
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        void (^invalidate)(NSNotification *) = ^(NSNotification *notification) {
+            OSAtomicIncrement32Barrier(&IGDateFormatterCacheGeneration);
+        };
+        NSNotificationCenter *notificationCenter = [NSNotificationCenter defaultCenter];
+        [notificationCenter addObserverForName:NSCurrentLocaleDidChangeNotification object:nil queue:nil usingBlock:invalidate];
+        [notificationCenter addObserverForName:NSSystemTimeZoneDidChangeNotification object:nil queue:nil usingBlock:invalidate];
+    });
+    
+    NSMutableDictionary *threadDictionary = [[NSThread currentThread] threadDictionary];
+    NSMutableDictionary *cache = [threadDictionary objectForKey:IGDateFormatterCacheKey];
+    NSNumber *generation = @(IGDateFormatterCacheGeneration);
+    if (!cache || ![[cache objectForKey:IGDateFormatterCacheGenerationKey] isEqualToNumber:generation])
+    {
+        cache = [NSMutableDictionary dictionaryWithObject:generation forKey:IGDateFormatterCacheGenerationKey];
+        [threadDictionary setObject:cache forKey:IGDateFormatterCacheKey];
+    }
+    
+    return cache;
+}
+
++ (NSDateFormatter *)cachedDateFormatterWithFormat:(NSString *)format
+{
+    NSMutableDictionary *cache = [self dateFormatterCache];
+    NSDateFormatter *dateFormatter = [cache objectForKey:format];
+    if (!dateFormatter)
+    {
+        dateFormatter = [[NSDateFormatter alloc] init];
+        [dateFormatter setDateFormat:format];
+        [cache setObject:dateFormatter forKey:format];
+    }
+    
+    return dateFormatter;
+}
+
+- (NSString *)displayStringWithFormat:(NSString *)format
+{
+    return [[NSDate cachedDateFormatterWithFormat:format] stringFromDate:self];
+}
+
+@end
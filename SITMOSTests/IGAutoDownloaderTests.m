@@ -0,0 +1,110 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGAutoDownloader.h"
+#import "IGEpisodeStorage.h"
+#import <SenTestingKit/SenTestingKit.h>
+
+#define HC_SHORTHAND
+#import <OCHamcrestIOS/OCHamcrestIOS.h>
+
+static NSString * const IGAutoDownloaderTestsHistoryKey = @"IGAutoDownloaderTestsHistory";
+
+@interface IGAutoDownloaderTests : SenTestCase
+@end
+
+@implementation IGAutoDownloaderTests {
+    NSURL *_directory;
+    IGEpisodeStorage *_storage;
+    IGAutoDownloader *_autoDownloader;
+    NSArray *_downloadURLs;
+}
+
+- (void)setUp {
+    [super setUp];
+    
+    _directory = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:@"IGAutoDownloaderTests"]];
+    [[NSFileManager defaultManager] removeItemAtURL:_directory error:nil];
+    [[NSFileManager defaultManager] createDirectoryAtURL:_directory withIntermediateDirectories:YES attributes:nil error:nil];
+    _storage = [[IGEpisodeStorage alloc] initWithDirectory:_directory
+                                                  indexURL:[_directory URLByAppendingPathComponent:@"Index.plist"]];
+    [[NSUserDefaults standardUserDefaults] removeObjectForKey:IGAutoDownloaderTestsHistoryKey];
+    _autoDownloader = [[IGAutoDownloader alloc] initWithEpisodeStorage:_storage historyKey:IGAutoDownloaderTestsHistoryKey];
+    _downloadURLs = @[[NSURL URLWithString:@"http://example.com/1.mp3"],
+                      [NSURL URLWithString:@"http://example.com/2.mp3"],
+                      [NSURL URLWithString:@"http://example.com/3.mp3"],
+                      [NSURL URLWithString:@"http://example.com/4.mp3"]];
+}
+
+- (void)tearDown {
+    _autoDownloader = nil;
+    _storage = nil;
+    [[NSUserDefaults standardUserDefaults] removeObjectForKey:IGAutoDownloaderTestsHistoryKey];
+    [[NSFileManager defaultManager] removeItemAtURL:_directory error:nil];
+    
+    [super tearDown];
+}
+
+- (void)testNewestEpisodesAreQueuedUpToTheLimit {
+    NSArray *downloadURLs = [_autoDownloader downloadURLsToQueueFromURLs:_downloadURLs fileSizes:@[@1000, @0, @1000, @1000]];
+    
+    assertThat(downloadURLs, contains(_downloadURLs[0], _downloadURLs[1], _downloadURLs[2], nil));
+}
+
+- (void)testEpisodesThatDoNotFitInTheBudgetAreSkipped {
+    [_storage recordFileWithName:@"unplayed.mp3" size:1000];
+    _storage.budget = 3000;
+    
+    NSArray *downloadURLs = [_autoDownloader downloadURLsToQueueFromURLs:_downloadURLs fileSizes:@[@1500, @1000, @0, @1000]];
+    
+    assertThat(downloadURLs, contains(_downloadURLs[0], nil));
+}
+
+- (void)testPlayedEpisodesDoNotCountAgainstTheBudget {
+    [_storage recordFileWithName:@"played.mp3" size:2000];
+    [_storage recordPlayed:YES forFileWithName:@"played.mp3"];
+    _storage.budget = 2000;
+    
+    NSArray *downloadURLs = [_autoDownloader downloadURLsToQueueFromURLs:_downloadURLs fileSizes:@[@1000, @1000, @1000, @1000]];
+    
+    assertThat(downloadURLs, contains(_downloadURLs[0], _downloadURLs[1], nil));
+}
+
+- (void)testFetchHistoryIsRecorded {
+    _autoDownloader.fetchTimeBudget = 20;
+    [_autoDownloader recordFetchWithDuration:5 result:UIBackgroundFetchResultNewData];
+    [_autoDownloader recordFetchWithDuration:15 result:UIBackgroundFetchResultNoData];
+    [_autoDownloader recordFetchWithDuration:40 result:UIBackgroundFetchResultFailed];
+    [_autoDownloader recordFetchWithDuration:0 result:UIBackgroundFetchResultNoData];
+    
+    assertThatUnsignedInteger([_autoDownloader numberOfRecordedFetches], equalToUnsignedInteger(4));
+    assertThatDouble([_autoDownloader averageFetchTimeBudgetUsage], closeTo(0.5, 0.001));
+    assertThatDouble([_autoDownloader newDataRate], closeTo(0.25, 0.001));
+}
+
+- (void)testFetchHistoryKeepsTheMostRecentFetches {
+    for (NSUInteger i = 0; i < 60; i++)
+        [_autoDownloader recordFetchWithDuration:1 result:UIBackgroundFetchResultNoData];
+    
+    assertThatUnsignedInteger([_autoDownloader numberOfRecordedFetches], equalToUnsignedInteger(50));
+}
+
+@end
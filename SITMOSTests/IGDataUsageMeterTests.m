@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGDataUsageMeter.h"
+#import <SenTestingKit/SenTestingKit.h>
+
+#define HC_SHORTHAND
+#import <OCHamcrestIOS/OCHamcrestIOS.h>
+
+static NSString * const IGDataUsageMeterTestsUsageKey = @"IGDataUsageMeterTestsUsage";
+
+@interface IGDataUsageMeterTests : SenTestCase
+@end
+
+@implementation IGDataUsageMeterTests {
+    IGDataUsageMeter *_meter;
+}
+
+- (void)setUp {
+    [super setUp];
+    
+    [[NSUserDefaults standardUserDefaults] removeObjectForKey:IGDataUsageMeterTestsUsageKey];
+    _meter = [[IGDataUsageMeter alloc] initWithUsageKey:IGDataUsageMeterTestsUsageKey];
+}
+
+- (void)tearDown {
+    _meter = nil;
+    [[NSUserDefaults standardUserDefaults] removeObjectForKey:IGDataUsageMeterTestsUsageKey];
+    
+    [super tearDown];
+}
+
+- (NSDate *)dateWithYear:(NSInteger)year month:(NSInteger)month day:(NSInteger)day {
+    NSDateComponents *components = [[NSDateComponents alloc] init];
+    [components setYear:year];
+    [components setMonth:month];
+    [components setDay:day];
+    return [[NSCalendar currentCalendar] dateFromComponents:components];
+}
+
+- (void)testBytesAreCountedPerNetwork {
+    [_meter recordBytes:1000 onNetwork:IGDownloadNetworkWiFi];
+    [_meter recordBytes:300 onNetwork:IGDownloadNetworkCellular];
+    [_meter recordBytes:200 onNetwork:IGDownloadNetworkCellular];
+    
+    assertThatLongLong([_meter bytesUsedOnNetwork:IGDownloadNetworkWiFi], equalToLongLong(1000));
+    assertThatLongLong([_meter bytesUsedOnNetwork:IGDownloadNetworkCellular], equalToLongLong(500));
+}
+
+- (void)testCountsArePersisted {
+    [_meter recordBytes:300 onNetwork:IGDownloadNetworkCellular];
+    
+    IGDataUsageMeter *meter = [[IGDataUsageMeter alloc] initWithUsageKey:IGDataUsageMeterTestsUsageKey];
+    assertThatLongLong([meter bytesUsedOnNetwork:IGDownloadNetworkCellular], equalToLongLong(300));
+}
+
+- (void)testCountsStartOverEachMonth {
+    NSDate *october = [self dateWithYear:2026 month:10 day:31];
+    NSDate *november = [self dateWithYear:2026 month:11 day:1];
+    [_meter recordBytes:300 onNetwork:IGDownloadNetworkCellular date:october];
+    [_meter recordBytes:100 onNetwork:IGDownloadNetworkCellular date:november];
+    // Late news of the month before is dropped.
+    [_meter recordBytes:50 onNetwork:IGDownloadNetworkCellular date:october];
+    
+    assertThatLongLong([_meter bytesUsedOnNetwork:IGDownloadNetworkCellular inMonthOfDate:november], equalToLongLong(100));
+    assertThatLongLong([_meter bytesUsedOnNetwork:IGDownloadNetworkCellular inMonthOfDate:october], equalToLongLong(0));
+}
+
+- (void)testMonthlyCellularLimit {
+    assertThatBool([_meter isMonthlyCellularLimitReached], equalToBool(NO));
+    
+    _meter.monthlyCellularLimit = 1000;
+    [_meter recordBytes:5000 onNetwork:IGDownloadNetworkWiFi];
+    [_meter recordBytes:999 onNetwork:IGDownloadNetworkCellular];
+    assertThatBool([_meter isMonthlyCellularLimitReached], equalToBool(NO));
+    
+    [_meter recordBytes:1 onNetwork:IGDownloadNetworkCellular];
+    assertThatBool([_meter isMonthlyCellularLimitReached], equalToBool(YES));
+}
+
+@end
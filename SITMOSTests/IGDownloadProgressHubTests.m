@@ -0,0 +1,165 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGDownloadProgressHub.h"
+#import <SenTestingKit/SenTestingKit.h>
+
+#define HC_SHORTHAND
+#import <OCHamcrestIOS/OCHamcrestIOS.h>
+
+@interface IGDownloadProgressTestObserver : NSObject <IGDownloadProgressObserver>
+@property (nonatomic, strong) NSMutableArray *snapshots;
+@end
+
+@implementation IGDownloadProgressTestObserver
+
+- (id)init {
+    if (!(self = [super init])) return nil;
+    
+    _snapshots = [[NSMutableArray alloc] init];
+    
+    return self;
+}
+
+- (void)downloadProgressDidChange:(IGDownloadProgressSnapshot *)progress {
+    [_snapshots addObject:progress];
+}
+
+@end
+
+@interface IGDownloadProgressHubTests : SenTestCase
+@end
+
+@implementation IGDownloadProgressHubTests {
+    NSMutableDictionary *_progressByURL;
+    IGDownloadProgressHub *_hub;
+    NSURL *_downloadURL;
+}
+
+- (void)setUp {
+    [super setUp];
+    
+    _progressByURL = [[NSMutableDictionary alloc] init];
+    _downloadURL = [NSURL URLWithString:@"http://example.com/episode.mp3"];
+    
+    __weak NSMutableDictionary *progressByURL = _progressByURL;
+    _hub = [[IGDownloadProgressHub alloc] initWithProgressProvider:^IGDownloadProgressSnapshot *(NSURL *downloadURL) {
+        return [progressByURL objectForKey:downloadURL];
+    }];
+}
+
+- (void)tearDown {
+    _hub = nil;
+    _progressByURL = nil;
+    
+    [super tearDown];
+}
+
+- (void)setState:(IGDownloadProgressState)state received:(int64_t)received expected:(int64_t)expected {
+    IGDownloadProgressSnapshot *snapshot = [[IGDownloadProgressSnapshot alloc] initWithDownloadURL:_downloadURL
+                                                                                             state:state
+                                                                              countOfBytesReceived:received
+                                                                     countOfBytesExpectedToReceive:expected];
+    [_progressByURL setObject:snapshot forKey:_downloadURL];
+}
+
+- (void)testCurrentProgressIsDeliveredWhenObserverIsAdded {
+    [self setState:IGDownloadProgressStateSuspended received:512 expected:1024];
+    
+    IGDownloadProgressTestObserver *observer = [[IGDownloadProgressTestObserver alloc] init];
+    [_hub addObserver:observer forURL:_downloadURL];
+    
+    assertThatUnsignedInteger([observer.snapshots count], equalToUnsignedInteger(1));
+    IGDownloadProgressSnapshot *snapshot = [observer.snapshots lastObject];
+    assertThatInteger(snapshot.state, equalToInteger(IGDownloadProgressStateSuspended));
+    assertThatDouble([snapshot fractionCompleted], equalToDouble(0.5));
+    
+    [_hub removeObserver:observer forURL:_downloadURL];
+}
+
+- (void)testUnknownDownloadIsDeliveredAsNotRunning {
+    IGDownloadProgressTestObserver *observer = [[IGDownloadProgressTestObserver alloc] init];
+    [_hub addObserver:observer forURL:_downloadURL];
+    
+    IGDownloadProgressSnapshot *snapshot = [observer.snapshots lastObject];
+    assertThatInteger(snapshot.state, equalToInteger(IGDownloadProgressStateNone));
+    assertThat(snapshot.downloadURL, equalTo(_downloadURL));
+    
+    [_hub removeObserver:observer forURL:_downloadURL];
+}
+
+- (void)testOnlyChangedProgressIsDelivered {
+    [self setState:IGDownloadProgressStateSuspended received:0 expected:1024];
+    
+    IGDownloadProgressTestObserver *observer = [[IGDownloadProgressTestObserver alloc] init];
+    [_hub addObserver:observer forURL:_downloadURL];
+    
+    [_hub setNeedsUpdate];
+    assertThatUnsignedInteger([observer.snapshots count], equalToUnsignedInteger(1));
+    
+    [self setState:IGDownloadProgressStateSuspended received:256 expected:1024];
+    [_hub setNeedsUpdate];
+    [_hub setNeedsUpdate];
+    assertThatUnsignedInteger([observer.snapshots count], equalToUnsignedInteger(2));
+    assertThatLongLong([[observer.snapshots lastObject] countOfBytesReceived], equalToLongLong(256));
+    
+    [_hub removeObserver:observer forURL:_downloadURL];
+}
+
+- (void)testProgressIsOnlyDeliveredToObserversOfTheURL {
+    NSURL *otherURL = [NSURL URLWithString:@"http://example.com/other.mp3"];
+    IGDownloadProgressTestObserver *observer = [[IGDownloadProgressTestObserver alloc] init];
+    IGDownloadProgressTestObserver *otherObserver = [[IGDownloadProgressTestObserver alloc] init];
+    [_hub addObserver:observer forURL:_downloadURL];
+    [_hub addObserver:otherObserver forURL:otherURL];
+    
+    [self setState:IGDownloadProgressStateWaiting received:0 expected:0];
+    [_hub setNeedsUpdate];
+    
+    assertThatUnsignedInteger([observer.snapshots count], equalToUnsignedInteger(2));
+    assertThatUnsignedInteger([otherObserver.snapshots count], equalToUnsignedInteger(1));
+    
+    [_hub removeObserver:observer forURL:_downloadURL];
+    [_hub removeObserver:otherObserver forURL:otherURL];
+}
+
+- (void)testRemovedObserverReceivesNothing {
+    IGDownloadProgressTestObserver *observer = [[IGDownloadProgressTestObserver alloc] init];
+    [_hub addObserver:observer forURL:_downloadURL];
+    [_hub removeObserver:observer forURL:_downloadURL];
+    
+    [self setState:IGDownloadProgressStateSuspended received:128 expected:1024];
+    [_hub setNeedsUpdate];
+    
+    assertThatUnsignedInteger([observer.snapshots count], equalToUnsignedInteger(1));
+}
+
+- (void)testSnapshotEquality {
+    IGDownloadProgressSnapshot *snapshot = [[IGDownloadProgressSnapshot alloc] initWithDownloadURL:_downloadURL state:IGDownloadProgressStateRunning countOfBytesReceived:10 countOfBytesExpectedToReceive:100];
+    IGDownloadProgressSnapshot *sameSnapshot = [[IGDownloadProgressSnapshot alloc] initWithDownloadURL:_downloadURL state:IGDownloadProgressStateRunning countOfBytesReceived:10 countOfBytesExpectedToReceive:100];
+    IGDownloadProgressSnapshot *suspendedSnapshot = [[IGDownloadProgressSnapshot alloc] initWithDownloadURL:_downloadURL state:IGDownloadProgressStateSuspended countOfBytesReceived:10 countOfBytesExpectedToReceive:100];
+    
+    assertThatBool([snapshot isEqualToSnapshot:sameSnapshot], equalToBool(YES));
+    assertThat(snapshot, equalTo(sameSnapshot));
+    assertThatBool([snapshot isEqualToSnapshot:suspendedSnapshot], equalToBool(NO));
+}
+
+@end
@@ -0,0 +1,254 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGDownloadScheduler.h"
+#import <SenTestingKit/SenTestingKit.h>
+
+#define HC_SHORTHAND
+#import <OCHamcrestIOS/OCHamcrestIOS.h>
+
+static NSString * const IGDownloadSchedulerTestsQueueKey = @"DownloadSchedulerTestsQueue";
+
+@interface IGDownloadSchedulerTests : SenTestCase
+@end
+
+@implementation IGDownloadSchedulerTests {
+    IGDownloadScheduler *_scheduler;
+    NSMutableArray *_startedURLs;
+}
+
+- (void)setUp {
+    [super setUp];
+    
+    [[NSUserDefaults standardUserDefaults] removeObjectForKey:IGDownloadSchedulerTestsQueueKey];
+    
+    _startedURLs = [NSMutableArray array];
+    _scheduler = [self schedulerRecordingStartedURLs];
+    [_scheduler restoreQueueWithRunningDownloadURLs:@[]];
+}
+
+- (void)tearDown {
+    [[NSUserDefaults standardUserDefaults] removeObjectForKey:IGDownloadSchedulerTestsQueueKey];
+    _scheduler = nil;
+    _startedURLs = nil;
+    
+    [super tearDown];
+}
+
+- (IGDownloadScheduler *)schedulerRecordingStartedURLs {
+    IGDownloadScheduler *scheduler = [[IGDownloadScheduler alloc] initWithQueueStateKey:IGDownloadSchedulerTestsQueueKey];
+    __weak NSMutableArray *startedURLs = _startedURLs;
+    [scheduler setStartDownloadBlock:^(NSURL *downloadURL, NSURL *destinationURL) {
+        [startedURLs addObject:downloadURL];
+    }];
+    return scheduler;
+}
+
+- (NSURL *)URLForEpisode:(NSUInteger)episode {
+    return [NSURL URLWithString:[NSString stringWithFormat:@"https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_%lu.mp3", (unsigned long)episode]];
+}
+
+- (void)enqueueEpisode:(NSUInteger)episode priority:(IGDownloadPriority)priority {
+    [_scheduler enqueueDownloadWithURL:[self URLForEpisode:episode]
+                        destinationURL:[NSURL fileURLWithPath:[NSString stringWithFormat:@"/tmp/%lu.mp3", (unsigned long)episode]]
+                              priority:priority
+                            completion:nil];
+}
+
+- (void)enqueueEpisode:(NSUInteger)episode allowsCellularAccess:(BOOL)allowsCellularAccess {
+    [_scheduler enqueueDownloadWithURL:[self URLForEpisode:episode]
+                        destinationURL:nil
+                              priority:IGDownloadPriorityUserRequested
+                  allowsCellularAccess:allowsCellularAccess
+                            completion:nil];
+}
+
+- (void)testOnlyMaximumConcurrentDownloadsAreStarted {
+    for (NSUInteger i = 1; i <= 5; i++) {
+        [self enqueueEpisode:i priority:IGDownloadPriorityUserRequested];
+    }
+    
+    assertThat(_startedURLs, contains([self URLForEpisode:1], [self URLForEpisode:2], nil));
+    assertThatInteger([[_scheduler queuedDownloadURLs] count], equalToInteger(5));
+}
+
+- (void)testFinishingADownloadStartsTheNextWaitingDownload {
+    for (NSUInteger i = 1; i <= 3; i++) {
+        [self enqueueEpisode:i priority:IGDownloadPriorityUserRequested];
+    }
+    [_scheduler finishDownloadWithURL:[self URLForEpisode:1] success:YES error:nil];
+    
+    assertThat(_startedURLs, contains([self URLForEpisode:1], [self URLForEpisode:2], [self URLForEpisode:3], nil));
+    assertThatBool([_scheduler isDownloadQueuedWithURL:[self URLForEpisode:1]], equalToBool(NO));
+}
+
+- (void)testUserRequestedDownloadsAreStartedBeforeAutomaticDownloads {
+    _scheduler.maximumConcurrentDownloads = 1;
+    [self enqueueEpisode:1 priority:IGDownloadPriorityAutomatic];
+    [self enqueueEpisode:2 priority:IGDownloadPriorityAutomatic];
+    [self enqueueEpisode:3 priority:IGDownloadPriorityUserRequested];
+    
+    // Episode 1 is suspended to make room for the user requested download.
+    assertThat([_scheduler runningDownloadURLs], contains([self URLForEpisode:3], nil));
+    assertThat([_scheduler queuedDownloadURLs], contains([self URLForEpisode:3], [self URLForEpisode:1], [self URLForEpisode:2], nil));
+}
+
+- (void)testPreemptedTransferThatIsStoppedIsNotStartedAgainUntilItHasReportedBack {
+    NSMutableArray *suspendedURLs = [NSMutableArray array];
+    [_scheduler setSuspendDownloadBlock:^BOOL(NSURL *downloadURL) {
+        [suspendedURLs addObject:downloadURL];
+        return YES;
+    }];
+    _scheduler.maximumConcurrentDownloads = 1;
+    [self enqueueEpisode:1 priority:IGDownloadPriorityAutomatic];
+    [self enqueueEpisode:2 priority:IGDownloadPriorityUserRequested];
+    
+    assertThat(suspendedURLs, contains([self URLForEpisode:1], nil));
+    assertThat([_scheduler runningDownloadURLs], contains([self URLForEpisode:2], nil));
+    
+    // The slot frees up while the stopped transfer of episode 1 is still winding down.
+    [_scheduler finishDownloadWithURL:[self URLForEpisode:2] success:YES error:nil];
+    assertThat(_startedURLs, contains([self URLForEpisode:1], [self URLForEpisode:2], nil));
+    assertThat([_scheduler runningDownloadURLs], isEmpty());
+    
+    [_scheduler finishDownloadWithURL:[self URLForEpisode:1] success:NO error:nil];
+    assertThat(_startedURLs, contains([self URLForEpisode:1], [self URLForEpisode:2], [self URLForEpisode:1], nil));
+    assertThat([_scheduler runningDownloadURLs], contains([self URLForEpisode:1], nil));
+}
+
+- (void)testPrioritizedDownloadIsStartedNext {
+    _scheduler.maximumConcurrentDownloads = 1;
+    for (NSUInteger i = 1; i <= 4; i++) {
+        [self enqueueEpisode:i priority:IGDownloadPriorityUserRequested];
+    }
+    [_scheduler prioritizeDownloadWithURL:[self URLForEpisode:4]];
+    
+    assertThat([_scheduler runningDownloadURLs], contains([self URLForEpisode:4], nil));
+    assertThat([_startedURLs lastObject], equalTo([self URLForEpisode:4]));
+}
+
+- (void)testCompletionBlocksAreExecutedWhenDownloadFinishes {
+    __block NSUInteger completions = 0;
+    for (NSUInteger i = 0; i < 2; i++) {
+        [_scheduler enqueueDownloadWithURL:[self URLForEpisode:1] destinationURL:nil priority:IGDownloadPriorityUserRequested completion:^(BOOL success, NSError *error) {
+            completions++;
+        }];
+    }
+    [_scheduler finishDownloadWithURL:[self URLForEpisode:1] success:YES error:nil];
+    
+    assertThatUnsignedInteger(completions, equalToUnsignedInteger(2));
+    assertThat(_startedURLs, contains([self URLForEpisode:1], nil));
+}
+
+- (void)testNothingIsStartedBeforeTheQueueIsRestored {
+    IGDownloadScheduler *scheduler = [self schedulerRecordingStartedURLs];
+    [scheduler enqueueDownloadWithURL:[self URLForEpisode:1] destinationURL:nil priority:IGDownloadPriorityUserRequested completion:nil];
+    
+    assertThat(_startedURLs, isEmpty());
+    
+    [scheduler restoreQueueWithRunningDownloadURLs:@[]];
+    
+    assertThat(_startedURLs, contains([self URLForEpisode:1], nil));
+}
+
+- (void)testQueueIsRestoredInPriorityOrder {
+    _scheduler.maximumConcurrentDownloads = 1;
+    [self enqueueEpisode:1 priority:IGDownloadPriorityAutomatic];
+    [self enqueueEpisode:2 priority:IGDownloadPriorityUserRequested];
+    [self enqueueEpisode:3 priority:IGDownloadPriorityAutomatic];
+    
+    [_startedURLs removeAllObjects];
+    IGDownloadScheduler *restoredScheduler = [self schedulerRecordingStartedURLs];
+    restoredScheduler.maximumConcurrentDownloads = 1;
+    [restoredScheduler restoreQueueWithRunningDownloadURLs:@[[self URLForEpisode:2]]];
+    
+    assertThat([restoredScheduler queuedDownloadURLs], contains([self URLForEpisode:2], [self URLForEpisode:1], [self URLForEpisode:3], nil));
+    assertThat([restoredScheduler runningDownloadURLs], contains([self URLForEpisode:2], nil));
+    // The transfer still running in the background session is not started again.
+    assertThat(_startedURLs, isEmpty());
+}
+
+- (void)testWiFiOnlyDownloadsAreParkedOnCellular {
+    NSMutableArray *parkedURLs = [NSMutableArray array];
+    [_scheduler setParkDownloadBlock:^BOOL(NSURL *downloadURL) {
+        [parkedURLs addObject:downloadURL];
+        return YES;
+    }];
+    _scheduler.maximumConcurrentDownloads = 3;
+    [self enqueueEpisode:1 allowsCellularAccess:NO];
+    [self enqueueEpisode:2 allowsCellularAccess:YES];
+    [self enqueueEpisode:3 allowsCellularAccess:YES];
+    
+    _scheduler.network = IGDownloadNetworkCellular;
+    
+    assertThat(parkedURLs, contains([self URLForEpisode:1], nil));
+    assertThat([_scheduler runningDownloadURLs], contains([self URLForEpisode:2], [self URLForEpisode:3], nil));
+    assertThatBool([_scheduler isDownloadParkedWithURL:[self URLForEpisode:1]], equalToBool(YES));
+    
+    // Not started again until the stopped transfer has reported back.
+    [_startedURLs removeAllObjects];
+    _scheduler.network = IGDownloadNetworkWiFi;
+    assertThat(_startedURLs, isEmpty());
+    
+    [_scheduler finishDownloadWithURL:[self URLForEpisode:1] success:NO error:nil];
+    assertThat(_startedURLs, contains([self URLForEpisode:1], nil));
+}
+
+- (void)testEveryDownloadIsParkedWhenCellularDataIsNotAllowed {
+    [_scheduler setParkDownloadBlock:^BOOL(NSURL *downloadURL) {
+        return NO;
+    }];
+    _scheduler.network = IGDownloadNetworkCellular;
+    [self enqueueEpisode:1 allowsCellularAccess:YES];
+    
+    _scheduler.cellularDataAllowed = NO;
+    assertThat([_scheduler runningDownloadURLs], isEmpty());
+    
+    // Queueing it to use cellular data again does not lift the limit.
+    [self enqueueEpisode:1 allowsCellularAccess:YES];
+    assertThat([_scheduler runningDownloadURLs], isEmpty());
+    
+    _scheduler.cellularDataAllowed = YES;
+    assertThat([_scheduler runningDownloadURLs], contains([self URLForEpisode:1], nil));
+}
+
+- (void)testQueueingAParkedDownloadForCellularStartsIt {
+    _scheduler.network = IGDownloadNetworkCellular;
+    [self enqueueEpisode:1 allowsCellularAccess:NO];
+    assertThat(_startedURLs, isEmpty());
+    
+    [self enqueueEpisode:1 allowsCellularAccess:YES];
+    assertThat(_startedURLs, contains([self URLForEpisode:1], nil));
+}
+
+- (void)testAllowedNetworkIsRestored {
+    _scheduler.network = IGDownloadNetworkCellular;
+    [self enqueueEpisode:1 allowsCellularAccess:NO];
+    
+    IGDownloadScheduler *restoredScheduler = [self schedulerRecordingStartedURLs];
+    restoredScheduler.network = IGDownloadNetworkCellular;
+    [restoredScheduler restoreQueueWithRunningDownloadURLs:@[]];
+    
+    assertThatBool([restoredScheduler isDownloadParkedWithURL:[self URLForEpisode:1]], equalToBool(YES));
+    assertThat(_startedURLs, isEmpty());
+}
+
+@end
@@ -0,0 +1,125 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGDownloadTaskRegistry.h"
+#import <SenTestingKit/SenTestingKit.h>
+
+#define HC_SHORTHAND
+#import <OCHamcrestIOS/OCHamcrestIOS.h>
+
+@interface IGDownloadTaskRegistryTests : SenTestCase
+@end
+
+@implementation IGDownloadTaskRegistryTests {
+    IGDownloadTaskRegistry *_registry;
+    NSURLSession *_session;
+}
+
+- (void)setUp {
+    [super setUp];
+    
+    _registry = [[IGDownloadTaskRegistry alloc] init];
+    _session = [NSURLSession sessionWithConfiguration:[NSURLSessionConfiguration ephemeralSessionConfiguration]];
+}
+
+- (void)tearDown {
+    [_session invalidateAndCancel];
+    _session = nil;
+    _registry = nil;
+    
+    [super tearDown];
+}
+
+- (NSURLSessionDownloadTask *)downloadTaskForURLString:(NSString *)URLString {
+    return [_session downloadTaskWithURL:[NSURL URLWithString:URLString]];
+}
+
+- (void)testRegisteredTaskIsFoundByURL {
+    NSURLSessionDownloadTask *task = [self downloadTaskForURLString:@"http://example.com/episode1.mp3"];
+    [_registry registerDownloadTask:task];
+    
+    assertThat([_registry downloadTaskForURL:[NSURL URLWithString:@"http://example.com/episode1.mp3"]], sameInstance(task));
+    assertThat([_registry downloadTaskForURL:[NSURL URLWithString:@"http://example.com/episode2.mp3"]], nilValue());
+    assertThat([_registry downloadTasks], contains(task, nil));
+}
+
+- (void)testUnregisteredTaskIsRemoved {
+    NSURLSessionDownloadTask *task = [self downloadTaskForURLString:@"http://example.com/episode1.mp3"];
+    [_registry registerDownloadTask:task];
+    [_registry unregisterTask:task];
+    
+    assertThat([_registry downloadTaskForURL:[[task originalRequest] URL]], nilValue());
+    assertThat([_registry downloadTasks], isEmpty());
+}
+
+- (void)testUnregisteringAReplacedTaskKeepsTheNewerTask {
+    NSURLSessionDownloadTask *oldTask = [self downloadTaskForURLString:@"http://example.com/episode1.mp3"];
+    NSURLSessionDownloadTask *newTask = [self downloadTaskForURLString:@"http://example.com/episode1.mp3"];
+    [_registry registerDownloadTask:oldTask];
+    [_registry registerDownloadTask:newTask];
+    [_registry unregisterTask:oldTask];
+    
+    assertThat([_registry downloadTaskForURL:[[newTask originalRequest] URL]], sameInstance(newTask));
+}
+
+- (void)testRebuildingKeepsRegisteredTasksAndSkipsCompletedTasks {
+    NSURLSessionDownloadTask *registeredTask = [self downloadTaskForURLString:@"http://example.com/episode1.mp3"];
+    NSURLSessionDownloadTask *restoredTask = [self downloadTaskForURLString:@"http://example.com/episode1.mp3"];
+    NSURLSessionDownloadTask *suspendedTask = [self downloadTaskForURLString:@"http://example.com/episode2.mp3"];
+    NSURLSessionDownloadTask *cancelledTask = [self downloadTaskForURLString:@"http://example.com/episode3.mp3"];
+    [cancelledTask cancel];
+    
+    [_registry registerDownloadTask:registeredTask];
+    [_registry registerDownloadTasks:@[restoredTask, suspendedTask, cancelledTask]];
+    
+    assertThat([_registry downloadTaskForURL:[[registeredTask originalRequest] URL]], sameInstance(registeredTask));
+    assertThat([_registry downloadTaskForURL:[[suspendedTask originalRequest] URL]], sameInstance(suspendedTask));
+    assertThat([_registry downloadTaskForURL:[[cancelledTask originalRequest] URL]], nilValue());
+}
+
+- (void)testLookupsDoNotWaitOnConcurrentWriters {
+    NSURL *url = [NSURL URLWithString:@"http://example.com/episode1.mp3"];
+    NSURLSessionDownloadTask *task = [_session downloadTaskWithURL:url];
+    [_registry registerDownloadTask:task];
+    
+    dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    dispatch_group_t group = dispatch_group_create();
+    for (NSUInteger i = 0; i < 100; i++) {
+        dispatch_group_async(group, queue, ^{
+            NSURLSessionDownloadTask *otherTask = [self downloadTaskForURLString:[NSString stringWithFormat:@"http://example.com/other%lu.mp3", (unsigned long)i]];
+            [_registry registerDownloadTask:otherTask];
+            [_registry unregisterTask:otherTask];
+        });
+    }
+    
+    __block NSUInteger misses = 0;
+    for (NSUInteger i = 0; i < 10000; i++) {
+        if ([_registry downloadTaskForURL:url] != task) {
+            misses++;
+        }
+    }
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+    
+    assertThatUnsignedInteger(misses, equalToUnsignedInteger(0));
+    assertThat([_registry downloadTasks], contains(task, nil));
+}
+
+@end
@@ -0,0 +1,197 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGDownloadVerifier.h"
+#import <CommonCrypto/CommonDigest.h>
+#import <SenTestingKit/SenTestingKit.h>
+
+#define HC_SHORTHAND
+#import <OCHamcrestIOS/OCHamcrestIOS.h>
+
+/* MPEG 1 Layer III, 128 kbps, 44.1 kHz, no padding */
+static uint8_t const IGTestFrameHeader[4] = { 0xFF, 0xFB, 0x90, 0x64 };
+static NSUInteger const IGTestFrameLength = 417;
+
+@interface IGDownloadVerifierTests : SenTestCase
+@end
+
+@implementation IGDownloadVerifierTests {
+    NSURL *_fileURL;
+}
+
+- (void)setUp {
+    [super setUp];
+    
+    _fileURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:@"IGDownloadVerifierTests.mp3"]];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtURL:_fileURL error:nil];
+    
+    [super tearDown];
+}
+
+- (NSData *)episodeDataWithFrameCount:(NSUInteger)frameCount {
+    NSMutableData *episodeData = [NSMutableData data];
+    uint8_t ID3Header[10] = { 'I', 'D', '3', 4, 0, 0, 0, 0, 0, 100 };
+    [episodeData appendBytes:ID3Header length:sizeof(ID3Header)];
+    [episodeData increaseLengthBy:100];
+    
+    NSMutableData *frame = [NSMutableData dataWithLength:IGTestFrameLength];
+    memset([frame mutableBytes], 0x55, IGTestFrameLength);
+    memcpy([frame mutableBytes], IGTestFrameHeader, sizeof(IGTestFrameHeader));
+    for (NSUInteger i = 0; i < frameCount; i++) {
+        [episodeData appendData:frame];
+    }
+    return episodeData;
+}
+
+- (NSData *)MD5OfData:(NSData *)data {
+    NSMutableData *MD5 = [NSMutableData dataWithLength:CC_MD5_DIGEST_LENGTH];
+    CC_MD5([data bytes], (CC_LONG)[data length], [MD5 mutableBytes]);
+    return MD5;
+}
+
+- (void)testValidEpisodePassesVerification {
+    NSData *episodeData = [self episodeDataWithFrameCount:500];
+    [episodeData writeToURL:_fileURL atomically:YES];
+    
+    IGDownloadVerification *verification = [IGDownloadVerifier verifyFileAtURL:_fileURL
+                                                                 expectedLength:[episodeData length]
+                                                                    expectedMD5:[self MD5OfData:episodeData]
+                                                                          error:nil];
+    
+    assertThatBool([verification isValid], equalToBool(YES));
+    assertThatBool([verification frameSyncChecked], equalToBool(YES));
+    assertThat([verification contentMD5], equalTo([self MD5OfData:episodeData]));
+}
+
+- (void)testTruncatedEpisodeIsMissingItsEnd {
+    NSData *episodeData = [self episodeDataWithFrameCount:500];
+    NSData *truncatedData = [episodeData subdataWithRange:NSMakeRange(0, 100000)];
+    [truncatedData writeToURL:_fileURL atomically:YES];
+    
+    IGDownloadVerification *verification = [IGDownloadVerifier verifyFileAtURL:_fileURL
+                                                                 expectedLength:[episodeData length]
+                                                                    expectedMD5:nil
+                                                                          error:nil];
+    
+    assertThatBool([verification isValid], equalToBool(NO));
+    assertThatBool([[verification corruptRanges] containsIndexesInRange:NSMakeRange(100000, [episodeData length] - 100000)], equalToBool(YES));
+    assertThatBool([[verification corruptRanges] containsIndex:50000], equalToBool(NO));
+}
+
+- (void)testLostFrameSyncMarksOnlyTheDamagedRange {
+    NSMutableData *episodeData = [[self episodeDataWithFrameCount:500] mutableCopy];
+    NSRange holeRange = NSMakeRange(60000, 20000);
+    memset((uint8_t *)[episodeData mutableBytes] + holeRange.location, 0, holeRange.length);
+    [episodeData writeToURL:_fileURL atomically:YES];
+    
+    IGDownloadVerification *verification = [IGDownloadVerifier verifyFileAtURL:_fileURL
+                                                                 expectedLength:[episodeData length]
+                                                                    expectedMD5:nil
+                                                                          error:nil];
+    
+    NSIndexSet *corruptRanges = [verification corruptRanges];
+    assertThatBool([verification isValid], equalToBool(NO));
+    assertThatBool([corruptRanges containsIndexesInRange:holeRange], equalToBool(YES));
+    assertThatUnsignedInteger([corruptRanges count], lessThan(@(holeRange.length + 2 * IGTestFrameLength)));
+}
+
+- (void)testOtherMediaOnlyHasItsLengthChecked {
+    NSMutableData *episodeData = [NSMutableData dataWithLength:100000];
+    memset([episodeData mutableBytes], 0x55, [episodeData length]);
+    [episodeData writeToURL:_fileURL atomically:YES];
+    
+    IGDownloadVerification *verification = [IGDownloadVerifier verifyFileAtURL:_fileURL
+                                                                 expectedLength:[episodeData length]
+                                                                    expectedMD5:nil
+                                                                          error:nil];
+    
+    assertThatBool([verification frameSyncChecked], equalToBool(NO));
+    assertThatBool([verification isValid], equalToBool(YES));
+}
+
+- (void)testTrailingAPETagIsNotCorruption {
+    NSMutableData *episodeData = [[self episodeDataWithFrameCount:500] mutableCopy];
+    NSMutableData *APETag = [NSMutableData dataWithLength:20000];
+    uint8_t footer[32] = { 'A', 'P', 'E', 'T', 'A', 'G', 'E', 'X', 0xD0, 0x07, 0, 0, 0x20, 0x4E, 0, 0 };
+    [APETag replaceBytesInRange:NSMakeRange([APETag length] - sizeof(footer), sizeof(footer)) withBytes:footer];
+    [episodeData appendData:APETag];
+    [episodeData writeToURL:_fileURL atomically:YES];
+    
+    IGDownloadVerification *verification = [IGDownloadVerifier verifyFileAtURL:_fileURL
+                                                                 expectedLength:[episodeData length]
+                                                                    expectedMD5:nil
+                                                                          error:nil];
+    
+    assertThatBool([verification isValid], equalToBool(YES));
+    assertThatUnsignedInteger([verification warnings], equalToUnsignedInteger(0));
+}
+
+- (void)testUnrecognisedTrailingDataIsOnlyAWarning {
+    NSMutableData *episodeData = [[self episodeDataWithFrameCount:500] mutableCopy];
+    [episodeData increaseLengthBy:20000];
+    [episodeData writeToURL:_fileURL atomically:YES];
+    
+    IGDownloadVerification *verification = [IGDownloadVerifier verifyFileAtURL:_fileURL
+                                                                 expectedLength:[episodeData length]
+                                                                    expectedMD5:nil
+                                                                          error:nil];
+    
+    assertThatBool([verification isValid], equalToBool(YES));
+    assertThatUnsignedInteger([verification warnings], equalToUnsignedInteger(IGDownloadVerificationWarningUnrecognisedTrailingData));
+}
+
+- (void)testHashMismatchFailsVerification {
+    NSData *episodeData = [self episodeDataWithFrameCount:100];
+    [episodeData writeToURL:_fileURL atomically:YES];
+    
+    IGDownloadVerification *verification = [IGDownloadVerifier verifyFileAtURL:_fileURL
+                                                                 expectedLength:0
+                                                                    expectedMD5:[self MD5OfData:[NSData dataWithBytes:"sitmos" length:6]]
+                                                                          error:nil];
+    
+    assertThatBool([verification isValid], equalToBool(NO));
+}
+
+- (void)testMissingFileIsAnError {
+    NSError *error = nil;
+    IGDownloadVerification *verification = [IGDownloadVerifier verifyFileAtURL:_fileURL
+                                                                 expectedLength:0
+                                                                    expectedMD5:nil
+                                                                          error:&error];
+    
+    assertThat(verification, nilValue());
+    assertThatInteger([error code], equalToInteger(IGDownloadVerifierErrorFileNotReadable));
+}
+
+- (void)testExpectedLengthOfPartialResponseIsTheWholeFile {
+    NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:[NSURL URLWithString:@"http://example.com/episode.mp3"]
+                                                              statusCode:206
+                                                             HTTPVersion:@"HTTP/1.1"
+                                                            headerFields:@{ @"Content-Range": @"bytes 1000-1999/5000", @"Content-Length": @"1000" }];
+    
+    assertThatLongLong([IGDownloadVerifier expectedLengthOfResponse:response], equalToLongLong(5000));
+    assertThat([IGDownloadVerifier expectedMD5OfResponse:response], nilValue());
+}
+
+@end
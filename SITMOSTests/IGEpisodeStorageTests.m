@@ -0,0 +1,143 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGEpisodeStorage.h"
+#import <SenTestingKit/SenTestingKit.h>
+
+#define HC_SHORTHAND
+#import <OCHamcrestIOS/OCHamcrestIOS.h>
+
+@interface IGEpisodeStorageTests : SenTestCase
+@end
+
+@implementation IGEpisodeStorageTests {
+    NSURL *_directory;
+    NSURL *_indexURL;
+    IGEpisodeStorage *_storage;
+}
+
+- (void)setUp {
+    [super setUp];
+    
+    NSURL *baseURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:@"IGEpisodeStorageTests"]];
+    [[NSFileManager defaultManager] removeItemAtURL:baseURL error:nil];
+    _directory = [baseURL URLByAppendingPathComponent:@"Episodes"];
+    [[NSFileManager defaultManager] createDirectoryAtURL:_directory withIntermediateDirectories:YES attributes:nil error:nil];
+    _indexURL = [baseURL URLByAppendingPathComponent:@"EpisodesStorage.plist"];
+    _storage = [[IGEpisodeStorage alloc] initWithDirectory:_directory indexURL:_indexURL];
+}
+
+- (void)tearDown {
+    _storage = nil;
+    [[NSFileManager defaultManager] removeItemAtURL:[_directory URLByDeletingLastPathComponent] error:nil];
+    
+    [super tearDown];
+}
+
+- (void)saveFileWithName:(NSString *)fileName size:(NSUInteger)size {
+    [[NSMutableData dataWithLength:size] writeToURL:[_directory URLByAppendingPathComponent:fileName] atomically:YES];
+    [_storage recordFileWithName:fileName size:size];
+}
+
+- (BOOL)fileExistsWithName:(NSString *)fileName {
+    return [[NSFileManager defaultManager] fileExistsAtPath:[[_directory URLByAppendingPathComponent:fileName] path]];
+}
+
+- (void)testUsedSizeIsKeptAsFilesComeAndGo {
+    [self saveFileWithName:@"1.mp3" size:1000];
+    [self saveFileWithName:@"2.mp3" size:2000];
+    assertThatLongLong([_storage usedSize], equalToLongLong(3000));
+    
+    [self saveFileWithName:@"1.mp3" size:1500];
+    assertThatLongLong([_storage usedSize], equalToLongLong(3500));
+    
+    [_storage recordRemovalOfFileWithName:@"2.mp3"];
+    assertThatLongLong([_storage usedSize], equalToLongLong(1500));
+}
+
+- (void)testIndexIsRestored {
+    [self saveFileWithName:@"1.mp3" size:1000];
+    
+    IGEpisodeStorage *storage = [[IGEpisodeStorage alloc] initWithDirectory:_directory indexURL:_indexURL];
+    assertThatLongLong([storage usedSize], equalToLongLong(1000));
+}
+
+- (void)testExistingFilesAreRecordedWhenThereIsNoIndex {
+    [[NSMutableData dataWithLength:4000] writeToURL:[_directory URLByAppendingPathComponent:@"old.mp3"] atomically:YES];
+    [[NSFileManager defaultManager] removeItemAtURL:_indexURL error:nil];
+    
+    IGEpisodeStorage *storage = [[IGEpisodeStorage alloc] initWithDirectory:_directory indexURL:_indexURL];
+    assertThatLongLong([storage usedSize], equalToLongLong(4000));
+}
+
+- (void)testReconcileDropsFilesThatHaveGone {
+    [self saveFileWithName:@"1.mp3" size:1000];
+    [self saveFileWithName:@"2.mp3" size:2000];
+    
+    [_storage reconcileWithFileSizes:@{ @"2.mp3": @2000, @"3.mp3": @500 }];
+    assertThatLongLong([_storage usedSize], equalToLongLong(2500));
+}
+
+- (void)testReconcileIgnoresPartialFiles {
+    [self saveFileWithName:@"1.mp3" size:1000];
+    
+    [_storage reconcileWithFileSizes:@{ @"1.mp3": @1000, @"2.mp3.part": @5000 }];
+    assertThatLongLong([_storage usedSize], equalToLongLong(1000));
+}
+
+- (void)testNothingIsRemovedWithoutBudget {
+    [self saveFileWithName:@"1.mp3" size:1000];
+    
+    NSArray *removedFileNames = [_storage enforceBudgetSparingFileNames:nil];
+    assertThat(removedFileNames, isEmpty());
+    assertThatBool([self fileExistsWithName:@"1.mp3"], equalToBool(YES));
+}
+
+- (void)testPlayedEpisodesAreRemovedFirst {
+    [self saveFileWithName:@"old.mp3" size:1000];
+    [self saveFileWithName:@"played.mp3" size:1000];
+    [self saveFileWithName:@"new.mp3" size:1000];
+    [_storage recordPlayed:YES forFileWithName:@"played.mp3"];
+    
+    _storage.budget = 2000;
+    NSArray *removedFileNames = [_storage enforceBudgetSparingFileNames:nil];
+    
+    assertThat(removedFileNames, contains(@"played.mp3", nil));
+    assertThatBool([self fileExistsWithName:@"played.mp3"], equalToBool(NO));
+    assertThatLongLong([_storage usedSize], equalToLongLong(2000));
+}
+
+- (void)testLeastRecentlyUsedEpisodesAreRemovedNext {
+    [self saveFileWithName:@"1.mp3" size:1000];
+    [self saveFileWithName:@"2.mp3" size:1000];
+    [self saveFileWithName:@"3.mp3" size:1000];
+    [NSThread sleepForTimeInterval:0.01];
+    [_storage recordAccessToFileWithName:@"1.mp3"];
+    
+    _storage.budget = 1500;
+    NSArray *removedFileNames = [_storage enforceBudgetSparingFileNames:[NSSet setWithObject:@"3.mp3"]];
+    
+    assertThat(removedFileNames, contains(@"2.mp3", @"1.mp3", nil));
+    assertThatBool([self fileExistsWithName:@"3.mp3"], equalToBool(YES));
+    assertThatLongLong([_storage usedSize], equalToLongLong(1000));
+}
+
+@end
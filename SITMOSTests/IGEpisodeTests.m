@@ -21,8 +21,8 @@
 
 #import "IGEpisode.h"
 
+#import "IGFeedItem.h"
 #import "IGDefines.h"
-#import "NSDate+Helper.h"
 
 #import <SenTestingKit/SenTestingKit.h>
 
@@ -46,8 +46,8 @@
     [NSManagedObjectModel MR_setDefaultManagedObjectModel:[NSManagedObjectModel MR_managedObjectModelNamed:@"SITMOS.momd"]];
     [MagicalRecord setupCoreDataStackWithInMemoryStore];
     
-    NSDictionary *episodeOneFeedItem = @{@"downloadURL": @"https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_1.mp3", @"duration": @"31:15", @"fileSize": @(28900000), @"mediaType": @"audio/mpeg", @"pubDate": @"Tue, 10 Aug 2010 08:00:00 BST", @"title": @"Episode 1", @"summary": @"Achievements, Arizona Immigration Laws, and Annoying Social Networking Apps"};
-    NSDictionary *episodeTwoFeedItem = @{@"downloadURL": @"https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_2.mp3", @"duration": @"36:52", @"fileSize": @(34000000), @"mediaType": @"audio/mpeg", @"pubDate": @"Sat, 21 Aug 2010 08:00:00 BST", @"title": @"Episode 2", @"summary": @"Dr, Laura vs. Dr. Satan, PC Gaming vs. Consoles, Black Ops Sheep and Twitter Questions - So Hide Your Kids, Hide your Wife!"};
+    IGFeedItem *episodeOneFeedItem = [[IGFeedItem alloc] initWithGUID:@"https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_1.mp3" title:@"Episode 1" summary:@"Achievements, Arizona Immigration Laws, and Annoying Social Networking Apps" pubDate:[NSDate dateWithTimeIntervalSince1970:1281423600] fileSize:28900000 duration:1875 downloadURL:@"https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_1.mp3" mediaType:@"audio/mpeg" imageURL:nil];
+    IGFeedItem *episodeTwoFeedItem = [[IGFeedItem alloc] initWithGUID:@"https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_2.mp3" title:@"Episode 2" summary:@"Dr, Laura vs. Dr. Satan, PC Gaming vs. Consoles, Black Ops Sheep and Twitter Questions - So Hide Your Kids, Hide your Wife!" pubDate:[NSDate dateWithTimeIntervalSince1970:1282374000] fileSize:34000000 duration:2212 downloadURL:@"https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_2.mp3" mediaType:@"audio/mpeg" imageURL:nil];
     _feedItems = @[episodeOneFeedItem, episodeTwoFeedItem];
 
     dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
@@ -96,7 +96,7 @@
 }
 
 - (void)testEpisodeOnePubDatePresentedInFeedItemsArrayIsSavedInEpisodeOneEntity {
-    assertThat([_episodeOne pubDate], equalTo([NSDate dateFromString:@"Tue, 10 Aug 2010 08:00:00 BST" withFormat:IGDateFormatString]));
+    assertThat([_episodeOne pubDate], equalTo([NSDate dateWithTimeIntervalSince1970:1281423600])); // Tue, 10 Aug 2010 08:00:00 BST
 }
 
 - (void)testEpisodeOneSummaryPresentedInFeedItemsArrayIsSavedInEpisodeOneEntity {
@@ -134,8 +134,8 @@
 - (void)testWhenTwoNewEpisodesGetSavedBothAreMarkedAsUnplayed {
     dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
     
-    NSDictionary *episodeThreePointFiveFeedItem = @{@"downloadURL": @"https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_3.5.mp3", @"duration": @"40:03", @"fileSize": @(37000000), @"mediaType": @"audio/mpeg", @"pubDate": @"Mon, 6 Sep 2010 08:00:00 BST", @"title": @"Episode 3.5", @"summary": @"War Between New and Used Games, Dead Rising 2 Case:Zero and Shank reviews, Black Ops trash talk take back, banning MMA in Canada and more Pure Pwnage news!"};
-    NSDictionary *episodeFourFeedItem = @{@"downloadURL": @"https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_4.mp3", @"duration": @"32:56", @"fileSize": @(34000000), @"mediaType": @"audio/mpeg", @"pubDate": @"Fri, 17 Sep 2010 08:00:00 BST", @"title": @"Episode 4", @"summary": @"Dr, Laura vs. Dr. Satan, PC Gaming vs. Consoles, Black Ops Sheep and Twitter Questions - So Hide Your Kids, Hide your Wife!"};
+    IGFeedItem *episodeThreePointFiveFeedItem = [[IGFeedItem alloc] initWithGUID:@"https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_3.5.mp3" title:@"Episode 3.5" summary:@"War Between New and Used Games, Dead Rising 2 Case:Zero and Shank reviews, Black Ops trash talk take back, banning MMA in Canada and more Pure Pwnage news!" pubDate:[NSDate dateWithTimeIntervalSince1970:1283756400] fileSize:37000000 duration:2403 downloadURL:@"https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_3.5.mp3" mediaType:@"audio/mpeg" imageURL:nil];
+    IGFeedItem *episodeFourFeedItem = [[IGFeedItem alloc] initWithGUID:@"https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_4.mp3" title:@"Episode 4" summary:@"Dr, Laura vs. Dr. Satan, PC Gaming vs. Consoles, Black Ops Sheep and Twitter Questions - So Hide Your Kids, Hide your Wife!" pubDate:[NSDate dateWithTimeIntervalSince1970:1284706800] fileSize:34000000 duration:1976 downloadURL:@"https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_4.mp3" mediaType:@"audio/mpeg" imageURL:nil];
     NSArray *newFeedItems = @[episodeThreePointFiveFeedItem, episodeFourFeedItem];
     
     [IGEpisode importPodcastFeedItems:newFeedItems completion:^(BOOL success, NSError *error) {
@@ -155,4 +155,285 @@
                                  beforeDate:[NSDate dateWithTimeIntervalSinceNow:10]];
 }
 
+#pragma mark - Episode Identity Tests
+
+- (void)testEpisodeOneGUIDPresentedInFeedItemsArrayIsSavedInEpisodeOneEntity {
+    assertThat([_episodeOne guid], equalTo(@"https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_1.mp3"));
+}
+
+- (void)testEpisodeWithGUIDReturnsEpisode {
+    assertThat([IGEpisode episodeWithGUID:@"https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_2.mp3"], equalTo(_episodeTwo));
+}
+
+- (void)testEpisodesSharingATitleAreKeptApart {
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    
+    IGFeedItem *rerunFeedItem = [[IGFeedItem alloc] initWithGUID:@"https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_1_RERUN.mp3" title:@"Episode 1" summary:@"Rerun" pubDate:[NSDate dateWithTimeIntervalSince1970:1284706800] fileSize:28900000 duration:1875 downloadURL:@"https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_1_RERUN.mp3" mediaType:@"audio/mpeg" imageURL:nil];
+    
+    [IGEpisode importPodcastFeedItems:@[rerunFeedItem] completion:^(BOOL success, NSError *error) {
+        NSArray *episodes = [IGEpisode MR_findByAttribute:@"title" withValue:@"Episode 1"];
+        
+        assertThatInteger([episodes count], equalToInteger(2));
+        assertThat([[IGEpisode episodeWithGUID:@"https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_1.mp3"] summary], equalTo(@"Achievements, Arizona Immigration Laws, and Annoying Social Networking Apps"));
+        
+        dispatch_semaphore_signal(semaphore);
+    }];
+    
+    while (dispatch_semaphore_wait(semaphore, DISPATCH_TIME_NOW))
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode
+                                 beforeDate:[NSDate dateWithTimeIntervalSinceNow:10]];
+}
+
+- (void)testEpisodeStoredWithoutGUIDIsMatchedByDownloadURL {
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    
+    // Episodes stored before the guid attribute was added have no guid.
+    [_episodeOne setGuid:nil];
+    [[NSManagedObjectContext MR_defaultContext] MR_saveToPersistentStoreAndWait];
+    
+    IGFeedItem *episodeOneFeedItem = [[IGFeedItem alloc] initWithGUID:@"sitmos-episode-1" title:@"Episode 1" summary:@"Achievements, Arizona Immigration Laws, and Annoying Social Networking Apps" pubDate:[NSDate dateWithTimeIntervalSince1970:1281423600] fileSize:28900000 duration:1875 downloadURL:@"https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_1.mp3" mediaType:@"audio/mpeg" imageURL:nil];
+    
+    [IGEpisode importPodcastFeedItems:@[episodeOneFeedItem] completion:^(BOOL success, NSError *error) {
+        assertThatInteger([IGEpisode MR_countOfEntities], equalToInteger(2));
+        assertThat([IGEpisode episodeWithGUID:@"sitmos-episode-1"], notNilValue());
+        
+        dispatch_semaphore_signal(semaphore);
+    }];
+    
+    while (dispatch_semaphore_wait(semaphore, DISPATCH_TIME_NOW))
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode
+                                 beforeDate:[NSDate dateWithTimeIntervalSinceNow:10]];
+}
+
+- (void)testEpisodeWithoutGUIDIsFoundByItsIdentifier {
+    [_episodeOne setGuid:nil];
+    
+    NSString *identifier = [_episodeOne identifier];
+    assertThat(identifier, equalTo(@"https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_1.mp3"));
+    assertThat([IGEpisode episodeWithIdentifier:identifier], equalTo(_episodeOne));
+}
+
+- (void)testLikelyNextEpisodesAreTheUnplayedOnes {
+    assertThat([IGEpisode likelyNextEpisodesWithLimit:5], equalTo(@[_episodeTwo]));
+}
+
+- (void)testLikelyNextEpisodesPutHalfPlayedEpisodesFirst {
+    [_episodeOne markAsPlayed:NO];
+    [_episodeOne setProgress:@60];
+    [[NSManagedObjectContext MR_defaultContext] MR_saveToPersistentStoreAndWait];
+    
+    assertThat([IGEpisode likelyNextEpisodesWithLimit:5], equalTo(@[_episodeOne, _episodeTwo]));
+    assertThat([IGEpisode likelyNextEpisodesWithLimit:1], equalTo(@[_episodeOne]));
+}
+
+#pragma mark - Dirty Tracking Tests
+
+/**
+ * Imports the feed items and returns the IDs of the episodes each save updated, counting an episode once however many contexts it is saved through.
+ */
+- (NSSet *)updatedObjectIDsImportingFeedItems:(NSArray *)feedItems {
+    NSMutableSet *updatedObjectIDs = [NSMutableSet set];
+    id observer = [[NSNotificationCenter defaultCenter] addObserverForName:NSManagedObjectContextDidSaveNotification object:nil queue:nil usingBlock:^(NSNotification *notification) {
+        @synchronized(updatedObjectIDs) {
+            for (NSManagedObject *object in [[notification userInfo] objectForKey:NSUpdatedObjectsKey]) {
+                [updatedObjectIDs addObject:[object objectID]];
+            }
+        }
+    }];
+    
+    [self importFeedItemsAndWait:feedItems];
+    
+    [[NSNotificationCenter defaultCenter] removeObserver:observer];
+    
+    return updatedObjectIDs;
+}
+
+- (void)testReimportingUnchangedFeedItemsUpdatesNoEpisodes {
+    NSSet *updatedObjectIDs = [self updatedObjectIDsImportingFeedItems:_feedItems];
+    
+    assertThatInteger([updatedObjectIDs count], equalToInteger(0));
+}
+
+- (void)testReimportingChangedFeedItemUpdatesOnlyThatEpisode {
+    IGFeedItem *episodeOneFeedItem = [_feedItems objectAtIndex:0];
+    IGFeedItem *changedFeedItem = [[IGFeedItem alloc] initWithGUID:[episodeOneFeedItem guid] title:[episodeOneFeedItem title] summary:@"Updated show notes" pubDate:[episodeOneFeedItem pubDate] fileSize:[episodeOneFeedItem fileSize] duration:[episodeOneFeedItem duration] downloadURL:[episodeOneFeedItem downloadURL] mediaType:[episodeOneFeedItem mediaType] imageURL:[episodeOneFeedItem imageURL]];
+    
+    NSSet *updatedObjectIDs = [self updatedObjectIDsImportingFeedItems:@[changedFeedItem, [_feedItems objectAtIndex:1]]];
+    
+    assertThatInteger([updatedObjectIDs count], equalToInteger(1));
+    assertThat([[IGEpisode episodeWithGUID:[episodeOneFeedItem guid]] summary], equalTo(@"Updated show notes"));
+}
+
+- (void)testReimportingFeedItemWithoutLengthOrDurationKeepsThemAndUpdatesNothing {
+    IGFeedItem *episodeOneFeedItem = [_feedItems objectAtIndex:0];
+    IGFeedItem *strippedFeedItem = [[IGFeedItem alloc] initWithGUID:[episodeOneFeedItem guid] title:[episodeOneFeedItem title] summary:[episodeOneFeedItem summary] pubDate:[episodeOneFeedItem pubDate] fileSize:0 duration:0 downloadURL:[episodeOneFeedItem downloadURL] mediaType:[episodeOneFeedItem mediaType] imageURL:[episodeOneFeedItem imageURL]];
+    
+    NSSet *updatedObjectIDs = [self updatedObjectIDsImportingFeedItems:@[strippedFeedItem, [_feedItems objectAtIndex:1]]];
+    
+    assertThatInteger([updatedObjectIDs count], equalToInteger(0));
+    IGEpisode *episode = [IGEpisode episodeWithGUID:[episodeOneFeedItem guid]];
+    assertThatLongLong([[episode fileSize] longLongValue], equalToLongLong([episodeOneFeedItem fileSize]));
+    assertThat([episode duration], equalTo([episodeOneFeedItem durationString]));
+}
+
+- (void)testReimportingDoesNotMarkPlayedEpisodeAsUnplayed {
+    [_episodeTwo markAsPlayed:YES];
+    [[NSManagedObjectContext MR_defaultContext] MR_saveToPersistentStoreAndWait];
+    
+    [self importFeedItemsAndWait:_feedItems];
+    
+    assertThatBool([[IGEpisode episodeWithGUID:[_episodeTwo guid]] isPlayed], equalToBool(YES));
+}
+
+#pragma mark - Download State Tests
+
+- (void)waitForCompletion:(void (^)(void (^completion)(BOOL success, NSError *error)))block {
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    
+    block(^(BOOL success, NSError *error) {
+        dispatch_semaphore_signal(semaphore);
+    });
+    
+    while (dispatch_semaphore_wait(semaphore, DISPATCH_TIME_NOW))
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode
+                                 beforeDate:[NSDate dateWithTimeIntervalSinceNow:10]];
+    
+    [[NSManagedObjectContext MR_defaultContext] refreshObject:_episodeOne mergeChanges:NO];
+}
+
+- (void)writeEpisodeOneFileWithLength:(NSUInteger)length {
+    [[NSMutableData dataWithLength:length] writeToURL:[_episodeOne fileURL] atomically:YES];
+}
+
+- (void)recordEpisodeOneDownloadAndWait {
+    [self waitForCompletion:^(void (^completion)(BOOL success, NSError *error)) {
+        [IGEpisode recordFinishedDownloadForDownloadURL:[NSURL URLWithString:[_episodeOne downloadURL]]
+                                             completion:completion];
+    }];
+}
+
+- (void)reconcileAndWait {
+    [self waitForCompletion:^(void (^completion)(BOOL success, NSError *error)) {
+        [IGEpisode reconcileDownloadedEpisodesWithCompletion:completion];
+    }];
+}
+
+- (void)testEpisodeOneIsNotDownloaded {
+    assertThatBool([_episodeOne isDownloaded], equalToBool(NO));
+    assertThatInteger([_episodeOne downloadStatus], equalToInteger(IGEpisodeDownloadStatusNotDownloading));
+}
+
+- (void)testRecordingFinishedDownloadStoresFileNameAndSize {
+    [self writeEpisodeOneFileWithLength:1024];
+    [self recordEpisodeOneDownloadAndWait];
+    [[NSFileManager defaultManager] removeItemAtURL:[_episodeOne fileURL] error:nil];
+    
+    assertThatBool([_episodeOne isDownloaded], equalToBool(YES));
+    assertThat([_episodeOne downloadedFileName], equalTo(@"Episode 1.mp3"));
+    assertThat([_episodeOne downloadedFileSize], equalTo(@1024));
+    assertThatInteger([_episodeOne downloadStatus], equalToInteger(IGEpisodeDownloadStatusDownloaded));
+}
+
+- (void)testRecordingFinishedDownloadWithoutFileRecordsNothing {
+    [self recordEpisodeOneDownloadAndWait];
+    
+    assertThatBool([_episodeOne isDownloaded], equalToBool(NO));
+    assertThat([_episodeOne downloadedFileName], nilValue());
+}
+
+- (void)testReconcilingRecordsEpisodeDownloadedBeforeStateWasRecorded {
+    [self writeEpisodeOneFileWithLength:2048];
+    [self reconcileAndWait];
+    [[NSFileManager defaultManager] removeItemAtURL:[_episodeOne fileURL] error:nil];
+    
+    assertThatBool([_episodeOne isDownloaded], equalToBool(YES));
+    assertThat([_episodeOne downloadedFileSize], equalTo(@2048));
+}
+
+- (void)testReconcilingMarksEpisodeWithMissingFileAsNotDownloaded {
+    [self writeEpisodeOneFileWithLength:1024];
+    [self recordEpisodeOneDownloadAndWait];
+    [[NSFileManager defaultManager] removeItemAtURL:[_episodeOne fileURL] error:nil];
+    [self reconcileAndWait];
+    
+    assertThatBool([_episodeOne isDownloaded], equalToBool(NO));
+    assertThat([_episodeOne downloadedFileName], nilValue());
+    assertThat([_episodeOne downloadedFileSize], equalTo(@0));
+}
+
+- (void)testReconcilingIgnoresStagedEpisodes {
+    NSURL *stagingURL = [IGEpisode stagingURLForFileURL:[_episodeOne fileURL]];
+    [[NSMutableData dataWithLength:1024] writeToURL:stagingURL atomically:YES];
+    [self reconcileAndWait];
+    [[NSFileManager defaultManager] removeItemAtURL:stagingURL error:nil];
+    
+    assertThatBool([_episodeOne isDownloaded], equalToBool(NO));
+}
+
+- (void)testReconcilingUnchangedDownloadsUpdatesNoEpisodes {
+    NSMutableSet *updatedObjectIDs = [NSMutableSet set];
+    id observer = [[NSNotificationCenter defaultCenter] addObserverForName:NSManagedObjectContextDidSaveNotification object:nil queue:nil usingBlock:^(NSNotification *notification) {
+        for (NSManagedObject *object in [[notification userInfo] objectForKey:NSUpdatedObjectsKey]) {
+            [updatedObjectIDs addObject:[object objectID]];
+        }
+    }];
+    [self reconcileAndWait];
+    [[NSNotificationCenter defaultCenter] removeObserver:observer];
+    
+    assertThatInteger([updatedObjectIDs count], equalToInteger(0));
+}
+
+- (void)testDeletingDownloadedEpisodeClearsDownloadState {
+    [self writeEpisodeOneFileWithLength:1024];
+    [self recordEpisodeOneDownloadAndWait];
+    [_episodeOne deleteDownloadedEpisode];
+    
+    assertThatBool([_episodeOne isDownloaded], equalToBool(NO));
+    assertThat([_episodeOne downloadedFileName], nilValue());
+    assertThatBool([[NSFileManager defaultManager] fileExistsAtPath:[[_episodeOne fileURL] path]], equalToBool(NO));
+}
+
+#pragma mark - Bulk Import Tests
+
+- (NSArray *)feedItemsWithCount:(NSUInteger)count {
+    NSMutableArray *feedItems = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        NSString *title = [NSString stringWithFormat:@"Bulk Episode %lu", (unsigned long)i];
+        NSString *downloadURL = [NSString stringWithFormat:@"https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_BULK_%lu.mp3", (unsigned long)i];
+        IGFeedItem *feedItem = [[IGFeedItem alloc] initWithGUID:downloadURL title:title summary:@"Bulk" pubDate:[NSDate dateWithTimeIntervalSince1970:1281423600 + i * 86400] fileSize:28900000 duration:1875 downloadURL:downloadURL mediaType:@"audio/mpeg" imageURL:nil];
+        [feedItems addObject:feedItem];
+    }
+    return feedItems;
+}
+
+- (void)importFeedItemsAndWait:(NSArray *)feedItems {
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    
+    [IGEpisode importPodcastFeedItems:feedItems completion:^(BOOL success, NSError *error) {
+        dispatch_semaphore_signal(semaphore);
+    }];
+    
+    while (dispatch_semaphore_wait(semaphore, DISPATCH_TIME_NOW))
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode
+                                 beforeDate:[NSDate dateWithTimeIntervalSinceNow:10]];
+}
+
+- (void)testImportingManyFeedItemsIntoEmptyStoreCreatesOneEpisodeEach {
+    [IGEpisode MR_truncateAll];
+    [[NSManagedObjectContext MR_defaultContext] MR_saveToPersistentStoreAndWait];
+    
+    [self importFeedItemsAndWait:[self feedItemsWithCount:500]];
+    
+    assertThatInteger([IGEpisode MR_countOfEntities], equalToInteger(500));
+}
+
+- (void)testImportingManyFeedItemsIntoPopulatedStoreUpdatesExistingEpisodes {
+    NSArray *feedItems = [self feedItemsWithCount:500];
+    [self importFeedItemsAndWait:feedItems];
+    [self importFeedItemsAndWait:feedItems];
+    
+    // The two episodes from setUp plus the 500 imported once.
+    assertThatInteger([IGEpisode MR_countOfEntities], equalToInteger(502));
+}
+
 @end
@@ -0,0 +1,126 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGHeadPrefetcher.h"
+#import "IGStreamingCache.h"
+#import "IGTestHTTPServer.h"
+#import <SenTestingKit/SenTestingKit.h>
+
+#define HC_SHORTHAND
+#import <OCHamcrestIOS/OCHamcrestIOS.h>
+
+@interface IGHeadPrefetcherTests : SenTestCase
+@end
+
+@implementation IGHeadPrefetcherTests {
+    NSString *_directory;
+    IGStreamingCache *_cache;
+    IGHeadPrefetcher *_prefetcher;
+}
+
+- (void)setUp {
+    [super setUp];
+    
+    _directory = [NSTemporaryDirectory() stringByAppendingPathComponent:@"IGHeadPrefetcherTests"];
+    [[NSFileManager defaultManager] removeItemAtPath:_directory error:nil];
+    _cache = [[IGStreamingCache alloc] initWithDirectory:_directory];
+    _prefetcher = [[IGHeadPrefetcher alloc] initWithStreamingCache:_cache];
+    _prefetcher.headLength = 64 * 1024;
+}
+
+- (void)tearDown {
+    _prefetcher = nil;
+    _cache = nil;
+    [[NSFileManager defaultManager] removeItemAtPath:_directory error:nil];
+    
+    [super tearDown];
+}
+
+- (NSData *)episodeDataWithLength:(NSUInteger)length ID3TagSize:(NSUInteger)tagSize {
+    NSMutableData *episodeData = [NSMutableData dataWithLength:length];
+    arc4random_buf([episodeData mutableBytes], [episodeData length]);
+    
+    uint8_t *bytes = [episodeData mutableBytes];
+    bytes[0] = 0xFF;
+    if (tagSize > 0) {
+        uint8_t header[10] = { 'I', 'D', '3', 4, 0, 0, (tagSize >> 21) & 0x7F, (tagSize >> 14) & 0x7F, (tagSize >> 7) & 0x7F, tagSize & 0x7F };
+        memcpy(bytes, header, sizeof(header));
+    }
+    return episodeData;
+}
+
+- (BOOL)waitForHeadOfURL:(NSURL *)URL {
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:10];
+    while (![_prefetcher isHeadCachedForURL:URL] && [timeout timeIntervalSinceNow] > 0)
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode
+                                 beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+    
+    return [_prefetcher isHeadCachedForURL:URL];
+}
+
+- (void)testHeadIsPrefetched {
+    NSData *episodeData = [self episodeDataWithLength:1024 * 1024 ID3TagSize:0];
+    IGTestHTTPServer *server = [[IGTestHTTPServer alloc] initWithData:episodeData];
+    [server start];
+    
+    [_prefetcher prefetchHeadsForURLs:@[[server URL]]];
+    
+    assertThatBool([self waitForHeadOfURL:[server URL]], equalToBool(YES));
+    IGStreamingCacheEntry *entry = [_cache existingEntryForURL:[server URL]];
+    assertThatLongLong([entry cachedLengthFromOffset:0], equalToLongLong(64 * 1024));
+    assertThatLongLong([entry contentLength], equalToLongLong([episodeData length]));
+    assertThat([entry readDataFromOffset:0 length:64 * 1024], equalTo([episodeData subdataWithRange:NSMakeRange(0, 64 * 1024)]));
+    
+    [server stop];
+}
+
+- (void)testHeadIncludesTheID3Tag {
+    NSData *episodeData = [self episodeDataWithLength:1024 * 1024 ID3TagSize:300 * 1024];
+    IGTestHTTPServer *server = [[IGTestHTTPServer alloc] initWithData:episodeData];
+    [server start];
+    
+    [_prefetcher prefetchHeadsForURLs:@[[server URL]]];
+    
+    assertThatBool([self waitForHeadOfURL:[server URL]], equalToBool(YES));
+    IGStreamingCacheEntry *entry = [_cache existingEntryForURL:[server URL]];
+    assertThatLongLong([entry cachedLengthFromOffset:0], equalToLongLong(10 + 300 * 1024 + 64 * 1024));
+    
+    [server stop];
+}
+
+- (void)testCachedHeadIsNotFetchedAgain {
+    NSData *episodeData = [self episodeDataWithLength:1024 * 1024 ID3TagSize:0];
+    IGTestHTTPServer *server = [[IGTestHTTPServer alloc] initWithData:episodeData];
+    [server start];
+    
+    [_prefetcher prefetchHeadsForURLs:@[[server URL]]];
+    [self waitForHeadOfURL:[server URL]];
+    NSUInteger requestCount = [server requestCount];
+    
+    [_prefetcher prefetchHeadsForURLs:@[[server URL]]];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.5]];
+    
+    assertThatUnsignedInteger([server requestCount], equalToUnsignedInteger(requestCount));
+    
+    [server stop];
+}
+
+@end
@@ -0,0 +1,188 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGMediaPlayer.h"
+#import "IGMediaAsset.h"
+#import <AVFoundation/AVFoundation.h>
+#import <SenTestingKit/SenTestingKit.h>
+
+#define HC_SHORTHAND
+#import <OCHamcrestIOS/OCHamcrestIOS.h>
+
+static NSString * const IGMediaPlayerCurrentAssetKey = @"MediaPlayerCurrentAsset";
+static NSString * const IGMediaPlayerUpNextAssetsKey = @"MediaPlayerUpNextAssets";
+
+@interface IGMediaPlayer (Testing)
+
+- (void)dropUnplayableUpNextAsset:(IGMediaAsset *)asset;
+- (void)playerItemDidReachEnd:(NSNotification *)notification;
+
+@end
+
+@interface IGMediaPlayerTests : SenTestCase
+@end
+
+@implementation IGMediaPlayerTests {
+    id _savedCurrentAsset;
+    id _savedUpNextAssets;
+}
+
+- (void)setUp {
+    [super setUp];
+    
+    // The tests run inside the app, keep its saved player state aside
+    NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
+    _savedCurrentAsset = [userDefaults objectForKey:IGMediaPlayerCurrentAssetKey];
+    _savedUpNextAssets = [userDefaults objectForKey:IGMediaPlayerUpNextAssetsKey];
+    [userDefaults removeObjectForKey:IGMediaPlayerCurrentAssetKey];
+    [userDefaults removeObjectForKey:IGMediaPlayerUpNextAssetsKey];
+}
+
+- (void)tearDown {
+    NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
+    [userDefaults removeObjectForKey:IGMediaPlayerCurrentAssetKey];
+    [userDefaults removeObjectForKey:IGMediaPlayerUpNextAssetsKey];
+    if (_savedCurrentAsset) {
+        [userDefaults setObject:_savedCurrentAsset forKey:IGMediaPlayerCurrentAssetKey];
+    }
+    if (_savedUpNextAssets) {
+        [userDefaults setObject:_savedUpNextAssets forKey:IGMediaPlayerUpNextAssetsKey];
+    }
+    
+    [super tearDown];
+}
+
+- (IGMediaAsset *)assetWithIdentifier:(NSString *)identifier {
+    NSURL *contentURL = [NSURL URLWithString:[NSString stringWithFormat:@"http://www.example.com/%@.mp3", identifier]];
+    return [[IGMediaAsset alloc] initWithTitle:identifier identifier:identifier contentURL:contentURL isAudio:YES];
+}
+
+- (NSArray *)identifiersOfAssets:(NSArray *)assets {
+    return [assets valueForKey:@"identifier"];
+}
+
+#pragma mark - Up Next Queue Tests
+
+- (void)testAddedAssetsAreQueuedInOrder {
+    IGMediaPlayer *player = [[IGMediaPlayer alloc] init];
+    [player addAssetToUpNext:[self assetWithIdentifier:@"1"]];
+    [player addAssetToUpNext:[self assetWithIdentifier:@"2"]];
+    
+    assertThat([self identifiersOfAssets:[player upNextAssets]], contains(@"1", @"2", nil));
+}
+
+- (void)testAddingAQueuedAssetMovesItToTheEnd {
+    IGMediaPlayer *player = [[IGMediaPlayer alloc] init];
+    [player addAssetToUpNext:[self assetWithIdentifier:@"1"]];
+    [player addAssetToUpNext:[self assetWithIdentifier:@"2"]];
+    // A fresh asset for the same episode, the queue matches it by identifier
+    [player addAssetToUpNext:[self assetWithIdentifier:@"1"]];
+    
+    assertThat([self identifiersOfAssets:[player upNextAssets]], contains(@"2", @"1", nil));
+}
+
+- (void)testRemovedAssetIsNoLongerQueued {
+    IGMediaPlayer *player = [[IGMediaPlayer alloc] init];
+    [player addAssetToUpNext:[self assetWithIdentifier:@"1"]];
+    [player addAssetToUpNext:[self assetWithIdentifier:@"2"]];
+    [player removeAssetFromUpNext:[self assetWithIdentifier:@"1"]];
+    
+    assertThat([self identifiersOfAssets:[player upNextAssets]], contains(@"2", nil));
+    assertThatBool([player isAssetInUpNext:[self assetWithIdentifier:@"1"]], equalToBool(NO));
+    assertThatBool([player isAssetInUpNext:[self assetWithIdentifier:@"2"]], equalToBool(YES));
+}
+
+- (void)testRemovingAllAssetsEmptiesTheQueue {
+    IGMediaPlayer *player = [[IGMediaPlayer alloc] init];
+    [player addAssetToUpNext:[self assetWithIdentifier:@"1"]];
+    [player addAssetToUpNext:[self assetWithIdentifier:@"2"]];
+    [player removeAllAssetsFromUpNext];
+    
+    assertThat([player upNextAssets], isEmpty());
+}
+
+- (void)testAssetsWithoutAnIdentifierMatchByContentURL {
+    IGMediaPlayer *player = [[IGMediaPlayer alloc] init];
+    NSURL *contentURL = [NSURL URLWithString:@"http://www.example.com/1.mp3"];
+    [player addAssetToUpNext:[[IGMediaAsset alloc] initWithTitle:@"1" contentURL:contentURL isAudio:YES]];
+    
+    assertThatBool([player isAssetInUpNext:[[IGMediaAsset alloc] initWithTitle:@"Other Title" contentURL:contentURL isAudio:YES]], equalToBool(YES));
+    assertThatBool([player isAssetInUpNext:[[IGMediaAsset alloc] initWithTitle:@"1" contentURL:[NSURL URLWithString:@"http://www.example.com/2.mp3"] isAudio:YES]], equalToBool(NO));
+}
+
+- (void)testAssetWithAnIdentifierDoesNotMatchAnAssetWithoutOne {
+    IGMediaPlayer *player = [[IGMediaPlayer alloc] init];
+    IGMediaAsset *asset = [self assetWithIdentifier:@"1"];
+    [player addAssetToUpNext:asset];
+    
+    assertThatBool([player isAssetInUpNext:[[IGMediaAsset alloc] initWithTitle:@"1" contentURL:[asset contentURL] isAudio:YES]], equalToBool(NO));
+}
+
+- (void)testQueueIsRestoredByANewPlayer {
+    IGMediaPlayer *player = [[IGMediaPlayer alloc] init];
+    [player addAssetToUpNext:[self assetWithIdentifier:@"1"]];
+    [player addAssetToUpNext:[self assetWithIdentifier:@"2"]];
+    [player removeAssetFromUpNext:[self assetWithIdentifier:@"1"]];
+    [player addAssetToUpNext:[self assetWithIdentifier:@"3"]];
+    
+    IGMediaPlayer *restoredPlayer = [[IGMediaPlayer alloc] init];
+    NSArray *restoredAssets = [restoredPlayer upNextAssets];
+    
+    assertThat([self identifiersOfAssets:restoredAssets], contains(@"2", @"3", nil));
+    assertThat([[restoredAssets firstObject] contentURL], equalTo([NSURL URLWithString:@"http://www.example.com/2.mp3"]));
+}
+
+- (void)testDroppedUnplayableAssetIsReplacedByTheNextAsset {
+    IGMediaPlayer *player = [[IGMediaPlayer alloc] init];
+    [player addAssetToUpNext:[self assetWithIdentifier:@"1"]];
+    [player addAssetToUpNext:[self assetWithIdentifier:@"2"]];
+    [player dropUnplayableUpNextAsset:[[player upNextAssets] firstObject]];
+    
+    assertThat([self identifiersOfAssets:[player upNextAssets]], contains(@"2", nil));
+    assertThat([self identifiersOfAssets:[[[IGMediaPlayer alloc] init] upNextAssets]], contains(@"2", nil));
+}
+
+- (void)testReachingTheEndWithoutAPreparedItemStartsTheFirstQueuedAsset {
+    IGMediaPlayer *player = [[IGMediaPlayer alloc] init];
+    [player addAssetToUpNext:[self assetWithIdentifier:@"1"]];
+    [player addAssetToUpNext:[self assetWithIdentifier:@"2"]];
+    __block BOOL reachedEnd = NO;
+    [player setStoppedBlock:^(Float64 currentTime, BOOL playbackEnded) {
+        reachedEnd = playbackEnded;
+    }];
+    
+    [player playerItemDidReachEnd:[NSNotification notificationWithName:AVPlayerItemDidPlayToEndTimeNotification object:nil]];
+    
+    assertThat([[player asset] identifier], equalTo(@"1"));
+    assertThat([self identifiersOfAssets:[player upNextAssets]], contains(@"2", nil));
+    assertThatBool(reachedEnd, equalToBool(YES));
+    assertThatInteger([player playbackState], equalToInteger(IGMediaPlayerPlaybackStateLoading));
+}
+
+- (void)testReachingTheEndWithAnEmptyQueueEndsPlayback {
+    IGMediaPlayer *player = [[IGMediaPlayer alloc] init];
+    
+    [player playerItemDidReachEnd:[NSNotification notificationWithName:AVPlayerItemDidPlayToEndTimeNotification object:nil]];
+    
+    assertThatInteger([player playbackState], equalToInteger(IGMediaPlayerPlaybackStateDidReachEnd));
+}
+
+@end
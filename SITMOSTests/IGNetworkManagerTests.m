@@ -20,17 +20,94 @@
  */
 
 #import "IGNetworkManager.h"
+#import "IGTestHTTPServer.h"
 #import <SenTestingKit/SenTestingKit.h>
 
 #define HC_SHORTHAND
 #import <OCHamcrestIOS/OCHamcrestIOS.h>
 
+static NSString *feedXMLString = @"<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+@"<rss xmlns:itunes=\"http://www.itunes.com/dtds/podcast-1.0.dtd\" version=\"2.0\">"
+@"<channel>"
+@"<title>Stuck in the Middle of Somewhere</title>"
+@"<item>"
+@"<title>Episode 2</title>"
+@"<pubDate>Tue, 17 Aug 2010 00:00:00 MST</pubDate>"
+@"<enclosure url=\"https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_2.mp3\" length=\"28900000\" type=\"audio/mpeg\" />"
+@"<guid>https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_2.mp3</guid>"
+@"</item>"
+@"<item>"
+@"<title>Episode 1</title>"
+@"<pubDate>Tue, 10 Aug 2010 00:00:00 MST</pubDate>"
+@"<enclosure url=\"https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_1.mp3\" length=\"28900000\" type=\"audio/mpeg\" />"
+@"<guid>https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_1.mp3</guid>"
+@"</item>"
+@"</channel>"
+@"</rss>";
+
+@interface IGNetworkManager (Testing)
+
+- (void)setPodcastFeedURL:(NSURL *)podcastFeedURL;
+
+@end
+
 @interface IGNetworkManagerTests : SenTestCase
 @end
 
 @implementation IGNetworkManagerTests
 {
+    IGTestHTTPServer *_server;
+    IGNetworkManager *_networkManager;
+}
+
+- (void)setUp {
+    [super setUp];
+    
+    _server = [[IGTestHTTPServer alloc] initWithData:[feedXMLString dataUsingEncoding:NSUTF8StringEncoding]];
+    _server.contentType = @"application/rss+xml";
+    [_server start];
+    
+    _networkManager = [[IGNetworkManager alloc] init];
+    [_networkManager setPodcastFeedURL:[_server URL]];
     
+    [[NSUserDefaults standardUserDefaults] removeObjectForKey:IGPodcastFeedValidatorsKey];
+    [[NSUserDefaults standardUserDefaults] removeObjectForKey:IGPodcastFeedLastFullSyncDateKey];
+}
+
+- (void)tearDown {
+    [_server stop];
+    _server = nil;
+    _networkManager = nil;
+    
+    [[NSUserDefaults standardUserDefaults] removeObjectForKey:IGPodcastFeedValidatorsKey];
+    [[NSUserDefaults standardUserDefaults] removeObjectForKey:IGPodcastFeedLastFullSyncDateKey];
+    
+    [super tearDown];
+}
+
+- (void)storeValidatorsWithETag:(NSString *)ETag lastModified:(NSString *)lastModified {
+    NSDictionary *validators = @{ [[_server URL] absoluteString]: @{ @"ETag": ETag, @"Last-Modified": lastModified } };
+    [[NSUserDefaults standardUserDefaults] setObject:validators forKey:IGPodcastFeedValidatorsKey];
+}
+
+- (BOOL)syncNewerThanPubDate:(NSDate *)pubDate feedItems:(NSArray **)feedItems {
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    __block BOOL syncSuccess = NO;
+    __block NSArray *syncedFeedItems = nil;
+    [_networkManager syncPodcastFeedNewerThanPubDate:pubDate completion:^(BOOL success, NSArray *items, NSError *error) {
+        syncSuccess = success;
+        syncedFeedItems = items;
+        dispatch_semaphore_signal(semaphore);
+    }];
+    
+    while (dispatch_semaphore_wait(semaphore, DISPATCH_TIME_NOW))
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode
+                                 beforeDate:[NSDate dateWithTimeIntervalSinceNow:10]];
+    
+    if (feedItems) {
+        *feedItems = syncedFeedItems;
+    }
+    return syncSuccess;
 }
 
 - (void)testDevelopmentModeBaseURLIsCorrect {
@@ -49,4 +126,52 @@
     assertThat(IGPodcastFeedURL, equalTo(@"http://www.dereksweet.com/sitmos/sitmos.xml"));
 }
 
+#pragma mark - Conditional Sync Tests
+
+- (void)testIncrementalSyncSendsTheStoredValidators {
+    [self storeValidatorsWithETag:@"\"stale\"" lastModified:@"Tue, 10 Aug 2010 07:00:00 GMT"];
+    [[NSUserDefaults standardUserDefaults] setObject:[NSDate date] forKey:IGPodcastFeedLastFullSyncDateKey];
+    
+    assertThatBool([self syncNewerThanPubDate:[NSDate dateWithTimeIntervalSince1970:0] feedItems:NULL], equalToBool(YES));
+    
+    assertThat([[_server lastRequestHeaders] objectForKey:@"if-none-match"], equalTo(@"\"stale\""));
+    assertThat([[_server lastRequestHeaders] objectForKey:@"if-modified-since"], equalTo(@"Tue, 10 Aug 2010 07:00:00 GMT"));
+}
+
+- (void)testNotModifiedFeedCompletesWithNoItems {
+    [self storeValidatorsWithETag:@"\"sitmos-test\"" lastModified:@"Tue, 10 Aug 2010 07:00:00 GMT"];
+    [[NSUserDefaults standardUserDefaults] setObject:[NSDate date] forKey:IGPodcastFeedLastFullSyncDateKey];
+    
+    NSArray *feedItems = @[];
+    assertThatBool([self syncNewerThanPubDate:[NSDate dateWithTimeIntervalSince1970:0] feedItems:&feedItems], equalToBool(YES));
+    assertThat(feedItems, nilValue());
+}
+
+- (void)testFullSyncIsSentUnconditionally {
+    [self storeValidatorsWithETag:@"\"sitmos-test\"" lastModified:@"Tue, 10 Aug 2010 07:00:00 GMT"];
+    
+    // No full sync has been done yet.
+    NSArray *feedItems = nil;
+    assertThatBool([self syncNewerThanPubDate:[NSDate dateWithTimeIntervalSince1970:0] feedItems:&feedItems], equalToBool(YES));
+    
+    assertThat([[_server lastRequestHeaders] objectForKey:@"if-none-match"], nilValue());
+    assertThat([[_server lastRequestHeaders] objectForKey:@"if-modified-since"], nilValue());
+    assertThatUnsignedInteger([feedItems count], equalToUnsignedInteger(2));
+}
+
+- (void)testIncrementalSyncStoppedAtAKnownItemStoresValidators {
+    [[NSUserDefaults standardUserDefaults] setObject:[NSDate date] forKey:IGPodcastFeedLastFullSyncDateKey];
+    NSDate *episodeOnePubDate = [NSDate dateWithTimeIntervalSince1970:1281423600];
+    
+    NSArray *feedItems = nil;
+    assertThatBool([self syncNewerThanPubDate:episodeOnePubDate feedItems:&feedItems], equalToBool(YES));
+    assertThatUnsignedInteger([feedItems count], equalToUnsignedInteger(1));
+    
+    // The next incremental sync is answered with 304 Not Modified.
+    feedItems = @[];
+    assertThatBool([self syncNewerThanPubDate:episodeOnePubDate feedItems:&feedItems], equalToBool(YES));
+    assertThat([[_server lastRequestHeaders] objectForKey:@"if-none-match"], equalTo(@"\"sitmos-test\""));
+    assertThat(feedItems, nilValue());
+}
+
 @end
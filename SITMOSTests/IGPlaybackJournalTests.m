@@ -0,0 +1,150 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGPlaybackJournal.h"
+#import <SenTestingKit/SenTestingKit.h>
+
+#define HC_SHORTHAND
+#import <OCHamcrestIOS/OCHamcrestIOS.h>
+
+@interface IGPlaybackJournalTests : SenTestCase
+@end
+
+@implementation IGPlaybackJournalTests {
+    NSString *_path;
+    IGPlaybackJournal *_journal;
+}
+
+- (void)setUp {
+    [super setUp];
+    
+    _path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"IGPlaybackJournalTests"];
+    [[NSFileManager defaultManager] removeItemAtPath:_path error:nil];
+    _journal = [[IGPlaybackJournal alloc] initWithPath:_path capacity:4];
+}
+
+- (void)tearDown {
+    _journal = nil;
+    [[NSFileManager defaultManager] removeItemAtPath:_path error:nil];
+    
+    [super tearDown];
+}
+
+- (void)testLatestPositionOfEachEpisode {
+    [_journal appendPosition:10 forEpisodeWithGUID:@"episode1"];
+    [_journal appendPosition:20 forEpisodeWithGUID:@"episode2"];
+    [_journal appendPosition:15 forEpisodeWithGUID:@"episode1"];
+    
+    assertThat([_journal latestPositions], equalTo(@{ @"episode1" : @15, @"episode2" : @20 }));
+    assertThat([_journal positionForEpisodeWithGUID:@"episode1"], equalTo(@15));
+    assertThat([_journal positionForEpisodeWithGUID:@"episode3"], nilValue());
+}
+
+- (void)testUnchangedPositionIsNotAppended {
+    [_journal appendPosition:10 forEpisodeWithGUID:@"episode1"];
+    [_journal appendPosition:10 forEpisodeWithGUID:@"episode1"];
+    
+    assertThatUnsignedInteger([_journal numberOfRecords], equalToUnsignedInteger(1));
+}
+
+- (void)testPositionsSurviveReopening {
+    [_journal appendPosition:10 forEpisodeWithGUID:@"episode1"];
+    [_journal appendPosition:20 forEpisodeWithGUID:@"episode2"];
+    _journal = nil;
+    
+    IGPlaybackJournal *journal = [[IGPlaybackJournal alloc] initWithPath:_path capacity:4];
+    assertThat([journal latestPositions], equalTo(@{ @"episode1" : @10, @"episode2" : @20 }));
+}
+
+- (void)testTornRecordIsIgnored {
+    [_journal appendPosition:10 forEpisodeWithGUID:@"episode1"];
+    [_journal appendPosition:20 forEpisodeWithGUID:@"episode1"];
+    _journal = nil;
+    
+    // Scribble over the position of the second record, as a write cut short would leave it.
+    unsigned long long recordLength = ([[[NSFileManager defaultManager] attributesOfItemAtPath:_path error:nil] fileSize] - sizeof(uint64_t)) / 4;
+    NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingAtPath:_path];
+    [fileHandle seekToFileOffset:recordLength + 16];
+    [fileHandle writeData:[NSData dataWithBytes:"torn" length:4]];
+    [fileHandle closeFile];
+    
+    IGPlaybackJournal *journal = [[IGPlaybackJournal alloc] initWithPath:_path capacity:4];
+    assertThat([journal positionForEpisodeWithGUID:@"episode1"], equalTo(@10));
+    assertThatUnsignedInteger([journal numberOfRecords], equalToUnsignedInteger(1));
+    
+    [journal appendPosition:30 forEpisodeWithGUID:@"episode1"];
+    journal = nil;
+    journal = [[IGPlaybackJournal alloc] initWithPath:_path capacity:4];
+    assertThat([journal positionForEpisodeWithGUID:@"episode1"], equalTo(@30));
+}
+
+- (void)testFullJournalIsCompacted {
+    [_journal appendPosition:10 forEpisodeWithGUID:@"episode1"];
+    [_journal appendPosition:20 forEpisodeWithGUID:@"episode1"];
+    [_journal appendPosition:30 forEpisodeWithGUID:@"episode2"];
+    [_journal appendPosition:40 forEpisodeWithGUID:@"episode1"];
+    
+    assertThatBool([_journal appendPosition:50 forEpisodeWithGUID:@"episode2"], equalToBool(YES));
+    assertThatUnsignedInteger([_journal numberOfRecords], equalToUnsignedInteger(3));
+    assertThat([_journal latestPositions], equalTo(@{ @"episode1" : @40, @"episode2" : @50 }));
+}
+
+- (void)testRemovingFoldedPositionsKeepsLaterOnes {
+    [_journal appendPosition:10 forEpisodeWithGUID:@"episode1"];
+    [_journal appendPosition:20 forEpisodeWithGUID:@"episode2"];
+    uint64_t sequenceNumber = 0;
+    [_journal latestPositionsReturningSequenceNumber:&sequenceNumber];
+    [_journal appendPosition:15 forEpisodeWithGUID:@"episode1"];
+    
+    [_journal removePositionsUpToSequenceNumber:sequenceNumber];
+    
+    assertThat([_journal latestPositions], equalTo(@{ @"episode1" : @15 }));
+    
+    [_journal appendPosition:25 forEpisodeWithGUID:@"episode2"];
+    _journal = nil;
+    IGPlaybackJournal *journal = [[IGPlaybackJournal alloc] initWithPath:_path capacity:4];
+    assertThat([journal latestPositions], equalTo(@{ @"episode1" : @15, @"episode2" : @25 }));
+}
+
+- (void)testFoldedPositionsAreDroppedWhenCompacted {
+    [_journal appendPosition:10 forEpisodeWithGUID:@"episode1"];
+    [_journal appendPosition:20 forEpisodeWithGUID:@"episode2"];
+    uint64_t sequenceNumber = 0;
+    [_journal latestPositionsReturningSequenceNumber:&sequenceNumber];
+    [_journal removePositionsUpToSequenceNumber:sequenceNumber];
+    assertThatUnsignedInteger([_journal numberOfRecords], equalToUnsignedInteger(2));
+    
+    [_journal appendPosition:30 forEpisodeWithGUID:@"episode1"];
+    [_journal appendPosition:40 forEpisodeWithGUID:@"episode1"];
+    [_journal appendPosition:50 forEpisodeWithGUID:@"episode2"];
+    
+    assertThatUnsignedInteger([_journal numberOfRecords], equalToUnsignedInteger(2));
+    assertThat([_journal latestPositions], equalTo(@{ @"episode1" : @40, @"episode2" : @50 }));
+}
+
+- (void)testOverlongGUIDIsRejected {
+    NSString *guid = [@"" stringByPaddingToLength:300 withString:@"x" startingAtIndex:0];
+    
+    assertThatBool([_journal appendPosition:10 forEpisodeWithGUID:guid], equalToBool(NO));
+    assertThatUnsignedInteger([_journal numberOfRecords], equalToUnsignedInteger(0));
+}
+
+@end
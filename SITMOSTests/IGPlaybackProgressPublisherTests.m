@@ -0,0 +1,121 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGPlaybackProgressPublisher.h"
+#import <SenTestingKit/SenTestingKit.h>
+
+#define HC_SHORTHAND
+#import <OCHamcrestIOS/OCHamcrestIOS.h>
+
+@interface IGPlaybackProgressPublisherTests : SenTestCase
+@end
+
+@implementation IGPlaybackProgressPublisherTests {
+    IGPlaybackProgressPublisher *_publisher;
+    NSMutableArray *_elapsedTexts;
+    NSMutableArray *_remainingTexts;
+    NSMutableArray *_durations;
+    NSMutableArray *_currentTimes;
+}
+
+- (void)setUp {
+    [super setUp];
+    
+    _elapsedTexts = [NSMutableArray array];
+    _remainingTexts = [NSMutableArray array];
+    _durations = [NSMutableArray array];
+    _currentTimes = [NSMutableArray array];
+    
+    NSMutableArray *elapsedTexts = _elapsedTexts;
+    NSMutableArray *remainingTexts = _remainingTexts;
+    NSMutableArray *durations = _durations;
+    NSMutableArray *currentTimes = _currentTimes;
+    _publisher = [[IGPlaybackProgressPublisher alloc] init];
+    [_publisher setElapsedTimeTextBlock:^(NSString *text) {
+        [elapsedTexts addObject:text];
+    }];
+    [_publisher setRemainingTimeTextBlock:^(NSString *text) {
+        [remainingTexts addObject:text];
+    }];
+    [_publisher setDurationBlock:^(Float64 duration) {
+        [durations addObject:@(duration)];
+    }];
+    [_publisher setCurrentTimeBlock:^(Float64 currentTime) {
+        [currentTimes addObject:@(currentTime)];
+    }];
+}
+
+- (void)tearDown {
+    _publisher = nil;
+    
+    [super tearDown];
+}
+
+- (void)testTimeTexts {
+    assertThat([IGPlaybackProgressPublisher elapsedTimeTextForTime:3725.5], equalTo(@" 1:02:05"));
+    assertThat([IGPlaybackProgressPublisher remainingTimeTextForTime:65 duration:2600], equalTo(@"-0:42:15"));
+}
+
+- (void)testFirstPublishDeliversEveryValue {
+    [_publisher publishCurrentTime:65 duration:2600];
+    
+    assertThat(_elapsedTexts, equalTo(@[@" 0:01:05"]));
+    assertThat(_remainingTexts, equalTo(@[@"-0:42:15"]));
+    assertThat(_durations, equalTo(@[@2600]));
+    assertThat(_currentTimes, equalTo(@[@65]));
+}
+
+- (void)testTextsAreOnlyDeliveredWhenTheSecondChanges {
+    [_publisher publishCurrentTime:65.0 duration:2600];
+    [_publisher publishCurrentTime:65.2 duration:2600];
+    [_publisher publishCurrentTime:65.9 duration:2600];
+    [_publisher publishCurrentTime:66.1 duration:2600];
+    
+    assertThat(_elapsedTexts, equalTo(@[@" 0:01:05", @" 0:01:06"]));
+    assertThatUnsignedInteger([_remainingTexts count], equalToUnsignedInteger(2));
+    assertThat(_durations, equalTo(@[@2600]));
+    assertThatUnsignedInteger([_currentTimes count], equalToUnsignedInteger(4));
+}
+
+- (void)testUnchangedTimeIsNotDelivered {
+    [_publisher publishCurrentTime:65 duration:2600];
+    [_publisher publishCurrentTime:65 duration:2600];
+    
+    assertThatUnsignedInteger([_currentTimes count], equalToUnsignedInteger(1));
+}
+
+- (void)testUnknownDurationIsNotPublished {
+    [_publisher publishCurrentTime:0 duration:NAN];
+    
+    assertThat(_elapsedTexts, isEmpty());
+    assertThat(_durations, isEmpty());
+}
+
+- (void)testResetDeliversEveryValueAgain {
+    [_publisher publishCurrentTime:65 duration:2600];
+    [_publisher reset];
+    [_publisher publishCurrentTime:65 duration:2600];
+    
+    assertThatUnsignedInteger([_elapsedTexts count], equalToUnsignedInteger(2));
+    assertThatUnsignedInteger([_durations count], equalToUnsignedInteger(2));
+}
+
+@end
@@ -100,12 +100,27 @@ static NSString *feedXMLString = @"<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
                                  beforeDate:[NSDate dateWithTimeIntervalSinceNow:10]];
 }
 
+- (void)testEpisodeFeedParserReturnsGUIDPresentedInFeedXML {
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    
+    [IGPodcastFeedParser PodcastFeedParserWithXMLParser:self.feedXMLParser completion:^(NSArray *episodes, NSError *error) {
+        
+        assertThat([[episodes objectAtIndex:0] guid], equalTo(@"https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_1.mp3"));
+        
+        dispatch_semaphore_signal(semaphore);
+    }];
+    
+    while (dispatch_semaphore_wait(semaphore, DISPATCH_TIME_NOW))
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode
+                                 beforeDate:[NSDate dateWithTimeIntervalSinceNow:10]];
+}
+
 - (void)testEpisodeFeedParserReturnsPubDatePresentedInFeedXML {
     dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
     
     [IGPodcastFeedParser PodcastFeedParserWithXMLParser:self.feedXMLParser completion:^(NSArray *episodes, NSError *error) {
        
-        assertThat([[episodes objectAtIndex:0] valueForKey:@"pubDate"], equalTo(@"Tue, 10 Aug 2010 08:00:00 BST"));
+        assertThat([[episodes objectAtIndex:0] pubDate], equalTo([NSDate dateWithTimeIntervalSince1970:1281423600]));
         
         dispatch_semaphore_signal(semaphore);
     }];
@@ -152,7 +167,7 @@ static NSString *feedXMLString = @"<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
     
     [IGPodcastFeedParser PodcastFeedParserWithXMLParser:self.feedXMLParser completion:^(NSArray *episodes, NSError *error) {
         
-        assertThat([[episodes objectAtIndex:0] valueForKey:@"fileSize"], equalTo(@(28900000)));
+        assertThatLongLong([[episodes objectAtIndex:0] fileSize], equalToLongLong(28900000));
         
         dispatch_semaphore_signal(semaphore);
     }];
@@ -184,15 +199,122 @@ static NSString *feedXMLString = @"<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
     
     [IGPodcastFeedParser PodcastFeedParserWithXMLParser:self.feedXMLParser completion:^(NSArray *episodes, NSError *error) {
         
-        assertThat([[episodes objectAtIndex:0] valueForKey:@"duration"], equalTo(@"31:15"));
+        assertThatInteger([[episodes objectAtIndex:0] duration], equalToInteger(1875));
+        assertThat([[episodes objectAtIndex:0] durationString], equalTo(@"31:15"));
+        
+        dispatch_semaphore_signal(semaphore);
+    }];
+    
+    while (dispatch_semaphore_wait(semaphore, DISPATCH_TIME_NOW))
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode
+                                 beforeDate:[NSDate dateWithTimeIntervalSinceNow:10]];
+    
+}
+
+#pragma mark - Push Parsing Tests
+
+- (void)testPushFeedParserReturnsTitlePresentedInFeedXMLWhenFedInChunks {
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    
+    IGPodcastFeedParser *feedParser = [IGPodcastFeedParser PodcastFeedParserWithFeedItemHandler:nil completion:^(NSArray *episodes, NSError *error) {
+        
+        assertThat([[episodes objectAtIndex:0] valueForKey:@"title"], equalTo(@"Episode 1"));
         
         dispatch_semaphore_signal(semaphore);
     }];
     
+    NSData *feedData = [feedXMLString dataUsingEncoding:NSUTF8StringEncoding];
+    for (NSUInteger offset = 0; offset < [feedData length]; offset += 100) {
+        NSUInteger length = MIN(100, [feedData length] - offset);
+        [feedParser appendData:[feedData subdataWithRange:NSMakeRange(offset, length)]];
+    }
+    [feedParser finish];
+    
+    while (dispatch_semaphore_wait(semaphore, DISPATCH_TIME_NOW))
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode
+                                 beforeDate:[NSDate dateWithTimeIntervalSinceNow:10]];
+}
+
+- (void)testPushFeedParserHandsOutItemBeforeFeedIsFinished {
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    
+    IGPodcastFeedParser *feedParser = [IGPodcastFeedParser PodcastFeedParserWithFeedItemHandler:^(IGFeedItem *feedItem) {
+        
+        assertThat([feedItem valueForKey:@"title"], equalTo(@"Episode 1"));
+        
+        dispatch_semaphore_signal(semaphore);
+    } completion:nil];
+    
+    // Everything up to and including the closing item element, the channel and rss elements are still to come.
+    NSRange itemEnd = [feedXMLString rangeOfString:@"</item>"];
+    NSString *partialFeed = [feedXMLString substringToIndex:NSMaxRange(itemEnd)];
+    [feedParser appendData:[partialFeed dataUsingEncoding:NSUTF8StringEncoding]];
+    
     while (dispatch_semaphore_wait(semaphore, DISPATCH_TIME_NOW))
         [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode
                                  beforeDate:[NSDate dateWithTimeIntervalSinceNow:10]];
     
+    [feedParser finish];
+}
+
+- (void)testPushFeedParserReturnsAbortErrorWhenAborted {
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    NSError *abortError = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorNetworkConnectionLost userInfo:nil];
+    
+    IGPodcastFeedParser *feedParser = [IGPodcastFeedParser PodcastFeedParserWithFeedItemHandler:nil completion:^(NSArray *episodes, NSError *error) {
+        
+        assertThat(error, equalTo(abortError));
+        
+        dispatch_semaphore_signal(semaphore);
+    }];
+    
+    [feedParser appendData:[[feedXMLString substringToIndex:200] dataUsingEncoding:NSUTF8StringEncoding]];
+    [feedParser abortWithError:abortError];
+    
+    while (dispatch_semaphore_wait(semaphore, DISPATCH_TIME_NOW))
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode
+                                 beforeDate:[NSDate dateWithTimeIntervalSinceNow:10]];
+}
+
+#pragma mark - Incremental Sync Tests
+
+- (void)testPushFeedParserStopsAtItemNotNewerThanNewestKnownPubDate {
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    
+    __block IGPodcastFeedParser *feedParser = [IGPodcastFeedParser PodcastFeedParserWithFeedItemHandler:nil completion:^(NSArray *episodes, NSError *error) {
+        
+        assertThat(error, nilValue());
+        assertThatInteger([episodes count], equalToInteger(0));
+        assertThatBool([feedParser isStoppedAtKnownItem], equalToBool(YES));
+        
+        dispatch_semaphore_signal(semaphore);
+    }];
+    feedParser.newestKnownPubDate = [NSDate dateWithTimeIntervalSince1970:1281423600]; // Tue, 10 Aug 2010 00:00:00 MST
+    [feedParser appendData:[feedXMLString dataUsingEncoding:NSUTF8StringEncoding]];
+    [feedParser finish];
+    
+    while (dispatch_semaphore_wait(semaphore, DISPATCH_TIME_NOW))
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode
+                                 beforeDate:[NSDate dateWithTimeIntervalSinceNow:10]];
+    feedParser = nil;
+}
+
+- (void)testPushFeedParserReturnsItemsNewerThanNewestKnownPubDate {
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    
+    IGPodcastFeedParser *feedParser = [IGPodcastFeedParser PodcastFeedParserWithFeedItemHandler:nil completion:^(NSArray *episodes, NSError *error) {
+        
+        assertThat([[episodes objectAtIndex:0] valueForKey:@"title"], equalTo(@"Episode 1"));
+        
+        dispatch_semaphore_signal(semaphore);
+    }];
+    feedParser.newestKnownPubDate = [NSDate dateWithTimeIntervalSince1970:1281337200]; // Mon, 09 Aug 2010 00:00:00 MST
+    [feedParser appendData:[feedXMLString dataUsingEncoding:NSUTF8StringEncoding]];
+    [feedParser finish];
+    
+    while (dispatch_semaphore_wait(semaphore, DISPATCH_TIME_NOW))
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode
+                                 beforeDate:[NSDate dateWithTimeIntervalSinceNow:10]];
 }
 
 #pragma mark - Error Tests
@@ -227,4 +349,61 @@ static NSString *feedXMLString = @"<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
                                  beforeDate:[NSDate dateWithTimeIntervalSinceNow:10]];
 }
 
+#pragma mark - Feed Item Tests
+
+- (void)testFeedItemDurationIsParsedFromHoursMinutesAndSeconds {
+    assertThatInteger([IGFeedItem durationFromString:@"1:02:03"], equalToInteger(3723));
+    assertThatInteger([IGFeedItem durationFromString:@"31:15"], equalToInteger(1875));
+    assertThatInteger([IGFeedItem durationFromString:@"95"], equalToInteger(95));
+}
+
+#pragma mark - Allocation Tests
+
+- (NSData *)feedDataWithItemCount:(NSUInteger)count keywordsLength:(NSUInteger)keywordsLength {
+    NSString *keywords = [@"" stringByPaddingToLength:keywordsLength withString:@"achievements " startingAtIndex:0];
+    NSMutableString *feed = [NSMutableString stringWithString:@"<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+                             @"<rss xmlns:itunes=\"http://www.itunes.com/dtds/podcast-1.0.dtd\" version=\"2.0\"><channel>"
+                             @"<title>Stuck in the Middle of Somewhere</title>"];
+    for (NSUInteger i = count; i > 0; i--) {
+        [feed appendFormat:@"<item>"
+         @"<title>Episode %lu</title>"
+         @"<pubDate>Tue, 10 Aug 2010 00:00:00 MST</pubDate>"
+         @"<enclosure url=\"https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_%lu.mp3\" length=\"28900000\" type=\"audio/mpeg\" />"
+         @"<guid>https://s3.amazonaws.com/SITMOS_Audio_Episodes/SITMOS_EP_%lu.mp3</guid>"
+         @"<itunes:duration>31:15</itunes:duration>"
+         @"<itunes:keywords>%@</itunes:keywords>"
+         @"</item>", (unsigned long)i, (unsigned long)i, (unsigned long)i, keywords];
+    }
+    [feed appendString:@"</channel></rss>"];
+    
+    return [feed dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+- (void)testFeedParserProducesTypedFeedItemRecords {
+    __block NSArray *feedItems = nil;
+    [IGPodcastFeedParser PodcastFeedParserWithXMLParser:[[NSXMLParser alloc] initWithData:[self feedDataWithItemCount:50 keywordsLength:16]] completion:^(NSArray *episodes, NSError *error) {
+        feedItems = episodes;
+    }];
+    
+    assertThatUnsignedInteger([feedItems count], equalToUnsignedInteger(50));
+    for (id feedItem in feedItems) {
+        // A record per item, not a dictionary of strings to be converted on import.
+        assertThatBool([feedItem isMemberOfClass:[IGFeedItem class]], equalToBool(YES));
+        assertThat([feedItem pubDate], instanceOf([NSDate class]));
+        assertThatLongLong([feedItem fileSize], equalToLongLong(28900000));
+        assertThatInteger([feedItem duration], equalToInteger(1875));
+    }
+}
+
+- (void)testFeedParserDoesNotBufferTheTextOfSkippedElements {
+    __block NSArray *feedItems = nil;
+    IGPodcastFeedParser *feedParser = [IGPodcastFeedParser PodcastFeedParserWithXMLParser:[[NSXMLParser alloc] initWithData:[self feedDataWithItemCount:10 keywordsLength:64 * 1024]] completion:^(NSArray *episodes, NSError *error) {
+        feedItems = episodes;
+    }];
+    
+    assertThatUnsignedInteger([feedItems count], equalToUnsignedInteger(10));
+    // The shared text buffer only ever held the short values of the elements that are kept.
+    assertThatUnsignedInteger([[feedParser valueForKey:@"characters"] length], lessThan(@1024));
+}
+
 @end
@@ -0,0 +1,165 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGResumeDataStore.h"
+#import "IGTestHTTPServer.h"
+#import "NSString+MD5.h"
+#import <SenTestingKit/SenTestingKit.h>
+
+#define HC_SHORTHAND
+#import <OCHamcrestIOS/OCHamcrestIOS.h>
+
+@interface IGResumeDataStoreTests : SenTestCase
+@end
+
+@implementation IGResumeDataStoreTests {
+    NSString *_directory;
+    NSString *_partialFilePath;
+    IGResumeDataStore *_store;
+    NSURL *_downloadURL;
+}
+
+- (void)setUp {
+    [super setUp];
+    
+    _directory = [NSTemporaryDirectory() stringByAppendingPathComponent:@"IGResumeDataStoreTests"];
+    [[NSFileManager defaultManager] removeItemAtPath:_directory error:nil];
+    _store = [[IGResumeDataStore alloc] initWithDirectory:_directory];
+    
+    _partialFilePath = [NSTemporaryDirectory() stringByAppendingPathComponent:@"IGResumeDataStoreTests.tmp"];
+    [[NSData dataWithBytes:"partial" length:7] writeToFile:_partialFilePath atomically:YES];
+    
+    _downloadURL = [NSURL URLWithString:@"http://example.com/episode1.mp3"];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:_directory error:nil];
+    [[NSFileManager defaultManager] removeItemAtPath:_partialFilePath error:nil];
+    _store = nil;
+    
+    [super tearDown];
+}
+
+/**
+ * Builds a blob laid out like the resume data of an interrupted NSURLSessionDownloadTask.
+ */
+- (NSData *)resumeDataForDownloadURL:(NSURL *)downloadURL bytesReceived:(int64_t)bytesReceived {
+    NSDictionary *resumeInfo = @{ @"NSURLSessionDownloadURL": [downloadURL absoluteString],
+                                  @"NSURLSessionResumeBytesReceived": @(bytesReceived),
+                                  @"NSURLSessionResumeInfoLocalPath": _partialFilePath };
+    return [NSPropertyListSerialization dataWithPropertyList:resumeInfo format:NSPropertyListXMLFormat_v1_0 options:0 error:nil];
+}
+
+- (NSHTTPURLResponse *)responseForDownloadURL:(NSURL *)downloadURL ETag:(NSString *)ETag {
+    return [[NSHTTPURLResponse alloc] initWithURL:downloadURL statusCode:200 HTTPVersion:@"HTTP/1.1" headerFields:@{ @"ETag": ETag }];
+}
+
+- (NSData *)validateResumeDataForDownloadURL:(NSURL *)downloadURL {
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    __block NSData *validResumeData = nil;
+    [_store validateResumeDataForDownloadURL:downloadURL completion:^(NSData *resumeData) {
+        validResumeData = resumeData;
+        dispatch_semaphore_signal(semaphore);
+    }];
+    
+    while (dispatch_semaphore_wait(semaphore, DISPATCH_TIME_NOW))
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode
+                                 beforeDate:[NSDate dateWithTimeIntervalSinceNow:10]];
+    
+    return validResumeData;
+}
+
+- (void)testSavedResumeDataIsReturnedWithItsByteOffset {
+    NSData *resumeData = [self resumeDataForDownloadURL:_downloadURL bytesReceived:1024];
+    [_store saveResumeData:resumeData forDownloadURL:_downloadURL response:nil];
+    
+    assertThat([_store resumeDataForDownloadURL:_downloadURL], equalTo(resumeData));
+    assertThat([_store downloadURLs], contains(_downloadURL, nil));
+    assertThatLongLong([_store bytesReceivedForDownloadURL:_downloadURL], equalToLongLong(1024));
+}
+
+- (void)testResumeDataIsKeptAcrossStores {
+    NSData *resumeData = [self resumeDataForDownloadURL:_downloadURL bytesReceived:1024];
+    [_store saveResumeData:resumeData forDownloadURL:_downloadURL response:nil];
+    
+    IGResumeDataStore *store = [[IGResumeDataStore alloc] initWithDirectory:_directory];
+    
+    assertThat([store resumeDataForDownloadURL:_downloadURL], equalTo(resumeData));
+    assertThatLongLong([store bytesReceivedForDownloadURL:_downloadURL], equalToLongLong(1024));
+}
+
+- (void)testRemovedResumeDataIsGone {
+    [_store saveResumeData:[self resumeDataForDownloadURL:_downloadURL bytesReceived:1024] forDownloadURL:_downloadURL response:nil];
+    [_store removeResumeDataForDownloadURL:_downloadURL];
+    
+    assertThat([_store resumeDataForDownloadURL:_downloadURL], nilValue());
+    assertThat([_store downloadURLs], isEmpty());
+}
+
+- (void)testExpiredResumeDataIsRemoved {
+    [_store saveResumeData:[self resumeDataForDownloadURL:_downloadURL bytesReceived:1024] forDownloadURL:_downloadURL response:nil];
+    _store.maximumAge = -1;
+    [_store removeExpiredResumeData];
+    
+    NSString *blobPath = [_directory stringByAppendingPathComponent:[NSString MD5Hash:[_downloadURL absoluteString]]];
+    assertThatBool([[NSFileManager defaultManager] fileExistsAtPath:blobPath], equalToBool(NO));
+    assertThat([_store downloadURLs], isEmpty());
+}
+
+- (void)testResumeDataWithoutItsPartialFileIsNotReturned {
+    [_store saveResumeData:[self resumeDataForDownloadURL:_downloadURL bytesReceived:1024] forDownloadURL:_downloadURL response:nil];
+    [[NSFileManager defaultManager] removeItemAtPath:_partialFilePath error:nil];
+    
+    assertThat([_store resumeDataForDownloadURL:_downloadURL], nilValue());
+}
+
+- (void)testResumeDataSavedBeforeTheIndexIsAdopted {
+    NSString *blobPath = [_directory stringByAppendingPathComponent:[NSString MD5Hash:[_downloadURL absoluteString]]];
+    [[self resumeDataForDownloadURL:_downloadURL bytesReceived:2048] writeToFile:blobPath atomically:YES];
+    [_store removeExpiredResumeData];
+    
+    assertThat([_store downloadURLs], contains(_downloadURL, nil));
+    assertThatLongLong([_store bytesReceivedForDownloadURL:_downloadURL], equalToLongLong(2048));
+}
+
+- (void)testResumeDataIsValidWhenTheFileIsUnchanged {
+    IGTestHTTPServer *server = [[IGTestHTTPServer alloc] initWithData:[NSData dataWithBytes:"episode" length:7]];
+    [server start];
+    NSData *resumeData = [self resumeDataForDownloadURL:[server URL] bytesReceived:3];
+    [_store saveResumeData:resumeData forDownloadURL:[server URL] response:[self responseForDownloadURL:[server URL] ETag:@"\"sitmos-test\""]];
+    
+    assertThat([self validateResumeDataForDownloadURL:[server URL]], equalTo(resumeData));
+    
+    [server stop];
+}
+
+- (void)testResumeDataIsDroppedWhenTheFileHasChanged {
+    IGTestHTTPServer *server = [[IGTestHTTPServer alloc] initWithData:[NSData dataWithBytes:"episode" length:7]];
+    [server start];
+    [_store saveResumeData:[self resumeDataForDownloadURL:[server URL] bytesReceived:3] forDownloadURL:[server URL] response:[self responseForDownloadURL:[server URL] ETag:@"\"an-older-file\""]];
+    
+    assertThat([self validateResumeDataForDownloadURL:[server URL]], nilValue());
+    assertThat([_store resumeDataForDownloadURL:[server URL]], nilValue());
+    
+    [server stop];
+}
+
+@end
@@ -0,0 +1,130 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGSeekCoordinator.h"
+#import <SenTestingKit/SenTestingKit.h>
+
+#define HC_SHORTHAND
+#import <OCHamcrestIOS/OCHamcrestIOS.h>
+
+@interface IGSeekCoordinatorTests : SenTestCase
+@end
+
+@implementation IGSeekCoordinatorTests {
+    IGSeekCoordinator *_coordinator;
+    NSMutableArray *_issuedSeeks;
+    NSMutableArray *_completions;
+    NSMutableArray *_settledTimes;
+}
+
+- (void)setUp {
+    [super setUp];
+    
+    _issuedSeeks = [NSMutableArray array];
+    _completions = [NSMutableArray array];
+    _settledTimes = [NSMutableArray array];
+    
+    NSMutableArray *issuedSeeks = _issuedSeeks;
+    NSMutableArray *completions = _completions;
+    NSMutableArray *settledTimes = _settledTimes;
+    _coordinator = [[IGSeekCoordinator alloc] initWithSeekBlock:^(Float64 time, BOOL exact, IGSeekCompletionBlock completion) {
+        [issuedSeeks addObject:@[@(time), @(exact)]];
+        [completions addObject:[completion copy]];
+    }];
+    [_coordinator setSettledBlock:^(Float64 time) {
+        [settledTimes addObject:@(time)];
+    }];
+}
+
+- (void)tearDown {
+    _coordinator = nil;
+    
+    [super tearDown];
+}
+
+- (void)completeSeekInFlight {
+    IGSeekCompletionBlock completion = [_completions objectAtIndex:0];
+    [_completions removeObjectAtIndex:0];
+    completion(YES);
+}
+
+- (void)testSeekIsIssuedStraightAway {
+    [_coordinator seekToTime:30 exact:YES];
+    
+    assertThat(_issuedSeeks, equalTo(@[@[@30, @YES]]));
+    assertThatBool([_coordinator isSeeking], equalToBool(YES));
+}
+
+- (void)testSeeksWhileOneIsInFlightCollapseToTheLatest {
+    [_coordinator seekToTime:10 exact:NO];
+    [_coordinator seekToTime:20 exact:NO];
+    [_coordinator seekToTime:30 exact:NO];
+    [_coordinator seekToTime:40 exact:YES];
+    
+    assertThatUnsignedInteger([_issuedSeeks count], equalToUnsignedInteger(1));
+    assertThatDouble([_coordinator targetTime], equalToDouble(40));
+    
+    [self completeSeekInFlight];
+    
+    assertThat(_issuedSeeks, equalTo(@[@[@10, @NO], @[@40, @YES]]));
+    assertThat(_settledTimes, isEmpty());
+}
+
+- (void)testSettledOnceNoSeekIsWaiting {
+    [_coordinator seekToTime:10 exact:NO];
+    [_coordinator seekToTime:20 exact:YES];
+    [self completeSeekInFlight];
+    [self completeSeekInFlight];
+    
+    assertThat(_settledTimes, equalTo(@[@20]));
+    assertThatBool([_coordinator isSeeking], equalToBool(NO));
+}
+
+- (void)testCancelledSeekCompletionIsIgnored {
+    [_coordinator seekToTime:10 exact:YES];
+    [_coordinator seekToTime:20 exact:YES];
+    [_coordinator cancelSeeks];
+    [self completeSeekInFlight];
+    
+    assertThatUnsignedInteger([_issuedSeeks count], equalToUnsignedInteger(1));
+    assertThat(_settledTimes, isEmpty());
+    assertThatBool([_coordinator isSeeking], equalToBool(NO));
+    
+    [_coordinator seekToTime:5 exact:YES];
+    assertThat([_issuedSeeks lastObject], equalTo(@[@5, @YES]));
+}
+
+- (void)testSeekCompletingStraightAwaySettles {
+    IGSeekCoordinator *coordinator = [[IGSeekCoordinator alloc] initWithSeekBlock:^(Float64 time, BOOL exact, IGSeekCompletionBlock completion) {
+        completion(NO);
+    }];
+    NSMutableArray *settledTimes = [NSMutableArray array];
+    [coordinator setSettledBlock:^(Float64 time) {
+        [settledTimes addObject:@(time)];
+    }];
+    
+    [coordinator seekToTime:15 exact:YES];
+    
+    assertThat(settledTimes, equalTo(@[@15]));
+    assertThatBool([coordinator isSeeking], equalToBool(NO));
+}
+
+@end
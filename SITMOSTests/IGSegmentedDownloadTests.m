@@ -0,0 +1,173 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGSegmentedDownload.h"
+#import "IGTestHTTPServer.h"
+#import <SenTestingKit/SenTestingKit.h>
+
+#define HC_SHORTHAND
+#import <OCHamcrestIOS/OCHamcrestIOS.h>
+
+@interface IGSegmentedDownloadTests : SenTestCase
+@end
+
+@implementation IGSegmentedDownloadTests {
+    NSData *_episodeData;
+    IGTestHTTPServer *_server;
+    NSURL *_destinationURL;
+}
+
+- (void)setUp {
+    [super setUp];
+    
+    NSMutableData *episodeData = [NSMutableData dataWithLength:4 * 1024 * 1024];
+    arc4random_buf([episodeData mutableBytes], [episodeData length]);
+    _episodeData = episodeData;
+    
+    _server = [[IGTestHTTPServer alloc] initWithData:_episodeData];
+    [_server start];
+    
+    _destinationURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:@"IGSegmentedDownloadTests.mp3"]];
+    [[NSFileManager defaultManager] removeItemAtURL:_destinationURL error:nil];
+}
+
+- (void)tearDown {
+    [_server stop];
+    _server = nil;
+    [[NSFileManager defaultManager] removeItemAtURL:_destinationURL error:nil];
+    
+    [super tearDown];
+}
+
+- (NSError *)downloadWithMaximumConnections:(NSUInteger)maximumConnections {
+    IGSegmentedDownload *download = [[IGSegmentedDownload alloc] initWithDownloadURL:[_server URL] destinationURL:_destinationURL];
+    download.maximumConnections = maximumConnections;
+    download.minimumSegmentLength = 256 * 1024;
+    download.maximumRetries = 20;
+    
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    __block NSError *downloadError = nil;
+    
+    [download startWithCompletion:^(BOOL success, NSError *error) {
+        downloadError = error;
+        dispatch_semaphore_signal(semaphore);
+    }];
+    
+    while (dispatch_semaphore_wait(semaphore, DISPATCH_TIME_NOW))
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode
+                                 beforeDate:[NSDate dateWithTimeIntervalSinceNow:10]];
+    
+    return downloadError;
+}
+
+- (void)testSegmentedDownloadMatchesServedFile {
+    NSError *error = [self downloadWithMaximumConnections:4];
+    
+    assertThat(error, nilValue());
+    assertThat([NSData dataWithContentsOfURL:_destinationURL], equalTo(_episodeData));
+    // The probe plus one request per range.
+    assertThatUnsignedInteger([_server requestCount], greaterThan(@4));
+}
+
+- (void)testOnlyLostRangesAreFetchedAgain {
+    _server.lossRate = 0.3;
+    
+    NSError *error = [self downloadWithMaximumConnections:4];
+    
+    assertThat(error, nilValue());
+    assertThat([NSData dataWithContentsOfURL:_destinationURL], equalTo(_episodeData));
+}
+
+- (void)testServerWithoutRangeSupportFailsBeforeWritingAnything {
+    _server.supportsRanges = NO;
+    
+    NSError *error = [self downloadWithMaximumConnections:4];
+    
+    assertThat([error domain], equalTo(IGSegmentedDownloadErrorDomain));
+    assertThatInteger([error code], equalToInteger(IGSegmentedDownloadErrorRangesNotSupported));
+    assertThatBool([[NSFileManager defaultManager] fileExistsAtPath:[_destinationURL path]], equalToBool(NO));
+    assertThatUnsignedInteger([_server requestCount], equalToUnsignedInteger(1));
+}
+
+- (void)testSuspendedDownloadStartsNoRangeUntilResumed {
+    IGSegmentedDownload *download = [[IGSegmentedDownload alloc] initWithDownloadURL:[_server URL] destinationURL:_destinationURL];
+    download.minimumSegmentLength = 256 * 1024;
+    
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    __block NSError *downloadError = nil;
+    [download startWithCompletion:^(BOOL success, NSError *error) {
+        downloadError = error;
+        dispatch_semaphore_signal(semaphore);
+    }];
+    [download suspend];
+    
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.5]];
+    
+    // At most the probe went out before the download was suspended.
+    assertThatBool([download isSuspended], equalToBool(YES));
+    assertThatUnsignedInteger([_server requestCount], lessThanOrEqualTo(@1));
+    assertThatBool([[NSFileManager defaultManager] fileExistsAtPath:[_destinationURL path]], equalToBool(NO));
+    
+    [download resume];
+    while (dispatch_semaphore_wait(semaphore, DISPATCH_TIME_NOW))
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode
+                                 beforeDate:[NSDate dateWithTimeIntervalSinceNow:10]];
+    
+    assertThat(downloadError, nilValue());
+    assertThat([NSData dataWithContentsOfURL:_destinationURL], equalTo(_episodeData));
+}
+
+- (void)testLostRangeIsResumedOnSlowLossyLink {
+    _server.latency = 0.05;
+    _server.bytesPerSecondPerConnection = 2 * 1024 * 1024;
+    // The request after the probe is the first range, cut off half way through its body.
+    _server.lostRequestNumbers = [NSIndexSet indexSetWithIndex:2];
+    
+    NSError *error = [self downloadWithMaximumConnections:4];
+    
+    assertThat(error, nilValue());
+    assertThat([NSData dataWithContentsOfURL:_destinationURL], equalTo(_episodeData));
+    
+    NSArray *requestedRanges = [_server requestedRanges];
+    assertThatUnsignedInteger([requestedRanges count], greaterThan(@2));
+    assertThatUnsignedInteger([[requestedRanges objectAtIndex:0] rangeValue].length, equalToUnsignedInteger(1));
+    
+    // The lost range is asked for again from where its body stopped, not from its start.
+    NSRange lostRange = [[requestedRanges objectAtIndex:1] rangeValue];
+    NSUInteger retries = 0;
+    for (NSValue *value in [requestedRanges subarrayWithRange:NSMakeRange(2, [requestedRanges count] - 2)]) {
+        NSRange range = [value rangeValue];
+        if (NSMaxRange(range) == NSMaxRange(lostRange)) {
+            assertThatUnsignedInteger(range.location, greaterThan(@(lostRange.location)));
+            retries++;
+        }
+    }
+    assertThatUnsignedInteger(retries, equalToUnsignedInteger(1));
+    
+    // Every range other than the lost one is requested exactly once.
+    NSUInteger requestedLength = 0;
+    for (NSValue *value in [requestedRanges subarrayWithRange:NSMakeRange(1, [requestedRanges count] - 1)]) {
+        requestedLength += [value rangeValue].length;
+    }
+    assertThatUnsignedInteger(requestedLength, lessThan(@([_episodeData length] + lostRange.length)));
+}
+
+@end
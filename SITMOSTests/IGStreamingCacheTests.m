@@ -0,0 +1,185 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGStreamingCache.h"
+#import "IGTestHTTPServer.h"
+#import <SenTestingKit/SenTestingKit.h>
+
+#define HC_SHORTHAND
+#import <OCHamcrestIOS/OCHamcrestIOS.h>
+
+@interface IGStreamingCacheTests : SenTestCase
+@end
+
+@implementation IGStreamingCacheTests {
+    NSString *_directory;
+    NSData *_episodeData;
+    IGTestHTTPServer *_server;
+    IGStreamingCache *_cache;
+    NSURL *_destinationURL;
+}
+
+- (void)setUp {
+    [super setUp];
+    
+    NSMutableData *episodeData = [NSMutableData dataWithLength:1024 * 1024];
+    arc4random_buf([episodeData mutableBytes], [episodeData length]);
+    _episodeData = episodeData;
+    
+    _server = [[IGTestHTTPServer alloc] initWithData:_episodeData];
+    [_server start];
+    
+    _directory = [NSTemporaryDirectory() stringByAppendingPathComponent:@"IGStreamingCacheTests"];
+    [[NSFileManager defaultManager] removeItemAtPath:_directory error:nil];
+    _cache = [[IGStreamingCache alloc] initWithDirectory:_directory];
+    
+    _destinationURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:@"IGStreamingCacheTests.mp3"]];
+    [[NSFileManager defaultManager] removeItemAtURL:_destinationURL error:nil];
+}
+
+- (void)tearDown {
+    [_server stop];
+    _server = nil;
+    _cache = nil;
+    [[NSFileManager defaultManager] removeItemAtPath:_directory error:nil];
+    [[NSFileManager defaultManager] removeItemAtURL:_destinationURL error:nil];
+    
+    [super tearDown];
+}
+
+- (void)waitForSemaphore:(dispatch_semaphore_t)semaphore {
+    while (dispatch_semaphore_wait(semaphore, DISPATCH_TIME_NOW))
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode
+                                 beforeDate:[NSDate dateWithTimeIntervalSinceNow:10]];
+}
+
+- (NSError *)fetchEntry:(IGStreamingCacheEntry *)entry fromOffset:(int64_t)offset length:(int64_t)length {
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    __block NSError *fetchError = nil;
+    [entry fetchFromOffset:offset length:length dataHandler:nil completion:^(NSError *error) {
+        fetchError = error;
+        dispatch_semaphore_signal(semaphore);
+    }];
+    [self waitForSemaphore:semaphore];
+    
+    return fetchError;
+}
+
+- (NSError *)fillEntry:(IGStreamingCacheEntry *)entry {
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    __block NSError *fillError = nil;
+    [entry fillWithCompletion:^(BOOL success, NSError *error) {
+        fillError = error;
+        dispatch_semaphore_signal(semaphore);
+    }];
+    [self waitForSemaphore:semaphore];
+    
+    return fillError;
+}
+
+- (void)testFetchedRangeIsCached {
+    IGStreamingCacheEntry *entry = [_cache entryForURL:[_server URL]];
+    
+    assertThat([self fetchEntry:entry fromOffset:4096 length:8192], nilValue());
+    assertThatLongLong([entry contentLength], equalToLongLong([_episodeData length]));
+    assertThat([entry contentType], equalTo(@"audio/mpeg"));
+    assertThatLongLong([entry countOfBytesCached], equalToLongLong(8192));
+    assertThatLongLong([entry cachedLengthFromOffset:4096], equalToLongLong(8192));
+    assertThatLongLong([entry cachedLengthFromOffset:0], equalToLongLong(0));
+    assertThatLongLong([entry missingLengthFromOffset:0], equalToLongLong(4096));
+    assertThat([entry readDataFromOffset:4096 length:8192], equalTo([_episodeData subdataWithRange:NSMakeRange(4096, 8192)]));
+    assertThatBool([entry isComplete], equalToBool(NO));
+}
+
+- (void)testCachedRangesAreKeptAcrossCaches {
+    IGStreamingCacheEntry *entry = [_cache entryForURL:[_server URL]];
+    [self fetchEntry:entry fromOffset:0 length:8192];
+    entry = nil;
+    
+    IGStreamingCache *cache = [[IGStreamingCache alloc] initWithDirectory:_directory];
+    IGStreamingCacheEntry *reopenedEntry = [cache existingEntryForURL:[_server URL]];
+    
+    assertThatLongLong([reopenedEntry cachedLengthFromOffset:0], equalToLongLong(8192));
+    assertThat([reopenedEntry readDataFromOffset:0 length:8192], equalTo([_episodeData subdataWithRange:NSMakeRange(0, 8192)]));
+}
+
+- (void)testFillOnlyFetchesTheMissingRanges {
+    IGStreamingCacheEntry *entry = [_cache entryForURL:[_server URL]];
+    [self fetchEntry:entry fromOffset:0 length:256 * 1024];
+    [self fetchEntry:entry fromOffset:512 * 1024 length:256 * 1024];
+    NSUInteger requestCount = [_server requestCount];
+    
+    assertThat([self fillEntry:entry], nilValue());
+    assertThatBool([entry isComplete], equalToBool(YES));
+    assertThatUnsignedInteger([_server requestCount] - requestCount, equalToUnsignedInteger(2));
+}
+
+- (void)testSecondFillWaitsForTheRunningFill {
+    _server.bytesPerSecondPerConnection = 512 * 1024;
+    IGStreamingCacheEntry *entry = [_cache entryForURL:[_server URL]];
+    
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    __block NSUInteger completions = 0;
+    for (NSUInteger i = 0; i < 2; i++) {
+        [entry fillWithCompletion:^(BOOL success, NSError *error) {
+            completions++;
+            dispatch_semaphore_signal(semaphore);
+        }];
+    }
+    [self waitForSemaphore:semaphore];
+    [self waitForSemaphore:semaphore];
+    
+    assertThatUnsignedInteger(completions, equalToUnsignedInteger(2));
+    assertThatBool([entry isComplete], equalToBool(YES));
+    // The whole file in one range, it is not fetched a second time.
+    assertThatUnsignedInteger([_server requestCount], equalToUnsignedInteger(1));
+}
+
+- (void)testCompleteEntryIsMovedToTheDestination {
+    IGStreamingCacheEntry *entry = [_cache entryForURL:[_server URL]];
+    [self fillEntry:entry];
+    
+    NSError *error = nil;
+    assertThatBool([_cache moveEntryForURL:[_server URL] toURL:_destinationURL error:&error], equalToBool(YES));
+    assertThat([NSData dataWithContentsOfURL:_destinationURL], equalTo(_episodeData));
+    assertThat([_cache existingEntryForURL:[_server URL]], nilValue());
+}
+
+- (void)testIncompleteEntryIsNotMoved {
+    IGStreamingCacheEntry *entry = [_cache entryForURL:[_server URL]];
+    [self fetchEntry:entry fromOffset:0 length:8192];
+    
+    NSError *error = nil;
+    assertThatBool([_cache moveEntryForURL:[_server URL] toURL:_destinationURL error:&error], equalToBool(NO));
+    assertThatInteger([error code], equalToInteger(IGStreamingCacheErrorNotComplete));
+    assertThatBool([[NSFileManager defaultManager] fileExistsAtPath:[_destinationURL path]], equalToBool(NO));
+}
+
+- (void)testServerWithoutRangesFillsFromTheStart {
+    _server.supportsRanges = NO;
+    IGStreamingCacheEntry *entry = [_cache entryForURL:[_server URL]];
+    
+    assertThat([self fillEntry:entry], nilValue());
+    assertThatBool([entry isComplete], equalToBool(YES));
+    assertThat([entry readDataFromOffset:0 length:[_episodeData length]], equalTo(_episodeData));
+}
+
+@end
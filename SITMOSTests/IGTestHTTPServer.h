@@ -0,0 +1,98 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * A minimal HTTP/1.1 server on the loopback interface that serves one file, standing in for the episode host in tests.
+ *
+ * Latency, a per connection bandwidth limit and lost connections can be injected to compare download strategies on a lossy link.
+ */
+@interface IGTestHTTPServer : NSObject
+
+/**
+ * Initializes a server that answers every GET with the given data, HEAD requests are answered with the headers alone. A request whose If-None-Match matches the ETag of the data is answered with 304 Not Modified.
+ */
+- (id)initWithData:(NSData *)data;
+
+/**
+ * The content type the file is served with. Defaults to audio/mpeg.
+ */
+@property (atomic, copy) NSString *contentType;
+
+/**
+ * YES if Range requests are answered with 206 Partial Content, NO to always send the whole file. Defaults to YES.
+ */
+@property (atomic, assign) BOOL supportsRanges;
+
+/**
+ * The delay before each response is sent.
+ */
+@property (atomic, assign) NSTimeInterval latency;
+
+/**
+ * The most bytes per second sent over one connection, 0 for no limit.
+ */
+@property (atomic, assign) NSUInteger bytesPerSecondPerConnection;
+
+/**
+ * The probability between 0 and 1 that a response body is cut off part way and its connection closed.
+ */
+@property (atomic, assign) double lossRate;
+
+/**
+ * The numbers, counting from 1, of the requests whose response bodies are cut off half way and their connections closed, regardless of lossRate.
+ */
+@property (atomic, copy) NSIndexSet *lostRequestNumbers;
+
+/**
+ * The URL of the served file, nil until the server is started.
+ */
+@property (atomic, strong, readonly) NSURL *URL;
+
+/**
+ * The number of requests answered so far.
+ */
+@property (atomic, assign, readonly) NSUInteger requestCount;
+
+/**
+ * The headers of the last request keyed by lowercased name, nil until a request has been answered.
+ */
+@property (atomic, copy, readonly) NSDictionary *lastRequestHeaders;
+
+/**
+ * The byte range answered for each request so far, as NSValues in the order the requests arrived.
+ */
+@property (atomic, copy, readonly) NSArray *requestedRanges;
+
+/**
+ * Starts listening on a free port.
+ *
+ * @return YES if the server is listening, NO otherwise.
+ */
+- (BOOL)start;
+
+/**
+ * Stops listening and closes every open connection.
+ */
+- (void)stop;
+
+@end
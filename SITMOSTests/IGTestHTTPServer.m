@@ -0,0 +1,289 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "IGTestHTTPServer.h"
+
+#import <arpa/inet.h>
+#import <netinet/in.h>
+#import <sys/socket.h>
+#import <unistd.h>
+
+static NSUInteger const IGTestHTTPServerChunkLength = 16 * 1024;
+static NSString * const IGTestHTTPServerETag = @"\"sitmos-test\"";
+
+@interface IGTestHTTPServer ()
+
+@property (atomic, strong, readwrite) NSURL *URL;
+@property (atomic, assign, readwrite) NSUInteger requestCount;
+@property (atomic, copy, readwrite) NSDictionary *lastRequestHeaders;
+
+@end
+
+@implementation IGTestHTTPServer {
+    NSData *_data;
+    int _listenSocket;
+    dispatch_source_t _acceptSource;
+    dispatch_queue_t _connectionQueue;
+    NSMutableSet *_connectionSockets;
+    NSMutableArray *_requestedRanges;
+}
+
+- (id)initWithData:(NSData *)data {
+    if (!(self = [super init])) return nil;
+    
+    _data = [data copy];
+    _contentType = @"audio/mpeg";
+    _supportsRanges = YES;
+    _listenSocket = -1;
+    _connectionQueue = dispatch_queue_create("com.idlegeniussoftware.sitmos.tests.http.connection", DISPATCH_QUEUE_CONCURRENT);
+    _connectionSockets = [[NSMutableSet alloc] init];
+    _requestedRanges = [[NSMutableArray alloc] init];
+    
+    return self;
+}
+
+- (void)dealloc {
+    [self stop];
+}
+
+- (NSArray *)requestedRanges {
+    @synchronized(_requestedRanges) {
+        return [_requestedRanges copy];
+    }
+}
+
+#pragma mark - Starting and Stopping
+
+- (BOOL)start {
+    _listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if (_listenSocket < 0) {
+        return NO;
+    }
+    
+    int yes = 1;
+    setsockopt(_listenSocket, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_len = sizeof(address);
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    
+    socklen_t addressLength = sizeof(address);
+    if (bind(_listenSocket, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        listen(_listenSocket, 64) != 0 ||
+        getsockname(_listenSocket, (struct sockaddr *)&address, &addressLength) != 0) {
+        [self stop];
+        return NO;
+    }
+    
+    self.URL = [NSURL URLWithString:[NSString stringWithFormat:@"http://127.0.0.1:%d/episode.mp3", ntohs(address.sin_port)]];
+    
+    int listenSocket = _listenSocket;
+    _acceptSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, listenSocket, 0, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0));
+    __weak IGTestHTTPServer *weakSelf = self;
+    dispatch_source_set_event_handler(_acceptSource, ^{
+        int connectionSocket = accept(listenSocket, NULL, NULL);
+        if (connectionSocket >= 0) {
+            [weakSelf serveConnection:connectionSocket];
+        }
+    });
+    dispatch_source_set_cancel_handler(_acceptSource, ^{
+        close(listenSocket);
+    });
+    dispatch_resume(_acceptSource);
+    
+    return YES;
+}
+
+- (void)stop {
+    if (_acceptSource) {
+        dispatch_source_cancel(_acceptSource);
+        _acceptSource = nil;
+    } else if (_listenSocket >= 0) {
+        close(_listenSocket);
+    }
+    _listenSocket = -1;
+    
+    @synchronized(_connectionSockets) {
+        for (NSNumber *connectionSocket in _connectionSockets) {
+            shutdown([connectionSocket intValue], SHUT_RDWR);
+        }
+    }
+}
+
+#pragma mark - Serving Requests
+
+- (void)serveConnection:(int)connectionSocket {
+    int yes = 1;
+    setsockopt(connectionSocket, SOL_SOCKET, SO_NOSIGPIPE, &yes, sizeof(yes));
+    
+    @synchronized(_connectionSockets) {
+        [_connectionSockets addObject:@(connectionSocket)];
+    }
+    
+    dispatch_async(_connectionQueue, ^{
+        NSMutableData *buffer = [NSMutableData data];
+        while (YES) {
+            NSDictionary *headers = [self readRequestHeadersFromSocket:connectionSocket buffer:buffer];
+            if (!headers || ![self respondToRequestWithHeaders:headers onSocket:connectionSocket]) {
+                break;
+            }
+        }
+        
+        @synchronized(_connectionSockets) {
+            [_connectionSockets removeObject:@(connectionSocket)];
+        }
+        close(connectionSocket);
+    });
+}
+
+/**
+ * Reads one request from the connection, returning its headers keyed by lowercased name and its method keyed by ":method", nil once the connection is closed.
+ */
+- (NSDictionary *)readRequestHeadersFromSocket:(int)connectionSocket buffer:(NSMutableData *)buffer {
+    NSData *terminator = [@"\r\n\r\n" dataUsingEncoding:NSASCIIStringEncoding];
+    char bytes[4096];
+    
+    NSRange terminatorRange = [buffer rangeOfData:terminator options:0 range:NSMakeRange(0, [buffer length])];
+    while (terminatorRange.location == NSNotFound) {
+        ssize_t length = read(connectionSocket, bytes, sizeof(bytes));
+        if (length <= 0) {
+            return nil;
+        }
+        [buffer appendBytes:bytes length:length];
+        terminatorRange = [buffer rangeOfData:terminator options:0 range:NSMakeRange(0, [buffer length])];
+    }
+    
+    NSString *request = [[NSString alloc] initWithData:[buffer subdataWithRange:NSMakeRange(0, terminatorRange.location)] encoding:NSASCIIStringEncoding];
+    [buffer replaceBytesInRange:NSMakeRange(0, NSMaxRange(terminatorRange)) withBytes:NULL length:0];
+    
+    NSArray *lines = [request componentsSeparatedByString:@"\r\n"];
+    NSMutableDictionary *headers = [NSMutableDictionary dictionary];
+    [headers setObject:[[[lines firstObject] componentsSeparatedByString:@" "] firstObject] forKey:@":method"];
+    for (NSString *line in lines) {
+        NSRange separator = [line rangeOfString:@":"];
+        if (separator.location != NSNotFound) {
+            NSString *name = [[line substringToIndex:separator.location] lowercaseString];
+            NSString *value = [[line substringFromIndex:separator.location + 1] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+            [headers setObject:value forKey:name];
+        }
+    }
+    return headers;
+}
+
+/**
+ * Writes the response to one request, returning NO if the connection has to be closed.
+ */
+- (BOOL)respondToRequestWithHeaders:(NSDictionary *)headers onSocket:(int)connectionSocket {
+    NSUInteger length = [_data length];
+    NSRange range = NSMakeRange(0, length);
+    BOOL partial = NO;
+    
+    NSString *rangeHeader = [headers objectForKey:@"range"];
+    if (self.supportsRanges && [rangeHeader hasPrefix:@"bytes="]) {
+        NSArray *bounds = [[rangeHeader substringFromIndex:6] componentsSeparatedByString:@"-"];
+        NSUInteger start = (NSUInteger)[[bounds objectAtIndex:0] longLongValue];
+        NSUInteger end = ([bounds count] > 1 && [[bounds objectAtIndex:1] length] > 0) ? (NSUInteger)[[bounds objectAtIndex:1] longLongValue] : length - 1;
+        end = MIN(end, length - 1);
+        if (start <= end) {
+            range = NSMakeRange(start, end - start + 1);
+            partial = YES;
+        }
+    }
+    
+    NSUInteger requestNumber;
+    @synchronized(_requestedRanges) {
+        [_requestedRanges addObject:[NSValue valueWithRange:range]];
+        requestNumber = [_requestedRanges count];
+        self.requestCount = requestNumber;
+        self.lastRequestHeaders = headers;
+    }
+    
+    if ([[headers objectForKey:@"if-none-match"] isEqualToString:IGTestHTTPServerETag]) {
+        NSData *head = [[NSString stringWithFormat:@"HTTP/1.1 304 Not Modified\r\nETag: %@\r\n\r\n", IGTestHTTPServerETag] dataUsingEncoding:NSASCIIStringEncoding];
+        return [self writeBytes:[head bytes] length:[head length] toSocket:connectionSocket];
+    }
+    
+    NSMutableString *response = [NSMutableString string];
+    [response appendString:partial ? @"HTTP/1.1 206 Partial Content\r\n" : @"HTTP/1.1 200 OK\r\n"];
+    [response appendFormat:@"Content-Type: %@\r\n", self.contentType];
+    [response appendFormat:@"ETag: %@\r\n", IGTestHTTPServerETag];
+    [response appendFormat:@"Content-Length: %lu\r\n", (unsigned long)range.length];
+    if (self.supportsRanges) {
+        [response appendString:@"Accept-Ranges: bytes\r\n"];
+    }
+    if (partial) {
+        [response appendFormat:@"Content-Range: bytes %lu-%lu/%lu\r\n", (unsigned long)range.location, (unsigned long)NSMaxRange(range) - 1, (unsigned long)length];
+    }
+    [response appendString:@"\r\n"];
+    
+    if (self.latency > 0) {
+        usleep((useconds_t)(self.latency * USEC_PER_SEC));
+    }
+    
+    NSData *head = [response dataUsingEncoding:NSASCIIStringEncoding];
+    if (![self writeBytes:[head bytes] length:[head length] toSocket:connectionSocket]) {
+        return NO;
+    }
+    
+    if ([[headers objectForKey:@":method"] isEqualToString:@"HEAD"]) {
+        return YES;
+    }
+    
+    // A lost response stops somewhere in its body and the connection is dropped.
+    NSUInteger cutOff = NSMaxRange(range);
+    if ([self.lostRequestNumbers containsIndex:requestNumber]) {
+        cutOff = range.location + range.length / 2;
+    } else if (self.lossRate > 0 && arc4random_uniform(1000) < self.lossRate * 1000) {
+        cutOff = range.location + arc4random_uniform((u_int32_t)range.length);
+    }
+    
+    const char *bytes = [_data bytes];
+    for (NSUInteger offset = range.location; offset < cutOff; offset += IGTestHTTPServerChunkLength) {
+        NSUInteger chunkLength = MIN(IGTestHTTPServerChunkLength, cutOff - offset);
+        if (![self writeBytes:bytes + offset length:chunkLength toSocket:connectionSocket]) {
+            return NO;
+        }
+        
+        NSUInteger bytesPerSecond = self.bytesPerSecondPerConnection;
+        if (bytesPerSecond > 0) {
+            usleep((useconds_t)((double)chunkLength / bytesPerSecond * USEC_PER_SEC));
+        }
+    }
+    
+    return cutOff == NSMaxRange(range);
+}
+
+- (BOOL)writeBytes:(const char *)bytes length:(NSUInteger)length toSocket:(int)connectionSocket {
+    while (length > 0) {
+        ssize_t written = write(connectionSocket, bytes, length);
+        if (written <= 0) {
+            return NO;
+        }
+        bytes += written;
+        length -= written;
+    }
+    return YES;
+}
+
+@end
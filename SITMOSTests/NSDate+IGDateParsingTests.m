@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2013, Tom Diggle
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "NSDate+IGDateParsing.h"
+
+#import <SenTestingKit/SenTestingKit.h>
+
+#define HC_SHORTHAND
+#import <OCHamcrestIOS/OCHamcrestIOS.h>
+
+@interface NSDate_IGDateParsingTests : SenTestCase
+
+@end
+
+@implementation NSDate_IGDateParsingTests
+
+#pragma mark - RFC 822 Date Tests
+
+- (void)testRFC822DateWithZoneNameIsParsed {
+    assertThat([NSDate dateFromRFC822String:@"Tue, 10 Aug 2010 00:00:00 MST"], equalTo([NSDate dateWithTimeIntervalSince1970:1281423600]));
+}
+
+- (void)testRFC1123DateInGMTIsParsed {
+    assertThat([NSDate dateFromRFC822String:@"Sun, 06 Nov 1994 08:49:37 GMT"], equalTo([NSDate dateWithTimeIntervalSince1970:784111777]));
+}
+
+- (void)testRFC822DateWithNumericZoneIsParsed {
+    assertThat([NSDate dateFromRFC822String:@"Tue, 10 Aug 2010 08:00:00 +0100"], equalTo([NSDate dateWithTimeIntervalSince1970:1281423600]));
+}
+
+- (void)testRFC822DateWithoutDayNameOrSecondsIsParsed {
+    assertThat([NSDate dateFromRFC822String:@"10 Aug 2010 07:00 GMT"], equalTo([NSDate dateWithTimeIntervalSince1970:1281423600]));
+}
+
+- (void)testRFC822DateWithTwoDigitYearIsParsed {
+    assertThat([NSDate dateFromRFC822String:@"Tue, 10 Aug 10 07:00:00 GMT"], equalTo([NSDate dateWithTimeIntervalSince1970:1281423600]));
+}
+
+- (void)testRFC822DateBeforeMarchInLeapYearIsParsed {
+    assertThat([NSDate dateFromRFC822String:@"Thu, 29 Feb 2024 12:00:00 GMT"], equalTo([NSDate dateWithTimeIntervalSince1970:1709208000]));
+}
+
+- (void)testMalformedDateReturnsNil {
+    assertThat([NSDate dateFromRFC822String:@"Not a date"], nilValue());
+    assertThat([NSDate dateFromRFC822String:@"Tue, 10 Foo 2010 00:00:00 GMT"], nilValue());
+}
+
+#pragma mark - Display Formatting Tests
+
+- (void)testCachedDateFormatterIsReusedOnTheSameThread {
+    NSDateFormatter *dateFormatter = [NSDate cachedDateFormatterWithFormat:@"dd MMM yyyy"];
+    
+    assertThat([NSDate cachedDateFormatterWithFormat:@"dd MMM yyyy"], sameInstance(dateFormatter));
+    assertThat([NSDate cachedDateFormatterWithFormat:@"yyyy"], isNot(sameInstance(dateFormatter)));
+}
+
+- (void)testCachedDateFormatterIsNotSharedBetweenThreads {
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    NSDateFormatter *dateFormatter = [NSDate cachedDateFormatterWithFormat:@"dd MMM yyyy"];
+    __block NSDateFormatter *otherThreadDateFormatter = nil;
+    
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        otherThreadDateFormatter = [NSDate cachedDateFormatterWithFormat:@"dd MMM yyyy"];
+        dispatch_semaphore_signal(semaphore);
+    });
+    
+    while (dispatch_semaphore_wait(semaphore, DISPATCH_TIME_NOW))
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode
+                                 beforeDate:[NSDate dateWithTimeIntervalSinceNow:10]];
+    
+    assertThat(otherThreadDateFormatter, notNilValue());
+    assertThat(otherThreadDateFormatter, isNot(sameInstance(dateFormatter)));
+}
+
+- (void)testDisplayStringUsesGivenFormat {
+    NSDate *date = [NSDate dateWithTimeIntervalSince1970:1281423600];
+    
+    assertThat([date displayStringWithFormat:@"yyyy"], equalTo(@"2010"));
+}
+
+@end